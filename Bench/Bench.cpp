@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Bench.cpp
+//! \brief  The benchmark harness entry point.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Bench.hpp"
+#include <tchar.h>
+#include <WCL/Module.hpp>
+#include <NCL/AutoWinSock.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The signature of a benchmark entry point.
+
+typedef void (*BenchmarkFn)();
+
+////////////////////////////////////////////////////////////////////////////////
+//! The table of benchmarks that can be run.
+
+static const struct Benchmark
+{
+	const tchar*	m_name;		//!< The name used to select it.
+	BenchmarkFn		m_fn;		//!< The entry point.
+}
+s_benchmarks[] =
+{
+	{ TXT("dde"),		runDDEBenchmark			},
+	{ TXT("pipe"),		runPipeBenchmark		},
+	{ TXT("rpc"),		runRPCBenchmark			},
+	{ TXT("transport"),	runTransportBenchmark	},
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The timer is started.
+
+Stopwatch::Stopwatch()
+{
+	::QueryPerformanceFrequency(&m_frequency);
+
+	start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Restart the timer.
+
+void Stopwatch::start()
+{
+	::QueryPerformanceCounter(&m_start);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of seconds since the timer was started.
+
+double Stopwatch::elapsed() const
+{
+	LARGE_INTEGER now;
+
+	::QueryPerformanceCounter(&now);
+
+	return static_cast<double>(now.QuadPart - m_start.QuadPart) / static_cast<double>(m_frequency.QuadPart);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the result of a benchmark run to stdout.
+
+void reportResult(const tchar* name, const tstring& variant, size_t operations, double seconds)
+{
+	const double opsPerSec = (seconds > 0.0) ? (operations / seconds) : 0.0;
+	const double usPerOp   = (operations != 0) ? ((seconds * 1000000.0) / operations) : 0.0;
+
+	_tprintf(TXT("%-20s %-24s %10u ops %10.2f ms %12.0f ops/s %10.3f us/op\n"),
+				name, variant.c_str(), static_cast<uint>(operations), seconds * 1000.0, opsPerSec, usPerOp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check if the benchmark was selected on the command line. All benchmarks are
+//! run when none are named.
+
+static bool isSelected(const tchar* name, int argc, _TCHAR* argv[])
+{
+	if (argc < 2)
+		return true;
+
+	for (int i = 1; i != argc; ++i)
+	{
+		if (tstricmp(argv[i], name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The entry point for the benchmark harness.
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	try
+	{
+		CModule     module;
+		AutoWinSock autoWinSock;
+
+		for (size_t i = 0; i != ARRAY_SIZE(s_benchmarks); ++i)
+		{
+			if (isSelected(s_benchmarks[i].m_name, argc, argv))
+				s_benchmarks[i].m_fn();
+		}
+
+		return EXIT_SUCCESS;
+	}
+	catch (const Core::Exception& e)
+	{
+		_tprintf(TXT("ERROR: %s\n"), e.twhat());
+	}
+
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Bench.hpp
+//! \brief  The benchmark harness declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_BENCH_HPP
+#define APP_BENCH_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! A high resolution timer used to measure a benchmark run.
+
+class Stopwatch
+{
+public:
+	//! Constructor. The timer is started.
+	Stopwatch();
+
+	//! Restart the timer.
+	void start();
+
+	//! The number of seconds since the timer was started.
+	double elapsed() const;
+
+private:
+	//
+	// Members.
+	//
+	LARGE_INTEGER	m_frequency;	//!< The counter frequency.
+	LARGE_INTEGER	m_start;		//!< The counter when started.
+};
+
+//! Write the result of a benchmark run to stdout.
+void reportResult(const tchar* name, const tstring& variant, size_t operations, double seconds);
+
+////////////////////////////////////////////////////////////////////////////////
+// The benchmarks.
+
+//! Measure DDE request and advise throughput through the in-process broker.
+void runDDEBenchmark();
+
+//! Compare the latency of the named pipe and shared memory transports.
+void runPipeBenchmark();
+
+//! Measure RPC round-trips over a loopback connection at various depths.
+void runRPCBenchmark();
+
+//! Compare the latency of the TCP and Unix domain socket transports.
+void runTransportBenchmark();
+
+#endif // APP_BENCH_HPP
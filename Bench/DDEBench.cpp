@@ -0,0 +1,546 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBench.cpp
+//! \brief  The benchmark for the DDE client and server classes.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Bench.hpp"
+#include <NCL/DDEBroker.hpp>
+#include <NCL/DDEClient.hpp>
+#include <NCL/DDECltConvPtr.hpp>
+#include <NCL/DDEServer.hpp>
+#include <NCL/DDESvrConv.hpp>
+#include <NCL/DDEData.hpp>
+#include <NCL/DDELink.hpp>
+#include <NCL/DDETextTable.hpp>
+#include <NCL/DDEXlTable.hpp>
+#include <NCL/DefDDEClientListener.hpp>
+#include <NCL/DefDDEServerListener.hpp>
+#include <WCL/StrArray.hpp>
+#include <vector>
+
+namespace
+{
+
+//! The service name.
+const tchar* SERVICE = TXT("NCL_BENCH");
+
+//! The topic name.
+const tchar* TOPIC = TXT("BENCH_TOPIC");
+
+//! The value for every item.
+const tchar* VALUE = TXT("1234.5678");
+
+//! The number of transactions made for each measurement.
+const size_t NUM_TRANSACTIONS = 20000;
+
+//! The number of items linked for the fan-out measurement.
+const size_t NUM_ITEMS = 100;
+
+//! The number of items linked for the link lookup measurement.
+const size_t NUM_LINKS = 50000;
+
+//! The number of conversions made for each text payload measurement.
+const size_t NUM_CONVERSIONS = 2000;
+
+//! The number of rows in the table parsing measurement.
+const size_t NUM_TABLE_ROWS = 10000;
+
+//! The number of columns in the table parsing measurement.
+const size_t NUM_TABLE_COLUMNS = 20;
+
+//! The number of times the table is parsed.
+const size_t NUM_TABLE_PARSES = 100;
+
+//! The number of times each table format is encoded and decoded.
+const size_t NUM_TABLE_CODINGS = 10;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The server side of the benchmark, which serves a constant value for every
+//! item and remembers the advise loops so that it can post updates.
+
+class BenchServer : public CDefDDEServerListener
+{
+public:
+	//! Constructor.
+	BenchServer(CDDEServer& server)
+		: m_server(server)
+	{
+		m_server.AddListener(this);
+		m_server.Register(SERVICE);
+	}
+
+	//! Destructor.
+	~BenchServer()
+	{
+		m_server.Unregister(SERVICE);
+		m_server.RemoveListener(this);
+	}
+
+	//! Post an update for a single advise loop.
+	void postUpdate(size_t link)
+	{
+		m_convs[link]->PostLinkUpdate(m_links[link]);
+	}
+
+	//! Post an update for every advise loop in one batch.
+	void postAllUpdates()
+	{
+		m_server.PostLinkUpdates(m_updated);
+	}
+
+	//! The conversation for the first advise loop.
+	CDDESvrConv* firstConv() const
+	{
+		return m_convs.front();
+	}
+
+	//! Forget the advise loops.
+	void clearLinks()
+	{
+		m_convs.clear();
+		m_links.clear();
+		m_updated.clear();
+	}
+
+private:
+	//
+	// Members.
+	//
+	CDDEServer&					m_server;	//!< The DDE server.
+	std::vector<CDDESvrConv*>	m_convs;	//!< The advise loop conversations.
+	std::vector<CDDELink*>		m_links;	//!< The advise loops.
+	CDDELinkUpdates				m_updated;	//!< The advise loops to post as a batch.
+
+	//
+	// IDDEServerListener methods.
+	//
+
+	virtual bool OnConnect(const tchar* /*service*/, const tchar* /*topic*/)
+	{
+		return true;
+	}
+
+	virtual bool OnRequest(CDDESvrConv* /*conversation*/, const tchar* /*item*/, uint /*format*/, CDDEData& data)
+	{
+		data.SetString(VALUE, ANSI_TEXT);
+		return true;
+	}
+
+	virtual bool OnAdviseStart(CDDESvrConv* /*conversation*/, const tchar* /*item*/, uint /*format*/)
+	{
+		return true;
+	}
+
+	virtual void OnAdviseConfirm(CDDESvrConv* conversation, CDDELink* link)
+	{
+		m_convs.push_back(conversation);
+		m_links.push_back(link);
+		m_updated.push_back(link);
+	}
+
+	virtual bool OnAdviseRequest(CDDESvrConv* /*conversation*/, CDDELink* /*link*/, CDDEData& data)
+	{
+		data.SetString(VALUE, ANSI_TEXT);
+		return true;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The client side of the benchmark, which counts the advise loop updates.
+
+class BenchClientListener : public CDefDDEClientListener
+{
+public:
+	//! Constructor.
+	BenchClientListener()
+		: m_updates(0)
+	{
+	}
+
+	virtual void OnAdvise(CDDELink* /*link*/, const CDDEData* /*data*/)
+	{
+		++m_updates;
+	}
+
+	//
+	// Members.
+	//
+	size_t	m_updates;	//!< The number of updates received.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time synchronous request transactions for a single item.
+
+void measureRequests(CDDEClient& client)
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != NUM_TRANSACTIONS; ++i)
+		conv->RequestString(TXT("ITEM"), CF_TEXT);
+
+	reportResult(TXT("DDE request"), TXT("Broker"), NUM_TRANSACTIONS, stopwatch.elapsed());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time request transactions for a number of items made as one batch.
+
+void measureBatchRequests(CDDEClient& client, size_t numItems)
+{
+	DDE::CltConvPtr     conv(client.CreateConversation(SERVICE, TOPIC));
+	CStrArray           items;
+	DDE::RequestResults results;
+
+	for (size_t i = 0; i != numItems; ++i)
+		items.Add(Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)).c_str());
+
+	const size_t batches = NUM_TRANSACTIONS / numItems;
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != batches; ++i)
+		conv->RequestMany(items, CF_TEXT, results);
+
+	reportResult(TXT("DDE request"), Core::fmt(TXT("Broker batch (%u items)"), static_cast<uint>(numItems)), batches * numItems, stopwatch.elapsed());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time advise loop updates spread across a number of items.
+
+void measureAdvises(CDDEClient& client, BenchServer& server, BenchClientListener& listener, size_t numItems)
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	for (size_t i = 0; i != numItems; ++i)
+		conv->CreateLink(Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)).c_str(), CF_TEXT);
+
+	listener.m_updates = 0;
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != NUM_TRANSACTIONS; ++i)
+		server.postUpdate(i % numItems);
+
+	const double seconds = stopwatch.elapsed();
+
+	ASSERT(listener.m_updates == NUM_TRANSACTIONS);
+
+	reportResult(TXT("DDE advise"), Core::fmt(TXT("Broker (%u items)"), static_cast<uint>(numItems)), NUM_TRANSACTIONS, seconds);
+
+	conv->DestroyAllLinks();
+	server.clearLinks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time advise loop updates posted as a batch for every item at once.
+
+void measureBatchAdvises(CDDEClient& client, BenchServer& server, BenchClientListener& listener, size_t numItems)
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	for (size_t i = 0; i != numItems; ++i)
+		conv->CreateLink(Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)).c_str(), CF_TEXT);
+
+	const size_t batches = NUM_TRANSACTIONS / numItems;
+
+	listener.m_updates = 0;
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != batches; ++i)
+		server.postAllUpdates();
+
+	const double seconds = stopwatch.elapsed();
+
+	ASSERT(listener.m_updates == (batches * numItems));
+
+	reportResult(TXT("DDE advise"), Core::fmt(TXT("Broker batch (%u items)"), static_cast<uint>(numItems)), batches * numItems, seconds);
+
+	conv->DestroyAllLinks();
+	server.clearLinks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time finding links by item on both ends of a conversation with many links.
+
+void measureLinkLookups(CDDEClient& client, BenchServer& server, size_t numLinks)
+{
+	DDE::CltConvPtr      conv(client.CreateConversation(SERVICE, TOPIC));
+	std::vector<tstring> items;
+
+	for (size_t i = 0; i != numLinks; ++i)
+	{
+		items.push_back(Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)));
+		conv->CreateLink(items.back().c_str(), CF_TEXT);
+	}
+
+	const tstring links = Core::fmt(TXT("%u links"), static_cast<uint>(numLinks));
+
+	Stopwatch clientStopwatch;
+
+	for (size_t i = 0; i != NUM_TRANSACTIONS; ++i)
+		conv->FindLink(items[i % numLinks].c_str(), CF_TEXT);
+
+	reportResult(TXT("DDE link lookup"), Core::fmt(TXT("Client (%s)"), links.c_str()), NUM_TRANSACTIONS, clientStopwatch.elapsed());
+
+	CDDESvrConv* svrConv = server.firstConv();
+
+	Stopwatch serverStopwatch;
+
+	for (size_t i = 0; i != NUM_TRANSACTIONS; ++i)
+		svrConv->FindLink(items[i % numLinks].c_str(), CF_TEXT);
+
+	reportResult(TXT("DDE link lookup"), Core::fmt(TXT("Server (%s)"), links.c_str()), NUM_TRANSACTIONS, serverStopwatch.elapsed());
+
+	conv->DestroyAllLinks();
+	server.clearLinks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time subscribing to and unsubscribing from many items, one link at a time
+//! and as a batch.
+
+void measureLinkSubscriptions(CDDEClient& client, BenchServer& server, size_t numLinks)
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+	CStrArray       items;
+	CDDECltLinks    links;
+
+	for (size_t i = 0; i != numLinks; ++i)
+		items.Add(Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)).c_str());
+
+	const tstring variant = Core::fmt(TXT("%u links"), static_cast<uint>(numLinks));
+
+	Stopwatch createStopwatch;
+
+	for (size_t i = 0; i != numLinks; ++i)
+		conv->CreateLink(items[i], CF_TEXT);
+
+	reportResult(TXT("DDE link create"), variant, numLinks, createStopwatch.elapsed());
+
+	Stopwatch destroyStopwatch;
+
+	for (size_t i = 0; i != numLinks; ++i)
+		conv->DestroyLink(conv->GetLink(0));
+
+	reportResult(TXT("DDE link destroy"), variant, numLinks, destroyStopwatch.elapsed());
+	server.clearLinks();
+
+	Stopwatch batchCreateStopwatch;
+
+	conv->CreateLinks(items, CF_TEXT, links);
+
+	reportResult(TXT("DDE link create"), Core::fmt(TXT("Batch (%s)"), variant.c_str()), numLinks, batchCreateStopwatch.elapsed());
+
+	Stopwatch batchDestroyStopwatch;
+
+	conv->DestroyLinks(links);
+
+	reportResult(TXT("DDE link destroy"), Core::fmt(TXT("Batch (%s)"), variant.c_str()), numLinks, batchDestroyStopwatch.elapsed());
+	server.clearLinks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time extracting and storing a text payload of the given size in both text
+//! formats. One of the formats is always converted to the build's character
+//! type.
+
+void measureTextConversions(CDDEClient& client, size_t size)
+{
+	tstring text;
+
+	while (text.length() < size)
+		text += VALUE;
+
+	text.resize(size);
+
+	const CString value(text.c_str());
+	const tstring payload = Core::fmt(TXT("%u KB"), static_cast<uint>(size / 1024));
+
+	const uint   formats[] = { CF_TEXT, CF_UNICODETEXT };
+	const tchar* names[]   = { TXT("CF_TEXT"), TXT("CF_UNICODETEXT") };
+
+	for (size_t f = 0; f != ARRAY_SIZE(formats); ++f)
+	{
+		const TextFormat encoding = (formats[f] == CF_TEXT) ? ANSI_TEXT : UNICODE_TEXT;
+		const tstring    variant = Core::fmt(TXT("%s (%s)"), names[f], payload.c_str());
+
+		CDDEData data(&client, static_cast<HSZ>(NULL), formats[f], true);
+
+		data.SetString(value, encoding);
+
+		Stopwatch getStopwatch;
+
+		for (size_t i = 0; i != NUM_CONVERSIONS; ++i)
+			data.GetString(encoding);
+
+		reportResult(TXT("DDE text get"), variant, NUM_CONVERSIONS, getStopwatch.elapsed());
+
+		Stopwatch setStopwatch;
+
+		for (size_t i = 0; i != NUM_CONVERSIONS; ++i)
+			data.SetString(value, encoding);
+
+		reportResult(TXT("DDE text set"), variant, NUM_CONVERSIONS, setStopwatch.elapsed());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time decoding a spreadsheet style CF_TEXT table in place.
+
+void measureTableParsing(CDDEClient& client, size_t numRows, size_t numColumns)
+{
+	std::string text;
+
+	for (size_t row = 0; row != numRows; ++row)
+	{
+		for (size_t column = 0; column != numColumns; ++column)
+		{
+			if (column != 0)
+				text += '\t';
+
+			text += "1234.5678";
+		}
+
+		text += "\r\n";
+	}
+
+	const CDDEData  data(&client, text.c_str(), text.length()+1, 0, CF_TEXT, true);
+	CDDEData::CView view(data);
+	DDE::TextTable  table;
+
+	const tstring cells = Core::fmt(TXT("%u x %u cells"), static_cast<uint>(numRows), static_cast<uint>(numColumns));
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != NUM_TABLE_PARSES; ++i)
+		table.Parse(reinterpret_cast<const char*>(view.Data()), view.Size());
+
+	reportResult(TXT("DDE text table parse"), cells, NUM_TABLE_PARSES, stopwatch.elapsed());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time encoding and decoding a table of numbers in the XlTable format and as
+//! tab delimited CF_TEXT, which has to be formatted and parsed a cell at a time.
+
+void measureTableFormats(CDDEClient& client, size_t numRows, size_t numColumns)
+{
+	const tstring cells = Core::fmt(TXT("%u x %u cells"), static_cast<uint>(numRows), static_cast<uint>(numColumns));
+
+	CDDEData xlData(&client, static_cast<HSZ>(NULL), DDE::xlTableFormat(), true);
+	CDDEData textData(&client, static_cast<HSZ>(NULL), CF_TEXT, true);
+
+	Stopwatch xlEncodeStopwatch;
+
+	for (size_t i = 0; i != NUM_TABLE_CODINGS; ++i)
+	{
+		DDE::XlTableWriter writer(xlData, numRows, numColumns);
+
+		for (size_t cell = 0; cell != (numRows * numColumns); ++cell)
+			writer.WriteNumber(cell + 0.5);
+
+		writer.End();
+	}
+
+	reportResult(TXT("DDE table encode"), Core::fmt(TXT("XlTable (%s)"), cells.c_str()), NUM_TABLE_CODINGS, xlEncodeStopwatch.elapsed());
+
+	Stopwatch textEncodeStopwatch;
+
+	for (size_t i = 0; i != NUM_TABLE_CODINGS; ++i)
+	{
+		tstring text;
+
+		for (size_t row = 0; row != numRows; ++row)
+		{
+			for (size_t column = 0; column != numColumns; ++column)
+			{
+				if (column != 0)
+					text += TXT('\t');
+
+				text += Core::fmt(TXT("%g"), (row * numColumns) + column + 0.5);
+			}
+
+			text += TXT("\r\n");
+		}
+
+		textData.SetString(CString(text.c_str()), ANSI_TEXT);
+	}
+
+	reportResult(TXT("DDE table encode"), Core::fmt(TXT("CF_TEXT (%s)"), cells.c_str()), NUM_TABLE_CODINGS, textEncodeStopwatch.elapsed());
+
+	double total = 0.0;
+
+	Stopwatch xlDecodeStopwatch;
+
+	for (size_t i = 0; i != NUM_TABLE_CODINGS; ++i)
+	{
+		CDDEData::CView          view(xlData);
+		DDE::XlTableReader       reader(view);
+		DDE::XlTableReader::Cell cell;
+
+		while (reader.Next(cell))
+			total += cell.m_number;
+	}
+
+	reportResult(TXT("DDE table decode"), Core::fmt(TXT("XlTable (%s)"), cells.c_str()), NUM_TABLE_CODINGS, xlDecodeStopwatch.elapsed());
+
+	Stopwatch textDecodeStopwatch;
+
+	for (size_t i = 0; i != NUM_TABLE_CODINGS; ++i)
+	{
+		CDDEData::CView view(textData);
+		DDE::TextTable  table(view);
+		double          value = 0.0;
+
+		for (size_t row = 0; row != table.Rows(); ++row)
+		{
+			for (size_t column = 0; column != table.Columns(row); ++column)
+			{
+				if (table.ParseNumber(row, column, value))
+					total += value;
+			}
+		}
+	}
+
+	reportResult(TXT("DDE table decode"), Core::fmt(TXT("CF_TEXT (%s)"), cells.c_str()), NUM_TABLE_CODINGS, textDecodeStopwatch.elapsed());
+
+	ASSERT(total > 0.0);
+}
+
+//namespace
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure DDE request and advise throughput through the in-process broker.
+
+void runDDEBenchmark()
+{
+	DDE::DDEBroker::install();
+
+	{
+		CDDEClient          client;
+		CDDEServer          ddeServer;
+		BenchServer         server(ddeServer);
+		BenchClientListener listener;
+
+		client.AddListener(&listener);
+
+		measureRequests(client);
+		measureBatchRequests(client, NUM_ITEMS);
+		measureAdvises(client, server, listener, 1);
+		measureAdvises(client, server, listener, NUM_ITEMS);
+		measureBatchAdvises(client, server, listener, NUM_ITEMS);
+		measureLinkLookups(client, server, NUM_LINKS);
+		measureLinkSubscriptions(client, server, NUM_LINKS);
+		measureTextConversions(client, 1024);
+		measureTextConversions(client, 64 * 1024);
+		measureTableParsing(client, NUM_TABLE_ROWS, NUM_TABLE_COLUMNS);
+		measureTableFormats(client, NUM_TABLE_ROWS, NUM_TABLE_COLUMNS);
+
+		client.RemoveListener(&listener);
+	}
+
+	DDE::DDEBroker::uninstall();
+}
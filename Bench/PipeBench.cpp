@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PipeBench.cpp
+//! \brief  The benchmark comparing the named pipe and shared memory transports.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Bench.hpp"
+#include <tchar.h>
+#include <NCL/ServerPipe.hpp>
+#include <NCL/ClientPipe.hpp>
+#include <NCL/SharedMemPipe.hpp>
+#include <NCL/PipeException.hpp>
+
+namespace
+{
+
+//! The name of the named pipe.
+const tchar* PIPE_NAME = TXT("\\\\.\\pipe\\ncl-bench");
+
+//! The name of the shared memory pipe.
+const tchar* SHARED_MEM_NAME = TXT("ncl-bench-shm");
+
+//! The number of round-trips made for each transport.
+const size_t NUM_ROUND_TRIPS = 20000;
+
+//! The size of each message.
+const size_t MESSAGE_SIZE = 64;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The thread which echoes each message back to the sender.
+
+template<typename Pipe>
+DWORD WINAPI echoMessages(LPVOID param)
+{
+	Pipe* pipe = static_cast<Pipe*>(param);
+	byte  buffer[MESSAGE_SIZE];
+
+	try
+	{
+		for (size_t i = 0; i != NUM_ROUND_TRIPS; ++i)
+		{
+			pipe->Read(buffer, sizeof(buffer));
+			pipe->Write(buffer, sizeof(buffer));
+		}
+	}
+	catch (const CPipeException& e)
+	{
+		_tprintf(TXT("Echo thread failed: %s\n"), e.twhat());
+		return 1;
+	}
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time ping-pong round-trips between a pair of connected pipe ends. The
+//! remote end is serviced by another thread so that the cost of waking the
+//! reader is included.
+
+template<typename Pipe>
+void measureRoundTrips(const tchar* transport, Pipe& local, Pipe& remote)
+{
+	byte request[MESSAGE_SIZE]  = { 0 };
+	byte response[MESSAGE_SIZE] = { 0 };
+
+	HANDLE thread = ::CreateThread(nullptr, 0, echoMessages<Pipe>, &remote, 0, nullptr);
+
+	if (thread == NULL)
+		throw CPipeException(CPipeException::E_CREATE_FAILED, ::GetLastError());
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != NUM_ROUND_TRIPS; ++i)
+	{
+		local.Write(request, sizeof(request));
+		local.Read(response, sizeof(response));
+	}
+
+	const double seconds = stopwatch.elapsed();
+
+	::WaitForSingleObject(thread, INFINITE);
+	::CloseHandle(thread);
+
+	reportResult(TXT("Ping-pong (64 bytes)"), transport, NUM_ROUND_TRIPS, seconds);
+}
+
+//namespace
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare the latency of the named pipe and shared memory transports.
+
+void runPipeBenchmark()
+{
+	{
+		CServerPipe server;
+
+		server.Create(PIPE_NAME);
+
+		CClientPipe client;
+
+		client.Open(PIPE_NAME);
+
+		while (!server.Accept())
+			::Sleep(0);
+
+		measureRoundTrips<CNamedPipe>(TXT("Named pipe"), server, client);
+	}
+
+	{
+		CSharedMemPipe server;
+
+		server.Create(SHARED_MEM_NAME);
+
+		CSharedMemPipe client;
+
+		client.Open(SHARED_MEM_NAME);
+
+		measureRoundTrips(TXT("Shared memory"), server, client);
+	}
+}
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCBench.cpp
+//! \brief  The benchmark for the RPC client session and server dispatcher.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Bench.hpp"
+#include <tchar.h>
+#include <NCL/WinSock.hpp>
+#include <NCL/TCPSvrSocket.hpp>
+#include <NCL/TCPCltSocket.hpp>
+#include <NCL/RPCCltSession.hpp>
+#include <NCL/RPCSvrDispatcher.hpp>
+#include <NCL/IRPCRequestHandler.hpp>
+#include <NCL/IRPCResponseHandler.hpp>
+
+namespace
+{
+
+//! The port used for the loopback connection.
+const uint BENCH_PORT = 50126;
+
+//! The method used for the echo request.
+const WORD ECHO_METHOD = 1;
+
+//! The number of requests made at each depth.
+const size_t NUM_REQUESTS = 20000;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The server handler which echoes the request payload back.
+
+class EchoHandler : public RPC::IRequestHandler
+{
+public:
+	virtual WORD OnRequest(CSocket& /*client*/, WORD method, const byte* payload, size_t size, CNetBuffer& response)
+	{
+		if (method != ECHO_METHOD)
+			return RPC::UNKNOWN_METHOD;
+
+		if (size != 0)
+			response.Append(payload, size);
+
+		return RPC::OK;
+	}
+
+	virtual void OnClientClosed(CSocket& /*client*/)
+	{
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The client handler which counts the completed requests.
+
+class CompletionCounter : public RPC::IResponseHandler
+{
+public:
+	CompletionCounter()
+		: m_completed(0), m_failed(0)
+	{ }
+
+	size_t Done() const
+	{
+		return m_completed + m_failed;
+	}
+
+	virtual void OnResponse(RPC::CltSession& /*session*/, DWORD /*id*/, WORD /*status*/, const byte* /*payload*/, size_t /*size*/)
+	{
+		++m_completed;
+	}
+
+	virtual void OnFailed(RPC::CltSession& /*session*/, DWORD /*id*/, int /*reason*/)
+	{
+		++m_failed;
+	}
+
+	size_t	m_completed;
+	size_t	m_failed;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait for, and then process, any socket events.
+
+void pumpSocketMsgs()
+{
+	::MsgWaitForMultipleObjects(0, nullptr, FALSE, 10, QS_ALLINPUT);
+
+	CWinSock::ProcessSocketMsgs();
+}
+
+//namespace
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure RPC round-trips over a loopback connection. A depth of 1 is the
+//! classic one request at a time latency, larger depths keep that many
+//! requests in flight to show the effect of pipelining.
+
+void runRPCBenchmark()
+{
+	const size_t depths[] = { 1, 4, 16, 64, 256 };
+
+	CTCPSvrSocket     server(CSocket::ASYNC);
+	EchoHandler       handler;
+
+	server.Listen(BENCH_PORT);
+
+	RPC::SvrDispatcher dispatcher(server, handler);
+
+	CTCPCltSocket client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), BENCH_PORT);
+
+	RPC::CltSession session(client);
+	byte            payload[64] = { 0 };
+
+	// Wait for the connection to be accepted.
+	while (dispatcher.ClientCount() == 0)
+		pumpSocketMsgs();
+
+	for (size_t d = 0; d != ARRAY_SIZE(depths); ++d)
+	{
+		const size_t      depth = depths[d];
+		CompletionCounter counter;
+		size_t            sent = 0;
+		Stopwatch         stopwatch;
+
+		while (counter.Done() != NUM_REQUESTS)
+		{
+			// Top up the requests in flight.
+			session.BeginBatch();
+
+			while ( ((sent - counter.Done()) < depth) && (sent != NUM_REQUESTS) )
+			{
+				session.Call(ECHO_METHOD, payload, sizeof(payload), &counter);
+				++sent;
+			}
+
+			session.EndBatch();
+
+			pumpSocketMsgs();
+		}
+
+		const double seconds = stopwatch.elapsed();
+
+		if (counter.m_failed != 0)
+			_tprintf(TXT("WARNING: %u requests failed\n"), static_cast<uint>(counter.m_failed));
+
+		reportResult(TXT("RPC echo (64 bytes)"), Core::fmt(TXT("depth %u"), static_cast<uint>(depth)), NUM_REQUESTS, seconds);
+	}
+
+	dispatcher.CloseClients();
+}
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TransportBench.cpp
+//! \brief  The benchmark comparing the TCP and Unix domain socket transports.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Bench.hpp"
+#include <tchar.h>
+#include <NCL/TCPSvrSocket.hpp>
+#include <NCL/TCPCltSocket.hpp>
+#include <NCL/UnixSvrSocket.hpp>
+#include <NCL/UnixCltSocket.hpp>
+#include <NCL/SocketException.hpp>
+#include <Core/SharedPtr.hpp>
+
+namespace
+{
+
+//! The port used for the TCP loopback connection.
+const uint BENCH_PORT = 50127;
+
+//! The path used for the Unix domain socket.
+const tchar* BENCH_PATH = TXT("ncl-bench.sock");
+
+//! The number of round-trips made for each transport.
+const size_t NUM_ROUND_TRIPS = 20000;
+
+//! The size of each message.
+const size_t MESSAGE_SIZE = 64;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read exactly the number of bytes requested from a blocking socket.
+
+void recvAll(CSocket& socket, byte* buffer, size_t size)
+{
+	size_t received = 0;
+
+	while (received != size)
+	{
+		size_t count = socket.Recv(buffer+received, size-received);
+
+		if (count == 0)
+			throw CSocketException(CSocketException::E_DISCONNECTED, WSAESHUTDOWN);
+
+		received += count;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time ping-pong round-trips between a connected pair of blocking sockets.
+//! Both ends are driven from this thread so that only the transport cost is
+//! being measured.
+
+void measureRoundTrips(const tchar* transport, CSocket& client, CSocket& server)
+{
+	byte request[MESSAGE_SIZE]  = { 0 };
+	byte response[MESSAGE_SIZE] = { 0 };
+
+	Stopwatch stopwatch;
+
+	for (size_t i = 0; i != NUM_ROUND_TRIPS; ++i)
+	{
+		client.Send(request, sizeof(request));
+		recvAll(server, response, sizeof(response));
+
+		server.Send(response, sizeof(response));
+		recvAll(client, request, sizeof(request));
+	}
+
+	const double seconds = stopwatch.elapsed();
+
+	reportResult(TXT("Ping-pong (64 bytes)"), transport, NUM_ROUND_TRIPS, seconds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure the round-trips over a Unix domain socket of the given type.
+
+void measureUnixSocket(const tchar* transport, int type)
+{
+	try
+	{
+		CUnixSvrSocket listener(CSocket::BLOCK, type);
+
+		listener.Listen(BENCH_PATH);
+
+		CUnixCltSocket client(CSocket::BLOCK, type);
+
+		client.Connect(BENCH_PATH);
+
+		Core::SharedPtr<CTCPCltSocket> server(listener.Accept());
+
+		measureRoundTrips(transport, client, *server);
+	}
+	catch (const CSocketException& e)
+	{
+		_tprintf(TXT("%-20s %-24s unavailable: %s\n"), TXT("Ping-pong (64 bytes)"), transport, e.twhat());
+	}
+}
+
+//namespace
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare the latency of the socket transports between two local endpoints.
+
+void runTransportBenchmark()
+{
+	{
+		CTCPSvrSocket listener(CSocket::BLOCK);
+
+		listener.Listen(BENCH_PORT);
+
+		CTCPCltSocket client(CSocket::BLOCK);
+
+		client.Connect(TXT("localhost"), BENCH_PORT);
+
+		Core::SharedPtr<CTCPCltSocket> server(listener.Accept());
+
+		BOOL noDelay = TRUE;
+
+		::setsockopt(client.Handle(),  IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+		::setsockopt(server->Handle(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+		measureRoundTrips(TXT("TCP loopback"), client, *server);
+	}
+
+	measureUnixSocket(TXT("Unix SOCK_STREAM"), SOCK_STREAM);
+	measureUnixSocket(TXT("Unix SOCK_SEQPACKET"), SOCK_SEQPACKET);
+}
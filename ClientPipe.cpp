@@ -21,7 +21,8 @@
 
 const DWORD CClientPipe::DEF_OPEN_MODE = /*FILE_ATTRIBUTE_NORMAL |*/ FILE_FLAG_OVERLAPPED;
 const DWORD CClientPipe::DEF_PIPE_MODE = PIPE_READMODE_MESSAGE | PIPE_WAIT;
-const DWORD CClientPipe::DEF_INTERVAL  = 1000;
+const DWORD CClientPipe::MIN_BACKOFF   = 10;
+const DWORD CClientPipe::MAX_BACKOFF   = 1000;
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -36,6 +37,11 @@ const DWORD CClientPipe::DEF_INTERVAL  = 1000;
 */
 
 CClientPipe::CClientPipe()
+	: m_dwBackOff(MIN_BACKOFF)
+	, m_dwSeed(::GetTickCount() ^ ::GetCurrentThreadId())
+	, m_bOpening(false)
+	, m_dwOpenStart(0)
+	, m_hOpenTimer(NULL)
 {
 }
 
@@ -54,6 +60,9 @@ CClientPipe::CClientPipe()
 CClientPipe::~CClientPipe()
 {
 	Close();
+
+	if (m_hOpenTimer != NULL)
+		::CloseHandle(m_hOpenTimer);
 }
 
 /******************************************************************************
@@ -72,30 +81,241 @@ CClientPipe::~CClientPipe()
 
 void CClientPipe::Open(const tchar* pszName)
 {
-	// Calculate max wait time.
-	DWORD dwMaxTime = ::GetTickCount() + m_dwTimeOut;
+	ASSERT(m_hPipe == INVALID_HANDLE_VALUE);
+	ASSERT(!IsOpening());
+
+	Attach(Connect(pszName));
+
+	m_strName = pszName;
+}
+
+/******************************************************************************
+** Method:		BeginOpen()
+**
+** Description:	Start opening an existing named pipe without blocking. The
+**				OpenCompleteEvent() is signalled when EndOpen() should be called
+**				to make the next attempt, until it returns true or throws.
+**
+** Parameters:	pszName		The pipes' name.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CClientPipe::BeginOpen(const tchar* pszName)
+{
+	ASSERT(m_hPipe == INVALID_HANDLE_VALUE);
+	ASSERT(!IsOpening());
+
+	// First use?
+	if (m_hOpenTimer == NULL)
+	{
+		m_hOpenTimer = ::CreateWaitableTimer(nullptr, TRUE, nullptr);
+
+		if (m_hOpenTimer == NULL)
+			throw CPipeException(CPipeException::E_OPEN_FAILED, ::GetLastError());
+	}
+
+	m_strName     = pszName;
+	m_dwOpenStart = ::GetTickCount();
+	m_dwBackOff   = MIN_BACKOFF;
+
+	// Make the first attempt straight away.
+	ScheduleRetry(0);
+
+	m_bOpening = true;
+}
+
+/******************************************************************************
+** Method:		EndOpen()
+**
+** Description:	Make the next attempt at opening the pipe started by
+**				BeginOpen(), if it is due. When the server is missing, or all
+**				its instances are busy, the next attempt is scheduled after a
+**				back-off with some jitter.
+**				NB: Unlike Open() a busy server is polled, as WaitNamedPipe()
+**				has no asynchronous form.
+**
+** Parameters:	None.
+**
+** Returns:		true if open or false if still in progress.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+bool CClientPipe::EndOpen()
+{
+	ASSERT(IsOpening());
+
+	// Next attempt not due yet?
+	if (::WaitForSingleObject(m_hOpenTimer, 0) == WAIT_TIMEOUT)
+		return false;
+
+	// NB: Any failure ends the open.
+	m_bOpening = false;
+
+	DWORD  dwError = NO_ERROR;
+	HANDLE hPipe   = TryConnect(m_strName.c_str(), dwError);
+
+	// Connected?
+	if (hPipe != INVALID_HANDLE_VALUE)
+	{
+		Attach(hPipe);
+		return true;
+	}
+
+	DWORD dwElapsed = ::GetTickCount() - m_dwOpenStart;
+
+	// Timed out?
+	if (dwElapsed >= m_dwTimeOut)
+		throw CPipeException(CPipeException::E_OPEN_FAILED, dwError);
+
+	ScheduleRetry(std::min(NextBackOff(), m_dwTimeOut - dwElapsed));
+
+	m_bOpening = true;
+
+	return false;
+}
+
+/******************************************************************************
+** Method:		Connect()
+**
+** Description:	Connect to a server pipe instance. When all instances are busy
+**				the kernel notifies us, via WaitNamedPipe(), when one becomes
+**				free. When the pipe doesn't exist, or another client got the
+**				free instance first, the retries back off with some jitter.
+**
+** Parameters:	pszName		The pipes' name.
+**
+** Returns:		The pipe handle.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+HANDLE CClientPipe::Connect(const tchar* pszName)
+{
+	DWORD dwStart = ::GetTickCount();
 
-	while (::GetTickCount() < dwMaxTime)
+	m_dwBackOff = MIN_BACKOFF;
+
+	for (;;)
 	{
-		::WaitNamedPipe(pszName, DEF_INTERVAL);
+		DWORD  dwError = NO_ERROR;
+		HANDLE hPipe   = TryConnect(pszName, dwError);
+
+		if (hPipe != INVALID_HANDLE_VALUE)
+			return hPipe;
 
-		// Try and open the pipe.
-		m_hPipe = ::CreateFile(pszName, GENERIC_READWRITE, 0, nullptr, OPEN_EXISTING, DEF_OPEN_MODE, NULL);
+		DWORD dwElapsed = ::GetTickCount() - dwStart;
 
-		// Success OR NOT server busy?
-		if ( (m_hPipe != INVALID_HANDLE_VALUE) || (::GetLastError() != ERROR_PIPE_BUSY) )
-			break;
+		// Timed out?
+		if (dwElapsed >= m_dwTimeOut)
+			throw CPipeException(CPipeException::E_OPEN_FAILED, dwError);
+
+		// Wait for a free instance?
+		if ( (dwError == ERROR_PIPE_BUSY) && (::WaitNamedPipe(pszName, m_dwTimeOut - dwElapsed)) )
+			continue;
+
+		// The wait may have used up the time left.
+		dwElapsed = ::GetTickCount() - dwStart;
+
+		if (dwElapsed < m_dwTimeOut)
+			::Sleep(std::min(NextBackOff(), m_dwTimeOut - dwElapsed));
 	}
+}
+
+/******************************************************************************
+** Method:		TryConnect()
+**
+** Description:	Make a single attempt at connecting to a server pipe instance.
+**
+** Parameters:	pszName		The pipes' name.
+**				dwError		The error if the server is busy or missing.
+**
+** Returns:		The pipe handle or INVALID_HANDLE_VALUE if worth retrying.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+HANDLE CClientPipe::TryConnect(const tchar* pszName, DWORD& dwError)
+{
+	// Try and open the pipe.
+	HANDLE hPipe = ::CreateFile(pszName, GENERIC_READWRITE, 0, nullptr, OPEN_EXISTING, DEF_OPEN_MODE, NULL);
+
+	if (hPipe != INVALID_HANDLE_VALUE)
+		return hPipe;
+
+	dwError = ::GetLastError();
+
+	// NOT server busy or missing?
+	if ( (dwError != ERROR_PIPE_BUSY) && (dwError != ERROR_FILE_NOT_FOUND) )
+		throw CPipeException(CPipeException::E_OPEN_FAILED, dwError);
+
+	return INVALID_HANDLE_VALUE;
+}
+
+/******************************************************************************
+** Method:		ScheduleRetry()
+**
+** Description:	Set the OpenCompleteEvent() to be signalled after a delay.
+**
+** Parameters:	dwDelay		The delay in ms.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CClientPipe::ScheduleRetry(DWORD dwDelay)
+{
+	LARGE_INTEGER liDueTime;
 
-	// Create failed?
-	if (m_hPipe == INVALID_HANDLE_VALUE)
+	// Relative time, in 100ns units.
+	liDueTime.QuadPart = -static_cast<LONGLONG>(std::max<DWORD>(dwDelay, 1)) * 10000;
+
+	if (::SetWaitableTimer(m_hOpenTimer, &liDueTime, 0, nullptr, nullptr, FALSE) == 0)
 		throw CPipeException(CPipeException::E_OPEN_FAILED, ::GetLastError());
+}
+
+/******************************************************************************
+** Method:		Attach()
+**
+** Description:	Take ownership of the opened pipe and switch it to message mode.
+**
+** Parameters:	hPipe		The pipe handle.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CClientPipe::Attach(HANDLE hPipe)
+{
+	m_hPipe = hPipe;
 
 	DWORD dwPipeMode = DEF_PIPE_MODE;
 
 	// Switch pipe to message mode.
 	if (::SetNamedPipeHandleState(m_hPipe, &dwPipeMode, nullptr, nullptr) == 0)
-		throw CPipeException(CPipeException::E_OPEN_FAILED, ::GetLastError());
+	{
+		DWORD dwError = ::GetLastError();
+
+		Close();
+		throw CPipeException(CPipeException::E_OPEN_FAILED, dwError);
+	}
 }
 
 /******************************************************************************
@@ -112,5 +332,13 @@ void CClientPipe::Open(const tchar* pszName)
 
 void CClientPipe::Close()
 {
+	// Abandon any background open.
+	if (m_bOpening)
+	{
+		::CancelWaitableTimer(m_hOpenTimer);
+
+		m_bOpening = false;
+	}
+
 	CNamedPipe::Close();
 }
@@ -17,6 +17,7 @@
 #endif
 
 #include "NamedPipe.hpp"
+#include <algorithm>
 
 /******************************************************************************
 ** 
@@ -39,19 +40,39 @@ public:
 	//
 	void Open(const tchar* pszName);
 
+	void BeginOpen(const tchar* pszName);
+	bool EndOpen();
+	bool IsOpening() const;
+	HANDLE OpenCompleteEvent() const;	// Signalled when EndOpen() is due.
+
 	virtual void Close();
 
 protected:
 	//
 	// Members.
 	//
+	DWORD		m_dwBackOff;	// Current retry back-off, in ms.
+	DWORD		m_dwSeed;		// Back-off jitter random seed.
+	bool		m_bOpening;		// BeginOpen() in progress?
+	DWORD		m_dwOpenStart;	// When BeginOpen() was called.
+	HANDLE		m_hOpenTimer;	// Signalled when the next retry is due.
 
 	//
 	// Constants.
 	//
 	static const DWORD DEF_OPEN_MODE;
 	static const DWORD DEF_PIPE_MODE;
-	static const DWORD DEF_INTERVAL;
+	static const DWORD MIN_BACKOFF;
+	static const DWORD MAX_BACKOFF;
+
+	//
+	// Internal methods.
+	//
+	DWORD  NextBackOff();
+	HANDLE Connect(const tchar* pszName);
+	HANDLE TryConnect(const tchar* pszName, DWORD& dwError);
+	void   ScheduleRetry(DWORD dwDelay);
+	void   Attach(HANDLE hPipe);
 };
 
 /******************************************************************************
@@ -61,4 +82,30 @@ protected:
 *******************************************************************************
 */
 
+inline bool CClientPipe::IsOpening() const
+{
+	return m_bOpening;
+}
+
+inline HANDLE CClientPipe::OpenCompleteEvent() const
+{
+	return m_hOpenTimer;
+}
+
+// Calculate the delay before the next retry. It is chosen at random from the
+// upper half of the back-off, so that clients that failed together don't retry
+// together, and the back-off is then doubled.
+
+inline DWORD CClientPipe::NextBackOff()
+{
+	m_dwSeed = (m_dwSeed * 1103515245) + 12345;
+
+	DWORD dwHalf  = m_dwBackOff / 2;
+	DWORD dwDelay = dwHalf + ((m_dwSeed >> 16) % (dwHalf + 1));
+
+	m_dwBackOff = std::min(m_dwBackOff * 2, MAX_BACKOFF);
+
+	return dwDelay;
+}
+
 #endif // CLIENTPIPE_HPP
@@ -20,6 +20,9 @@
 //! \namespace DDE
 //! \brief     The Dynamic Data Exchange namespace.
 //!
+//! \namespace RPC
+//! \brief     The socket based Remote Procedure Call namespace.
+//!
 //! \mainpage  Network & Comms C++ Library
 //! \section   introduction Introduction
 //! This is a class library for Inter Process Communication.
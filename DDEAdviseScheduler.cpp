@@ -0,0 +1,310 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEAdviseScheduler.cpp
+//! \brief  The AdviseScheduler class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEAdviseScheduler.hpp"
+#include "DDEConv.hpp"
+#include "DDELink.hpp"
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+AdviseScheduler::Entry::Entry()
+	: m_lastPost(0)
+	, m_interval(0)
+	, m_posted(false)
+	, m_dirty(false)
+	, m_fixed(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+AdviseScheduler::AdviseScheduler()
+	: m_interval(0)
+	, m_topics()
+	, m_entries()
+	, m_items()
+	, m_dirty()
+	, m_pending(0)
+{
+	ResetStats();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+AdviseScheduler::~AdviseScheduler()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the interval for links with no topic or link interval. An interval of
+//! 0 posts every update immediately.
+
+void AdviseScheduler::SetInterval(DWORD interval)
+{
+	m_interval = interval;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the interval for the links on a topic. The name is not case-sensitive.
+
+void AdviseScheduler::SetInterval(const tchar* topic, DWORD interval)
+{
+	ASSERT(topic != nullptr);
+
+	for (TopicIntervals::iterator it = m_topics.begin(); it != m_topics.end(); ++it)
+	{
+		if (tstricmp(it->first.c_str(), topic) == 0)
+		{
+			it->second = interval;
+			return;
+		}
+	}
+
+	m_topics.push_back(TopicInterval(topic, interval));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the interval for a single link, which overrides any topic interval.
+
+void AdviseScheduler::SetInterval(const CDDELink* link, DWORD interval)
+{
+	ASSERT(link != nullptr);
+
+	Entry& entry = GetEntry(link);
+
+	entry.m_interval = interval;
+	entry.m_fixed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Schedule an update for the link. Returns true if the interval has elapsed
+//! and the update should be posted now, in which case the outcome should be
+//! passed to RecordPost(). Any update pending for another link to the same
+//! topic and item is merged into the post.
+
+bool AdviseScheduler::Schedule(const CDDELink* link, DWORD now)
+{
+	ASSERT(link != nullptr);
+
+	++m_stats.m_updates;
+
+	Entry& entry = GetEntry(link);
+
+	if (entry.m_dirty)
+	{
+		++m_stats.m_coalesced;
+		return false;
+	}
+
+	// The tick count may wrap.
+	if (!entry.m_posted || ((now - entry.m_lastPost) >= Interval(link, entry)))
+	{
+		MarkItemPosted(link, now);
+		return true;
+	}
+
+	entry.m_dirty = true;
+	m_dirty.push_back(link);
+	++m_pending;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the dirty links whose interval has elapsed. The links are marked as
+//! posted and the outcome of posting them should be passed to RecordPosts().
+//! Only one link is returned for each topic and item.
+
+void AdviseScheduler::GetDue(DWORD now, Links& due)
+{
+	size_t kept = 0;
+
+	for (size_t i = 0, n = m_dirty.size(); i != n; ++i)
+	{
+		const CDDELink*   link = m_dirty[i];
+		Entries::iterator it = m_entries.find(link);
+
+		// Removed since it was marked dirty?
+		if ( (it == m_entries.end()) || (!it->second.m_dirty) )
+			continue;
+
+		Entry& entry = it->second;
+
+		if ((now - entry.m_lastPost) >= Interval(link, entry))
+		{
+			entry.m_dirty = false;
+			--m_pending;
+
+			MarkItemPosted(link, now);
+
+			due.push_back(link);
+		}
+		else
+		{
+			m_dirty[kept++] = link;
+		}
+	}
+
+	m_dirty.resize(kept);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the outcome of posting an update.
+
+void AdviseScheduler::RecordPost(bool posted)
+{
+	if (posted)
+		++m_stats.m_posted;
+	else
+		++m_stats.m_dropped;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the outcome of posting a batch of updates.
+
+void AdviseScheduler::RecordPosts(size_t posted, size_t failed)
+{
+	m_stats.m_posted  += posted;
+	m_stats.m_dropped += failed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forget the link, dropping any pending update. This must be called before
+//! the link is destroyed.
+
+void AdviseScheduler::Remove(const CDDELink* link)
+{
+	Entries::iterator it = m_entries.find(link);
+
+	if (it == m_entries.end())
+		return;
+
+	if (it->second.m_dirty)
+	{
+		++m_stats.m_dropped;
+		--m_pending;
+	}
+
+	std::pair<ItemLinks::iterator, ItemLinks::iterator> range = m_items.equal_range(MakeKey(link));
+
+	for (ItemLinks::iterator itLink = range.first; itLink != range.second; ++itLink)
+	{
+		if (itLink->second == link)
+		{
+			m_items.erase(itLink);
+			break;
+		}
+	}
+
+	m_entries.erase(it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reset the update counters.
+
+void AdviseScheduler::ResetStats()
+{
+	m_stats.m_updates   = 0;
+	m_stats.m_posted    = 0;
+	m_stats.m_coalesced = 0;
+	m_stats.m_dropped   = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the state for the link, adding it to the item index if new. A new link
+//! inherits the time of the last post for the item from the other links to it.
+
+AdviseScheduler::Entry& AdviseScheduler::GetEntry(const CDDELink* link)
+{
+	Entries::iterator it = m_entries.find(link);
+
+	if (it != m_entries.end())
+		return it->second;
+
+	ItemKey             key = MakeKey(link);
+	ItemLinks::iterator itSibling = m_items.find(key);
+	Entry&              entry = m_entries[link];
+
+	if (itSibling != m_items.end())
+	{
+		const Entry& sibling = m_entries[itSibling->second];
+
+		entry.m_lastPost = sibling.m_lastPost;
+		entry.m_posted   = sibling.m_posted;
+	}
+
+	m_items.insert(ItemLinks::value_type(key, link));
+
+	return entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Mark every link to the same topic and item as the link as posted. The post
+//! reaches them all, so an update pending for one of them is merged into it.
+
+void AdviseScheduler::MarkItemPosted(const CDDELink* link, DWORD now)
+{
+	std::pair<ItemLinks::iterator, ItemLinks::iterator> range = m_items.equal_range(MakeKey(link));
+
+	for (ItemLinks::iterator itLink = range.first; itLink != range.second; ++itLink)
+	{
+		Entries::iterator it = m_entries.find(itLink->second);
+
+		ASSERT(it != m_entries.end());
+
+		Entry& entry = it->second;
+
+		entry.m_lastPost = now;
+		entry.m_posted = true;
+
+		if (entry.m_dirty)
+		{
+			entry.m_dirty = false;
+			--m_pending;
+			++m_stats.m_coalesced;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the interval that applies to the link. A link interval takes precedence
+//! over a topic interval which takes precedence over the default.
+
+DWORD AdviseScheduler::Interval(const CDDELink* link, const Entry& entry) const
+{
+	if (entry.m_fixed)
+		return entry.m_interval;
+
+	if (!m_topics.empty())
+	{
+		const tchar* topic = link->Conversation()->Topic();
+
+		for (TopicIntervals::const_iterator it = m_topics.begin(); it != m_topics.end(); ++it)
+		{
+			if (tstricmp(it->first.c_str(), topic) == 0)
+				return it->second;
+		}
+	}
+
+	return m_interval;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the topic and item handles for the link.
+
+AdviseScheduler::ItemKey AdviseScheduler::MakeKey(const CDDELink* link)
+{
+	return ItemKey(link->Conversation()->TopicHandle(), link->ItemHandle());
+}
+
+//namespace DDE
+}
@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEAdviseScheduler.hpp
+//! \brief  The AdviseScheduler class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEADVISESCHEDULER_HPP
+#define NCL_DDEADVISESCHEDULER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEFwd.hpp"
+#include <map>
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The advise update counters. Each update scheduled is either posted, merged
+//! into one already pending, dropped or is still pending.
+
+struct AdviseStats
+{
+	size_t	m_updates;		//!< The number of updates scheduled.
+	size_t	m_posted;		//!< The number of updates posted.
+	size_t	m_coalesced;	//!< The number of updates merged with a pending one.
+	size_t	m_dropped;		//!< The number of updates discarded or failed.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Limits the rate at which advise loop updates are posted. An update is posted
+//! immediately if the link's interval has elapsed since its last post,
+//! otherwise the link is marked dirty and any further updates are merged into
+//! it. Because DDEML asks the server for the current value when the update is
+//! posted, only the latest value is ever sent. An update is posted for the
+//! topic and item, and so reaches every link to the item, which is why posting
+//! one link also posts the others and merges any update pending for them. The
+//! interval can be set for all links, a topic or a single link. The times are
+//! in milliseconds and are supplied by the caller.
+
+class AdviseScheduler
+{
+public:
+	//! The links to post.
+	typedef std::vector<const CDDELink*> Links;
+
+public:
+	//! Default constructor.
+	AdviseScheduler();
+
+	//! Destructor.
+	~AdviseScheduler();
+
+	//
+	// Properties.
+	//
+
+	//! The update counters.
+	const AdviseStats& Stats() const;
+
+	//! The number of links with an update pending.
+	size_t PendingCount() const;
+
+	//! Set the interval for links with no topic or link interval.
+	void SetInterval(DWORD interval);
+
+	//! Set the interval for the links on a topic.
+	void SetInterval(const tchar* topic, DWORD interval);
+
+	//! Set the interval for a single link.
+	void SetInterval(const CDDELink* link, DWORD interval);
+
+	//
+	// Methods.
+	//
+
+	//! Schedule an update for the link. Returns true if it should be posted now.
+	bool Schedule(const CDDELink* link, DWORD now);
+
+	//! Get the dirty links whose interval has elapsed.
+	void GetDue(DWORD now, Links& due);
+
+	//! Record the outcome of posting an update.
+	void RecordPost(bool posted);
+
+	//! Record the outcome of posting a batch of updates.
+	void RecordPosts(size_t posted, size_t failed);
+
+	//! Forget the link, dropping any pending update.
+	void Remove(const CDDELink* link);
+
+	//! Reset the update counters.
+	void ResetStats();
+
+private:
+	//! The scheduling state for a link.
+	struct Entry
+	{
+		//! Default constructor.
+		Entry();
+
+		DWORD	m_lastPost;		//!< The time of the last post.
+		DWORD	m_interval;		//!< The link specific interval.
+		bool	m_posted;		//!< Posted at least once?
+		bool	m_dirty;		//!< Update pending?
+		bool	m_fixed;		//!< Has a link specific interval?
+	};
+
+	//! The topic interval type.
+	typedef std::pair<tstring, DWORD> TopicInterval;
+	//! The topic intervals.
+	typedef std::vector<TopicInterval> TopicIntervals;
+	//! The link state keyed by link.
+	typedef std::map<const CDDELink*, Entry> Entries;
+	//! The topic and item handles for a link.
+	typedef std::pair<HSZ, HSZ> ItemKey;
+	//! The links keyed by topic and item.
+	typedef std::multimap<ItemKey, const CDDELink*> ItemLinks;
+
+	//
+	// Members.
+	//
+	DWORD			m_interval;		//!< The default interval.
+	TopicIntervals	m_topics;		//!< The topic intervals.
+	Entries			m_entries;		//!< The link state.
+	ItemLinks		m_items;		//!< The links by topic and item.
+	Links			m_dirty;		//!< The links with an update pending.
+	size_t			m_pending;		//!< The number of links with an update pending.
+	AdviseStats		m_stats;		//!< The update counters.
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the state for the link, adding it if new.
+	Entry& GetEntry(const CDDELink* link);
+
+	//! Mark every link to the same topic and item as the link as posted.
+	void MarkItemPosted(const CDDELink* link, DWORD now);
+
+	//! Get the interval that applies to the link.
+	DWORD Interval(const CDDELink* link, const Entry& entry) const;
+
+	//! Get the topic and item handles for the link.
+	static ItemKey MakeKey(const CDDELink* link);
+
+	// NotCopyable.
+	AdviseScheduler(const AdviseScheduler&);
+	AdviseScheduler& operator=(const AdviseScheduler&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The update counters.
+
+inline const AdviseStats& AdviseScheduler::Stats() const
+{
+	return m_stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of links with an update pending.
+
+inline size_t AdviseScheduler::PendingCount() const
+{
+	return m_pending;
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDEADVISESCHEDULER_HPP
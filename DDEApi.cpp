@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEApi.cpp
+//! \brief  The DDEApi functions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEApi.hpp"
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dispatch the thread's pending messages, waiting up to the timeout for one
+//! to arrive. The DDEML completes asynchronous transactions via its windows.
+//! NB: Messages already in the queue count as having arrived.
+
+static BOOL WINAPI processMessages(DWORD /*idInst*/, DWORD dwTimeout)
+{
+	if (::MsgWaitForMultipleObjectsEx(0, nullptr, dwTimeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_TIMEOUT)
+		return FALSE;
+
+	MSG oMsg;
+
+	while (::PeekMessage(&oMsg, NULL, 0, 0, PM_REMOVE))
+	{
+		// Leave the quit message for the application's message loop.
+		if (oMsg.message == WM_QUIT)
+		{
+			::PostQuitMessage(static_cast<int>(oMsg.wParam));
+			break;
+		}
+
+		::TranslateMessage(&oMsg);
+		::DispatchMessage(&oMsg);
+	}
+
+	return TRUE;
+}
+
+//! The Windows DDEML functions.
+static const DDEApi s_windowsApi =
+{
+	::DdeInitialize,
+	::DdeUninitialize,
+	::DdeGetLastError,
+
+	::DdeCreateStringHandle,
+	::DdeFreeStringHandle,
+	::DdeKeepStringHandle,
+	::DdeQueryString,
+
+	::DdeCreateDataHandle,
+	::DdeAddData,
+	::DdeGetData,
+	::DdeAccessData,
+	::DdeUnaccessData,
+	::DdeFreeDataHandle,
+
+	::DdeNameService,
+	::DdeConnect,
+	::DdeDisconnect,
+	::DdeConnectList,
+	::DdeQueryNextServer,
+	::DdeDisconnectList,
+	::DdeQueryConvInfo,
+
+	::DdeClientTransaction,
+	::DdeAbandonTransaction,
+	::DdePostAdvise,
+
+	processMessages,
+};
+
+//! The DDEML function table in use.
+static const DDEApi* s_api = &s_windowsApi;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the DDEML function table in use.
+
+const DDEApi& ddeApi()
+{
+	return *s_api;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace the DDEML function table, or restore the Windows DDEML with nullptr.
+
+void setDDEApi(const DDEApi* api)
+{
+	s_api = (api != nullptr) ? api : &s_windowsApi;
+}
+
+//namespace DDE
+}
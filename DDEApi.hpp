@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEApi.hpp
+//! \brief  The DDEApi struct declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEAPI_HPP
+#define NCL_DDEAPI_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The table of DDEML functions used by the DDE classes. By default these are
+//! the Windows DDEML functions, but another implementation, such as the
+//! in-process DDEBroker, can be installed in their place.
+
+struct DDEApi
+{
+	UINT      (WINAPI* Initialize)(LPDWORD pidInst, PFNCALLBACK pfnCallback, DWORD afCmd, DWORD ulRes);
+	BOOL      (WINAPI* Uninitialize)(DWORD idInst);
+	UINT      (WINAPI* GetLastError)(DWORD idInst);
+
+	HSZ       (WINAPI* CreateStringHandle)(DWORD idInst, LPCTSTR psz, int iCodePage);
+	BOOL      (WINAPI* FreeStringHandle)(DWORD idInst, HSZ hsz);
+	BOOL      (WINAPI* KeepStringHandle)(DWORD idInst, HSZ hsz);
+	DWORD     (WINAPI* QueryString)(DWORD idInst, HSZ hsz, LPTSTR psz, DWORD cchMax, int iCodePage);
+
+	HDDEDATA  (WINAPI* CreateDataHandle)(DWORD idInst, LPBYTE pSrc, DWORD cb, DWORD cbOff, HSZ hszItem, UINT wFmt, UINT afCmd);
+	HDDEDATA  (WINAPI* AddData)(HDDEDATA hData, LPBYTE pSrc, DWORD cb, DWORD cbOff);
+	DWORD     (WINAPI* GetData)(HDDEDATA hData, LPBYTE pDst, DWORD cbMax, DWORD cbOff);
+	LPBYTE    (WINAPI* AccessData)(HDDEDATA hData, LPDWORD pcbDataSize);
+	BOOL      (WINAPI* UnaccessData)(HDDEDATA hData);
+	BOOL      (WINAPI* FreeDataHandle)(HDDEDATA hData);
+
+	HDDEDATA  (WINAPI* NameService)(DWORD idInst, HSZ hsz1, HSZ hsz2, UINT afCmd);
+	HCONV     (WINAPI* Connect)(DWORD idInst, HSZ hszService, HSZ hszTopic, PCONVCONTEXT pCC);
+	BOOL      (WINAPI* Disconnect)(HCONV hConv);
+	HCONVLIST (WINAPI* ConnectList)(DWORD idInst, HSZ hszService, HSZ hszTopic, HCONVLIST hConvList, PCONVCONTEXT pCC);
+	HCONV     (WINAPI* QueryNextServer)(HCONVLIST hConvList, HCONV hConvPrev);
+	BOOL      (WINAPI* DisconnectList)(HCONVLIST hConvList);
+	UINT      (WINAPI* QueryConvInfo)(HCONV hConv, DWORD idTransaction, PCONVINFO pConvInfo);
+
+	HDDEDATA  (WINAPI* ClientTransaction)(LPBYTE pData, DWORD cbData, HCONV hConv, HSZ hszItem, UINT wFmt, UINT wType, DWORD dwTimeout, LPDWORD pdwResult);
+	BOOL      (WINAPI* AbandonTransaction)(DWORD idInst, HCONV hConv, DWORD idTransaction);
+	BOOL      (WINAPI* PostAdvise)(DWORD idInst, HSZ hszTopic, HSZ hszItem);
+
+	//! Dispatch the pending messages, which deliver the XTYP_XACT_COMPLETE
+	//! callbacks, waiting up to the timeout for one to arrive. Returns FALSE if
+	//! there was nothing to dispatch. NB: This is not a DDEML function.
+	BOOL      (WINAPI* ProcessMessages)(DWORD idInst, DWORD dwTimeout);
+};
+
+//! Get the DDEML function table in use.
+const DDEApi& ddeApi();
+
+//! Replace the DDEML function table, or restore the Windows DDEML with nullptr.
+//! NB: This must only be done whilst there are no DDE instances.
+void setDDEApi(const DDEApi* api);
+
+//namespace DDE
+}
+
+#endif // NCL_DDEAPI_HPP
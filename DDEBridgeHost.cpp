@@ -0,0 +1,329 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeHost.cpp
+//! \brief  The Host class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEBridgeHost.hpp"
+#include "DDEBridgeProtocol.hpp"
+#include "RPCProtocol.hpp"
+#include "SocketException.hpp"
+
+namespace DDEBridge
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+Host::Host(CTCPSvrSocket& socket, IService& service)
+	: m_service(service)
+	, m_dispatcher(socket, *this)
+	, m_convs()
+	, m_links()
+	, m_nextID(1)
+	, m_batches()
+	, m_pending(0)
+	, m_payload()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+Host::~Host()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the advise loops for an item. The names are not case-sensitive.
+
+void Host::FindLinks(const tstring& topic, const tstring& item, std::vector<DWORD>& links) const
+{
+	for (Links::const_iterator it = m_links.begin(); it != m_links.end(); ++it)
+	{
+		const Link&         link = it->second;
+		const Conversation& conv = m_convs.find(link.m_conv)->second;
+
+		if ( (tstricmp(link.m_item.c_str(), item.c_str()) == 0)
+		  && (tstricmp(conv.m_topic.c_str(), topic.c_str()) == 0) )
+			links.push_back(link.m_id);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Queue an update for an advise loop. The updates for each relay are sent
+//! together when Flush() is called. Returns false if the link is unknown.
+
+bool Host::PostUpdate(DWORD link, const void* data, size_t size)
+{
+	Links::const_iterator it = m_links.find(link);
+
+	if (it == m_links.end())
+		return false;
+
+	CSocket*  client = m_convs.find(it->second.m_conv)->second.m_client;
+	BatchPtr& batch  = m_batches[client];
+
+	if (batch.get() == nullptr)
+	{
+		batch = BatchPtr(new Batch);
+		batch->m_count = 0;
+	}
+
+	Writer writer(batch->m_updates);
+
+	writer.writeDWord(link);
+	writer.writeData(data, size);
+
+	++batch->m_count;
+	++m_pending;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send the queued updates. Each relay is sent one notification containing all
+//! of the updates queued for its links. A relay whose connection fails is
+//! closed, which releases its conversations.
+
+void Host::Flush()
+{
+	std::vector<CSocket*> failed;
+
+	for (Batches::iterator it = m_batches.begin(); it != m_batches.end(); ++it)
+	{
+		Batch& batch = *it->second;
+
+		if (batch.m_count == 0)
+			continue;
+
+		m_payload.Clear();
+
+		Writer(m_payload).writeDWord(static_cast<DWORD>(batch.m_count));
+		m_payload.Append(batch.m_updates.Ptr(), batch.m_updates.Size());
+
+		batch.m_count = 0;
+		batch.m_updates.Clear();
+
+		try
+		{
+			m_dispatcher.Notify(*it->first, ADVISE_DATA, m_payload.Ptr(), m_payload.Size());
+		}
+		catch (const CSocketException& e)
+		{
+			TRACE1(TXT("DDE bridge relay dropped: %s\n"), e.twhat());
+			DEBUG_USE_ONLY(e);
+			failed.push_back(it->first);
+		}
+	}
+
+	m_pending = 0;
+
+	// Closing a relay removes its batch.
+	for (std::vector<CSocket*>::const_iterator it = failed.begin(); it != failed.end(); ++it)
+		m_dispatcher.CloseClient(**it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode and service a request from a relay.
+
+WORD Host::OnRequest(CSocket& client, WORD method, const byte* payload, size_t size, CNetBuffer& response)
+{
+	Reader reader(payload, size);
+
+	switch (method)
+	{
+		case CONNECT:
+		{
+			const tstring service = reader.readString();
+			const tstring topic = reader.readString();
+
+			if (!m_service.OnConnect(service, topic))
+				return NOT_PROCESSED;
+
+			const Conversation conv = { m_nextID++, &client, service, topic };
+
+			m_convs.insert(std::make_pair(conv.m_id, conv));
+
+			Writer(response).writeDWord(conv.m_id);
+		}
+		break;
+
+		case DISCONNECT:
+		{
+			Conversations::iterator it = m_convs.find(reader.readDWord());
+
+			if ( (it == m_convs.end()) || (it->second.m_client != &client) )
+				return UNKNOWN_ID;
+
+			CloseConversation(it);
+		}
+		break;
+
+		case REQUEST:
+		{
+			const Conversation* conv = FindConversation(client, reader.readDWord());
+			const tstring       item = reader.readString();
+			const uint          format = reader.readFormat();
+
+			if (conv == nullptr)
+				return UNKNOWN_ID;
+
+			if (!m_service.OnRequest(*conv, item, format, response))
+			{
+				response.Clear();
+				return NOT_PROCESSED;
+			}
+		}
+		break;
+
+		case POKE:
+		{
+			const Conversation* conv = FindConversation(client, reader.readDWord());
+			const tstring       item = reader.readString();
+			const uint          format = reader.readFormat();
+			size_t              length;
+			const byte*         data = reader.readData(length);
+
+			if (conv == nullptr)
+				return UNKNOWN_ID;
+
+			if (!m_service.OnPoke(*conv, item, format, data, length))
+				return NOT_PROCESSED;
+		}
+		break;
+
+		case EXECUTE:
+		{
+			const Conversation* conv = FindConversation(client, reader.readDWord());
+			const tstring       command = reader.readString();
+
+			if (conv == nullptr)
+				return UNKNOWN_ID;
+
+			if (!m_service.OnExecute(*conv, command))
+				return NOT_PROCESSED;
+		}
+		break;
+
+		case ADVISE_START:
+		{
+			const Conversation* conv = FindConversation(client, reader.readDWord());
+			const tstring       item = reader.readString();
+			const uint          format = reader.readFormat();
+
+			if (conv == nullptr)
+				return UNKNOWN_ID;
+
+			const Link link = { m_nextID, conv->m_id, item, format };
+
+			if (!m_service.OnAdviseStart(*conv, link))
+				return NOT_PROCESSED;
+
+			++m_nextID;
+			m_links.insert(std::make_pair(link.m_id, link));
+
+			Writer(response).writeDWord(link.m_id);
+		}
+		break;
+
+		case ADVISE_STOP:
+		{
+			Links::iterator it = m_links.find(reader.readDWord());
+
+			if (it == m_links.end())
+				return UNKNOWN_ID;
+
+			const Conversation* conv = FindConversation(client, it->second.m_conv);
+
+			if (conv == nullptr)
+				return UNKNOWN_ID;
+
+			const Link link = it->second;
+
+			m_links.erase(it);
+			m_service.OnAdviseStop(*conv, link);
+		}
+		break;
+
+		default:
+		{
+			return RPC::UNKNOWN_METHOD;
+		}
+	}
+
+	return RPC::OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the conversations and links for a closed relay.
+
+void Host::OnClientClosed(CSocket& client)
+{
+	Conversations::iterator it = m_convs.begin();
+
+	while (it != m_convs.end())
+	{
+		Conversations::iterator next = it;
+		++next;
+
+		if (it->second.m_client == &client)
+			CloseConversation(it);
+
+		it = next;
+	}
+
+	Batches::iterator batch = m_batches.find(&client);
+
+	if (batch != m_batches.end())
+	{
+		m_pending -= batch->second->m_count;
+		m_batches.erase(batch);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a conversation opened by the relay.
+
+Conversation* Host::FindConversation(CSocket& client, DWORD id)
+{
+	Conversations::iterator it = m_convs.find(id);
+
+	if ( (it == m_convs.end()) || (it->second.m_client != &client) )
+		return nullptr;
+
+	return &it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Close a conversation and its links, notifying the service.
+
+void Host::CloseConversation(Conversations::iterator it)
+{
+	const Conversation conv = it->second;
+
+	m_convs.erase(it);
+
+	Links::iterator link = m_links.begin();
+
+	while (link != m_links.end())
+	{
+		Links::iterator next = link;
+		++next;
+
+		if (link->second.m_conv == conv.m_id)
+		{
+			const Link stopped = link->second;
+
+			m_links.erase(link);
+			m_service.OnAdviseStop(conv, stopped);
+		}
+
+		link = next;
+	}
+
+	m_service.OnDisconnect(conv);
+}
+
+//namespace DDEBridge
+}
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeHost.hpp
+//! \brief  The Host class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEBRIDGEHOST_HPP
+#define NCL_DDEBRIDGEHOST_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "IRPCRequestHandler.hpp"
+#include "IDDEBridgeService.hpp"
+#include "RPCSvrDispatcher.hpp"
+#include "NetBuffer.hpp"
+#include <Core/SharedPtr.hpp>
+#include <map>
+#include <vector>
+
+namespace DDEBridge
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The service side of the DDE bridge. Relays connect to the listening socket
+//! and forward the events from their DDE server, which are decoded and passed
+//! to the service. Any number of conversations and links can be multiplexed
+//! over each connection. Advise loop updates are queued with PostUpdate() and
+//! sent to each relay as a single batch by Flush(). The listening socket must
+//! be in ASYNC mode.
+
+class Host : public RPC::IRequestHandler
+{
+public:
+	//! Constructor.
+	Host(CTCPSvrSocket& socket, IService& service);
+
+	//! Destructor.
+	virtual ~Host();
+
+	//
+	// Properties.
+	//
+
+	//! The number of open conversations.
+	size_t ConversationCount() const;
+
+	//! The number of active advise loops.
+	size_t LinkCount() const;
+
+	//! The number of updates queued and not yet flushed.
+	size_t PendingUpdates() const;
+
+	//
+	// Methods.
+	//
+
+	//! Find the advise loops for an item.
+	void FindLinks(const tstring& topic, const tstring& item, std::vector<DWORD>& links) const;
+
+	//! Queue an update for an advise loop.
+	bool PostUpdate(DWORD link, const void* data, size_t size);
+
+	//! Send the queued updates.
+	void Flush();
+
+	//
+	// IRequestHandler methods.
+	//
+
+	//! Decode and service a request from a relay.
+	virtual WORD OnRequest(CSocket& client, WORD method, const byte* payload, size_t size, CNetBuffer& response);
+
+	//! Release the conversations and links for a closed relay.
+	virtual void OnClientClosed(CSocket& client);
+
+private:
+	//! The updates queued for a relay.
+	struct Batch
+	{
+		size_t		m_count;	//!< The number of updates.
+		CNetBuffer	m_updates;	//!< The encoded updates.
+	};
+
+	//! The batch smart-pointer type.
+	typedef Core::SharedPtr<Batch> BatchPtr;
+	//! The conversations keyed by ID.
+	typedef std::map<DWORD, Conversation> Conversations;
+	//! The links keyed by ID.
+	typedef std::map<DWORD, Link> Links;
+	//! The queued updates keyed by relay.
+	typedef std::map<CSocket*, BatchPtr> Batches;
+
+	//
+	// Members.
+	//
+	IService&			m_service;		//!< The service.
+	RPC::SvrDispatcher	m_dispatcher;	//!< The RPC server.
+	Conversations		m_convs;		//!< The open conversations.
+	Links				m_links;		//!< The active advise loops.
+	DWORD				m_nextID;		//!< The next conversation or link ID.
+	Batches				m_batches;		//!< The queued updates.
+	size_t				m_pending;		//!< The number of queued updates.
+	CNetBuffer			m_payload;		//!< The notification being sent.
+
+	//
+	// Internal methods.
+	//
+
+	//! Find a conversation opened by the relay.
+	Conversation* FindConversation(CSocket& client, DWORD id);
+
+	//! Close a conversation and its links.
+	void CloseConversation(Conversations::iterator it);
+
+	// NotCopyable.
+	Host(const Host&);
+	Host& operator=(const Host&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of open conversations.
+
+inline size_t Host::ConversationCount() const
+{
+	return m_convs.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of active advise loops.
+
+inline size_t Host::LinkCount() const
+{
+	return m_links.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of updates queued and not yet flushed.
+
+inline size_t Host::PendingUpdates() const
+{
+	return m_pending;
+}
+
+//namespace DDEBridge
+}
+
+#endif // NCL_DDEBRIDGEHOST_HPP
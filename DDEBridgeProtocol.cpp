@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeProtocol.cpp
+//! \brief  The DDE bridge protocol definitions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEBridgeProtocol.hpp"
+#include "NetBuffer.hpp"
+#include "SocketException.hpp"
+#include <Core/AnsiWide.hpp>
+#include <string>
+
+namespace DDEBridge
+{
+
+//! The first registered clipboard format.
+const uint FIRST_REGISTERED_FORMAT = 0xC000;
+//! The maximum length of a registered clipboard format name.
+const size_t MAX_FORMAT_NAME = 256;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+Writer::Writer(CNetBuffer& buffer)
+	: m_buffer(buffer)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a 16-bit value.
+
+void Writer::writeWord(WORD value)
+{
+	const byte encoded[2] = { static_cast<byte>(value >> 8), static_cast<byte>(value) };
+
+	m_buffer.Append(encoded, sizeof(encoded));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a 32-bit value.
+
+void Writer::writeDWord(DWORD value)
+{
+	const byte encoded[4] = { static_cast<byte>(value >> 24), static_cast<byte>(value >> 16),
+							  static_cast<byte>(value >>  8), static_cast<byte>(value) };
+
+	m_buffer.Append(encoded, sizeof(encoded));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a string.
+
+void Writer::writeString(const tstring& value)
+{
+	const std::string ansi(T2A(value.c_str()));
+
+	writeData(ansi.data(), ansi.length());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a block of data.
+
+void Writer::writeData(const void* data, size_t size)
+{
+	ASSERT((data != nullptr) || (size == 0));
+
+	writeDWord(static_cast<DWORD>(size));
+
+	if (size != 0)
+		m_buffer.Append(data, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a clipboard format. A registered format is followed by its name so
+//! that the other end can map it to its own value.
+
+void Writer::writeFormat(uint format)
+{
+	ASSERT(format <= 0xFFFF);
+
+	writeWord(static_cast<WORD>(format));
+
+	if (format >= FIRST_REGISTERED_FORMAT)
+	{
+		tchar name[MAX_FORMAT_NAME] = { 0 };
+
+		// NB: An unknown format is sent without a name, which the reader rejects.
+		::GetClipboardFormatName(format, name, MAX_FORMAT_NAME);
+
+		writeString(name);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+Reader::Reader(const byte* payload, size_t size)
+	: m_next(payload)
+	, m_end(payload+size)
+{
+	ASSERT((payload != nullptr) || (size == 0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check that there are enough bytes left to read.
+
+void Reader::ensure(size_t size) const
+{
+	if (remaining() < size)
+		throw CSocketException(CSocketException::E_BAD_PROTOCOL, WSAEMSGSIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a 16-bit value.
+
+WORD Reader::readWord()
+{
+	ensure(2);
+
+	const WORD value = static_cast<WORD>((m_next[0] << 8) | m_next[1]);
+
+	m_next += 2;
+
+	return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a 32-bit value.
+
+DWORD Reader::readDWord()
+{
+	ensure(4);
+
+	const DWORD value = (static_cast<DWORD>(m_next[0]) << 24) | (static_cast<DWORD>(m_next[1]) << 16)
+					  | (static_cast<DWORD>(m_next[2]) <<  8) |  static_cast<DWORD>(m_next[3]);
+
+	m_next += 4;
+
+	return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a string.
+
+tstring Reader::readString()
+{
+	size_t      size;
+	const byte* data = readData(size);
+
+	const std::string ansi(reinterpret_cast<const char*>(data), size);
+
+	return tstring(A2T(ansi.c_str()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a block of data. The data is not copied.
+
+const byte* Reader::readData(size_t& size)
+{
+	size = readDWord();
+
+	ensure(size);
+
+	const byte* data = m_next;
+
+	m_next += size;
+
+	return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a clipboard format. A registered format is looked up by its name, and
+//! registered here if need be, as its value differs between machines.
+
+uint Reader::readFormat()
+{
+	const uint format = readWord();
+
+	if (format < FIRST_REGISTERED_FORMAT)
+		return format;
+
+	const tstring name = readString();
+
+	if (name.empty())
+		throw CSocketException(CSocketException::E_BAD_PROTOCOL, WSAEINVAL);
+
+	const uint local = ::RegisterClipboardFormat(name.c_str());
+
+	if (local == 0)
+		throw CSocketException(CSocketException::E_BAD_PROTOCOL, WSAEINVAL);
+
+	return local;
+}
+
+//namespace DDEBridge
+}
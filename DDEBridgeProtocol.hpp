@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeProtocol.hpp
+//! \brief  The DDE bridge protocol declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEBRIDGEPROTOCOL_HPP
+#define NCL_DDEBRIDGEPROTOCOL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+class CNetBuffer;
+
+namespace DDEBridge
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The RPC methods used to forward the DDE server events to the remote service.
+//! The payloads are built from the Writer fields in the order shown.
+
+enum Method
+{
+	CONNECT			= 1,	//!< service, topic -> conversation ID.
+	DISCONNECT		= 2,	//!< conversation ID.
+	REQUEST			= 3,	//!< conversation ID, item, format -> data.
+	POKE			= 4,	//!< conversation ID, item, format, data.
+	EXECUTE			= 5,	//!< conversation ID, command.
+	ADVISE_START	= 6,	//!< conversation ID, item, format -> link ID.
+	ADVISE_STOP		= 7,	//!< link ID.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The RPC notifications sent from the remote service.
+
+enum Notification
+{
+	ADVISE_DATA		= 1,	//!< count, { link ID, data } x count.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The response status codes used in addition to the RPC ones.
+
+enum Status
+{
+	NOT_PROCESSED	= 1,	//!< The service rejected the transaction.
+	UNKNOWN_ID		= 2,	//!< The conversation or link ID is not known.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Used to build a message payload. All integers are sent in network byte
+//! order, strings as 8-bit ANSI text and both strings and data blocks are
+//! prefixed with their length. A clipboard format is sent as a 16-bit value
+//! and, for a registered format, its name as well because the value is only
+//! meaningful on the machine that registered it.
+
+class Writer
+{
+public:
+	//! Constructor.
+	Writer(CNetBuffer& buffer);
+
+	//! Append a 16-bit value.
+	void writeWord(WORD value);
+
+	//! Append a 32-bit value.
+	void writeDWord(DWORD value);
+
+	//! Append a string.
+	void writeString(const tstring& value);
+
+	//! Append a block of data.
+	void writeData(const void* data, size_t size);
+
+	//! Append a clipboard format.
+	void writeFormat(uint format);
+
+private:
+	//
+	// Members.
+	//
+	CNetBuffer&	m_buffer;	//!< The payload.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Used to unpack a message payload written by a Writer. A payload which is
+//! too short for the fields being read causes a CSocketException.
+
+class Reader
+{
+public:
+	//! Constructor.
+	Reader(const byte* payload, size_t size);
+
+	//! The number of bytes not yet read.
+	size_t remaining() const;
+
+	//! Read a 16-bit value.
+	WORD readWord();
+
+	//! Read a 32-bit value.
+	DWORD readDWord();
+
+	//! Read a string.
+	tstring readString();
+
+	//! Read a block of data. The data is not copied.
+	const byte* readData(size_t& size);
+
+	//! Read a clipboard format, mapped to the local value.
+	uint readFormat();
+
+private:
+	//
+	// Members.
+	//
+	const byte*	m_next;		//!< The next byte to read.
+	const byte*	m_end;		//!< The end of the payload.
+
+	//! Check that there are enough bytes left to read.
+	void ensure(size_t size) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of bytes not yet read.
+
+inline size_t Reader::remaining() const
+{
+	return static_cast<size_t>(m_end - m_next);
+}
+
+//namespace DDEBridge
+}
+
+#endif // NCL_DDEBRIDGEPROTOCOL_HPP
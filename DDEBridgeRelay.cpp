@@ -0,0 +1,605 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeRelay.cpp
+//! \brief  The Relay class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEBridgeRelay.hpp"
+#include "DDEBridgeProtocol.hpp"
+#include "DDEServer.hpp"
+#include "DDESvrConv.hpp"
+#include "DDEData.hpp"
+#include "RPCProtocol.hpp"
+#include "TCPCltSocket.hpp"
+#include "SocketException.hpp"
+#include "WinSock.hpp"
+#include <Core/AnsiWide.hpp>
+
+namespace DDEBridge
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create a reader for a response payload.
+
+static Reader responseReader(const std::vector<byte>& response)
+{
+	return Reader(response.empty() ? nullptr : &response[0], response.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+Relay::Relay(CDDEServer& server, CTCPCltSocket& socket)
+	: m_server(server)
+	, m_socket(socket)
+	, m_nextID(1)
+	, m_timeout(DEFAULT_TIMEOUT)
+	, m_convIDs()
+	, m_linkIDs()
+	, m_links()
+	, m_dirty()
+	, m_pendingID(0)
+	, m_payload()
+	, m_outbound()
+	, m_inbound()
+	, m_response()
+{
+	m_server.AddListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+Relay::~Relay()
+{
+	m_server.RemoveListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Is the connection to the host still open?
+
+bool Relay::IsConnected() const
+{
+	return m_socket.IsOpen();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read any updates sent by the host and post them to the DDE clients. Only the
+//! latest value for each link is posted, however many updates arrived. If the
+//! connection has failed the DDE conversations are disconnected instead.
+
+void Relay::ProcessUpdates()
+{
+	if (m_socket.IsOpen())
+	{
+		WORD status;
+
+		try
+		{
+			ReceiveMessages(0, status);
+		}
+		catch (const CSocketException& e)
+		{
+			TRACE1(TXT("DDE bridge connection failed: %s\n"), e.twhat());
+			DEBUG_USE_ONLY(e);
+			m_socket.Close();
+		}
+	}
+
+	if (!m_socket.IsOpen())
+	{
+		DisconnectAll();
+		return;
+	}
+
+	PostUpdates();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send the request in the payload buffer without waiting for the response.
+//! The socket is closed if the send fails.
+
+DWORD Relay::Send(WORD method)
+{
+	if (!m_socket.IsOpen())
+		throw CSocketException(CSocketException::E_DISCONNECTED, WSAENOTCONN);
+
+	const DWORD id = m_nextID++;
+
+	m_outbound.Clear();
+
+	RPC::appendMessage(m_outbound, RPC::REQUEST, id, method, m_payload.Ptr(), m_payload.Size());
+
+	try
+	{
+		m_socket.Send(m_outbound.Ptr(), m_outbound.Size());
+	}
+	catch (const CSocketException&)
+	{
+		m_socket.Close();
+		throw;
+	}
+
+	return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send the request in the payload buffer and wait for the response, which is
+//! left in the response buffer. If the response does not arrive in time the
+//! call fails but the connection is kept, the late response is discarded. Any
+//! other error closes the socket.
+
+WORD Relay::Call(WORD method)
+{
+	const DWORD id = Send(method);
+	WORD        status = RPC::HANDLER_FAILED;
+
+	try
+	{
+		ReceiveMessages(id, status);
+	}
+	catch (const CSocketException& e)
+	{
+		if (e.m_nWSACode != WSAETIMEDOUT)
+			m_socket.Close();
+
+		throw;
+	}
+
+	return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Process the messages received. If waiting for a response this blocks until
+//! it arrives or the timeout expires, otherwise it only processes what has
+//! already been received. Responses to requests that were not waited for are
+//! discarded.
+
+bool Relay::ReceiveMessages(DWORD waitForID, WORD& status)
+{
+	const DWORD start = ::GetTickCount();
+
+	for (;;)
+	{
+		const byte*  buffer = m_inbound.empty() ? nullptr : &m_inbound[0];
+		size_t       consumed = 0;
+		RPC::Header  header;
+		size_t       messageSize;
+		bool         found = false;
+
+		while (!found && RPC::parseMessage(buffer+consumed, m_inbound.size()-consumed, header, messageSize))
+		{
+			const byte* payload = buffer+consumed+RPC::HEADER_SIZE;
+
+			if ( (header.m_type == RPC::RESPONSE) && (header.m_id == waitForID) )
+			{
+				m_response.assign(payload, payload+header.m_length);
+				status = header.m_code;
+				found  = true;
+			}
+			else if ( (header.m_type == RPC::NOTIFY) && (header.m_code == ADVISE_DATA) )
+			{
+				OnUpdates(payload, header.m_length);
+			}
+
+			consumed += messageSize;
+		}
+
+		m_inbound.erase(m_inbound.begin(), m_inbound.begin()+consumed);
+
+		if (found)
+			return true;
+
+		const size_t available = m_socket.Available();
+
+		if (available == 0)
+		{
+			if (waitForID == 0)
+				return false;
+
+			WaitForData(start);
+			continue;
+		}
+
+		const size_t offset = m_inbound.size();
+
+		m_inbound.resize(offset + available);
+
+		const size_t read = m_socket.Recv(&m_inbound[offset], available);
+
+		m_inbound.resize(offset + read);
+
+		if (read == 0)
+			throw CSocketException(CSocketException::E_DISCONNECTED, WSAECONNRESET);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait for more data to arrive from the host. Throws if the response timeout,
+//! which started at the tick count given, expires first.
+
+void Relay::WaitForData(DWORD start)
+{
+	const DWORD elapsed = ::GetTickCount() - start;
+
+	if (elapsed >= m_timeout)
+		throw CSocketException(CSocketException::E_WAIT_FAILED, WSAETIMEDOUT);
+
+	const DWORD remaining = m_timeout - elapsed;
+	fd_set      sockets;
+	TIMEVAL     waitTime = { static_cast<long>(remaining / 1000), static_cast<long>((remaining % 1000) * 1000) };
+
+	FD_ZERO(&sockets);
+	FD_SET(m_socket.Handle(), &sockets);
+
+	const int result = ::select(1, &sockets, nullptr, nullptr, &waitTime);
+
+	if (result == SOCKET_ERROR)
+		throw CSocketException(CSocketException::E_SELECT_FAILED, CWinSock::LastError());
+
+	if (result == 0)
+		throw CSocketException(CSocketException::E_WAIT_FAILED, WSAETIMEDOUT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Disconnect the DDE clients after the connection has failed. This must not be
+//! called from inside a DDE callback.
+
+void Relay::DisconnectAll()
+{
+	std::vector<CDDESvrConv*> convs;
+
+	for (ConvIDs::const_iterator it = m_convIDs.begin(); it != m_convIDs.end(); ++it)
+		convs.push_back(it->first);
+
+	m_convIDs.clear();
+	m_linkIDs.clear();
+	m_links.clear();
+	m_dirty.clear();
+	m_inbound.clear();
+
+	for (std::vector<CDDESvrConv*>::const_iterator it = convs.begin(); it != convs.end(); ++it)
+		m_server.DestroyConversation(*it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Store the updates from a notification. The links are posted later as this
+//! may be called from inside a DDE callback.
+
+void Relay::OnUpdates(const byte* payload, size_t size)
+{
+	Reader reader(payload, size);
+
+	for (DWORD count = reader.readDWord(); count != 0; --count)
+	{
+		const DWORD  id = reader.readDWord();
+		size_t       length;
+		const byte*  data = reader.readData(length);
+
+		Links::iterator it = m_links.find(id);
+
+		// Stopped whilst the update was in flight?
+		if (it == m_links.end())
+			continue;
+
+		RemoteLink& link = it->second;
+
+		link.m_value.assign(data, data+length);
+
+		if (!link.m_dirty)
+		{
+			link.m_dirty = true;
+			m_dirty.push_back(id);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Post the updated links to the DDE clients.
+
+void Relay::PostUpdates()
+{
+	CDDELinkUpdates updated;
+
+	for (std::vector<DWORD>::const_iterator it = m_dirty.begin(); it != m_dirty.end(); ++it)
+	{
+		Links::iterator link = m_links.find(*it);
+
+		if (link == m_links.end())
+			continue;
+
+		link->second.m_dirty = false;
+		updated.push_back(link->second.m_link);
+	}
+
+	m_dirty.clear();
+
+	if (!updated.empty())
+		m_server.PostLinkUpdates(updated);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the forwarded advise loop.
+
+void Relay::RemoveLink(LinkIDs::iterator it)
+{
+	m_links.erase(it->second);
+	m_linkIDs.erase(it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward a connection request.
+
+bool Relay::OnConnect(const tchar* pszService, const tchar* pszTopic)
+{
+	m_payload.Clear();
+
+	Writer writer(m_payload);
+
+	writer.writeString(pszService);
+	writer.writeString(pszTopic);
+
+	try
+	{
+		if (Call(CONNECT) != RPC::OK)
+			return false;
+
+		m_pendingID = responseReader(m_response).readDWord();
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge connect failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the remote ID for the new conversation.
+
+void Relay::OnConnectConfirm(CDDESvrConv* pConv)
+{
+	m_convIDs[pConv] = m_pendingID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward a conversation being terminated.
+
+void Relay::OnDisconnect(CDDESvrConv* pConv)
+{
+	ConvIDs::iterator conv = m_convIDs.find(pConv);
+
+	if (conv == m_convIDs.end())
+		return;
+
+	for (LinkIDs::iterator it = m_linkIDs.begin(); it != m_linkIDs.end(); )
+	{
+		LinkIDs::iterator next = it;
+		++next;
+
+		if (m_links[it->second].m_conv == pConv)
+			RemoveLink(it);
+
+		it = next;
+	}
+
+	m_payload.Clear();
+
+	Writer(m_payload).writeDWord(conv->second);
+
+	m_convIDs.erase(conv);
+
+	try
+	{
+		Send(DISCONNECT);
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge disconnect failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward a request for an item.
+
+bool Relay::OnRequest(CDDESvrConv* pConv, const tchar* pszItem, uint nFormat, CDDEData& oData)
+{
+	ConvIDs::const_iterator conv = m_convIDs.find(pConv);
+
+	if (conv == m_convIDs.end())
+		return false;
+
+	m_payload.Clear();
+
+	Writer writer(m_payload);
+
+	writer.writeDWord(conv->second);
+	writer.writeString(pszItem);
+	writer.writeFormat(nFormat);
+
+	try
+	{
+		if (Call(REQUEST) != RPC::OK)
+			return false;
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge request failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+		return false;
+	}
+
+	if (!m_response.empty())
+		oData.SetData(&m_response[0], m_response.size());
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward the start of an advise loop.
+
+bool Relay::OnAdviseStart(CDDESvrConv* pConv, const tchar* pszItem, uint nFormat)
+{
+	ConvIDs::const_iterator conv = m_convIDs.find(pConv);
+
+	if (conv == m_convIDs.end())
+		return false;
+
+	m_payload.Clear();
+
+	Writer writer(m_payload);
+
+	writer.writeDWord(conv->second);
+	writer.writeString(pszItem);
+	writer.writeFormat(nFormat);
+
+	try
+	{
+		if (Call(ADVISE_START) != RPC::OK)
+			return false;
+
+		m_pendingID = responseReader(m_response).readDWord();
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge advise failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the remote ID for the new advise loop.
+
+void Relay::OnAdviseConfirm(CDDESvrConv* pConv, CDDELink* pLink)
+{
+	RemoteLink link;
+
+	link.m_conv  = pConv;
+	link.m_link  = pLink;
+	link.m_dirty = false;
+
+	m_linkIDs[pLink] = m_pendingID;
+	m_links[m_pendingID] = link;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Supply the latest value received for an advise loop.
+
+bool Relay::OnAdviseRequest(CDDESvrConv* /*pConv*/, CDDELink* pLink, CDDEData& oData)
+{
+	LinkIDs::const_iterator it = m_linkIDs.find(pLink);
+
+	if (it == m_linkIDs.end())
+		return false;
+
+	const std::vector<byte>& value = m_links[it->second].m_value;
+
+	if (!value.empty())
+		oData.SetData(&value[0], value.size());
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward the end of an advise loop.
+
+void Relay::OnAdviseStop(CDDESvrConv* /*pConv*/, CDDELink* pLink)
+{
+	LinkIDs::iterator it = m_linkIDs.find(pLink);
+
+	if (it == m_linkIDs.end())
+		return;
+
+	m_payload.Clear();
+
+	Writer(m_payload).writeDWord(it->second);
+
+	RemoveLink(it);
+
+	try
+	{
+		Send(ADVISE_STOP);
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge advise stop failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward a command.
+
+bool Relay::OnExecute(CDDESvrConv* pConv, const CString& strCmd)
+{
+	ConvIDs::const_iterator conv = m_convIDs.find(pConv);
+
+	if (conv == m_convIDs.end())
+		return false;
+
+	m_payload.Clear();
+
+	Writer writer(m_payload);
+
+	writer.writeDWord(conv->second);
+	writer.writeString(strCmd.c_str());
+
+	try
+	{
+		return (Call(EXECUTE) == RPC::OK);
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge execute failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forward an item being poked.
+
+bool Relay::OnPoke(CDDESvrConv* pConv, const tchar* pszItem, uint nFormat, const CDDEData& oData)
+{
+	ConvIDs::const_iterator conv = m_convIDs.find(pConv);
+
+	if (conv == m_convIDs.end())
+		return false;
+
+	m_payload.Clear();
+
+	Writer writer(m_payload);
+
+	writer.writeDWord(conv->second);
+	writer.writeString(pszItem);
+	writer.writeFormat(nFormat);
+
+	// Write the value straight from the data handle.
+	{
+		CDDEData::CView value(oData);
+
+		writer.writeData(value.Data(), value.Size());
+	}
+
+	try
+	{
+		return (Call(POKE) == RPC::OK);
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("DDE bridge poke failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+	}
+
+	return false;
+}
+
+//namespace DDEBridge
+}
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeRelay.hpp
+//! \brief  The Relay class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEBRIDGERELAY_HPP
+#define NCL_DDEBRIDGERELAY_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DefDDEServerListener.hpp"
+#include "NetBuffer.hpp"
+#include <map>
+#include <vector>
+
+// Forward declarations.
+class CDDEServer;
+class CTCPCltSocket;
+
+namespace DDEBridge
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The DDE side of the bridge. It listens to a DDE server and forwards the
+//! connect, request, poke, execute and advise events to a remote Host. The
+//! transactions that need an answer wait for the host's response, any updates
+//! which arrive in the meantime are stored. The latest value for each link is
+//! posted to the DDE clients by ProcessUpdates(), which should be called when
+//! the socket becomes readable or from a timer. A transaction fails if the host
+//! does not respond within the timeout. If the connection fails the socket is
+//! closed and the next call to ProcessUpdates() disconnects the DDE clients.
+//! The socket must be connected and in BLOCK mode.
+
+class Relay : public CDefDDEServerListener
+{
+public:
+	//! The default response timeout in milliseconds.
+	static const DWORD DEFAULT_TIMEOUT = 5000;
+
+public:
+	//! Constructor.
+	Relay(CDDEServer& server, CTCPCltSocket& socket);
+
+	//! Destructor.
+	virtual ~Relay();
+
+	//
+	// Properties.
+	//
+
+	//! The number of forwarded advise loops.
+	size_t LinkCount() const;
+
+	//! The number of links with updates not yet posted.
+	size_t PendingUpdates() const;
+
+	//! Is the connection to the host still open?
+	bool IsConnected() const;
+
+	//! Get the response timeout in milliseconds.
+	DWORD TimeOut() const;
+
+	//! Set the response timeout in milliseconds.
+	void SetTimeOut(DWORD timeout);
+
+	//
+	// Methods.
+	//
+
+	//! Read any updates sent by the host and post them to the DDE clients.
+	void ProcessUpdates();
+
+	//
+	// IDDEServerListener methods.
+	//
+	virtual bool OnConnect(const tchar* pszService, const tchar* pszTopic);
+	virtual void OnConnectConfirm(CDDESvrConv* pConv);
+	virtual void OnDisconnect(CDDESvrConv* pConv);
+	virtual bool OnRequest(CDDESvrConv* pConv, const tchar* pszItem, uint nFormat, CDDEData& oData);
+	virtual bool OnAdviseStart(CDDESvrConv* pConv, const tchar* pszItem, uint nFormat);
+	virtual void OnAdviseConfirm(CDDESvrConv* pConv, CDDELink* pLink);
+	virtual bool OnAdviseRequest(CDDESvrConv* pConv, CDDELink* pLink, CDDEData& oData);
+	virtual void OnAdviseStop(CDDESvrConv* pConv, CDDELink* pLink);
+	virtual bool OnExecute(CDDESvrConv* pConv, const CString& strCmd);
+	virtual bool OnPoke(CDDESvrConv* pConv, const tchar* pszItem, uint nFormat, const CDDEData& oData);
+
+private:
+	//! A forwarded advise loop.
+	struct RemoteLink
+	{
+		CDDESvrConv*		m_conv;		//!< The DDE conversation.
+		CDDELink*			m_link;		//!< The DDE link.
+		std::vector<byte>	m_value;	//!< The latest value.
+		bool				m_dirty;	//!< Not yet posted?
+	};
+
+	//! The remote conversation IDs.
+	typedef std::map<CDDESvrConv*, DWORD> ConvIDs;
+	//! The remote link IDs.
+	typedef std::map<CDDELink*, DWORD> LinkIDs;
+	//! The forwarded advise loops keyed by remote ID.
+	typedef std::map<DWORD, RemoteLink> Links;
+
+	//
+	// Members.
+	//
+	CDDEServer&			m_server;		//!< The DDE server.
+	CTCPCltSocket&		m_socket;		//!< The host connection.
+	DWORD				m_nextID;		//!< The next RPC request ID.
+	DWORD				m_timeout;		//!< The response timeout.
+	ConvIDs				m_convIDs;		//!< The remote conversation IDs.
+	LinkIDs				m_linkIDs;		//!< The remote link IDs.
+	Links				m_links;		//!< The forwarded advise loops.
+	std::vector<DWORD>	m_dirty;		//!< The links updated since last posted.
+	DWORD				m_pendingID;	//!< The remote ID awaiting confirmation.
+	CNetBuffer			m_payload;		//!< The request payload.
+	CNetBuffer			m_outbound;		//!< The request being sent.
+	std::vector<byte>	m_inbound;		//!< The messages not yet processed.
+	std::vector<byte>	m_response;		//!< The last response payload.
+
+	//
+	// Internal methods.
+	//
+
+	//! Send the request in the payload buffer.
+	DWORD Send(WORD method);
+
+	//! Send the request in the payload buffer and wait for the response.
+	WORD Call(WORD method);
+
+	//! Process the messages received, optionally waiting for a response.
+	bool ReceiveMessages(DWORD waitForID, WORD& status);
+
+	//! Wait for more data until the response timeout expires.
+	void WaitForData(DWORD start);
+
+	//! Disconnect the DDE clients after the connection has failed.
+	void DisconnectAll();
+
+	//! Store the updates from a notification.
+	void OnUpdates(const byte* payload, size_t size);
+
+	//! Post the updated links to the DDE clients.
+	void PostUpdates();
+
+	//! Remove the forwarded advise loop.
+	void RemoveLink(LinkIDs::iterator it);
+
+	// NotCopyable.
+	Relay(const Relay&);
+	Relay& operator=(const Relay&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of forwarded advise loops.
+
+inline size_t Relay::LinkCount() const
+{
+	return m_links.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of links with updates not yet posted.
+
+inline size_t Relay::PendingUpdates() const
+{
+	return m_dirty.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the response timeout in milliseconds.
+
+inline DWORD Relay::TimeOut() const
+{
+	return m_timeout;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the response timeout in milliseconds.
+
+inline void Relay::SetTimeOut(DWORD timeout)
+{
+	m_timeout = timeout;
+}
+
+//namespace DDEBridge
+}
+
+#endif // NCL_DDEBRIDGERELAY_HPP
@@ -0,0 +1,1317 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBroker.cpp
+//! \brief  The DDEBroker class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEBroker.hpp"
+#include "DDEClient.hpp"
+#include "DDEServer.hpp"
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <limits.h>
+
+namespace DDE
+{
+
+namespace
+{
+
+//! The case-insensitive ordering used for service, topic and item names.
+struct NoCaseLess
+{
+	bool operator()(const tstring& lhs, const tstring& rhs) const
+	{
+		return (tstricmp(lhs.c_str(), rhs.c_str()) < 0);
+	}
+};
+
+//! A DDE instance.
+struct Instance
+{
+	PFNCALLBACK			m_callback;		//!< The instance callback.
+	DWORD				m_flags;		//!< The APPCMD_ and CBF_ flags.
+	UINT				m_lastError;	//!< The last error code.
+	std::vector<HSZ>	m_services;		//!< The registered service names.
+};
+
+//! An interned string.
+struct String
+{
+	tstring	m_text;		//!< The string value.
+	size_t	m_refs;		//!< The reference count.
+};
+
+//! A data object.
+struct Data
+{
+	DWORD				m_inst;		//!< The owning instance.
+	std::vector<BYTE>	m_bytes;	//!< The data.
+};
+
+//! An advise loop.
+struct Link
+{
+	HSZ		m_item;		//!< The item name.
+	UINT	m_format;	//!< The clipboard format.
+	bool	m_noData;	//!< Notify without the data?
+};
+
+typedef std::pair<HSZ, UINT> LinkKey;
+typedef std::map<LinkKey, Link> Links;
+
+struct ConvList;
+
+//! One end of a conversation.
+struct Conversation
+{
+	DWORD				m_inst;			//!< The owning instance.
+	bool				m_client;		//!< The client end?
+	HSZ					m_service;		//!< The service name.
+	HSZ					m_topic;		//!< The topic name.
+	Conversation*		m_partner;		//!< The other end.
+	ConvList*			m_list;			//!< The owning list, if any.
+	Links				m_links;		//!< The advise loops by item and format (server end only).
+};
+
+//! A list of client conversations.
+struct ConvList
+{
+	DWORD						m_inst;		//!< The owning instance.
+	std::vector<Conversation*>	m_convs;	//!< The conversations.
+};
+
+//! An asynchronous transaction waiting to be processed.
+struct Transaction
+{
+	HCONV		m_conv;		//!< The client conversation.
+	HSZ			m_item;		//!< The item name.
+	UINT		m_format;	//!< The clipboard format.
+	UINT		m_type;		//!< The transaction type and flags.
+	HDDEDATA	m_data;		//!< The poke or execute data.
+};
+
+typedef std::map<DWORD, Instance> Instances;
+typedef std::map<tstring, size_t, NoCaseLess> StringIndex;
+typedef std::pair<DWORD, DWORD> TransactionKey;
+typedef std::map<TransactionKey, Transaction> Transactions;
+
+//! The DDE instances.
+Instances s_instances;
+//! The next instance ID.
+DWORD s_nextInst = 1;
+//! The string table, where an HSZ is the index + 1.
+std::vector<String> s_strings;
+//! The string table index.
+StringIndex s_stringIndex;
+//! The unused string table entries.
+std::vector<size_t> s_freeStrings;
+//! The live data handles.
+std::set<Data*> s_data;
+//! The live conversations.
+std::set<Conversation*> s_convs;
+//! The live conversation lists.
+std::set<ConvList*> s_lists;
+//! The queued asynchronous transactions, by instance and transaction ID.
+Transactions s_transactions;
+//! The next transaction ID.
+DWORD s_nextTransaction = 1;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find an instance by its ID.
+
+Instance* findInstance(DWORD inst)
+{
+	Instances::iterator it = s_instances.find(inst);
+
+	return (it != s_instances.end()) ? &it->second : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the last error for an instance.
+
+void setError(DWORD inst, UINT error)
+{
+	Instance* instance = findInstance(inst);
+
+	if (instance != nullptr)
+		instance->m_lastError = error;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Invoke an instance callback, applying its CBF_ filter flags.
+
+HDDEDATA callback(DWORD inst, UINT type, UINT format, HCONV conv, HSZ hsz1, HSZ hsz2,
+					HDDEDATA data, ULONG_PTR data1 = 0, ULONG_PTR data2 = 0)
+{
+	const Instance* instance = findInstance(inst);
+
+	if (instance == nullptr)
+		return nullptr;
+
+	const DWORD flags = instance->m_flags;
+
+	if ( ((type == XTYP_REGISTER)   && (flags & CBF_SKIP_REGISTRATIONS))
+	  || ((type == XTYP_UNREGISTER) && (flags & CBF_SKIP_UNREGISTRATIONS))
+	  || ((type == XTYP_DISCONNECT) && (flags & CBF_SKIP_DISCONNECTS))
+	  || ((type == XTYP_CONNECT_CONFIRM) && (flags & CBF_SKIP_CONNECT_CONFIRMS))
+	  || ((type == XTYP_CONNECT)    && (flags & CBF_FAIL_CONNECTIONS))
+	  || ((type == XTYP_WILDCONNECT) && (flags & CBF_FAIL_CONNECTIONS))
+	  || ((type == XTYP_REQUEST)    && (flags & CBF_FAIL_REQUESTS))
+	  || ((type == XTYP_POKE)       && (flags & CBF_FAIL_POKES))
+	  || ((type == XTYP_EXECUTE)    && (flags & CBF_FAIL_EXECUTES))
+	  || ((type == XTYP_ADVSTART)   && (flags & CBF_FAIL_ADVISES)) )
+		return nullptr;
+
+	return instance->m_callback(type, format, conv, hsz1, hsz2, data, data1, data2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert between a string handle and its table entry.
+
+String* findString(HSZ hsz)
+{
+	const size_t index = reinterpret_cast<ULONG_PTR>(hsz);
+
+	if ( (index == 0) || (index > s_strings.size()) || (s_strings[index-1].m_refs == 0) )
+		return nullptr;
+
+	return &s_strings[index-1];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a reference to a string handle.
+
+void keepString(HSZ hsz)
+{
+	String* string = findString(hsz);
+
+	if (string != nullptr)
+		++string->m_refs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release a reference to a string handle.
+
+bool releaseString(HSZ hsz)
+{
+	String* string = findString(hsz);
+
+	if (string == nullptr)
+		return false;
+
+	if (--string->m_refs == 0)
+	{
+		const size_t index = reinterpret_cast<ULONG_PTR>(hsz) - 1;
+
+		s_stringIndex.erase(string->m_text);
+		s_freeStrings.push_back(index);
+		string->m_text.clear();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate a data handle.
+
+Data* findData(HDDEDATA hData)
+{
+	Data* data = reinterpret_cast<Data*>(hData);
+
+	return (s_data.find(data) != s_data.end()) ? data : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free a data handle, if it has not already been freed.
+
+void freeData(HDDEDATA hData)
+{
+	Data* data = findData(hData);
+
+	if (data != nullptr)
+	{
+		s_data.erase(data);
+		delete data;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate a conversation handle.
+
+Conversation* findConv(HCONV hConv)
+{
+	Conversation* conv = reinterpret_cast<Conversation*>(hConv);
+
+	return (s_convs.find(conv) != s_convs.end()) ? conv : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a conversation to its handle.
+
+HCONV toHandle(Conversation* conv)
+{
+	return reinterpret_cast<HCONV>(conv);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard a queued transaction.
+
+void discardTransaction(Transactions::iterator it)
+{
+	freeData(it->second.m_data);
+	releaseString(it->second.m_item);
+
+	s_transactions.erase(it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the queued transactions for an instance, or only those for one of
+//! its conversations.
+
+void discardTransactions(DWORD inst, HCONV conv)
+{
+	Transactions::iterator it = s_transactions.lower_bound(TransactionKey(inst, 0));
+
+	while ( (it != s_transactions.end()) && (it->first.first == inst) )
+	{
+		Transactions::iterator next = it;
+
+		++next;
+
+		if ( (conv == nullptr) || (it->second.m_conv == conv) )
+			discardTransaction(it);
+
+		it = next;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destroy one end of a conversation.
+
+void destroyConv(Conversation* conv)
+{
+	if (conv->m_client)
+		discardTransactions(conv->m_inst, toHandle(conv));
+
+	if (conv->m_list != nullptr)
+	{
+		std::vector<Conversation*>& convs = conv->m_list->m_convs;
+
+		convs.erase(std::remove(convs.begin(), convs.end(), conv), convs.end());
+	}
+
+	for (Links::const_iterator it = conv->m_links.begin(); it != conv->m_links.end(); ++it)
+		releaseString(it->second.m_item);
+
+	releaseString(conv->m_service);
+	releaseString(conv->m_topic);
+
+	s_convs.erase(conv);
+	delete conv;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Terminate a conversation, notifying the partner.
+
+void disconnect(Conversation* conv)
+{
+	Conversation* partner = conv->m_partner;
+
+	destroyConv(conv);
+
+	// Already terminated by the partner?
+	if (partner == nullptr)
+		return;
+
+	partner->m_partner = nullptr;
+
+	// The partner may disconnect its end from the callback.
+	callback(partner->m_inst, XTYP_DISCONNECT, 0, toHandle(partner), nullptr, nullptr, nullptr, 0, FALSE);
+
+	if (findConv(toHandle(partner)) != nullptr)
+		destroyConv(partner);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Try and establish a conversation with a single server instance.
+
+Conversation* connect(DWORD client, DWORD server, HSZ service, HSZ topic, ConvList* list)
+{
+	if (!callback(server, XTYP_CONNECT, 0, nullptr, topic, service, nullptr, 0, FALSE))
+		return nullptr;
+
+	Conversation* clientConv = new Conversation;
+	Conversation* serverConv = new Conversation;
+
+	clientConv->m_inst    = client;
+	clientConv->m_client  = true;
+	clientConv->m_service = service;
+	clientConv->m_topic   = topic;
+	clientConv->m_partner = serverConv;
+	clientConv->m_list    = list;
+
+	serverConv->m_inst    = server;
+	serverConv->m_client  = false;
+	serverConv->m_service = service;
+	serverConv->m_topic   = topic;
+	serverConv->m_partner = clientConv;
+	serverConv->m_list    = nullptr;
+
+	// Each end holds a reference to the names.
+	keepString(service);
+	keepString(service);
+	keepString(topic);
+	keepString(topic);
+
+	s_convs.insert(clientConv);
+	s_convs.insert(serverConv);
+
+	if (list != nullptr)
+		list->m_convs.push_back(clientConv);
+
+	callback(server, XTYP_CONNECT_CONFIRM, 0, toHandle(serverConv), topic, service, nullptr, 0, FALSE);
+
+	return clientConv;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the instance is a server that has registered the service name.
+
+bool isServing(const Instance& instance, HSZ service)
+{
+	if (instance.m_flags & APPCMD_CLIENTONLY)
+		return false;
+
+	const std::vector<HSZ>& services = instance.m_services;
+
+	return (std::find(services.begin(), services.end(), service) != services.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find an advise loop on the server end of a conversation.
+
+Links::iterator findLink(Conversation* conv, HSZ item, UINT format)
+{
+	return conv->m_links.find(LinkKey(item, format));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Notify the other instances about a service name change.
+
+void notifyServiceChange(DWORD inst, UINT type, HSZ service)
+{
+	std::vector<DWORD> others;
+
+	for (Instances::const_iterator it = s_instances.begin(); it != s_instances.end(); ++it)
+	{
+		if (it->first != inst)
+			others.push_back(it->first);
+	}
+
+	for (std::vector<DWORD>::const_iterator it = others.begin(); it != others.end(); ++it)
+		callback(*it, type, 0, nullptr, service, service, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The DDEML function implementations.
+
+UINT WINAPI brokerInitialize(LPDWORD pidInst, PFNCALLBACK pfnCallback, DWORD afCmd, DWORD /*ulRes*/)
+{
+	if ( (pidInst == nullptr) || (pfnCallback == nullptr) )
+		return DMLERR_INVALIDPARAMETER;
+
+	Instance instance;
+
+	instance.m_callback  = pfnCallback;
+	instance.m_flags     = afCmd;
+	instance.m_lastError = DMLERR_NO_ERROR;
+
+	*pidInst = s_nextInst++;
+
+	s_instances[*pidInst] = instance;
+
+	return DMLERR_NO_ERROR;
+}
+
+BOOL WINAPI brokerUninitialize(DWORD idInst)
+{
+	Instance* instance = findInstance(idInst);
+
+	if (instance == nullptr)
+		return FALSE;
+
+	// Terminate all conversations.
+	std::vector<Conversation*> convs;
+
+	for (std::set<Conversation*>::const_iterator it = s_convs.begin(); it != s_convs.end(); ++it)
+	{
+		if ((*it)->m_inst == idInst)
+			convs.push_back(*it);
+	}
+
+	for (std::vector<Conversation*>::const_iterator it = convs.begin(); it != convs.end(); ++it)
+	{
+		if (findConv(toHandle(*it)) != nullptr)
+			disconnect(*it);
+	}
+
+	// Free the lists and data.
+	std::vector<ConvList*> lists;
+
+	for (std::set<ConvList*>::const_iterator it = s_lists.begin(); it != s_lists.end(); ++it)
+	{
+		if ((*it)->m_inst == idInst)
+			lists.push_back(*it);
+	}
+
+	for (std::vector<ConvList*>::const_iterator it = lists.begin(); it != lists.end(); ++it)
+	{
+		s_lists.erase(*it);
+		delete *it;
+	}
+
+	std::vector<Data*> data;
+
+	for (std::set<Data*>::const_iterator it = s_data.begin(); it != s_data.end(); ++it)
+	{
+		if ((*it)->m_inst == idInst)
+			data.push_back(*it);
+	}
+
+	for (std::vector<Data*>::const_iterator it = data.begin(); it != data.end(); ++it)
+		freeData(reinterpret_cast<HDDEDATA>(*it));
+
+	// Unregister the services.
+	std::vector<HSZ> services;
+
+	services.swap(instance->m_services);
+	s_instances.erase(idInst);
+
+	for (std::vector<HSZ>::const_iterator it = services.begin(); it != services.end(); ++it)
+	{
+		notifyServiceChange(idInst, XTYP_UNREGISTER, *it);
+		releaseString(*it);
+	}
+
+	return TRUE;
+}
+
+UINT WINAPI brokerGetLastError(DWORD idInst)
+{
+	Instance* instance = findInstance(idInst);
+
+	if (instance == nullptr)
+		return DMLERR_INVALIDPARAMETER;
+
+	UINT error = instance->m_lastError;
+
+	instance->m_lastError = DMLERR_NO_ERROR;
+
+	return error;
+}
+
+HSZ WINAPI brokerCreateStringHandle(DWORD idInst, LPCTSTR psz, int /*iCodePage*/)
+{
+	if ( (findInstance(idInst) == nullptr) || (psz == nullptr) )
+		return nullptr;
+
+	StringIndex::const_iterator it = s_stringIndex.find(psz);
+	size_t index;
+
+	if (it != s_stringIndex.end())
+	{
+		index = it->second;
+		++s_strings[index].m_refs;
+	}
+	else
+	{
+		if (!s_freeStrings.empty())
+		{
+			index = s_freeStrings.back();
+			s_freeStrings.pop_back();
+		}
+		else
+		{
+			index = s_strings.size();
+			s_strings.push_back(String());
+		}
+
+		s_strings[index].m_text = psz;
+		s_strings[index].m_refs = 1;
+		s_stringIndex[psz] = index;
+	}
+
+	return reinterpret_cast<HSZ>(static_cast<ULONG_PTR>(index + 1));
+}
+
+BOOL WINAPI brokerFreeStringHandle(DWORD /*idInst*/, HSZ hsz)
+{
+	return releaseString(hsz) ? TRUE : FALSE;
+}
+
+BOOL WINAPI brokerKeepStringHandle(DWORD /*idInst*/, HSZ hsz)
+{
+	if (findString(hsz) == nullptr)
+		return FALSE;
+
+	keepString(hsz);
+
+	return TRUE;
+}
+
+DWORD WINAPI brokerQueryString(DWORD /*idInst*/, HSZ hsz, LPTSTR psz, DWORD cchMax, int /*iCodePage*/)
+{
+	const String* string = findString(hsz);
+
+	if (string == nullptr)
+		return 0;
+
+	const DWORD length = static_cast<DWORD>(string->m_text.length());
+
+	if (psz == nullptr)
+		return length;
+
+	if (cchMax == 0)
+		return 0;
+
+	const DWORD count = std::min(length, cchMax-1);
+
+	memcpy(psz, string->m_text.c_str(), Core::numBytes<tchar>(count));
+	psz[count] = TXT('\0');
+
+	return count;
+}
+
+HDDEDATA WINAPI brokerCreateDataHandle(DWORD idInst, LPBYTE pSrc, DWORD cb, DWORD cbOff, HSZ /*hszItem*/, UINT /*wFmt*/, UINT /*afCmd*/)
+{
+	if (findInstance(idInst) == nullptr)
+		return nullptr;
+
+	Data* data = new Data;
+
+	data->m_inst = idInst;
+
+	if (pSrc != nullptr)
+		data->m_bytes.assign(pSrc + cbOff, pSrc + cbOff + cb);
+	else
+		data->m_bytes.resize(cb);
+
+	s_data.insert(data);
+
+	return reinterpret_cast<HDDEDATA>(data);
+}
+
+HDDEDATA WINAPI brokerAddData(HDDEDATA hData, LPBYTE pSrc, DWORD cb, DWORD cbOff)
+{
+	Data* data = findData(hData);
+
+	if (data == nullptr)
+		return nullptr;
+
+	if (data->m_bytes.size() < (cbOff + cb))
+		data->m_bytes.resize(cbOff + cb);
+
+	if (cb != 0)
+		memcpy(&data->m_bytes[cbOff], pSrc, cb);
+
+	return hData;
+}
+
+DWORD WINAPI brokerGetData(HDDEDATA hData, LPBYTE pDst, DWORD cbMax, DWORD cbOff)
+{
+	const Data* data = findData(hData);
+
+	if (data == nullptr)
+		return 0;
+
+	const DWORD size = static_cast<DWORD>(data->m_bytes.size());
+
+	if (cbOff > size)
+		return 0;
+
+	if (pDst == nullptr)
+		return size - cbOff;
+
+	const DWORD count = std::min(cbMax, size - cbOff);
+
+	if (count != 0)
+		memcpy(pDst, &data->m_bytes[cbOff], count);
+
+	return count;
+}
+
+LPBYTE WINAPI brokerAccessData(HDDEDATA hData, LPDWORD pcbDataSize)
+{
+	Data* data = findData(hData);
+
+	if (data == nullptr)
+		return nullptr;
+
+	if (pcbDataSize != nullptr)
+		*pcbDataSize = static_cast<DWORD>(data->m_bytes.size());
+
+	// An empty object still needs a valid pointer.
+	static BYTE empty = 0;
+
+	return !data->m_bytes.empty() ? &data->m_bytes[0] : &empty;
+}
+
+BOOL WINAPI brokerUnaccessData(HDDEDATA hData)
+{
+	return (findData(hData) != nullptr) ? TRUE : FALSE;
+}
+
+BOOL WINAPI brokerFreeDataHandle(HDDEDATA hData)
+{
+	if (findData(hData) == nullptr)
+		return FALSE;
+
+	freeData(hData);
+
+	return TRUE;
+}
+
+HDDEDATA WINAPI brokerNameService(DWORD idInst, HSZ hsz1, HSZ /*hsz2*/, UINT afCmd)
+{
+	Instance* instance = findInstance(idInst);
+
+	if (instance == nullptr)
+		return nullptr;
+
+	std::vector<HSZ>& services = instance->m_services;
+
+	if (afCmd & DNS_REGISTER)
+	{
+		if ( (instance->m_flags & APPCMD_CLIENTONLY) || (findString(hsz1) == nullptr) )
+		{
+			instance->m_lastError = DMLERR_DLL_USAGE;
+			return nullptr;
+		}
+
+		if (std::find(services.begin(), services.end(), hsz1) == services.end())
+		{
+			keepString(hsz1);
+			services.push_back(hsz1);
+			notifyServiceChange(idInst, XTYP_REGISTER, hsz1);
+		}
+	}
+	else if (afCmd & DNS_UNREGISTER)
+	{
+		std::vector<HSZ> removed;
+
+		if (hsz1 == nullptr)
+		{
+			removed.swap(services);
+		}
+		else
+		{
+			std::vector<HSZ>::iterator it = std::find(services.begin(), services.end(), hsz1);
+
+			if (it != services.end())
+			{
+				removed.push_back(*it);
+				services.erase(it);
+			}
+		}
+
+		for (std::vector<HSZ>::const_iterator it = removed.begin(); it != removed.end(); ++it)
+		{
+			notifyServiceChange(idInst, XTYP_UNREGISTER, *it);
+			releaseString(*it);
+		}
+	}
+
+	return reinterpret_cast<HDDEDATA>(TRUE);
+}
+
+HCONV WINAPI brokerConnect(DWORD idInst, HSZ hszService, HSZ hszTopic, PCONVCONTEXT /*pCC*/)
+{
+	if (findInstance(idInst) == nullptr)
+		return nullptr;
+
+	std::vector<DWORD> servers;
+
+	for (Instances::const_iterator it = s_instances.begin(); it != s_instances.end(); ++it)
+	{
+		if ( (it->first != idInst) && isServing(it->second, hszService) )
+			servers.push_back(it->first);
+	}
+
+	for (std::vector<DWORD>::const_iterator it = servers.begin(); it != servers.end(); ++it)
+	{
+		Conversation* conv = connect(idInst, *it, hszService, hszTopic, nullptr);
+
+		if (conv != nullptr)
+			return toHandle(conv);
+	}
+
+	setError(idInst, DMLERR_NO_CONV_ESTABLISHED);
+
+	return nullptr;
+}
+
+BOOL WINAPI brokerDisconnect(HCONV hConv)
+{
+	Conversation* conv = findConv(hConv);
+
+	if (conv == nullptr)
+		return FALSE;
+
+	disconnect(conv);
+
+	return TRUE;
+}
+
+HCONVLIST WINAPI brokerConnectList(DWORD idInst, HSZ hszService, HSZ hszTopic, HCONVLIST /*hConvList*/, PCONVCONTEXT /*pCC*/)
+{
+	if (findInstance(idInst) == nullptr)
+		return nullptr;
+
+	std::vector<DWORD> servers;
+
+	for (Instances::const_iterator it = s_instances.begin(); it != s_instances.end(); ++it)
+	{
+		if ( (it->first != idInst) && !(it->second.m_flags & APPCMD_CLIENTONLY)
+		  && ((hszService == nullptr) || isServing(it->second, hszService)) )
+			servers.push_back(it->first);
+	}
+
+	ConvList* list = new ConvList;
+
+	list->m_inst = idInst;
+
+	s_lists.insert(list);
+
+	for (std::vector<DWORD>::const_iterator it = servers.begin(); it != servers.end(); ++it)
+	{
+		HDDEDATA hData = callback(*it, XTYP_WILDCONNECT, 0, nullptr, hszTopic, hszService, nullptr, 0, FALSE);
+		const Data* data = findData(hData);
+
+		if (data == nullptr)
+			continue;
+
+		// Copy the (service, topic) pairs, as the data is freed by the server.
+		std::vector<HSZPAIR> pairs(data->m_bytes.size() / sizeof(HSZPAIR));
+
+		if (!pairs.empty())
+			memcpy(&pairs[0], &data->m_bytes[0], Core::numBytes<HSZPAIR>(pairs.size()));
+
+		freeData(hData);
+
+		for (std::vector<HSZPAIR>::const_iterator pair = pairs.begin(); pair != pairs.end(); ++pair)
+		{
+			if (pair->hszSvc == nullptr)
+				break;
+
+			connect(idInst, *it, pair->hszSvc, pair->hszTopic, list);
+		}
+	}
+
+	if (list->m_convs.empty())
+	{
+		s_lists.erase(list);
+		delete list;
+
+		setError(idInst, DMLERR_NO_CONV_ESTABLISHED);
+
+		return nullptr;
+	}
+
+	return reinterpret_cast<HCONVLIST>(list);
+}
+
+HCONV WINAPI brokerQueryNextServer(HCONVLIST hConvList, HCONV hConvPrev)
+{
+	ConvList* list = reinterpret_cast<ConvList*>(hConvList);
+
+	if (s_lists.find(list) == s_lists.end())
+		return nullptr;
+
+	std::vector<Conversation*>& convs = list->m_convs;
+	std::vector<Conversation*>::const_iterator it = convs.begin();
+
+	if (hConvPrev != nullptr)
+	{
+		it = std::find(convs.begin(), convs.end(), reinterpret_cast<Conversation*>(hConvPrev));
+
+		if (it != convs.end())
+			++it;
+	}
+
+	return (it != convs.end()) ? toHandle(*it) : nullptr;
+}
+
+BOOL WINAPI brokerDisconnectList(HCONVLIST hConvList)
+{
+	ConvList* list = reinterpret_cast<ConvList*>(hConvList);
+
+	if (s_lists.find(list) == s_lists.end())
+		return FALSE;
+
+	while (!list->m_convs.empty())
+		disconnect(list->m_convs.back());
+
+	s_lists.erase(list);
+	delete list;
+
+	return TRUE;
+}
+
+UINT WINAPI brokerQueryConvInfo(HCONV hConv, DWORD /*idTransaction*/, PCONVINFO pConvInfo)
+{
+	const Conversation* conv = findConv(hConv);
+
+	if ( (conv == nullptr) || (pConvInfo == nullptr) )
+		return FALSE;
+
+	const DWORD size = pConvInfo->cb;
+
+	memset(pConvInfo, 0, size);
+
+	pConvInfo->cb            = size;
+	pConvInfo->hConvPartner  = toHandle(conv->m_partner);
+	pConvInfo->hszSvcPartner = conv->m_service;
+	pConvInfo->hszServiceReq = conv->m_service;
+	pConvInfo->hszTopic      = conv->m_topic;
+	pConvInfo->wStatus       = static_cast<UINT>(ST_CONNECTED | (conv->m_client ? ST_CLIENT : 0));
+	pConvInfo->wConvst       = XST_CONNECTED;
+	pConvInfo->hConvList     = reinterpret_cast<HCONVLIST>(conv->m_list);
+
+	return TRUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Perform a transaction with the server end of a client conversation. The
+//! result is the data for a request, or TRUE if the server accepted any other
+//! type of transaction.
+
+HDDEDATA execute(Conversation* conv, LPBYTE pData, DWORD cbData, HSZ hszItem, UINT wFmt, UINT wType)
+{
+	const DWORD client = conv->m_inst;
+
+	if (conv->m_partner == nullptr)
+	{
+		setError(client, DMLERR_NO_CONV_ESTABLISHED);
+		return nullptr;
+	}
+
+	Conversation* server = conv->m_partner;
+	HCONV         hServerConv = toHandle(server);
+	const UINT    type = wType & ~(XTYPF_NODATA | XTYPF_ACKREQ);
+	HDDEDATA      result = nullptr;
+
+	switch (type)
+	{
+		case XTYP_REQUEST:
+		{
+			result = callback(server->m_inst, XTYP_REQUEST, wFmt, hServerConv, conv->m_topic, hszItem, nullptr);
+
+			Data* data = findData(result);
+
+			// The client now owns the data.
+			if (data != nullptr)
+				data->m_inst = client;
+			else
+				result = nullptr;
+		}
+		break;
+
+		case XTYP_POKE:
+		case XTYP_EXECUTE:
+		{
+			HDDEDATA hData = reinterpret_cast<HDDEDATA>(pData);
+
+			// Copy raw data, the server owns it for the duration of the callback.
+			if (cbData != static_cast<DWORD>(-1))
+				hData = brokerCreateDataHandle(client, pData, cbData, 0, hszItem, wFmt, 0);
+
+			HDDEDATA ack = callback(server->m_inst, type, wFmt, hServerConv, conv->m_topic, hszItem, hData);
+
+			freeData(hData);
+
+			if (reinterpret_cast<ULONG_PTR>(ack) & DDE_FACK)
+				result = reinterpret_cast<HDDEDATA>(TRUE);
+		}
+		break;
+
+		case XTYP_ADVSTART:
+		{
+			const bool noData = ((wType & XTYPF_NODATA) != 0);
+			Links::iterator it = findLink(server, hszItem, wFmt);
+
+			if (it != server->m_links.end())
+			{
+				it->second.m_noData = noData;
+				result = reinterpret_cast<HDDEDATA>(TRUE);
+			}
+			else if (callback(server->m_inst, XTYP_ADVSTART, wFmt, hServerConv, conv->m_topic, hszItem, nullptr))
+			{
+				// The server may have disconnected from the callback.
+				if (findConv(hServerConv) != nullptr)
+				{
+					Link link = { hszItem, wFmt, noData };
+
+					keepString(hszItem);
+					server->m_links.insert(Links::value_type(LinkKey(hszItem, wFmt), link));
+
+					result = reinterpret_cast<HDDEDATA>(TRUE);
+				}
+			}
+		}
+		break;
+
+		case XTYP_ADVSTOP:
+		{
+			Links::iterator it = findLink(server, hszItem, wFmt);
+
+			if (it != server->m_links.end())
+			{
+				server->m_links.erase(it);
+
+				callback(server->m_inst, XTYP_ADVSTOP, wFmt, hServerConv, conv->m_topic, hszItem, nullptr);
+
+				releaseString(hszItem);
+
+				result = reinterpret_cast<HDDEDATA>(TRUE);
+			}
+		}
+		break;
+
+		default:
+		{
+			setError(client, DMLERR_INVALIDPARAMETER);
+			return nullptr;
+		}
+	}
+
+	if (result == nullptr)
+		setError(client, DMLERR_NOTPROCESSED);
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Queue an asynchronous transaction to be performed by ProcessMessages(). The
+//! transaction ID is returned through the result.
+
+HDDEDATA queueTransaction(Conversation* conv, LPBYTE pData, DWORD cbData, HSZ hszItem, UINT wFmt, UINT wType, LPDWORD pdwResult)
+{
+	const DWORD client = conv->m_inst;
+	const UINT  type = wType & ~(XTYPF_NODATA | XTYPF_ACKREQ);
+	HDDEDATA    hData = nullptr;
+
+	switch (type)
+	{
+		case XTYP_POKE:
+		case XTYP_EXECUTE:
+		{
+			hData = reinterpret_cast<HDDEDATA>(pData);
+
+			// Copy raw data, the caller only owns it for the duration of the call.
+			if (cbData != static_cast<DWORD>(-1))
+				hData = brokerCreateDataHandle(client, pData, cbData, 0, hszItem, wFmt, 0);
+		}
+		break;
+
+		case XTYP_REQUEST:
+		case XTYP_ADVSTART:
+		case XTYP_ADVSTOP:
+		break;
+
+		default:
+		{
+			setError(client, DMLERR_INVALIDPARAMETER);
+			return nullptr;
+		}
+	}
+
+	const DWORD       id = s_nextTransaction++;
+	const Transaction transaction = { toHandle(conv), hszItem, wFmt, wType, hData };
+
+	keepString(hszItem);
+	s_transactions.insert(Transactions::value_type(TransactionKey(client, id), transaction));
+
+	if (pdwResult != nullptr)
+		*pdwResult = id;
+
+	return reinterpret_cast<HDDEDATA>(TRUE);
+}
+
+HDDEDATA WINAPI brokerClientTransaction(LPBYTE pData, DWORD cbData, HCONV hConv, HSZ hszItem, UINT wFmt, UINT wType, DWORD dwTimeout, LPDWORD pdwResult)
+{
+	Conversation* conv = findConv(hConv);
+
+	if (pdwResult != nullptr)
+		*pdwResult = 0;
+
+	if ( (conv == nullptr) || !conv->m_client )
+		return nullptr;
+
+	if (conv->m_partner == nullptr)
+	{
+		setError(conv->m_inst, DMLERR_NO_CONV_ESTABLISHED);
+		return nullptr;
+	}
+
+	if (dwTimeout == TIMEOUT_ASYNC)
+		return queueTransaction(conv, pData, cbData, hszItem, wFmt, wType, pdwResult);
+
+	HDDEDATA result = execute(conv, pData, cbData, hszItem, wFmt, wType);
+
+	if ( (result != nullptr) && (pdwResult != nullptr) )
+		*pdwResult = DDE_FACK;
+
+	return result;
+}
+
+BOOL WINAPI brokerAbandonTransaction(DWORD idInst, HCONV hConv, DWORD idTransaction)
+{
+	if (findInstance(idInst) == nullptr)
+		return FALSE;
+
+	// Abandon all for the conversation or instance?
+	if (idTransaction == 0)
+	{
+		discardTransactions(idInst, hConv);
+		return TRUE;
+	}
+
+	Transactions::iterator it = s_transactions.find(TransactionKey(idInst, idTransaction));
+
+	// Already completed?
+	if ( (it == s_transactions.end()) || ((hConv != nullptr) && (it->second.m_conv != hConv)) )
+	{
+		setError(idInst, DMLERR_UNFOUND_QUEUE_ID);
+		return FALSE;
+	}
+
+	discardTransaction(it);
+
+	return TRUE;
+}
+
+BOOL WINAPI brokerPostAdvise(DWORD idInst, HSZ hszTopic, HSZ hszItem)
+{
+	if (findInstance(idInst) == nullptr)
+		return FALSE;
+
+	// An advise loop to service.
+	struct Advise
+	{
+		Conversation*	m_server;
+		HSZ				m_item;
+		UINT			m_format;
+	};
+
+	// Take a snapshot, as the callbacks may change the links.
+	std::vector<Advise> advises;
+
+	for (std::set<Conversation*>::const_iterator conv = s_convs.begin(); conv != s_convs.end(); ++conv)
+	{
+		if ( ((*conv)->m_inst != idInst) || (*conv)->m_client )
+			continue;
+
+		if ( (hszTopic != nullptr) && ((*conv)->m_topic != hszTopic) )
+			continue;
+
+		const Links&          links = (*conv)->m_links;
+		Links::const_iterator link = links.begin();
+		Links::const_iterator end = links.end();
+
+		// Only the links for the item?
+		if (hszItem != nullptr)
+		{
+			link = links.lower_bound(LinkKey(hszItem, 0));
+			end = links.upper_bound(LinkKey(hszItem, UINT_MAX));
+		}
+
+		for (; link != end; ++link)
+		{
+			Advise advise = { *conv, link->second.m_item, link->second.m_format };
+
+			advises.push_back(advise);
+		}
+	}
+
+	for (size_t i = 0; i != advises.size(); ++i)
+	{
+		Conversation* server = advises[i].m_server;
+		HCONV         hServerConv = toHandle(server);
+
+		if (findConv(hServerConv) == nullptr)
+			continue;
+
+		const HSZ  topic = server->m_topic;
+		const HSZ  item = advises[i].m_item;
+		const UINT format = advises[i].m_format;
+
+		HDDEDATA hData = callback(idInst, XTYP_ADVREQ, format, hServerConv, topic, item, nullptr, advises.size()-i-1);
+
+		// The loop may have been stopped from the callback.
+		if ( (findConv(hServerConv) != nullptr) && (server->m_partner != nullptr) )
+		{
+			Links::const_iterator link = findLink(server, item, format);
+
+			if (link != server->m_links.end())
+			{
+				Conversation* client = server->m_partner;
+				HDDEDATA      hAdvData = link->second.m_noData ? nullptr : hData;
+
+				callback(client->m_inst, XTYP_ADVDATA, format, toHandle(client), topic, item, hAdvData);
+			}
+		}
+
+		freeData(hData);
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI brokerProcessMessages(DWORD idInst, DWORD /*dwTimeout*/)
+{
+	// Any transactions queued from the callbacks are left for the next call.
+	const DWORD last = s_nextTransaction;
+	DWORD       id = 0;
+	BOOL        processed = FALSE;
+
+	for (;;)
+	{
+		Transactions::iterator it = s_transactions.upper_bound(TransactionKey(idInst, id));
+
+		if ( (it == s_transactions.end()) || (it->first.first != idInst) || (it->first.second >= last) )
+			break;
+
+		const Transaction transaction = it->second;
+
+		id = it->first.second;
+		s_transactions.erase(it);
+		processed = TRUE;
+
+		Conversation* conv = findConv(transaction.m_conv);
+
+		ASSERT(conv != nullptr);
+
+		HDDEDATA result = execute(conv, reinterpret_cast<LPBYTE>(transaction.m_data), static_cast<DWORD>(-1),
+									transaction.m_item, transaction.m_format, transaction.m_type);
+
+		// The server may have disconnected from the callback.
+		if (findConv(transaction.m_conv) != nullptr)
+		{
+			const ULONG_PTR ack = (result != nullptr) ? DDE_FACK : 0;
+
+			callback(idInst, XTYP_XACT_COMPLETE, transaction.m_format, transaction.m_conv, conv->m_topic,
+						transaction.m_item, result, id, ack);
+		}
+
+		// The client only owns requested data for the duration of the callback.
+		freeData(result);
+		releaseString(transaction.m_item);
+	}
+
+	return processed;
+}
+
+//! The broker's DDEML functions.
+const DDEApi s_brokerApi =
+{
+	brokerInitialize,
+	brokerUninitialize,
+	brokerGetLastError,
+
+	brokerCreateStringHandle,
+	brokerFreeStringHandle,
+	brokerKeepStringHandle,
+	brokerQueryString,
+
+	brokerCreateDataHandle,
+	brokerAddData,
+	brokerGetData,
+	brokerAccessData,
+	brokerUnaccessData,
+	brokerFreeDataHandle,
+
+	brokerNameService,
+	brokerConnect,
+	brokerDisconnect,
+	brokerConnectList,
+	brokerQueryNextServer,
+	brokerDisconnectList,
+	brokerQueryConvInfo,
+
+	brokerClientTransaction,
+	brokerAbandonTransaction,
+	brokerPostAdvise,
+
+	brokerProcessMessages,
+};
+
+//! Is the broker installed?
+bool s_installed = false;
+
+//namespace
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Install the broker as the DDEML implementation.
+
+void DDEBroker::install()
+{
+	setDDEApi(&s_brokerApi);
+
+	s_installed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Restore the Windows DDEML implementation.
+
+void DDEBroker::uninstall()
+{
+	ASSERT(s_instances.empty());
+
+	setDDEApi(nullptr);
+
+	s_installed = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the broker is installed.
+
+bool DDEBroker::isInstalled()
+{
+	return s_installed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The broker's DDEML function table.
+
+const DDEApi& DDEBroker::api()
+{
+	return s_brokerApi;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Factory function for a DDE client that uses the broker.
+
+IDDEClientPtr DDEBroker::createClient(DWORD flags)
+{
+	install();
+
+	return IDDEClientPtr(new CDDEClient(flags));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Factory function for a DDE server that uses the broker.
+
+IDDEServerPtr DDEBroker::createServer(DWORD flags)
+{
+	install();
+
+	return IDDEServerPtr(new CDDEServer(flags));
+}
+
+//namespace DDE
+}
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBroker.hpp
+//! \brief  The DDEBroker class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEBROKER_HPP
+#define NCL_DDEBROKER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEApi.hpp"
+#include "IDDEClient.hpp"
+#include "IDDEServer.hpp"
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! An in-process implementation of the DDEML functions. Once installed the
+//! CDDEClient and CDDEServer classes talk to each other directly through the
+//! broker instead of via window messages. Transactions are synchronous and no
+//! message loop is required, so the DDE classes can be tested and benchmarked
+//! without any other process. Connect, wild connect, request, poke, execute
+//! and advise loops are supported. Asynchronous transactions are queued and
+//! then completed in order when the client calls ProcessMessages().
+//! The createClient() and createServer() functions can be registered with the
+//! DDEClientFactory and DDEServerFactory to create broker based instances.
+//! NB: The broker must only be used from a single thread.
+
+class DDEBroker
+{
+public:
+	//! Install the broker as the DDEML implementation.
+	static void install();
+
+	//! Restore the Windows DDEML implementation.
+	static void uninstall();
+
+	//! Query if the broker is installed.
+	static bool isInstalled();
+
+	//! The broker's DDEML function table.
+	static const DDEApi& api();
+
+	//! Factory function for a DDE client that uses the broker.
+	static IDDEClientPtr createClient(DWORD flags);
+
+	//! Factory function for a DDE server that uses the broker.
+	static IDDEServerPtr createServer(DWORD flags);
+
+private:
+	// Static class.
+	DDEBroker();
+	~DDEBroker();
+};
+
+//namespace DDE
+}
+
+#endif // NCL_DDEBROKER_HPP
@@ -51,8 +51,10 @@ CDDEClient* CDDEClient::g_pDDEClient = NULL;
 //! Constructor.
 
 CDDEClient::CDDEClient(DWORD dwFlags)
-	: m_defaultTimeout(DEFAULT_TIMEOUT)
+	: CDDEInst(sizeof(CDDECltConv))
+	, m_defaultTimeout(DEFAULT_TIMEOUT)
 	, m_aoConvs()
+	, m_oConvIndex()
 	, m_aoListeners()
 {
 	m_eType = CLIENT;
@@ -94,7 +96,7 @@ CDDEClient::~CDDEClient()
 void CDDEClient::Initialise(DWORD dwFlags)
 {
 	// Register with DDEML.
-	UINT nResult = ::DdeInitialize(&m_dwInst, DDECallbackProc, APPCMD_CLIENTONLY | dwFlags, 0);
+	UINT nResult = DDE::ddeApi().Initialize(&m_dwInst, DDECallbackProc, APPCMD_CLIENTONLY | dwFlags, 0);
 
 	// Failed?
 	if (nResult != DMLERR_NO_ERROR)
@@ -120,14 +122,18 @@ void CDDEClient::Uninitialise()
 	// Clean-up.
 	if (m_dwInst != 0)
 	{
-		BOOL okay = ::DdeUninitialize(m_dwInst);
+		BOOL okay = DDE::ddeApi().Uninitialize(m_dwInst);
 
 		ASSERT_RESULT(okay, okay != FALSE);
 	}
 
+	// The string handles were freed with the instance.
+	m_oStrings.Reset();
+
 	// Reset members.
 	m_dwInst = 0;
 	m_aoConvs.clear();
+	m_oConvIndex.Clear();
 	m_aoListeners.clear();
 }
 
@@ -161,17 +167,18 @@ DDE::IDDECltConv* CDDEClient::CreateConversation(const tchar* pszService, const
 		CDDEString strTopic(this, pszTopic);
 
 		// Attempt to connect to the service/topic.
-		HCONV hConv = ::DdeConnect(m_dwInst, strService, strTopic, nullptr);
+		HCONV hConv = DDE::ddeApi().Connect(m_dwInst, strService, strTopic, nullptr);
 
 		// Connect failed?
 		if (hConv == NULL)
-			throw CDDEException(CDDEException::E_CONN_FAILED, ::DdeGetLastError(m_dwInst));
+			throw CDDEException(CDDEException::E_CONN_FAILED, DDE::ddeApi().GetLastError(m_dwInst));
 
 		// Create conversation.
-		pConv = new CDDECltConv(this, hConv, pszService, pszTopic, m_defaultTimeout);
+		pConv = new(ConvPool()) CDDECltConv(this, hConv, pszService, pszTopic, m_defaultTimeout);
 
 		// Add to collection.
 		m_aoConvs.push_back(pConv);
+		m_oConvIndex.Insert(pConv, m_aoConvs.size()-1);
 	}
 
 	// New reference.
@@ -195,10 +202,11 @@ DDE::IDDECltConv* CDDEClient::CreateConversation(const tchar* pszService, const
 void CDDEClient::DestroyConversation(DDE::IDDECltConv* pIConv)
 {
 	ASSERT(pIConv != nullptr);
-	ASSERT(std::find(m_aoConvs.begin(), m_aoConvs.end(), pIConv) != m_aoConvs.end());
 
 	CDDECltConv* pConv = static_cast<CDDECltConv*>(pIConv);
 
+	ASSERT(m_oConvIndex.Contains(pConv));
+
 	// Last reference?
 	if (--pConv->m_nRefCount == 0)
 	{
@@ -206,7 +214,7 @@ void CDDEClient::DestroyConversation(DDE::IDDECltConv* pIConv)
 		pConv->Disconnect();
 
 		// Remove from collection.
-		m_aoConvs.erase(std::find(m_aoConvs.begin(), m_aoConvs.end(), pConv));
+		RemoveConversation(pConv);
 
 		// Delete conversation.
 		delete pConv;
@@ -216,7 +224,8 @@ void CDDEClient::DestroyConversation(DDE::IDDECltConv* pIConv)
 /******************************************************************************
 ** Method:		FindConversation()
 **
-** Description:	Find an existing conversation.
+** Description:	Find an existing conversation. The service and topic names
+**				are not case-sensitive.
 **
 ** Parameters:	pszService	The service name.
 **				pszTopic	The topic name.
@@ -233,30 +242,49 @@ DDE::IDDECltConv* CDDEClient::FindConversation(const tchar* pszService, const tc
 	ASSERT(pszTopic   != nullptr);
 	ASSERT(m_dwInst   != 0);
 
-	// Search the conversation list.
-	for (size_t i = 0, n = m_aoConvs.size(); i != n; ++i)
-	{
-		IDDECltConv* pConv = m_aoConvs[i];
+	// Every conversation interns its service and topic names.
+	HSZ hszService = m_oStrings.Find(pszService);
+	HSZ hszTopic   = m_oStrings.Find(pszTopic);
 
-		if ( (pConv->Service() == pszService) && (pConv->Topic() == pszTopic) )
-			return pConv;
-	}
+	if ( (hszService == NULL) || (hszTopic == NULL) )
+		return nullptr;
 
-	return nullptr;
+	return static_cast<CDDECltConv*>(m_oConvIndex.Find(hszService, hszTopic));
 }
 
 DDE::IDDECltConv* CDDEClient::FindConversation(HCONV hConv) const
 {
-	// Search the conversation list.
-	for (size_t i = 0, n = m_aoConvs.size(); i != n; ++i)
-	{
-		CDDECltConv* pConv = static_cast<CDDECltConv*>(m_aoConvs[i]);
+	return static_cast<CDDECltConv*>(m_oConvIndex.Find(hConv));
+}
 
-		if (pConv->Handle() == hConv)
-			return pConv;
-	}
+/******************************************************************************
+** Method:		RemoveConversation()
+**
+** Description:	Remove a conversation from the collection by moving the last
+**				one into its place.
+**
+** Parameters:	pConv	The conversation.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDEClient::RemoveConversation(CDDECltConv* pConv)
+{
+	ASSERT(pConv != nullptr);
 
-	return nullptr;
+	size_t nPos = m_oConvIndex.Erase(pConv);
+
+	ASSERT(m_aoConvs[nPos] == pConv);
+
+	CDDECltConv* pLast = static_cast<CDDECltConv*>(m_aoConvs.back());
+
+	m_aoConvs[nPos] = pLast;
+	m_aoConvs.pop_back();
+
+	if (pLast != pConv)
+		m_oConvIndex.Move(pLast, nPos);
 }
 
 /******************************************************************************
@@ -341,7 +369,9 @@ void CDDEClient::OnUnregister(const tchar* pszBaseName, const tchar* pszInstName
 /******************************************************************************
 ** Method:		OnDisconnect()
 **
-** Description:	A conversation was terminated by the server.
+** Description:	A conversation was terminated by the server. Any outstanding
+**				asynchronous transactions are failed first, as DDEML will
+**				not complete them.
 **
 ** Parameters:	hConv	The conversation.
 **
@@ -353,12 +383,25 @@ void CDDEClient::OnUnregister(const tchar* pszBaseName, const tchar* pszInstName
 void CDDEClient::OnDisconnect(HCONV hConv)
 {
 	// Find the conversation from the handle.
-	IDDECltConv* pConv = FindConversation(hConv);
+	CDDECltConv* pConv = static_cast<CDDECltConv*>(FindConversation(hConv));
 
 	ASSERT(pConv != nullptr);
 
+	CDDEAsyncTransactions aoFailed;
+
+	pConv->FailTransactions(DMLERR_NO_CONV_ESTABLISHED, aoFailed);
+
+	for (size_t i = 0, n = aoFailed.size(); i != n; ++i)
+	{
+		for (size_t j = 0, m = m_aoListeners.size(); j != m; ++j)
+			m_aoListeners[j]->OnTransactionComplete(pConv, aoFailed[i], nullptr);
+	}
+
 	for (size_t i = 0, n = m_aoListeners.size(); i != n; ++i)
 		m_aoListeners[i]->OnDisconnect(pConv);
+
+	// The handle may be reused before the conversation is destroyed.
+	m_oConvIndex.EraseHandle(pConv);
 }
 
 /******************************************************************************
@@ -398,6 +441,65 @@ void CDDEClient::OnAdvise(HCONV hConv, const tchar* /*pszTopic*/, const tchar* p
 		m_aoListeners[i]->OnAdvise(pLink, pData);
 }
 
+/******************************************************************************
+** Method:		OnTransactionComplete()
+**
+** Description:	An asynchronous transaction has completed.
+**
+** Parameters:	hConv		The conversation.
+**				dwTransID	The transaction ID.
+**				nFormat		The clipboard format.
+**				hData		The data for a request, or the result for others.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDEClient::OnTransactionComplete(HCONV hConv, DWORD dwTransID, uint nFormat, HDDEDATA hData)
+{
+	// Find the conversation for the handle.
+	CDDECltConv* pConv = static_cast<CDDECltConv*>(FindConversation(hConv));
+
+	// Already destroyed?
+	if (pConv == nullptr)
+		return;
+
+	DDE::AsyncTransaction oTransaction(dwTransID, 0, TXT(""), nFormat);
+
+	// Batched or cancelled?
+	if (!pConv->OnTransactionComplete(dwTransID, nFormat, hData, oTransaction))
+		return;
+
+	// Only a request returns data.
+	const bool     bData = (oTransaction.m_type == XTYP_REQUEST) && (hData != NULL);
+	const CDDEData oData(this, bData ? hData : NULL, nFormat, false);
+
+	for (size_t i = 0, n = m_aoListeners.size(); i != n; ++i)
+		m_aoListeners[i]->OnTransactionComplete(pConv, oTransaction, bData ? &oData : nullptr);
+}
+
+/******************************************************************************
+** Method:		ProcessMessages()
+**
+** Description:	Dispatch any pending messages, which includes the completion
+**				of asynchronous transactions. An application with a message
+**				loop does not need to call this.
+**
+** Parameters:	dwTimeout	The time to wait for a message (ms).
+**
+** Returns:		true if any messages were dispatched.
+**
+*******************************************************************************
+*/
+
+bool CDDEClient::ProcessMessages(DWORD dwTimeout)
+{
+	ASSERT(m_dwInst != 0);
+
+	return (DDE::ddeApi().ProcessMessages(m_dwInst, dwTimeout) != FALSE);
+}
+
 /******************************************************************************
 ** Method:		QueryServers()
 **
@@ -413,7 +515,7 @@ void CDDEClient::OnAdvise(HCONV hConv, const tchar* /*pszTopic*/, const tchar* p
 void CDDEClient::QueryServers(CStrArray& astrServers) const
 {
 	// Query all servers.
-	HCONVLIST hList = ::DdeConnectList(m_dwInst, NULL, NULL, NULL, nullptr);
+	HCONVLIST hList = DDE::ddeApi().ConnectList(m_dwInst, NULL, NULL, NULL, nullptr);
 
 	// Failed?
 	if (hList == NULL)
@@ -422,14 +524,14 @@ void CDDEClient::QueryServers(CStrArray& astrServers) const
 	HCONV hConv = NULL;
 
 	// For all servers...
-	while ((hConv = ::DdeQueryNextServer(hList, hConv)) != NULL)
+	while ((hConv = DDE::ddeApi().QueryNextServer(hList, hConv)) != NULL)
 	{
 		CONVINFO oConvInfo = { sizeof(oConvInfo), 0 };
 
 		// Query server details.
-		if (!::DdeQueryConvInfo(hConv, QID_SYNC, &oConvInfo))
+		if (!DDE::ddeApi().QueryConvInfo(hConv, QID_SYNC, &oConvInfo))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
@@ -438,9 +540,9 @@ void CDDEClient::QueryServers(CStrArray& astrServers) const
 		tchar szServer[MAX_LEN];
 
 		// Get the server name.
-		if (!::DdeQueryString(m_dwInst, oConvInfo.hszSvcPartner, szServer, MAX_LEN, CP_WIN_TCHAR))
+		if (!DDE::ddeApi().QueryString(m_dwInst, oConvInfo.hszSvcPartner, szServer, MAX_LEN, CP_WIN_TCHAR))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
@@ -450,7 +552,7 @@ void CDDEClient::QueryServers(CStrArray& astrServers) const
 	}
 
 	// Free connection list.
-	::DdeDisconnectList(hList);
+	DDE::ddeApi().DisconnectList(hList);
 }
 
 /******************************************************************************
@@ -473,7 +575,7 @@ void CDDEClient::QueryServerTopics(const tchar* pszServer, CStrArray& astrTopics
 	CDDEString strServer(g_pDDEClient, pszServer);
 
 	// Query all servers.
-	HCONVLIST hList = ::DdeConnectList(m_dwInst, strServer, NULL, NULL, nullptr);
+	HCONVLIST hList = DDE::ddeApi().ConnectList(m_dwInst, strServer, NULL, NULL, nullptr);
 
 	// Failed?
 	if (hList == NULL)
@@ -482,14 +584,14 @@ void CDDEClient::QueryServerTopics(const tchar* pszServer, CStrArray& astrTopics
 	HCONV hConv = NULL;
 
 	// For all servers...
-	while ((hConv = ::DdeQueryNextServer(hList, hConv)) != NULL)
+	while ((hConv = DDE::ddeApi().QueryNextServer(hList, hConv)) != NULL)
 	{
 		CONVINFO oConvInfo = { sizeof(oConvInfo), 0 };
 
 		// Query server details.
-		if (!::DdeQueryConvInfo(hConv, QID_SYNC, &oConvInfo))
+		if (!DDE::ddeApi().QueryConvInfo(hConv, QID_SYNC, &oConvInfo))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
@@ -497,9 +599,9 @@ void CDDEClient::QueryServerTopics(const tchar* pszServer, CStrArray& astrTopics
 
 		// Get the server name.
 		// NB: Some servers will return all service names regardless.
-		if (!::DdeQueryString(m_dwInst, oConvInfo.hszSvcPartner, szServer, MAX_SERVER_LEN, CP_WIN_TCHAR))
+		if (!DDE::ddeApi().QueryString(m_dwInst, oConvInfo.hszSvcPartner, szServer, MAX_SERVER_LEN, CP_WIN_TCHAR))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
@@ -510,9 +612,9 @@ void CDDEClient::QueryServerTopics(const tchar* pszServer, CStrArray& astrTopics
 		tchar szTopic[MAX_TOPIC_LEN] = { 0 };
 
 		// Get the topic name.
-		if (!::DdeQueryString(m_dwInst, oConvInfo.hszTopic, szTopic, MAX_TOPIC_LEN, CP_WIN_TCHAR))
+		if (!DDE::ddeApi().QueryString(m_dwInst, oConvInfo.hszTopic, szTopic, MAX_TOPIC_LEN, CP_WIN_TCHAR))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
@@ -520,7 +622,7 @@ void CDDEClient::QueryServerTopics(const tchar* pszServer, CStrArray& astrTopics
 	}
 
 	// Free connection list.
-	::DdeDisconnectList(hList);
+	DDE::ddeApi().DisconnectList(hList);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -529,7 +631,7 @@ void CDDEClient::QueryServerTopics(const tchar* pszServer, CStrArray& astrTopics
 void CDDEClient::QueryAll(CStrArray& astrServers, CStrArray& astrTopics) const
 {
 	// Query all servers.
-	HCONVLIST hList = ::DdeConnectList(m_dwInst, NULL, NULL, NULL, nullptr);
+	HCONVLIST hList = DDE::ddeApi().ConnectList(m_dwInst, NULL, NULL, NULL, nullptr);
 
 	// Failed?
 	if (hList == NULL)
@@ -538,32 +640,32 @@ void CDDEClient::QueryAll(CStrArray& astrServers, CStrArray& astrTopics) const
 	HCONV hConv = NULL;
 
 	// For all servers & topics...
-	while ((hConv = ::DdeQueryNextServer(hList, hConv)) != NULL)
+	while ((hConv = DDE::ddeApi().QueryNextServer(hList, hConv)) != NULL)
 	{
 		CONVINFO oConvInfo = { sizeof(oConvInfo), 0 };
 
 		// Query server details.
-		if (!::DdeQueryConvInfo(hConv, QID_SYNC, &oConvInfo))
+		if (!DDE::ddeApi().QueryConvInfo(hConv, QID_SYNC, &oConvInfo))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
 		tchar szServer[MAX_SERVER_LEN+1] = { 0 };
 
 		// Get the server name.
-		if (!::DdeQueryString(m_dwInst, oConvInfo.hszSvcPartner, szServer, MAX_SERVER_LEN, CP_WIN_TCHAR))
+		if (!DDE::ddeApi().QueryString(m_dwInst, oConvInfo.hszSvcPartner, szServer, MAX_SERVER_LEN, CP_WIN_TCHAR))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
 		tchar szTopic[MAX_TOPIC_LEN+1] = { 0 };
 
 		// Get the topic name.
-		if (!::DdeQueryString(m_dwInst, oConvInfo.hszTopic, szTopic, MAX_TOPIC_LEN, CP_WIN_TCHAR))
+		if (!DDE::ddeApi().QueryString(m_dwInst, oConvInfo.hszTopic, szTopic, MAX_TOPIC_LEN, CP_WIN_TCHAR))
 		{
-			::DdeDisconnectList(hList);
+			DDE::ddeApi().DisconnectList(hList);
 			throw CDDEException(CDDEException::E_QUERY_FAILED, LastError());
 		}
 
@@ -573,7 +675,7 @@ void CDDEClient::QueryAll(CStrArray& astrServers, CStrArray& astrTopics) const
 	}
 
 	// Free connection list.
-	::DdeDisconnectList(hList);
+	DDE::ddeApi().DisconnectList(hList);
 }
 
 /******************************************************************************
@@ -588,7 +690,7 @@ void CDDEClient::QueryAll(CStrArray& astrServers, CStrArray& astrTopics) const
 *******************************************************************************
 */
 
-HDDEDATA CALLBACK CDDEClient::DDECallbackProc(UINT uType, UINT uFormat, HCONV hConv, HSZ hsz1, HSZ hsz2, HDDEDATA hData, ULONG_PTR /*dwData1*/, ULONG_PTR /*dwData2*/)
+HDDEDATA CALLBACK CDDEClient::DDECallbackProc(UINT uType, UINT uFormat, HCONV hConv, HSZ hsz1, HSZ hsz2, HDDEDATA hData, ULONG_PTR dwData1, ULONG_PTR /*dwData2*/)
 {
 	ASSERT(g_pDDEClient != nullptr);
 
@@ -645,6 +747,13 @@ HDDEDATA CALLBACK CDDEClient::DDECallbackProc(UINT uType, UINT uFormat, HCONV hC
 		}
 		break;
 
+		// Asynchronous transaction completed?
+		case XTYP_XACT_COMPLETE:
+		{
+			g_pDDEClient->OnTransactionComplete(hConv, static_cast<DWORD>(dwData1), uFormat, hData);
+		}
+		break;
+
 		// Unknown message.
 		default:
 		{
@@ -19,6 +19,7 @@
 #include "DDEFwd.hpp"
 #include "IDDEClient.hpp"
 #include "DDEInst.hpp"
+#include "DDEConvIndex.hpp"
 #include <vector>
 
 // Template shorthands.
@@ -78,6 +79,9 @@ public:
 	void AddListener(IDDEClientListener* pListener);
 	void RemoveListener(IDDEClientListener* pListener);
 
+	//! Dispatch pending messages, such as completed asynchronous transactions.
+	bool ProcessMessages(DWORD dwTimeout = 0);
+
 	//
 	// Server query methods.
 	//
@@ -96,6 +100,7 @@ protected:
 	//
 	DWORD			m_defaultTimeout;	//!< The default time-out for transactions (ms).
 	CDDECltConvs	m_aoConvs;		// The list of conversations.
+	DDE::ConvIndex	m_oConvIndex;	//!< The conversations by handle and name.
 	CListeners		m_aoListeners;	// The list of event listeners.
 
 	//
@@ -104,6 +109,11 @@ protected:
 	void Initialise(DWORD dwFlags);
 	void Uninitialise();
 
+	//
+	// Internal methods.
+	//
+	void RemoveConversation(CDDECltConv* pConv);
+
 	//
 	// DDECallback handlers.
 	//
@@ -111,6 +121,7 @@ protected:
 	void OnUnregister(const tchar* pszBaseName, const tchar* pszInstName);
 	void OnDisconnect(HCONV hConv);
 	void OnAdvise(HCONV hConv, const tchar* pszTopic, const tchar* pszItem, uint nFormat, const CDDEData* pData);
+	void OnTransactionComplete(HCONV hConv, DWORD dwTransID, uint nFormat, HDDEDATA hData);
 
 	// The DDE Callback function.
 	static HDDEDATA CALLBACK DDECallbackProc(UINT uType, UINT uFormat, HCONV hConv, HSZ hsz1, HSZ hsz2, HDDEDATA hData, ULONG_PTR dwData1, ULONG_PTR dwData2);
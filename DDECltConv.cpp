@@ -15,8 +15,9 @@
 #include "DDEData.hpp"
 #include "DDEString.hpp"
 #include "DDEException.hpp"
+#include "DDETextCodec.hpp"
 #include <Core/AnsiWide.hpp>
-#include <algorithm>
+#include <vector>
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -36,6 +37,10 @@ CDDECltConv::CDDECltConv(CDDEClient* client, HCONV hConv, const tchar* pszServic
 	, m_client(client)
 	, m_timeout(timeout)
 	, m_aoLinks()
+	, m_oLinkIndex()
+	, m_pBatch(nullptr)
+	, m_nBatchType(0)
+	, m_oPending()
 {
 }
 
@@ -54,9 +59,10 @@ CDDECltConv::CDDECltConv(CDDEClient* client, HCONV hConv, const tchar* pszServic
 CDDECltConv::~CDDECltConv()
 {
 	ASSERT(m_nRefCount == 0);
+	ASSERT(m_pBatch == nullptr);
 
 	// Delete all links.
-	for (size_t i = 0, n = m_aoLinks.size(); i != n; ++i)
+	for (size_t i = 0, n = m_aoLinks.Size(); i != n; ++i)
 	{
 		CDDELink* pLink = m_aoLinks[i];
 
@@ -66,6 +72,42 @@ CDDECltConv::~CDDECltConv()
 	}
 }
 
+/******************************************************************************
+** Method:		BatchReference::Constructor.
+**
+** Description:	Add a reference to the conversation for the batch.
+**
+** Parameters:	pConv		The conversation.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CDDECltConv::BatchReference::BatchReference(CDDECltConv* pConv)
+	: m_pConv(pConv)
+{
+	++m_pConv->m_nRefCount;
+}
+
+/******************************************************************************
+** Method:		BatchReference::Destructor.
+**
+** Description:	Release the reference to the conversation. If the client has
+**				destroyed it during the batch it is deleted now.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CDDECltConv::BatchReference::~BatchReference()
+{
+	m_pConv->m_client->DestroyConversation(m_pConv);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the DDE Client that this conversation belongs to.
 
@@ -118,7 +160,7 @@ CDDEData CDDECltConv::Request(const tchar* pszItem, uint nFormat) const
 	DWORD      dwResult;
 
 	// Make the request.
-	HDDEDATA hData = ::DdeClientTransaction(nullptr, 0, m_hConv, strItem, nFormat, XTYP_REQUEST, m_timeout, &dwResult);
+	HDDEDATA hData = DDE::ddeApi().ClientTransaction(nullptr, 0, m_hConv, strItem, nFormat, XTYP_REQUEST, m_timeout, &dwResult);
 
 	// Request failed?
 	if (hData == NULL)
@@ -127,6 +169,192 @@ CDDEData CDDECltConv::Request(const tchar* pszItem, uint nFormat) const
 	return CDDEData(m_pInst, hData, nFormat, true);
 }
 
+/******************************************************************************
+** Method:		RequestMany()
+**
+** Description:	Request many items from the server in one batch. All the
+**				requests are started asynchronously and then the completions
+**				are collected, so the server answers them back-to-back instead
+**				of each one waiting for a round-trip. Any requests outstanding
+**				when no completion has arrived within the timeout are abandoned.
+**				NB: Messages are dispatched whilst waiting for the completions.
+**
+** Parameters:	astrItems	The items to request.
+**				nFormat		The format of the data.
+**				aoResults	The returned results, in the same order as the
+**							items. Failed requests have their error set.
+**
+** Returns:		The time taken for the whole batch (ms).
+**
+*******************************************************************************
+*/
+
+DWORD CDDECltConv::RequestMany(const CStrArray& astrItems, uint nFormat, DDE::RequestResults& aoResults)
+{
+	const DWORD dwStart = ::GetTickCount();
+
+	aoResults.clear();
+	aoResults.reserve(astrItems.Size());
+
+	BatchReference oReference(this);
+
+	BeginBatch(XTYP_REQUEST, aoResults);
+
+	try
+	{
+		// Start all the requests.
+		for (size_t i = 0, n = astrItems.Size(); i != n; ++i)
+		{
+			CDDEString strItem(m_pInst, astrItems[i]);
+
+			AddToBatch(strItem, astrItems[i], nFormat);
+		}
+
+		EndBatch();
+	}
+	catch (...)
+	{
+		AbandonRequests();
+		throw;
+	}
+
+	return ::GetTickCount() - dwStart;
+}
+
+/******************************************************************************
+** Method:		BeginBatch()
+**
+** Description:	Start a batch of asynchronous transactions of a single type.
+**				Only one batch can be in progress at a time.
+**
+** Parameters:	nType		The XTYP_ transaction type.
+**				aoResults	The results of the batch.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CDDEException if a batch is already in progress, e.g. when
+**				started by a listener whilst the batch is dispatching.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::BeginBatch(uint nType, DDE::RequestResults& aoResults)
+{
+	// Nested batch?
+	if (m_pBatch != nullptr)
+	{
+		int nError = (nType == XTYP_REQUEST) ? CDDEException::E_REQUEST_FAILED : CDDEException::E_LINK_FAILED;
+
+		throw CDDEException(nError, DMLERR_REENTRANCY);
+	}
+
+	ASSERT(m_oPending.empty());
+
+	m_pBatch     = &aoResults;
+	m_nBatchType = nType;
+}
+
+/******************************************************************************
+** Method:		AddToBatch()
+**
+** Description:	Start a transaction for an item in the batch. A transaction
+**				that fails to start has its error set.
+**
+** Parameters:	hszItem		The item handle.
+**				pszItem		The item.
+**				nFormat		The item data format.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::AddToBatch(HSZ hszItem, const tchar* pszItem, uint nFormat)
+{
+	ASSERT(m_pBatch != nullptr);
+
+	const size_t nIndex    = m_pBatch->size();
+	DWORD        dwTransID = 0;
+
+	m_pBatch->push_back(DDE::RequestResult(pszItem, CDDEData(m_pInst, static_cast<HDDEDATA>(NULL), nFormat, false)));
+
+	HDDEDATA hResult = DDE::ddeApi().ClientTransaction(nullptr, 0, m_hConv, hszItem, nFormat, m_nBatchType, TIMEOUT_ASYNC, &dwTransID);
+
+	if (hResult != NULL)
+		m_oPending[dwTransID] = nIndex;
+	else
+		m_pBatch->back().m_error = TransactionError();
+}
+
+/******************************************************************************
+** Method:		EndBatch()
+**
+** Description:	Wait for the transactions in the batch to complete and then end
+**				the batch. Any transactions outstanding when no completion has
+**				arrived within the timeout are abandoned.
+**				NB: Messages are dispatched whilst waiting for the completions.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::EndBatch()
+{
+	ASSERT(m_pBatch != nullptr);
+
+	DWORD dwProgress = ::GetTickCount();
+	DWORD dwWaited   = 0;
+
+	// Collect the results, until they stop arriving.
+	while (!m_oPending.empty() && (dwWaited < m_timeout))
+	{
+		const size_t nPending = m_oPending.size();
+
+		if (!DDE::ddeApi().ProcessMessages(m_pInst->Handle(), m_timeout - dwWaited))
+			break;
+
+		const DWORD dwNow = ::GetTickCount();
+
+		if (m_oPending.size() != nPending)
+			dwProgress = dwNow;
+
+		dwWaited = dwNow - dwProgress;
+	}
+
+	AbandonRequests();
+}
+
+/******************************************************************************
+** Method:		AbandonRequests()
+**
+** Description:	Abandon the outstanding requests in the batch, which are marked
+**				as having timed out, and end the batch.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::AbandonRequests()
+{
+	ASSERT(m_pBatch != nullptr);
+
+	for (CDDEPendingRequests::const_iterator it = m_oPending.begin(); it != m_oPending.end(); ++it)
+	{
+		DDE::ddeApi().AbandonTransaction(m_pInst->Handle(), m_hConv, it->first);
+
+		(*m_pBatch)[it->second].m_error = DMLERR_DATAACKTIMEOUT;
+	}
+
+	m_oPending.clear();
+	m_pBatch = nullptr;
+}
+
 /******************************************************************************
 ** Methods:		Execute()
 **
@@ -162,8 +390,8 @@ void CDDECltConv::Execute(const void* pValue, size_t nSize) const
 	LPBYTE lpData = static_cast<byte*>(const_cast<void*>(pValue));
 
 	// Execute it.
-	HDDEDATA hResult = ::DdeClientTransaction(lpData, static_cast<DWORD>(nSize), m_hConv,
-												NULL, 0, XTYP_EXECUTE, m_timeout, nullptr);
+	HDDEDATA hResult = DDE::ddeApi().ClientTransaction(lpData, static_cast<DWORD>(nSize), m_hConv,
+														NULL, 0, XTYP_EXECUTE, m_timeout, nullptr);
 
 	// Execute failed?
 	if (hResult == NULL)
@@ -188,10 +416,36 @@ void CDDECltConv::PokeString(const tchar* pszItem, const tchar* pszValue, uint n
 {
 	ASSERT((nFormat == CF_TEXT) || (nFormat == CF_UNICODETEXT));
 
+	// Include the terminator.
+	size_t nChars = tstrlen(pszValue)+1;
+
+#ifdef ANSI_BUILD
 	if (nFormat == CF_TEXT)
-		Poke(pszItem, CF_TEXT, T2A(pszValue), Core::numBytes<char>(tstrlen(pszValue)+1));
+	{
+		Poke(pszItem, CF_TEXT, pszValue, Core::numBytes<char>(nChars));
+	}
 	else
-		Poke(pszItem, CF_UNICODETEXT, T2W(pszValue), Core::numBytes<wchar_t>(tstrlen(pszValue)+1));
+	{
+		std::vector<wchar_t> vBuffer(nChars);
+
+		DDE::ansiToUtf16(pszValue, nChars, &vBuffer[0]);
+
+		Poke(pszItem, CF_UNICODETEXT, &vBuffer[0], Core::numBytes<wchar_t>(nChars));
+	}
+#else
+	if (nFormat == CF_TEXT)
+	{
+		std::vector<char> vBuffer(nChars);
+
+		DDE::utf16ToAnsi(pszValue, nChars, &vBuffer[0]);
+
+		Poke(pszItem, CF_TEXT, &vBuffer[0], Core::numBytes<char>(nChars));
+	}
+	else
+	{
+		Poke(pszItem, CF_UNICODETEXT, pszValue, Core::numBytes<wchar_t>(nChars));
+	}
+#endif
 }
 
 void CDDECltConv::Poke(const tchar* pszItem, uint nFormat, const void* pValue, size_t nSize) const
@@ -204,8 +458,8 @@ void CDDECltConv::Poke(const tchar* pszItem, uint nFormat, const void* pValue, s
 	LPBYTE lpData = static_cast<byte*>(const_cast<void*>(pValue));
 
 	// Do the poke.
-	HDDEDATA hResult = ::DdeClientTransaction(lpData, static_cast<DWORD>(nSize), m_hConv,
-												strItem, nFormat, XTYP_POKE, m_timeout, nullptr);
+	HDDEDATA hResult = DDE::ddeApi().ClientTransaction(lpData, static_cast<DWORD>(nSize), m_hConv,
+														strItem, nFormat, XTYP_POKE, m_timeout, nullptr);
 
 	// Poke failed?
 	if (hResult == NULL)
@@ -238,17 +492,18 @@ CDDELink* CDDECltConv::CreateLink(const tchar* pszItem, uint nFormat)
 		DWORD      dwResult;
 
 		// Attempt to start the advise loop.
-		HDDEDATA hData = ::DdeClientTransaction(nullptr, 0, m_hConv, strItem, nFormat, XTYP_ADVSTART, m_timeout, &dwResult);
+		HDDEDATA hData = DDE::ddeApi().ClientTransaction(nullptr, 0, m_hConv, strItem, nFormat, XTYP_ADVSTART, m_timeout, &dwResult);
 
 		// Advise failed?
 		if (hData == NULL)
 			throw CDDEException(CDDEException::E_LINK_FAILED, m_pInst->LastError());
 
 		// Create link.
-		pLink = new CDDELink(this, pszItem, nFormat);
+		pLink = new(m_pInst->LinkPool()) CDDELink(m_pInst, this, pszItem, nFormat);
 
 		// Add to collection.
-		m_aoLinks.push_back(pLink);
+		m_aoLinks.Add(pLink);
+		m_oLinkIndex.Insert(pszItem, nFormat, pLink);
 	}
 
 	// New reference.
@@ -276,17 +531,17 @@ void CDDECltConv::DestroyLink(CDDELink* pLink)
 	// Last reference?
 	if (--pLink->m_nRefCount == 0)
 	{
-		CDDEString strItem(m_pInst, pLink->Item());
-		DWORD      dwResult;
+		DWORD dwResult;
 
 		// End advise.
-		::DdeClientTransaction(nullptr, 0, m_hConv, strItem, pLink->Format(), XTYP_ADVSTOP, m_timeout, &dwResult);
+		DDE::ddeApi().ClientTransaction(nullptr, 0, m_hConv, pLink->ItemHandle(), pLink->Format(), XTYP_ADVSTOP, m_timeout, &dwResult);
+
+		// Remove from collection.
+		m_oLinkIndex.Erase(pLink->Item(), pLink->Format());
+		m_aoLinks.Remove(pLink);
 
 		// Delete link.
 		delete pLink;
-
-		// Remove from collection.
-		m_aoLinks.erase(std::find(m_aoLinks.begin(), m_aoLinks.end(), pLink));
 	}
 }
 
@@ -304,14 +559,199 @@ void CDDECltConv::DestroyLink(CDDELink* pLink)
 
 void CDDECltConv::DestroyAllLinks()
 {
-	while (!m_aoLinks.empty())
-		DestroyLink(m_aoLinks[0]);
+	CDDECltLinks aoLinks(m_aoLinks.Items());
+
+	// Drop all but the last reference.
+	for (size_t i = 0, n = aoLinks.size(); i != n; ++i)
+		aoLinks[i]->m_nRefCount = 1;
+
+	DestroyLinks(aoLinks);
+}
+
+/******************************************************************************
+** Method:		CreateLinks()
+**
+** Description:	Creates advise loops for many items in one batch. The advise
+**				transactions for the items not already linked are started
+**				asynchronously and then the completions are collected, so the
+**				server answers them back-to-back instead of each one waiting
+**				for a round-trip.
+**				NB: Messages are dispatched whilst waiting for the completions.
+**
+** Parameters:	astrItems	The items to link to.
+**				nFormat		The item data format.
+**				aoLinks		The returned links, in the same order as the items.
+**							The link is nullptr if the advise loop failed.
+**
+** Returns:		The number of links returned.
+**
+*******************************************************************************
+*/
+
+size_t CDDECltConv::CreateLinks(const CStrArray& astrItems, uint nFormat, CDDECltLinks& aoLinks)
+{
+	const size_t        nItems = astrItems.Size();
+	std::vector<size_t> anBatch(nItems, Core::npos);
+	DDE::RequestResults aoResults;
+
+	aoResults.reserve(nItems);
+
+	BatchReference oReference(this);
+
+	BeginBatch(XTYP_ADVSTART, aoResults);
+
+	try
+	{
+		// Start the advise loops that don't already exist.
+		for (size_t i = 0; i != nItems; ++i)
+		{
+			if (FindLink(astrItems[i], nFormat) != nullptr)
+				continue;
+
+			CDDEString strItem(m_pInst, astrItems[i]);
+
+			anBatch[i] = aoResults.size();
+			AddToBatch(strItem, astrItems[i], nFormat);
+		}
+
+		EndBatch();
+	}
+	catch (...)
+	{
+		AbandonRequests();
+		throw;
+	}
+
+	size_t nLinks = 0;
+
+	aoLinks.clear();
+	aoLinks.reserve(nItems);
+	m_aoLinks.Reserve(m_aoLinks.Size() + aoResults.size());
+
+	for (size_t i = 0; i != nItems; ++i)
+	{
+		const tchar* pszItem = astrItems[i];
+		CDDELink*    pLink   = FindLink(pszItem, nFormat);
+
+		// Advise loop started?
+		if ( (pLink == nullptr) && (anBatch[i] != Core::npos) && aoResults[anBatch[i]].Succeeded() )
+		{
+			pLink = new(m_pInst->LinkPool()) CDDELink(m_pInst, this, pszItem, nFormat);
+
+			m_aoLinks.Add(pLink);
+			m_oLinkIndex.Insert(pszItem, nFormat, pLink);
+		}
+
+		// New reference.
+		if (pLink != nullptr)
+		{
+			++pLink->m_nRefCount;
+			++nLinks;
+		}
+
+		aoLinks.push_back(pLink);
+	}
+
+	return nLinks;
+}
+
+/******************************************************************************
+** Method:		DestroyLinks()
+**
+** Description:	Releases a reference to many links in one batch. The advise
+**				loops for the links no longer referenced are ended with
+**				asynchronous transactions and then the links are removed in
+**				a single pass.
+**				NB: Messages are dispatched whilst waiting for the completions.
+**
+** Parameters:	aoLinks		The links to release.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::DestroyLinks(const CDDECltLinks& aoLinks)
+{
+	CDDECltLinks aoUnused;
+
+	for (size_t i = 0, n = aoLinks.size(); i != n; ++i)
+	{
+		CDDELink* pLink = aoLinks[i];
+
+		ASSERT(pLink != nullptr);
+		ASSERT(pLink->m_nRefCount != 0);
+
+		// Last reference?
+		if (--pLink->m_nRefCount == 0)
+			aoUnused.push_back(pLink);
+	}
+
+	if (aoUnused.empty())
+		return;
+
+	DDE::RequestResults aoResults;
+
+	aoResults.reserve(aoUnused.size());
+
+	BatchReference oReference(this);
+
+	BeginBatch(XTYP_ADVSTOP, aoResults);
+
+	try
+	{
+		// End all the advise loops.
+		for (size_t i = 0, n = aoUnused.size(); i != n; ++i)
+		{
+			CDDELink* pLink = aoUnused[i];
+
+			AddToBatch(pLink->ItemHandle(), pLink->Item(), pLink->Format());
+		}
+
+		EndBatch();
+	}
+	catch (...)
+	{
+		AbandonRequests();
+		RemoveLinks(aoUnused);
+		throw;
+	}
+
+	RemoveLinks(aoUnused);
+}
+
+/******************************************************************************
+** Method:		RemoveLinks()
+**
+** Description:	Remove many unreferenced links from the collection and delete
+**				them. Each link is removed in constant time.
+**
+** Parameters:	aoLinks		The links to remove.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::RemoveLinks(const CDDECltLinks& aoLinks)
+{
+	for (size_t i = 0, n = aoLinks.size(); i != n; ++i)
+	{
+		CDDELink* pLink = aoLinks[i];
+
+		ASSERT(pLink->m_nRefCount == 0);
+
+		m_oLinkIndex.Erase(pLink->Item(), pLink->Format());
+		m_aoLinks.Remove(pLink);
+
+		delete pLink;
+	}
 }
 
 /******************************************************************************
 ** Method:		FindLink()
 **
-** Description:	Finds an existing link.
+** Description:	Finds an existing link. The item name is not case-sensitive.
 **
 ** Parameters:	pszItem		The item to link to.
 **				nFormat		The item data format.
@@ -325,14 +765,288 @@ CDDELink* CDDECltConv::FindLink(const tchar* pszItem, uint nFormat) const
 {
 	ASSERT(pszItem != nullptr);
 
-	// Search the links list.
-	for (size_t i = 0, n = m_aoLinks.size(); i != n; ++i)
+	return m_oLinkIndex.Find(pszItem, nFormat);
+}
+
+/******************************************************************************
+** Methods:		RequestAsync()
+**				ExecuteAsync()
+**				PokeAsync()
+**				CreateLinkAsync()
+**
+** Description:	Start a transaction without waiting for the server to complete
+**				it. The listeners are notified with OnTransactionComplete()
+**				when it does, which requires the caller to dispatch messages.
+**				The data passed to a request's listeners is only valid for the
+**				duration of the callback. A link is only added to the
+**				conversation when its advise loop has started. If the item is
+**				already linked CreateLinkAsync() just adds a reference, as
+**				CreateLink() does, and no transaction is started.
+**
+** Parameters:	pszItem		The item.
+**				nFormat		The item data format.
+**				pValue		The value or command.
+**				nSize		The size of the value or command.
+**
+** Returns:		The transaction ID, or 0 if no transaction was started.
+**
+*******************************************************************************
+*/
+
+DWORD CDDECltConv::RequestAsync(const tchar* pszItem, uint nFormat)
+{
+	ASSERT(pszItem != nullptr);
+
+	return StartTransaction(nullptr, 0, pszItem, nFormat, XTYP_REQUEST, CDDEException::E_REQUEST_FAILED);
+}
+
+DWORD CDDECltConv::ExecuteAsync(const void* pValue, size_t nSize)
+{
+	ASSERT(pValue != nullptr);
+
+	return StartTransaction(pValue, nSize, nullptr, 0, XTYP_EXECUTE, CDDEException::E_EXECUTE_FAILED);
+}
+
+DWORD CDDECltConv::PokeAsync(const tchar* pszItem, uint nFormat, const void* pValue, size_t nSize)
+{
+	ASSERT(pszItem != nullptr);
+	ASSERT(pValue  != nullptr);
+
+	return StartTransaction(pValue, nSize, pszItem, nFormat, XTYP_POKE, CDDEException::E_POKE_FAILED);
+}
+
+DWORD CDDECltConv::CreateLinkAsync(const tchar* pszItem, uint nFormat)
+{
+	ASSERT(pszItem != nullptr);
+
+	// Already linked with format?
+	CDDELink* pLink = FindLink(pszItem, nFormat);
+
+	if (pLink != nullptr)
 	{
-		CDDELink* pLink = m_aoLinks[i];
+		// New reference.
+		++pLink->m_nRefCount;
+
+		return 0;
+	}
+
+	return StartTransaction(nullptr, 0, pszItem, nFormat, XTYP_ADVSTART, CDDEException::E_LINK_FAILED);
+}
+
+/******************************************************************************
+** Method:		CancelTransaction()
+**
+** Description:	Cancel an outstanding asynchronous transaction. The listeners
+**				are not notified.
+**
+** Parameters:	dwTransID	The transaction ID.
+**
+** Returns:		true if cancelled, or false if it had already completed.
+**
+*******************************************************************************
+*/
+
+bool CDDECltConv::CancelTransaction(DWORD dwTransID)
+{
+	CDDEPendingTransactions::iterator it = m_oAsync.find(dwTransID);
+
+	if (it == m_oAsync.end())
+		return false;
+
+	DDE::ddeApi().AbandonTransaction(m_pInst->Handle(), m_hConv, dwTransID);
+
+	m_oAsync.erase(it);
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		StartTransaction()
+**
+** Description:	Start an asynchronous transaction and record it as outstanding.
+**
+** Parameters:	pValue		The data, or nullptr.
+**				nSize		The size of the data.
+**				pszItem		The item, or nullptr for an execute.
+**				nFormat		The item data format.
+**				nType		The XTYP_ transaction type.
+**				nError		The exception error code if it fails to start.
+**
+** Returns:		The transaction ID.
+**
+*******************************************************************************
+*/
+
+DWORD CDDECltConv::StartTransaction(const void* pValue, size_t nSize, const tchar* pszItem, uint nFormat, uint nType, int nError)
+{
+	LPBYTE   lpData = static_cast<byte*>(const_cast<void*>(pValue));
+	DWORD    dwTransID = 0;
+	HDDEDATA hResult;
+
+	if (pszItem != nullptr)
+	{
+		CDDEString strItem(m_pInst, pszItem);
+
+		hResult = DDE::ddeApi().ClientTransaction(lpData, static_cast<DWORD>(nSize), m_hConv, strItem,
+													nFormat, nType, TIMEOUT_ASYNC, &dwTransID);
+	}
+	else
+	{
+		hResult = DDE::ddeApi().ClientTransaction(lpData, static_cast<DWORD>(nSize), m_hConv, NULL,
+													nFormat, nType, TIMEOUT_ASYNC, &dwTransID);
+	}
+
+	// Failed to start?
+	if (hResult == NULL)
+		throw CDDEException(nError, m_pInst->LastError());
+
+	const DDE::AsyncTransaction oTransaction(dwTransID, nType, (pszItem != nullptr) ? pszItem : TXT(""), nFormat);
+
+	m_oAsync.insert(CDDEPendingTransactions::value_type(dwTransID, oTransaction));
+
+	return dwTransID;
+}
+
+/******************************************************************************
+** Method:		TransactionError()
+**
+** Description:	Get the error code for an asynchronous transaction that failed.
+**				DDEML does not always set one, so a missing error is reported
+**				as the transaction not being processed.
+**
+** Parameters:	None.
+**
+** Returns:		The DMLERR_ error code.
+**
+*******************************************************************************
+*/
+
+uint CDDECltConv::TransactionError() const
+{
+	const uint nError = m_pInst->LastError();
+
+	return (nError != DMLERR_NO_ERROR) ? nError : DMLERR_NOTPROCESSED;
+}
+
+/******************************************************************************
+** Method:		OnTransactionComplete()
+**
+** Description:	Handle the completion of an asynchronous transaction. The result
+**				of a batched transaction is stored in the batch, the data for
+**				a request is only valid for the duration of the callback and
+**				so is copied. Any
+**				other transaction is timed and returned so that the listeners
+**				can be notified.
+**
+** Parameters:	dwTransID		The transaction ID.
+**				nFormat			The format of the data.
+**				hData			The data, TRUE, or NULL if the transaction failed.
+**				oTransaction	The returned transaction.
+**
+** Returns:		true if the listeners should be notified.
+**
+*******************************************************************************
+*/
+
+bool CDDECltConv::OnTransactionComplete(DWORD dwTransID, uint nFormat, HDDEDATA hData, DDE::AsyncTransaction& oTransaction)
+{
+	CDDEPendingRequests::iterator itRequest = m_oPending.find(dwTransID);
+
+	// Part of the batch?
+	if (itRequest != m_oPending.end())
+	{
+		DDE::RequestResult& oResult = (*m_pBatch)[itRequest->second];
+
+		m_oPending.erase(itRequest);
+
+		if (hData == NULL)
+		{
+			oResult.m_error = TransactionError();
+			return false;
+		}
+
+		// No data to keep?
+		if (m_nBatchType != XTYP_REQUEST)
+			return false;
+
+		const CDDEData        oData(m_pInst, hData, nFormat, false);
+		const CDDEData::CView oView(oData);
+
+		oResult.m_data = CDDEData(m_pInst, oView.Data(), oView.Size(), 0, nFormat, true);
+		return false;
+	}
+
+	CDDEPendingTransactions::iterator it = m_oAsync.find(dwTransID);
+
+	// Cancelled?
+	if (it == m_oAsync.end())
+		return false;
+
+	oTransaction = it->second;
+	oTransaction.m_elapsed = ::GetTickCount() - oTransaction.m_started;
+
+	m_oAsync.erase(it);
+
+	if (hData == NULL)
+	{
+		oTransaction.m_error = TransactionError();
+	}
+	else if (oTransaction.m_type == XTYP_ADVSTART)
+	{
+		const tchar* pszItem = oTransaction.m_item.c_str();
+
+		// Not linked whilst the transaction was outstanding?
+		CDDELink* pLink = FindLink(pszItem, oTransaction.m_format);
+
+		if (pLink == nullptr)
+		{
+			pLink = new(m_pInst->LinkPool()) CDDELink(m_pInst, this, pszItem, oTransaction.m_format);
+
+			m_aoLinks.Add(pLink);
+			m_oLinkIndex.Insert(pszItem, oTransaction.m_format, pLink);
+		}
+
+		// New reference.
+		++pLink->m_nRefCount;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		FailTransactions()
+**
+** Description:	Fail the outstanding transactions, which DDEML abandons when
+**				the conversation is terminated. The results of a batch are
+**				set directly, the other transactions are returned so that the
+**				listeners can be notified.
+**
+** Parameters:	nError		The DMLERR_ error code.
+**				aoFailed	The returned transactions.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDECltConv::FailTransactions(uint nError, CDDEAsyncTransactions& aoFailed)
+{
+	for (CDDEPendingRequests::const_iterator it = m_oPending.begin(); it != m_oPending.end(); ++it)
+		(*m_pBatch)[it->second].m_error = nError;
+
+	m_oPending.clear();
+
+	const DWORD dwNow = ::GetTickCount();
+
+	for (CDDEPendingTransactions::const_iterator it = m_oAsync.begin(); it != m_oAsync.end(); ++it)
+	{
+		DDE::AsyncTransaction oTransaction = it->second;
+
+		oTransaction.m_elapsed = dwNow - oTransaction.m_started;
+		oTransaction.m_error   = nError;
 
-		if ( (tstricmp(pLink->Item(), pszItem) == 0) && (pLink->Format() == nFormat) )
-			return pLink;
+		aoFailed.push_back(oTransaction);
 	}
 
-	return nullptr;
+	m_oAsync.clear();
 }
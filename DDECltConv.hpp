@@ -19,10 +19,17 @@
 #include "DDEFwd.hpp"
 #include "DDEConv.hpp"
 #include "IDDECltConv.hpp"
+#include "DDELinkIndex.hpp"
+#include "DDELinkList.hpp"
+#include "DDETransaction.hpp"
 #include <vector>
+#include <map>
 
 // Template shorthands.
 typedef std::vector<CDDELink*> CDDECltLinks;
+typedef std::map<DWORD, size_t> CDDEPendingRequests;
+typedef std::map<DWORD, DDE::AsyncTransaction> CDDEPendingTransactions;
+typedef std::vector<DDE::AsyncTransaction> CDDEAsyncTransactions;
 
 /******************************************************************************
 **
@@ -60,6 +67,9 @@ public:
 	//! Request a value in a custom format.
 	virtual CDDEData Request(const tchar* pszItem, uint nFormat) const;
 
+	//! Request many values in one batch.
+	virtual DWORD RequestMany(const CStrArray& astrItems, uint nFormat, DDE::RequestResults& aoResults);
+
 	//! Execute a string based command on the server.
 	void ExecuteString(const tchar* pszCommand) const;
 
@@ -86,14 +96,60 @@ public:
 	CDDELink* GetLink(size_t nIndex) const;
 	size_t    GetAllLinks(CDDECltLinks& aoLinks) const;
 
+	//! Start advise loops for many items in one batch.
+	size_t CreateLinks(const CStrArray& astrItems, uint nFormat, CDDECltLinks& aoLinks);
+
+	//! Release a reference to many links in one batch.
+	void DestroyLinks(const CDDECltLinks& aoLinks);
+
+	//
+	// Asynchronous methods.
+	//
+
+	//! Start a request for a value.
+	virtual DWORD RequestAsync(const tchar* pszItem, uint nFormat);
+
+	//! Start executing a command on the server.
+	virtual DWORD ExecuteAsync(const void* pValue, size_t nSize);
+
+	//! Start poking a value.
+	virtual DWORD PokeAsync(const tchar* pszItem, uint nFormat, const void* pValue, size_t nSize);
+
+	//! Start an advise loop on the server for an item, or add a reference to
+	//! an existing link, in which case 0 is returned.
+	virtual DWORD CreateLinkAsync(const tchar* pszItem, uint nFormat = CF_TEXT);
+
+	//! Cancel an outstanding asynchronous transaction.
+	virtual bool CancelTransaction(DWORD dwTransID);
+
+	//! The number of outstanding asynchronous transactions.
+	size_t NumPendingTransactions() const;
+
 protected:
+	//! Holds a reference to the conversation for the length of a batch, as
+	//! a listener may destroy it whilst messages are being dispatched.
+	class BatchReference
+	{
+	public:
+		BatchReference(CDDECltConv* pConv);
+		~BatchReference();
+
+	private:
+		CDDECltConv*	m_pConv;	//!< The conversation.
+	};
+
 	//
 	// Members.
 	//
-	uint			m_nRefCount;	// The reference count.
-	CDDEClient*		m_client;		//!< The owning DDE client.
-	DWORD			m_timeout;		//!< The time-out value for transactions.
-	CDDECltLinks	m_aoLinks;		// The list of links.
+	uint					m_nRefCount;	// The reference count.
+	CDDEClient*				m_client;		//!< The owning DDE client.
+	DWORD					m_timeout;		//!< The time-out value for transactions.
+	DDE::LinkList			m_aoLinks;		// The list of links.
+	DDE::LinkIndex			m_oLinkIndex;	//!< The links by item and format.
+	DDE::RequestResults*	m_pBatch;		//!< The results of the batch in progress.
+	uint					m_nBatchType;	//!< The transaction type of the batch.
+	CDDEPendingRequests		m_oPending;		//!< The batch result for each outstanding request.
+	CDDEPendingTransactions	m_oAsync;		//!< The outstanding asynchronous transactions.
 
 	//
 	// Constructors/Destructor.
@@ -103,6 +159,37 @@ protected:
 	CDDECltConv(const CDDECltConv&);
 	virtual ~CDDECltConv();
 
+	//
+	// Internal methods.
+	//
+
+	//! Start a batch of asynchronous transactions.
+	void BeginBatch(uint nType, DDE::RequestResults& aoResults);
+
+	//! Start a transaction for an item in the batch.
+	void AddToBatch(HSZ hszItem, const tchar* pszItem, uint nFormat);
+
+	//! Wait for the batch to complete.
+	void EndBatch();
+
+	//! Abandon the outstanding requests in the batch.
+	void AbandonRequests();
+
+	//! Remove and delete unreferenced links.
+	void RemoveLinks(const CDDECltLinks& aoLinks);
+
+	//! Start an asynchronous transaction.
+	DWORD StartTransaction(const void* pValue, size_t nSize, const tchar* pszItem, uint nFormat, uint nType, int nError);
+
+	//! The error code for a failed asynchronous transaction.
+	uint TransactionError() const;
+
+	//! Handle the completion of an asynchronous transaction.
+	bool OnTransactionComplete(DWORD dwTransID, uint nFormat, HDDEDATA hData, DDE::AsyncTransaction& oTransaction);
+
+	//! Fail the outstanding transactions.
+	void FailTransactions(uint nError, CDDEAsyncTransactions& aoFailed);
+
 	// Friends.
 	friend class CDDEClient;
 
@@ -135,7 +222,7 @@ inline void CDDECltConv::SetTimeout(DWORD timeout)
 
 inline size_t CDDECltConv::NumLinks() const
 {
-	return m_aoLinks.size();
+	return m_aoLinks.Size();
 }
 
 inline CDDELink* CDDECltConv::GetLink(size_t nIndex) const
@@ -145,9 +232,14 @@ inline CDDELink* CDDECltConv::GetLink(size_t nIndex) const
 
 inline size_t CDDECltConv::GetAllLinks(CDDECltLinks& aoLinks) const
 {
-	aoLinks = m_aoLinks;
+	aoLinks = m_aoLinks.Items();
 
 	return aoLinks.size();
 }
 
+inline size_t CDDECltConv::NumPendingTransactions() const
+{
+	return m_oAsync.size();
+}
+
 #endif // DDECLTCONV_HPP
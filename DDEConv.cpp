@@ -11,6 +11,7 @@
 #include "Common.hpp"
 #include "DDEConv.hpp"
 #include "DDEInst.hpp"
+#include "DDEPool.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Constructor.
@@ -20,6 +21,8 @@ CDDEConv::CDDEConv(CDDEInst* pInst, HCONV hConv, const tchar* pszService, const
 	, m_hConv(hConv)
 	, m_strService(pszService)
 	, m_strTopic(pszTopic)
+	, m_oService(pInst, pszService)
+	, m_oTopic(pInst, pszTopic)
 	, m_pAppData(nullptr)
 {
 	ASSERT(m_pInst != nullptr);
@@ -42,7 +45,7 @@ void CDDEConv::Disconnect()
 {
 	if (m_hConv != NULL)
 	{
-		BOOL okay = ::DdeDisconnect(m_hConv);
+		BOOL okay = DDE::ddeApi().Disconnect(m_hConv);
 
 		if (!okay)
 		{
@@ -55,3 +58,28 @@ void CDDEConv::Disconnect()
 
 	m_hConv = NULL;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate the memory for a conversation from a pool. A derived class bigger
+//! than the pool's blocks is allocated from the heap instead.
+
+void* CDDEConv::operator new(size_t nSize, DDE::Pool& oPool)
+{
+	return oPool.Allocate(nSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Return the memory for a conversation to its pool, if the constructor throws.
+
+void CDDEConv::operator delete(void* pBlock, DDE::Pool& /*oPool*/)
+{
+	DDE::Pool::Free(pBlock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Return the memory for a conversation to its pool.
+
+void CDDEConv::operator delete(void* pBlock)
+{
+	DDE::Pool::Free(pBlock);
+}
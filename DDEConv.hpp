@@ -17,6 +17,7 @@
 #endif
 
 #include "DDEFwd.hpp"
+#include "DDEString.hpp"
 #include "IDDEConv.hpp"
 
 /******************************************************************************
@@ -38,10 +39,19 @@ public:
 	HCONV          Handle() const;
 	virtual const CString& Service() const;
 	virtual const CString& Topic() const;
+	HSZ            ServiceHandle() const;
+	HSZ            TopicHandle() const;
 
 	IDDEConvData*  AppData() const;
 	void           SetAppData(IDDEConvData* pAppData);
 
+	//
+	// Allocation methods.
+	//
+	static void* operator new(size_t nSize, DDE::Pool& oPool);
+	static void  operator delete(void* pBlock, DDE::Pool& oPool);
+	static void  operator delete(void* pBlock);
+
 protected:
 	//
 	// Members.
@@ -50,6 +60,8 @@ protected:
 	HCONV			m_hConv;		// The conversation handle.
 	CString			m_strService;	// The service name.
 	CString			m_strTopic;		// The topic name.
+	CDDEString		m_oService;		// The interned service handle.
+	CDDEString		m_oTopic;		// The interned topic handle.
 	IDDEConvData*	m_pAppData;		// Custom data.
 
 	//
@@ -91,6 +103,16 @@ inline const CString& CDDEConv::Topic() const
 	return m_strTopic;
 }
 
+inline HSZ CDDEConv::ServiceHandle() const
+{
+	return m_oService;
+}
+
+inline HSZ CDDEConv::TopicHandle() const
+{
+	return m_oTopic;
+}
+
 inline IDDEConvData* CDDEConv::AppData() const
 {
 	return m_pAppData;
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEConvIndex.cpp
+//! \brief  The ConvIndex class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEConvIndex.hpp"
+#include "DDEConv.hpp"
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+ConvIndex::ConvIndex()
+	: m_entries()
+	, m_handles()
+	, m_names()
+	, m_topicLinks()
+	, m_itemLinks()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. The conversations are owned by the client or server.
+
+ConvIndex::~ConvIndex()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a conversation at a position in the owner's collection. The keys are
+//! captured now as the handle is reset when the conversation is disconnected.
+
+void ConvIndex::Insert(CDDEConv* conv, size_t position)
+{
+	ASSERT(conv != nullptr);
+	ASSERT(m_entries.find(conv) == m_entries.end());
+	ASSERT(m_handles.find(conv->Handle()) == m_handles.end());
+
+	Entry entry = { conv->Handle(), conv->ServiceHandle(), conv->TopicHandle(), position };
+
+	m_entries[conv] = entry;
+	m_handles[entry.m_handle] = conv;
+	m_names.insert(std::make_pair(Name(entry.m_service, entry.m_topic), conv));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a conversation, returning its position in the owner's collection.
+
+size_t ConvIndex::Erase(const CDDEConv* conv)
+{
+	Entries::iterator it = m_entries.find(conv);
+
+	ASSERT(it != m_entries.end());
+
+	const Entry entry = it->second;
+
+	m_entries.erase(it);
+
+	// The handle may have been reused by a later conversation.
+	Handles::iterator handle = m_handles.find(entry.m_handle);
+
+	if ( (handle != m_handles.end()) && (handle->second == conv) )
+		m_handles.erase(handle);
+
+	// Conversations may share a service and topic.
+	std::pair<Names::iterator, Names::iterator> range = m_names.equal_range(Name(entry.m_service, entry.m_topic));
+
+	for (Names::iterator name = range.first; name != range.second; ++name)
+	{
+		if (name->second == conv)
+		{
+			m_names.erase(name);
+			break;
+		}
+	}
+
+	return entry.m_position;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the new position of a conversation in the owner's collection.
+
+void ConvIndex::Move(const CDDEConv* conv, size_t position)
+{
+	Entries::iterator it = m_entries.find(conv);
+
+	ASSERT(it != m_entries.end());
+
+	it->second.m_position = position;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop finding a disconnected conversation by its handle, as the DDEML is
+//! free to reuse the handle for a new conversation.
+
+void ConvIndex::EraseHandle(const CDDEConv* conv)
+{
+	Entries::iterator it = m_entries.find(conv);
+
+	ASSERT(it != m_entries.end());
+
+	Handles::iterator handle = m_handles.find(it->second.m_handle);
+
+	if ( (handle != m_handles.end()) && (handle->second == conv) )
+		m_handles.erase(handle);
+
+	it->second.m_handle = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the conversation for a handle.
+
+CDDEConv* ConvIndex::Find(HCONV handle) const
+{
+	Handles::const_iterator it = m_handles.find(handle);
+
+	if (it == m_handles.end())
+		return nullptr;
+
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first conversation for a service and topic, which is the earliest
+//! one added that still exists.
+
+CDDEConv* ConvIndex::Find(HSZ service, HSZ topic) const
+{
+	const Name            name(service, topic);
+	Names::const_iterator it = m_names.lower_bound(name);
+
+	if ( (it == m_names.end()) || (it->first != name) )
+		return nullptr;
+
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of advise loops on a topic, across all conversations.
+
+size_t ConvIndex::LinkCount(HSZ topic) const
+{
+	TopicLinks::const_iterator it = m_topicLinks.find(topic);
+
+	return (it != m_topicLinks.end()) ? it->second : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of advise loops on a topic for an item, in any format.
+
+size_t ConvIndex::LinkCount(HSZ topic, HSZ item) const
+{
+	ItemLinks::const_iterator it = m_itemLinks.find(Item(topic, item));
+
+	return (it != m_itemLinks.end()) ? it->second : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count an advise loop started on a topic.
+
+void ConvIndex::AddLink(HSZ topic, HSZ item)
+{
+	++m_topicLinks[topic];
+	++m_itemLinks[Item(topic, item)];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count an advise loop stopped on a topic.
+
+void ConvIndex::RemoveLink(HSZ topic, HSZ item)
+{
+	TopicLinks::iterator topicIt = m_topicLinks.find(topic);
+	ItemLinks::iterator  itemIt = m_itemLinks.find(Item(topic, item));
+
+	ASSERT(topicIt != m_topicLinks.end());
+	ASSERT(itemIt != m_itemLinks.end());
+
+	if (--topicIt->second == 0)
+		m_topicLinks.erase(topicIt);
+
+	if (--itemIt->second == 0)
+		m_itemLinks.erase(itemIt);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all conversations and advise loops from the index.
+
+void ConvIndex::Clear()
+{
+	m_entries.clear();
+	m_handles.clear();
+	m_names.clear();
+	m_topicLinks.clear();
+	m_itemLinks.clear();
+}
+
+//namespace DDE
+}
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEConvIndex.hpp
+//! \brief  The ConvIndex class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDECONVINDEX_HPP
+#define NCL_DDECONVINDEX_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEFwd.hpp"
+#include <map>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! An index of the conversations owned by a DDE client or server. It maps the
+//! conversation handle and the interned service and topic handles to the
+//! conversation, and records each conversation's position in the owner's
+//! collection so that it can be removed by swapping it with the last one. It
+//! also counts the advise loops on each topic and item.
+
+class ConvIndex
+{
+public:
+	//! Default constructor.
+	ConvIndex();
+
+	//! Destructor.
+	~ConvIndex();
+
+	//
+	// Properties.
+	//
+
+	//! The number of conversations indexed.
+	size_t Size() const;
+
+	//! Check if a conversation is indexed.
+	bool Contains(const CDDEConv* conv) const;
+
+	//! The number of advise loops on a topic.
+	size_t LinkCount(HSZ topic) const;
+
+	//! The number of advise loops on a topic for an item.
+	size_t LinkCount(HSZ topic, HSZ item) const;
+
+	//
+	// Methods.
+	//
+
+	//! Add a conversation at a position in the owner's collection.
+	void Insert(CDDEConv* conv, size_t position);
+
+	//! Remove a conversation, returning its position in the owner's collection.
+	size_t Erase(const CDDEConv* conv);
+
+	//! Record the new position of a conversation in the owner's collection.
+	void Move(const CDDEConv* conv, size_t position);
+
+	//! Stop finding a disconnected conversation by its handle.
+	void EraseHandle(const CDDEConv* conv);
+
+	//! Find the conversation for a handle.
+	CDDEConv* Find(HCONV handle) const;
+
+	//! Find the first conversation for a service and topic.
+	CDDEConv* Find(HSZ service, HSZ topic) const;
+
+	//! Count an advise loop started on a topic.
+	void AddLink(HSZ topic, HSZ item);
+
+	//! Count an advise loop stopped on a topic.
+	void RemoveLink(HSZ topic, HSZ item);
+
+	//! Remove all conversations and advise loops from the index.
+	void Clear();
+
+private:
+	//! The keys a conversation was indexed with.
+	struct Entry
+	{
+		HCONV	m_handle;		//!< The conversation handle.
+		HSZ		m_service;		//!< The service name handle.
+		HSZ		m_topic;		//!< The topic name handle.
+		size_t	m_position;		//!< The position in the owner's collection.
+	};
+
+	//! The service and topic key.
+	typedef std::pair<HSZ, HSZ> Name;
+	//! The entries keyed by conversation.
+	typedef std::map<const CDDEConv*, Entry> Entries;
+	//! The conversations keyed by handle.
+	typedef std::map<HCONV, CDDEConv*> Handles;
+	//! The conversations keyed by service and topic.
+	typedef std::multimap<Name, CDDEConv*> Names;
+	//! The advise loop counts keyed by topic.
+	typedef std::map<HSZ, size_t> TopicLinks;
+	//! The topic and item key.
+	typedef std::pair<HSZ, HSZ> Item;
+	//! The advise loop counts keyed by topic and item.
+	typedef std::map<Item, size_t> ItemLinks;
+
+	//
+	// Members.
+	//
+	Entries		m_entries;		//!< The conversations indexed.
+	Handles		m_handles;		//!< The conversations by handle.
+	Names		m_names;		//!< The conversations by service and topic.
+	TopicLinks	m_topicLinks;	//!< The advise loops by topic.
+	ItemLinks	m_itemLinks;	//!< The advise loops by topic and item.
+
+	// NotCopyable.
+	ConvIndex(const ConvIndex&);
+	ConvIndex& operator=(const ConvIndex&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of conversations indexed.
+
+inline size_t ConvIndex::Size() const
+{
+	return m_entries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check if a conversation is indexed.
+
+inline bool ConvIndex::Contains(const CDDEConv* conv) const
+{
+	return (m_entries.find(conv) != m_entries.end());
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDECONVINDEX_HPP
@@ -12,18 +12,24 @@
 #include "DDEData.hpp"
 #include "DDEInst.hpp"
 #include "DDEException.hpp"
-#include <Core/AnsiWide.hpp>
-#include <malloc.h>
+#include "DDETextCodec.hpp"
 #include <Core/StringUtils.hpp>
+#include <algorithm>
+#include <vector>
 
-CDDEData::CHandle::CHandle(CDDEInst* pInst, HDDEDATA hData, uint nFormat, bool bOwn)
+CDDEData::CHandle::CHandle(CDDEInst* pInst, HDDEDATA hData, uint nFormat, bool bOwn, size_t nSize)
 	: m_nRefCount(1)
 	, m_pInst(pInst)
 	, m_hData(hData)
 	, m_nFormat(nFormat)
 	, m_bOwn(bOwn)
+	, m_nSize(nSize)
 {
 	ASSERT(pInst != nullptr);
+
+	// A null handle has no data.
+	if (m_hData == NULL)
+		m_nSize = 0;
 }
 
 CDDEData::CHandle::~CHandle()
@@ -33,7 +39,7 @@ CDDEData::CHandle::~CHandle()
 	// Free handle?
 	if (m_bOwn)
 	{
-		BOOL okay = ::DdeFreeDataHandle(m_hData);
+		BOOL okay = DDE::ddeApi().FreeDataHandle(m_hData);
 
 		ASSERT_RESULT(okay, okay != FALSE);
 	}
@@ -48,13 +54,13 @@ CDDEData::CDDEData(CDDEInst* pInst, HSZ hItem, uint nFormat, bool bOwn)
 	: m_pHandle()
 {
 	// Allocate data handle.
-	HDDEDATA hData = ::DdeCreateDataHandle(pInst->Handle(), nullptr, 0, 0, hItem, nFormat, 0);
+	HDDEDATA hData = DDE::ddeApi().CreateDataHandle(pInst->Handle(), nullptr, 0, 0, hItem, nFormat, 0);
 
 	if (hData == NULL)
 		throw CDDEException(CDDEException::E_ALLOC_FAILED, pInst->LastError());
 
 	// Attach handle.
-	m_pHandle = new CHandle(pInst, hData, nFormat, bOwn);
+	m_pHandle = new CHandle(pInst, hData, nFormat, bOwn, 0);
 }
 
 CDDEData::CDDEData(CDDEInst* pInst, const void* pBuffer, size_t nSize, size_t nOffset, uint nFormat, bool bOwn)
@@ -63,13 +69,13 @@ CDDEData::CDDEData(CDDEInst* pInst, const void* pBuffer, size_t nSize, size_t nO
 	LPBYTE lpData = static_cast<byte*>(const_cast<void*>(pBuffer));
 
 	// Allocate data handle.
-	HDDEDATA hData = ::DdeCreateDataHandle(pInst->Handle(), lpData, static_cast<DWORD>(nSize), static_cast<DWORD>(nOffset), NULL, nFormat, 0);
+	HDDEDATA hData = DDE::ddeApi().CreateDataHandle(pInst->Handle(), lpData, static_cast<DWORD>(nSize), static_cast<DWORD>(nOffset), NULL, nFormat, 0);
 
 	if (hData == NULL)
 		throw CDDEException(CDDEException::E_ALLOC_FAILED, pInst->LastError());
 
 	// Attach handle.
-	m_pHandle = new CHandle(pInst, hData, nFormat, bOwn);
+	m_pHandle = new CHandle(pInst, hData, nFormat, bOwn, nSize);
 }
 
 CDDEData::CDDEData(CDDEInst* pInst, const CBuffer& oBuffer, uint nFormat, bool bOwn)
@@ -78,13 +84,13 @@ CDDEData::CDDEData(CDDEInst* pInst, const CBuffer& oBuffer, uint nFormat, bool b
 	LPBYTE lpData = static_cast<byte*>(const_cast<void*>(oBuffer.Buffer()));
 
 	// Allocate data handle.
-	HDDEDATA hData = ::DdeCreateDataHandle(pInst->Handle(), lpData, static_cast<DWORD>(oBuffer.Size()), 0, NULL, nFormat, 0);
+	HDDEDATA hData = DDE::ddeApi().CreateDataHandle(pInst->Handle(), lpData, static_cast<DWORD>(oBuffer.Size()), 0, NULL, nFormat, 0);
 
 	if (hData == NULL)
 		throw CDDEException(CDDEException::E_ALLOC_FAILED, pInst->LastError());
 
 	// Attach handle.
-	m_pHandle = new CHandle(pInst, hData, nFormat, bOwn);
+	m_pHandle = new CHandle(pInst, hData, nFormat, bOwn, oBuffer.Size());
 }
 
 CDDEData::CDDEData(const CDDEData& oData)
@@ -126,7 +132,11 @@ size_t CDDEData::Size() const
 	if (m_pHandle->m_hData == NULL)
 		return 0;
 
-	DWORD dwResult = ::DdeGetData(m_pHandle->m_hData, nullptr, 0, 0);
+	// Already known?
+	if (m_pHandle->m_nSize != CHandle::UNKNOWN_SIZE)
+		return m_pHandle->m_nSize;
+
+	DWORD dwResult = DDE::ddeApi().GetData(m_pHandle->m_hData, nullptr, 0, 0);
 
 	// The documentation does not say how an error is detected, only that
 	// DdeGetLastError can be queried. But DdeGetData does reset it on success,
@@ -138,6 +148,8 @@ size_t CDDEData::Size() const
 		ASSERT_RESULT(uLastError, uLastError == DMLERR_NO_ERROR);
 	}
 
+	m_pHandle->m_nSize = dwResult;
+
 	return dwResult;
 }
 
@@ -148,8 +160,8 @@ size_t CDDEData::GetData(void* pBuffer, size_t nSize, size_t nOffset) const
 	ASSERT(pBuffer != nullptr);
 	ASSERT(nOffset+nSize <= Size());
 
-	DWORD dwResult = ::DdeGetData(m_pHandle->m_hData, static_cast<byte*>(pBuffer),
-						static_cast<DWORD>(nSize), static_cast<DWORD>(nOffset));
+	DWORD dwResult = DDE::ddeApi().GetData(m_pHandle->m_hData, static_cast<byte*>(pBuffer),
+								static_cast<DWORD>(nSize), static_cast<DWORD>(nOffset));
 
 	// The documentation does not say how an error is detected, only that
 	// DdeGetLastError can be queried. But DdeGetData does reset it on success,
@@ -166,66 +178,53 @@ size_t CDDEData::GetData(void* pBuffer, size_t nSize, size_t nOffset) const
 
 CBuffer CDDEData::GetBuffer() const
 {
-	size_t nSize = Size();
-
-	CBuffer oBuffer(nSize);
+	CView oView(*this);
 
-	GetData(oBuffer.Buffer(), nSize, 0);
+	if (oView.Empty())
+		return CBuffer();
 
-	return oBuffer;
+	return CBuffer(oView.Data(), oView.Size());
 }
 
 CString CDDEData::GetString(TextFormat eFormat) const
 {
 	CString str;
-	size_t  nBytes = Size();
+	CView   oView(*this);
 
 	if (eFormat == ANSI_TEXT)
 	{
-		size_t nChars = nBytes;
+		const char* psz    = reinterpret_cast<const char*>(oView.Data());
+		size_t      nChars = (!oView.Empty()) ? strnlen(psz, oView.Size()) : 0;
 
 		// Allocate the string buffer.
 		str.BufferSize(nChars+1);
 
 #ifdef ANSI_BUILD
 		// Copy the data contents directly into the string.
-		GetData(reinterpret_cast<byte*>(str.Buffer()), nBytes, 0);
+		memcpy(str.Buffer(), psz, nChars);
 #else
-		// Copy the ANSI string to a temporary buffer.
-		char* psz = static_cast<char*>(_alloca(nChars));
-
-		GetData(reinterpret_cast<byte*>(psz), nBytes, 0);
-
-		nChars = strnlen(psz, nChars);
-
 		// Convert to Unicode.
-		Core::ansiToWide(psz, psz+nChars, str.Buffer());
+		DDE::ansiToUtf16(psz, nChars, str.Buffer());
 #endif
 		// Ensure its null terminated.
 		str[nChars] = TXT('\0');
 	}
 	else // (eFormat == UNICODE_TEXT)
 	{
-		ASSERT((nBytes % 2) == 0);
+		ASSERT((oView.Size() % 2) == 0);
 
-		size_t nChars = nBytes / 2;
+		const wchar_t* psz    = reinterpret_cast<const wchar_t*>(oView.Data());
+		size_t         nChars = (!oView.Empty()) ? wcsnlen(psz, oView.Size() / 2) : 0;
 
 		// Allocate the string buffer.
 		str.BufferSize(nChars+1);
 
 #ifdef ANSI_BUILD
-		// Copy the Unicode string to a temporary buffer.
-		wchar_t* psz = static_cast<wchar_t*>(_alloca(nBytes));
-
-		GetData(reinterpret_cast<byte*>(psz), nBytes, 0);
-
-		nChars = wcsnlen(psz, nChars);
-
 		// Convert to ANSI.
-		Core::wideToAnsi(psz, psz+nChars, str.Buffer());
+		DDE::utf16ToAnsi(psz, nChars, str.Buffer());
 #else
 		// Copy the data contents directly into the string.
-		GetData(reinterpret_cast<byte*>(str.Buffer()), nBytes, 0);
+		memcpy(str.Buffer(), psz, Core::numBytes<wchar_t>(nChars));
 #endif
 		// Ensure its null terminated.
 		str[nChars] = TXT('\0');
@@ -241,12 +240,16 @@ void CDDEData::SetData(const void* pBuffer, size_t nSize, size_t nOffset)
 
 	LPBYTE lpData = static_cast<byte*>(const_cast<void*>(pBuffer));
 
-	HDDEDATA hData = ::DdeAddData(m_pHandle->m_hData, lpData, static_cast<DWORD>(nSize), static_cast<DWORD>(nOffset));
+	HDDEDATA hData = DDE::ddeApi().AddData(m_pHandle->m_hData, lpData, static_cast<DWORD>(nSize), static_cast<DWORD>(nOffset));
 
 	if (hData == NULL)
 		throw CDDEException(CDDEException::E_ALLOC_FAILED, m_pHandle->m_pInst->LastError());
 
 	m_pHandle->m_hData = hData;
+
+	// The data only grows.
+	if (m_pHandle->m_nSize != CHandle::UNKNOWN_SIZE)
+		m_pHandle->m_nSize = std::max(m_pHandle->m_nSize, nOffset+nSize);
 }
 
 void CDDEData::SetString(const CString& str, TextFormat eFormat)
@@ -264,7 +267,12 @@ void CDDEData::SetString(const CString& str, TextFormat eFormat)
 #ifdef ANSI_BUILD
 		SetData(str.Buffer(), nBytes);
 #else
-		SetData(T2A(str.Buffer()), nBytes);
+		std::vector<char> vBuffer(nChars+1);
+
+		// Convert to ANSI, including the terminator.
+		DDE::utf16ToAnsi(str.Buffer(), nChars+1, &vBuffer[0]);
+
+		SetData(&vBuffer[0], nBytes);
 #endif
 	}
 	else // (eFormat == UNICODE_TEXT)
@@ -274,7 +282,12 @@ void CDDEData::SetString(const CString& str, TextFormat eFormat)
 		size_t nBytes = Core::numBytes<wchar_t>(nChars+1);
 
 #ifdef ANSI_BUILD
-		SetData(T2W(str.Buffer()), nBytes);
+		std::vector<wchar_t> vBuffer(nChars+1);
+
+		// Convert to Unicode, including the terminator.
+		DDE::ansiToUtf16(str.Buffer(), nChars+1, &vBuffer[0]);
+
+		SetData(&vBuffer[0], nBytes);
 #else
 		SetData(str.Buffer(), nBytes);
 #endif
@@ -287,10 +300,43 @@ void CDDEData::Free()
 
 	if (m_pHandle->m_hData != NULL)
 	{
-		BOOL okay = ::DdeFreeDataHandle(m_pHandle->m_hData);
+		BOOL okay = DDE::ddeApi().FreeDataHandle(m_pHandle->m_hData);
 
 		ASSERT_RESULT(okay, okay != FALSE);
 	}
 
 	m_pHandle->m_hData = NULL;
+	m_pHandle->m_nSize = 0;
+}
+
+CDDEData::CView::CView(const CDDEData& oData)
+	: m_hData(oData.Handle())
+	, m_pData(nullptr)
+	, m_nSize(0)
+{
+	// Nothing to view?
+	if (m_hData == NULL)
+		return;
+
+	DWORD dwSize = 0;
+
+	m_pData = DDE::ddeApi().AccessData(m_hData, &dwSize);
+
+	if (m_pData == nullptr)
+		throw CDDEException(CDDEException::E_ACCESS_FAILED, oData.m_pHandle->m_pInst->LastError());
+
+	m_nSize = dwSize;
+
+	// Remember the size for later queries.
+	oData.m_pHandle->m_nSize = m_nSize;
+}
+
+CDDEData::CView::~CView()
+{
+	if (m_pData != nullptr)
+	{
+		BOOL okay = DDE::ddeApi().UnaccessData(m_hData);
+
+		ASSERT_RESULT(okay, okay != FALSE);
+	}
 }
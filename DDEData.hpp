@@ -29,6 +29,9 @@
 class CDDEData
 {
 public:
+	// Forward declarations.
+	class CView;
+
 	//
 	// Constructors/Destructor.
 	//
@@ -48,6 +51,7 @@ public:
 	// Accessors.
 	//
 	HDDEDATA Handle() const;
+	uint     Format() const;
 	size_t   Size() const;
 	size_t   GetData(void* pBuffer, size_t nSize, size_t nOffset = 0) const;
 	CBuffer  GetBuffer() const;
@@ -82,7 +86,10 @@ protected:
 class CDDEData::CHandle /*: private NotCopyable*/
 {
 public:
-	CHandle(CDDEInst* pInst, HDDEDATA hData, uint nFormat, bool bOwn);
+	// The size when it has not been queried yet.
+	static const size_t UNKNOWN_SIZE = static_cast<size_t>(-1);
+
+	CHandle(CDDEInst* pInst, HDDEDATA hData, uint nFormat, bool bOwn, size_t nSize = UNKNOWN_SIZE);
 	~CHandle();
 
 	//
@@ -93,6 +100,7 @@ public:
 	HDDEDATA		m_hData;		// The data handle.
 	const uint		m_nFormat;		// The data format.
 	const bool		m_bOwn;			// Ownership flag.
+	size_t			m_nSize;		// The cached data size.
 
 private:
 	// NotCopyable.
@@ -100,6 +108,43 @@ private:
 	CHandle& operator=(const CHandle&);
 };
 
+/******************************************************************************
+**
+** A scoped read-only view of the contents of a CDDEData object. The contents
+** are accessed in place and so must not be modified whilst in view.
+**
+*******************************************************************************
+*/
+
+class CDDEData::CView
+{
+public:
+	//
+	// Constructors/Destructor.
+	//
+	explicit CView(const CDDEData& oData);
+	~CView();
+
+	//
+	// Accessors.
+	//
+	const byte* Data() const;
+	size_t      Size() const;
+	bool        Empty() const;
+
+private:
+	//
+	// Members.
+	//
+	HDDEDATA	m_hData;		// The data handle.
+	const byte*	m_pData;		// The contents.
+	size_t		m_nSize;		// The contents size.
+
+	// NotCopyable.
+	CView(const CView&);
+	CView& operator=(const CView&);
+};
+
 /******************************************************************************
 **
 ** Implementation of inline functions.
@@ -114,9 +159,31 @@ inline HDDEDATA CDDEData::Handle() const
 	return m_pHandle->m_hData;
 }
 
+inline uint CDDEData::Format() const
+{
+	ASSERT(m_pHandle != NULL);
+
+	return m_pHandle->m_nFormat;
+}
+
 inline void CDDEData::SetBuffer(const CBuffer& oBuffer)
 {
 	SetData(oBuffer.Buffer(), oBuffer.Size());
 }
 
+inline const byte* CDDEData::CView::Data() const
+{
+	return m_pData;
+}
+
+inline size_t CDDEData::CView::Size() const
+{
+	return m_nSize;
+}
+
+inline bool CDDEData::CView::Empty() const
+{
+	return (m_nSize == 0);
+}
+
 #endif // DDEDATA_HPP
@@ -75,6 +75,14 @@ CDDEException::CDDEException(int eErrCode, uint nDDECode)
 			m_details = Core::fmt(TXT("Failed to query string data: %s"), strErrDef.c_str());
 			break;
 
+		case E_ACCESS_FAILED:
+			m_details = Core::fmt(TXT("Failed to access DDE data: %s"), strErrDef.c_str());
+			break;
+
+		case E_BAD_FORMAT:
+			m_details = TXT("Invalid DDE data format");
+			break;
+
 		// Shouldn't happen!
 		default:
 			ASSERT_FALSE();
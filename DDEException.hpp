@@ -44,6 +44,8 @@ public:
 		E_EXECUTE_FAILED	= 18,	// Failed to execute a command.
 		E_POKE_FAILED		= 19,	// Failed to poke a value.
 		E_STRCOPY_FAILED	= 20,	//!< Failed to query DDE string data.
+		E_ACCESS_FAILED		= 21,	//!< Failed to access DDE data.
+		E_BAD_FORMAT		= 22,	//!< The data is not in the expected format.
 	};
 
 	//
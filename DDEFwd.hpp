@@ -24,6 +24,12 @@ class CDDEInst;
 class CDDELink;
 class CDDESvrConv;
 
+namespace DDE
+{
+class LinkList;
+class Pool;
+}
+
 //#define USE_DDE_INTERFACES
 #ifdef USE_DDE_INTERFACES
 
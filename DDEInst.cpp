@@ -10,6 +10,69 @@
 
 #include "Common.hpp"
 #include "DDEInst.hpp"
+#include "DDELink.hpp"
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	.
+**
+** Parameters:	nConvSize	The size of the conversation class the instance
+**							creates, which its conversation pool is sized for.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CDDEInst::CDDEInst(size_t nConvSize)
+	: m_dwInst(0)
+	, m_eType(CLIENT)
+	, m_oStrings()
+	, m_oLinkPool(sizeof(CDDELink))
+	, m_oConvPool(nConvSize)
+{
+}
+
+/******************************************************************************
+** Method:		Destructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CDDEInst::~CDDEInst()
+{
+}
+
+/******************************************************************************
+** Method:		GetMemoryStats()
+**
+** Description:	Get the memory used by the links, conversations and strings
+**				the instance has created.
+**
+** Parameters:	None.
+**
+** Returns:		The memory statistics.
+**
+*******************************************************************************
+*/
+
+DDE::MemoryStats CDDEInst::GetMemoryStats() const
+{
+	DDE::MemoryStats oStats;
+
+	oStats.m_links   = m_oLinkPool.Stats();
+	oStats.m_convs   = m_oConvPool.Stats();
+	oStats.m_strings = m_oStrings.Size();
+
+	return oStats;
+}
 
 /******************************************************************************
 ** Method:		GetErrorCode()
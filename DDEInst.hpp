@@ -16,6 +16,10 @@
 #pragma once
 #endif
 
+#include "DDEApi.hpp"
+#include "DDEStringTable.hpp"
+#include "DDEPool.hpp"
+
 /******************************************************************************
 **
 ** The base class for all DDE services.
@@ -36,28 +40,36 @@ public:
 	//
 	// Accessors.
 	//
-	DWORD    Handle() const;
-	InstType Type() const;
+	DWORD             Handle() const;
+	InstType          Type() const;
+	DDE::StringTable& Strings();
+	DDE::Pool&        LinkPool();
+	DDE::Pool&        ConvPool();
 
 	//
 	// Methods.
 	//
 	uint    LastError() const;
 
+	DDE::MemoryStats GetMemoryStats() const;
+
 	static CString GetErrorCode(uint nError);
 
 protected:
 	//
 	// Members.
 	//
-	DWORD		m_dwInst;	// The instance handle.
-	InstType	m_eType;	// The instance type.
+	DWORD				m_dwInst;	// The instance handle.
+	InstType			m_eType;	// The instance type.
+	DDE::StringTable	m_oStrings;	// The interned string handles.
+	DDE::Pool			m_oLinkPool;	// The pool links are allocated from.
+	DDE::Pool			m_oConvPool;	// The pool conversations are allocated from.
 
 	//
 	// Constructors/Destructor.
 	// NB: Make abstract.
 	//
-	CDDEInst();
+	CDDEInst(size_t nConvSize);
 	virtual ~CDDEInst();
 
 private:
@@ -73,30 +85,35 @@ private:
 *******************************************************************************
 */
 
-inline CDDEInst::CDDEInst()
-	: m_dwInst(0)
-	, m_eType(CLIENT)
+inline DWORD CDDEInst::Handle() const
 {
+	return m_dwInst;
 }
 
-inline CDDEInst::~CDDEInst()
+inline CDDEInst::InstType CDDEInst::Type() const
 {
+	return m_eType;
 }
 
-inline DWORD CDDEInst::Handle() const
+inline DDE::StringTable& CDDEInst::Strings()
 {
-	return m_dwInst;
+	return m_oStrings;
 }
 
-inline CDDEInst::InstType CDDEInst::Type() const
+inline DDE::Pool& CDDEInst::LinkPool()
 {
-	return m_eType;
+	return m_oLinkPool;
+}
+
+inline DDE::Pool& CDDEInst::ConvPool()
+{
+	return m_oConvPool;
 }
 
 inline uint CDDEInst::LastError() const
 {
 	// NB: Resets the error code to DMLERR_NO_ERROR.
-	return ::DdeGetLastError(m_dwInst);
+	return DDE::ddeApi().GetLastError(m_dwInst);
 }
 
 #endif // DDEINST_HPP
@@ -11,6 +11,7 @@
 #include "Common.hpp"
 #include "DDELink.hpp"
 #include "DDEConv.hpp"
+#include "DDEPool.hpp"
 #include <WCL/Clipboard.hpp>
 #include <Core/AnsiWide.hpp>
 
@@ -35,15 +36,59 @@ static uint s_nLinkFormat = CClipboard::RegisterFormat(TXT("Link"));
 *******************************************************************************
 */
 
-CDDELink::CDDELink(CDDEConv* pConv, const tchar* pszItem, uint nFormat)
+CDDELink::CDDELink(CDDEInst* pInst, CDDEConv* pConv, const tchar* pszItem, uint nFormat)
 	: m_nRefCount(0)
 	, m_pConv(pConv)
 	, m_strItem(pszItem)
+	, m_oItem(pInst, pszItem)
 	, m_nFormat(nFormat)
 	, m_pAppData(nullptr)
+	, m_nPosition(Core::npos)
 {
 }
 
+/******************************************************************************
+** Method:		operator new()
+**
+** Description:	Allocate the memory for a link from a pool.
+**
+** Parameters:	nSize		The size of the link.
+**				oPool		The pool to allocate from.
+**
+** Returns:		The memory block.
+**
+*******************************************************************************
+*/
+
+void* CDDELink::operator new(size_t nSize, DDE::Pool& oPool)
+{
+	return oPool.Allocate(nSize);
+}
+
+/******************************************************************************
+** Method:		operator delete()
+**
+** Description:	Return the memory for a link to its pool. The first overload
+**				is only used if the constructor throws.
+**
+** Parameters:	pBlock		The memory block.
+**				oPool		The pool it was allocated from.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDELink::operator delete(void* pBlock, DDE::Pool& /*oPool*/)
+{
+	DDE::Pool::Free(pBlock);
+}
+
+void CDDELink::operator delete(void* pBlock)
+{
+	DDE::Pool::Free(pBlock);
+}
+
 /******************************************************************************
 ** Method:		CopyLink()
 **
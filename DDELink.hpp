@@ -17,6 +17,7 @@
 #endif
 
 #include "DDEFwd.hpp"
+#include "DDEString.hpp"
 
 /******************************************************************************
 **
@@ -34,6 +35,7 @@ public:
 	uint           RefCount() const;
 	CDDEConv*	   Conversation() const;
 	const CString& Item() const;
+	HSZ            ItemHandle() const;
 	uint           Format() const;
 
 	IDDELinkData*  AppData() const;
@@ -56,6 +58,13 @@ public:
 	//! Parse the DDE link into its separate parts.
 	static bool ParseLink(const tstring& link, tstring& service, tstring& topic, tstring& item);
 
+	//
+	// Allocation methods.
+	//
+	static void* operator new(size_t nSize, DDE::Pool& oPool);
+	static void  operator delete(void* pBlock, DDE::Pool& oPool);
+	static void  operator delete(void* pBlock);
+
 protected:
 	//
 	// Members.
@@ -63,19 +72,22 @@ protected:
 	uint			m_nRefCount;	// The reference count.
 	CDDEConv*		m_pConv;		// The parent conversation.
 	CString			m_strItem;		// The item name.
+	CDDEString		m_oItem;		// The interned item handle.
 	uint			m_nFormat;		// The data format.
 	IDDELinkData*	m_pAppData;		// Custom data.
+	size_t			m_nPosition;	// The position in the conversation's links.
 
 	//
 	// Constructors/Destructor.
 	//
-	CDDELink(CDDEConv* pConv, const tchar* pszItem, uint nFormat);
+	CDDELink(CDDEInst* pInst, CDDEConv* pConv, const tchar* pszItem, uint nFormat);
 	CDDELink(const CDDELink&);
 	~CDDELink();
 
 	// Friends.
 	friend class CDDECltConv;
 	friend class CDDESvrConv;
+	friend class DDE::LinkList;
 
 private:
 	// NotCopyable.
@@ -109,6 +121,11 @@ inline const CString& CDDELink::Item() const
 	return m_strItem;
 }
 
+inline HSZ CDDELink::ItemHandle() const
+{
+	return m_oItem;
+}
+
 inline uint CDDELink::Format() const
 {
 	return m_nFormat;
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDELinkIndex.cpp
+//! \brief  The LinkIndex class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDELinkIndex.hpp"
+#include <tchar.h>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+LinkIndex::LinkIndex()
+	: m_links()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. The links are owned by the conversation.
+
+LinkIndex::~LinkIndex()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a link to the index. An existing link for the same item and format is
+//! replaced.
+
+void LinkIndex::Insert(const tchar* item, uint format, CDDELink* link)
+{
+	ASSERT(item != nullptr);
+	ASSERT(link != nullptr);
+
+	m_links[MakeKey(item, format)] = link;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a link from the index.
+
+void LinkIndex::Erase(const tchar* item, uint format)
+{
+	ASSERT(item != nullptr);
+
+	m_links.erase(MakeKey(item, format));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the link for an item and format. The item name is not case-sensitive.
+
+CDDELink* LinkIndex::Find(const tchar* item, uint format) const
+{
+	ASSERT(item != nullptr);
+
+	Links::const_iterator it = m_links.find(MakeKey(item, format));
+
+	if (it == m_links.end())
+		return nullptr;
+
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all links from the index.
+
+void LinkIndex::Clear()
+{
+	m_links.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the key for an item and format. The item is folded to lower case in
+//! the same way as tstricmp() so that the lookup matches the linear search it
+//! replaces.
+
+LinkIndex::Key LinkIndex::MakeKey(const tchar* item, uint format)
+{
+	tstring folded(item);
+
+	for (tstring::iterator it = folded.begin(); it != folded.end(); ++it)
+		*it = static_cast<tchar>(_totlower(static_cast<_TUCHAR>(*it)));
+
+	return Key(folded, format);
+}
+
+//namespace DDE
+}
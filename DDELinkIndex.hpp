@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDELinkIndex.hpp
+//! \brief  The LinkIndex class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDELINKINDEX_HPP
+#define NCL_DDELINKINDEX_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEFwd.hpp"
+#include <map>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! An index of the links on a conversation by item and format. The item name
+//! is case-folded once when the link is added, so that a lookup is a single
+//! tree search rather than a case-insensitive comparison with every link.
+
+class LinkIndex
+{
+public:
+	//! Default constructor.
+	LinkIndex();
+
+	//! Destructor.
+	~LinkIndex();
+
+	//
+	// Properties.
+	//
+
+	//! The number of links indexed.
+	size_t Size() const;
+
+	//
+	// Methods.
+	//
+
+	//! Add a link to the index.
+	void Insert(const tchar* item, uint format, CDDELink* link);
+
+	//! Remove a link from the index.
+	void Erase(const tchar* item, uint format);
+
+	//! Find the link for an item and format.
+	CDDELink* Find(const tchar* item, uint format) const;
+
+	//! Remove all links from the index.
+	void Clear();
+
+private:
+	//! The index key.
+	typedef std::pair<tstring, uint> Key;
+	//! The links keyed by case-folded item and format.
+	typedef std::map<Key, CDDELink*> Links;
+
+	//
+	// Members.
+	//
+	Links	m_links;	//!< The indexed links.
+
+	//
+	// Internal methods.
+	//
+
+	//! Create the key for an item and format.
+	static Key MakeKey(const tchar* item, uint format);
+
+	// NotCopyable.
+	LinkIndex(const LinkIndex&);
+	LinkIndex& operator=(const LinkIndex&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of links indexed.
+
+inline size_t LinkIndex::Size() const
+{
+	return m_links.size();
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDELINKINDEX_HPP
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDELinkList.hpp
+//! \brief  The LinkList class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDELINKLIST_HPP
+#define NCL_DDELINKLIST_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDELink.hpp"
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The links owned by a conversation. Each link records its own position in
+//! the list so that it can be removed in constant time by moving the last link
+//! into its place, instead of searching for it and erasing it from the middle.
+//! NB: Removing a link changes the order of those that remain.
+
+class LinkList
+{
+public:
+	//! The underlying container type.
+	typedef std::vector<CDDELink*> Links;
+
+public:
+	//! Default constructor.
+	LinkList();
+
+	//
+	// Properties.
+	//
+
+	//! The number of links.
+	size_t Size() const;
+
+	//! Get a link by its position.
+	CDDELink* operator[](size_t index) const;
+
+	//! The links in the list.
+	const Links& Items() const;
+
+	//
+	// Methods.
+	//
+
+	//! Reserve space for a number of links.
+	void Reserve(size_t count);
+
+	//! Append a link.
+	void Add(CDDELink* link);
+
+	//! Remove a link.
+	void Remove(CDDELink* link);
+
+	//! Remove all the links.
+	void Clear();
+
+private:
+	//
+	// Members.
+	//
+	Links	m_links;	//!< The links.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline LinkList::LinkList()
+	: m_links()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of links.
+
+inline size_t LinkList::Size() const
+{
+	return m_links.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a link by its position.
+
+inline CDDELink* LinkList::operator[](size_t index) const
+{
+	ASSERT(index < m_links.size());
+
+	return m_links[index];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The links in the list.
+
+inline const LinkList::Links& LinkList::Items() const
+{
+	return m_links;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reserve space for a number of links.
+
+inline void LinkList::Reserve(size_t count)
+{
+	m_links.reserve(count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a link.
+
+inline void LinkList::Add(CDDELink* link)
+{
+	ASSERT(link->m_nPosition == Core::npos);
+
+	link->m_nPosition = m_links.size();
+	m_links.push_back(link);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a link by moving the last link into its place.
+
+inline void LinkList::Remove(CDDELink* link)
+{
+	const size_t position = link->m_nPosition;
+
+	ASSERT(position < m_links.size());
+	ASSERT(m_links[position] == link);
+
+	CDDELink* last = m_links.back();
+
+	m_links[position] = last;
+	last->m_nPosition = position;
+	m_links.pop_back();
+
+	link->m_nPosition = Core::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all the links.
+
+inline void LinkList::Clear()
+{
+	for (Links::const_iterator it = m_links.begin(); it != m_links.end(); ++it)
+		(*it)->m_nPosition = Core::npos;
+
+	m_links.clear();
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDELINKLIST_HPP
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEPool.cpp
+//! \brief  The Pool class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEPool.hpp"
+#include <new>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+Pool::Pool(size_t blockSize)
+	: m_blockSize(blockSize)
+	, m_stride(1 + ((blockSize + sizeof(Header) - 1) / sizeof(Header)))
+	, m_slabs()
+	, m_nextSlab(FIRST_SLAB_SIZE)
+	, m_free(nullptr)
+	, m_inUse(0)
+	, m_peak(0)
+	, m_reserved(0)
+	, m_oversized(0)
+{
+	ASSERT(blockSize != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any blocks still allocated become invalid.
+
+Pool::~Pool()
+{
+	ASSERT(m_inUse == 0);
+
+	for (Slabs::const_iterator it = m_slabs.begin(); it != m_slabs.end(); ++it)
+		delete[] *it;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The memory used by the pool.
+
+PoolStats Pool::Stats() const
+{
+	PoolStats stats;
+
+	stats.m_blockSize = m_blockSize;
+	stats.m_inUse     = m_inUse;
+	stats.m_peak      = m_peak;
+	stats.m_slabs     = m_slabs.size();
+	stats.m_reserved  = m_reserved;
+	stats.m_oversized = m_oversized;
+
+	return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate a block of at least the given size. Requests larger than the block
+//! size are passed onto the heap.
+
+void* Pool::Allocate(size_t size)
+{
+	if (size > m_blockSize)
+	{
+		Header* header = static_cast<Header*>(::operator new(sizeof(Header) + size));
+
+		header->m_pool = nullptr;
+		++m_oversized;
+
+		return header + 1;
+	}
+
+	if (m_free == nullptr)
+		AddSlab();
+
+	Header* header = m_free;
+
+	m_free = header->m_next;
+	header->m_pool = this;
+
+	if (++m_inUse > m_peak)
+		m_peak = m_inUse;
+
+	return header + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Return a block to the pool it was allocated from.
+
+void Pool::Free(void* block)
+{
+	if (block == nullptr)
+		return;
+
+	Header* header = static_cast<Header*>(block) - 1;
+	Pool*   pool = header->m_pool;
+
+	if (pool == nullptr)
+	{
+		::operator delete(header);
+		return;
+	}
+
+	ASSERT(pool->m_inUse != 0);
+
+	header->m_next = pool->m_free;
+	pool->m_free = header;
+	--pool->m_inUse;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate a new slab and add its blocks to the free list. Each slab is twice
+//! the size of the last one, up to a limit.
+
+void Pool::AddSlab()
+{
+	m_slabs.reserve(m_slabs.size() + 1);
+
+	const size_t blocks = m_nextSlab;
+	Header*      slab = new Header[blocks * m_stride];
+
+	m_slabs.push_back(slab);
+	m_reserved += blocks * m_stride * sizeof(Header);
+
+	// Chain the blocks so that they are handed out in address order.
+	for (size_t i = blocks; i != 0; --i)
+	{
+		Header* header = slab + ((i - 1) * m_stride);
+
+		header->m_next = m_free;
+		m_free = header;
+	}
+
+	if (m_nextSlab < MAX_SLAB_SIZE)
+		m_nextSlab = (2 * m_nextSlab < MAX_SLAB_SIZE) ? (2 * m_nextSlab) : MAX_SLAB_SIZE;
+}
+
+//namespace DDE
+}
@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEPool.hpp
+//! \brief  The Pool class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEPOOL_HPP
+#define NCL_DDEPOOL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The memory used by a pool.
+
+struct PoolStats
+{
+	size_t	m_blockSize;	//!< The size of each block.
+	size_t	m_inUse;		//!< The number of blocks allocated.
+	size_t	m_peak;			//!< The most blocks allocated at once.
+	size_t	m_slabs;		//!< The number of slabs.
+	size_t	m_reserved;		//!< The number of bytes reserved by the slabs.
+	size_t	m_oversized;	//!< The number of allocations too big for a block.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The memory used by a DDE instance.
+
+struct MemoryStats
+{
+	PoolStats	m_links;	//!< The pool the links are allocated from.
+	PoolStats	m_convs;	//!< The pool the conversations are allocated from.
+	size_t		m_strings;	//!< The number of interned strings.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A fixed size block allocator for the objects a DDE instance creates in
+//! large numbers, such as links. Blocks are carved out of slabs, which grow
+//! geometrically, and are recycled via a free list. Each block is prefixed with
+//! a header that refers to the owning pool so that a block can be freed without
+//! knowing where it came from. Requests larger than the block size, such as for
+//! a derived class, fall back to the heap. The slabs are only released when the
+//! pool is destroyed.
+
+class Pool
+{
+public:
+	//! The number of blocks in the first slab.
+	static const size_t FIRST_SLAB_SIZE = 32;
+
+	//! The largest number of blocks in a slab.
+	static const size_t MAX_SLAB_SIZE = 4096;
+
+public:
+	//! Constructor.
+	explicit Pool(size_t blockSize);
+
+	//! Destructor.
+	~Pool();
+
+	//
+	// Properties.
+	//
+
+	//! The size of each block.
+	size_t BlockSize() const;
+
+	//! The number of blocks allocated.
+	size_t InUse() const;
+
+	//! The memory used by the pool.
+	PoolStats Stats() const;
+
+	//
+	// Methods.
+	//
+
+	//! Allocate a block of at least the given size.
+	void* Allocate(size_t size);
+
+	//! Return a block to the pool it was allocated from.
+	static void Free(void* block);
+
+private:
+	//! The header that prefixes every block.
+	union Header
+	{
+		Pool*	m_pool;		//!< The owner, when allocated from a slab.
+		Header*	m_next;		//!< The next free block, when on the free list.
+		double	m_align;	//!< Forces the strictest alignment.
+	};
+
+	//! The slabs of blocks.
+	typedef std::vector<Header*> Slabs;
+
+	//
+	// Members.
+	//
+	size_t	m_blockSize;	//!< The size of each block.
+	size_t	m_stride;		//!< The distance between blocks, in headers.
+	Slabs	m_slabs;		//!< The slabs allocated.
+	size_t	m_nextSlab;		//!< The number of blocks in the next slab.
+	Header*	m_free;			//!< The head of the free list.
+	size_t	m_inUse;		//!< The number of blocks allocated.
+	size_t	m_peak;			//!< The most blocks allocated at once.
+	size_t	m_reserved;		//!< The number of bytes reserved by the slabs.
+	size_t	m_oversized;	//!< The number of oversized allocations.
+
+	//
+	// Internal methods.
+	//
+
+	//! Allocate a new slab and add its blocks to the free list.
+	void AddSlab();
+
+	// NotCopyable.
+	Pool(const Pool&);
+	Pool& operator=(const Pool&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The size of each block.
+
+inline size_t Pool::BlockSize() const
+{
+	return m_blockSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of blocks allocated.
+
+inline size_t Pool::InUse() const
+{
+	return m_inUse;
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDEPOOL_HPP
@@ -13,10 +13,12 @@
 #include <WCL/StrArray.hpp>
 #include "DDEException.hpp"
 #include "DDESvrConv.hpp"
+#include "DDELink.hpp"
 #include "DDEString.hpp"
 #include "IDDEServerListener.hpp"
 #include "DDEData.hpp"
 #include <algorithm>
+#include <map>
 #include <malloc.h>
 #include <WCL/Exception.hpp>
 
@@ -30,12 +32,40 @@
 // The single DDE Client object.
 CDDEServer* CDDEServer::g_pDDEServer = NULL;
 
+namespace
+{
+
+//! The number of updated links for each item handle.
+typedef std::map<HSZ, size_t> ItemUpdates;
+//! The updated items for each topic handle.
+typedef std::map<HSZ, ItemUpdates> TopicUpdates;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if every advise loop on the topic is for one of the updated items.
+
+bool allLinksUpdated(const DDE::ConvIndex& index, HSZ topic, const ItemUpdates& items)
+{
+	size_t links = 0;
+
+	for (ItemUpdates::const_iterator it = items.begin(); it != items.end(); ++it)
+		links += index.LinkCount(topic, it->first);
+
+	return (links == index.LinkCount(topic));
+}
+
+//namespace
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Constructor.
 
 CDDEServer::CDDEServer(DWORD dwFlags)
-	: m_aoConvs()
+	: CDDEInst(sizeof(CDDESvrConv))
+	, m_aoConvs()
+	, m_oConvIndex()
 	, m_aoListeners()
+	, m_oScheduler()
+	, m_aoDueLinks()
 {
 	m_eType = SERVER;
 
@@ -76,7 +106,7 @@ CDDEServer::~CDDEServer()
 void CDDEServer::Initialise(DWORD dwFlags)
 {
 	// Register with DDEML.
-	UINT nResult = ::DdeInitialize(&m_dwInst, DDECallbackProc, APPCLASS_STANDARD | dwFlags, 0);
+	UINT nResult = DDE::ddeApi().Initialize(&m_dwInst, DDECallbackProc, APPCLASS_STANDARD | dwFlags, 0);
 
 	// Failed?
 	if (nResult != DMLERR_NO_ERROR)
@@ -102,18 +132,25 @@ void CDDEServer::Uninitialise()
 	// Clean-up.
 	if (m_dwInst != 0)
 	{
-		BOOL okay = ::DdeUninitialize(m_dwInst);
+		BOOL okay = DDE::ddeApi().Uninitialize(m_dwInst);
 
 		ASSERT_RESULT(okay, okay != FALSE);
 	}
 
+	// The string handles were freed with the instance.
+	m_oStrings.Reset();
+
 	// Delete all conversations.
 	for (size_t i = 0, n = m_aoConvs.size(); i != n; ++i)
+	{
+		UnscheduleLinks(m_aoConvs[i]);
 		delete m_aoConvs[i];
+	}
 
 	// Reset members.
 	m_dwInst = 0;
 	m_aoConvs.clear();
+	m_oConvIndex.Clear();
 	m_aoListeners.clear();
 }
 
@@ -138,10 +175,10 @@ void CDDEServer::Register(const tchar* pszService)
 	CDDEString strService(this, pszService);
 
 	// Try and register the service name.
-	HDDEDATA hResult = ::DdeNameService(m_dwInst, strService, NULL, DNS_REGISTER);
+	HDDEDATA hResult = DDE::ddeApi().NameService(m_dwInst, strService, NULL, DNS_REGISTER);
 
 	if (hResult == NULL)
-		throw CDDEException(CDDEException::E_REG_FAILED, ::DdeGetLastError(m_dwInst));
+		throw CDDEException(CDDEException::E_REG_FAILED, DDE::ddeApi().GetLastError(m_dwInst));
 }
 
 /******************************************************************************
@@ -162,7 +199,7 @@ void CDDEServer::Unregister(const tchar* pszService)
 
 	CDDEString strService(this, pszService);
 
-	HDDEDATA hResult = ::DdeNameService(m_dwInst, strService, NULL, DNS_UNREGISTER);
+	HDDEDATA hResult = DDE::ddeApi().NameService(m_dwInst, strService, NULL, DNS_UNREGISTER);
 
 	ASSERT_RESULT(hResult, hResult != 0);
 }
@@ -182,13 +219,16 @@ void CDDEServer::Unregister(const tchar* pszService)
 void CDDEServer::DestroyConversation(CDDESvrConv* pConv)
 {
 	ASSERT(pConv != nullptr);
-	ASSERT(std::find(m_aoConvs.begin(), m_aoConvs.end(), pConv) != m_aoConvs.end());
+	ASSERT(FindConversation(pConv->Handle()) == pConv);
 
 	// Disconnect from service/topic.
 	pConv->Disconnect();
 
+	// Drop any pending updates.
+	UnscheduleLinks(pConv);
+
 	// Remove from collection.
-	m_aoConvs.erase(std::find(m_aoConvs.begin(), m_aoConvs.end(), pConv));
+	RemoveConversation(pConv);
 
 	// Delete conversation.
 	delete pConv;
@@ -197,7 +237,8 @@ void CDDEServer::DestroyConversation(CDDESvrConv* pConv)
 /******************************************************************************
 ** Method:		FindConversation()
 **
-** Description:	Find an existing conversation.
+** Description:	Find an existing conversation. The service and topic names
+**				are not case-sensitive.
 **
 ** Parameters:	pszService	The service name.
 **				pszTopic	The topic name.
@@ -213,34 +254,117 @@ CDDESvrConv* CDDEServer::FindConversation(const tchar* pszService, const tchar*
 	ASSERT(pszService != nullptr);
 	ASSERT(pszTopic   != nullptr);
 
-	// Search the conversation list.
-	for (size_t i = 0, n = m_aoConvs.size(); i != n; ++i)
-	{
-		CDDESvrConv* pConv = m_aoConvs[i];
+	// Every conversation interns its service and topic names.
+	HSZ hszService = m_oStrings.Find(pszService);
+	HSZ hszTopic   = m_oStrings.Find(pszTopic);
 
-		if ( (pConv->Service() == pszService) && (pConv->Topic() == pszTopic) )
-			return pConv;
-	}
+	if ( (hszService == NULL) || (hszTopic == NULL) )
+		return nullptr;
 
-	return nullptr;
+	return static_cast<CDDESvrConv*>(m_oConvIndex.Find(hszService, hszTopic));
 }
 
 CDDESvrConv* CDDEServer::FindConversation(HCONV hConv) const
 {
 	ASSERT(hConv != NULL);
 
-	// Search the conversation list.
-	for (size_t i = 0, n = m_aoConvs.size(); i != n; ++i)
+	return static_cast<CDDESvrConv*>(m_oConvIndex.Find(hConv));
+}
+
+/******************************************************************************
+** Method:		RemoveConversation()
+**
+** Description:	Remove a conversation from the collection by moving the last
+**				one into its place.
+**
+** Parameters:	pConv	The conversation.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDEServer::RemoveConversation(CDDESvrConv* pConv)
+{
+	ASSERT(pConv != nullptr);
+
+	// Its links are destroyed with it.
+	for (size_t i = 0, n = pConv->NumLinks(); i != n; ++i)
+		m_oConvIndex.RemoveLink(pConv->TopicHandle(), pConv->GetLink(i)->ItemHandle());
+
+	size_t nPos = m_oConvIndex.Erase(pConv);
+
+	ASSERT(m_aoConvs[nPos] == pConv);
+
+	CDDESvrConv* pLast = m_aoConvs.back();
+
+	m_aoConvs[nPos] = pLast;
+	m_aoConvs.pop_back();
+
+	if (pLast != pConv)
+		m_oConvIndex.Move(pLast, nPos);
+}
+
+
+/******************************************************************************
+** Method:		PostLinkUpdates()
+**
+** Description:	Posts updates for a set of links in a single pass. The links
+**				are grouped by topic and item so that each topic and item
+**				string handle is only created once and each item is only
+**				posted once, however many conversations have a link to it.
+**				If every advise loop on a topic is for an updated item, one
+**				topic-wide post is used instead.
+**
+** Parameters:	aoLinks		The updated links.
+**
+** Returns:		The number of links successfully posted.
+**
+*******************************************************************************
+*/
+
+size_t CDDEServer::PostLinkUpdates(const CDDELinkUpdates& aoLinks)
+{
+	TopicUpdates oTopics;
+
+	// Group the links by topic and item.
+	for (size_t i = 0, n = aoLinks.size(); i != n; ++i)
 	{
-		CDDESvrConv* pConv = m_aoConvs[i];
+		const CDDELink* pLink = aoLinks[i];
 
-		if (pConv->Handle() == hConv)
-			return pConv;
+		ASSERT(pLink != nullptr);
+
+		++oTopics[pLink->Conversation()->TopicHandle()][pLink->ItemHandle()];
 	}
 
-	return nullptr;
-}
+	size_t nPosted = 0;
+
+	for (TopicUpdates::const_iterator itTopic = oTopics.begin(); itTopic != oTopics.end(); ++itTopic)
+	{
+		HSZ                hszTopic = itTopic->first;
+		const ItemUpdates& oItems = itTopic->second;
+
+		// Cheaper to post for the whole topic?
+		if ( (oItems.size() > 1) && allLinksUpdated(m_oConvIndex, hszTopic, oItems) )
+		{
+			if (DDE::ddeApi().PostAdvise(Handle(), hszTopic, NULL))
+			{
+				for (ItemUpdates::const_iterator itItem = oItems.begin(); itItem != oItems.end(); ++itItem)
+					nPosted += itItem->second;
+			}
+
+			continue;
+		}
+
+		for (ItemUpdates::const_iterator itItem = oItems.begin(); itItem != oItems.end(); ++itItem)
+		{
+			if (DDE::ddeApi().PostAdvise(Handle(), hszTopic, itItem->first))
+				nPosted += itItem->second;
+		}
+	}
 
+	return nPosted;
+}
 
 /******************************************************************************
 ** Method:		AddListener()
@@ -283,6 +407,139 @@ void CDDEServer::RemoveListener(IDDEServerListener* pListener)
 		m_aoListeners.erase(it);
 }
 
+/******************************************************************************
+** Method:		SetAdviseInterval()
+**
+** Description:	Set the minimum interval between posting updates for a link.
+**				The interval can be set for all links, the links on a topic or
+**				a single link, with the most specific one taking precedence.
+**				An interval of 0 posts every update immediately.
+**
+** Parameters:	pszTopic	The topic name.
+**				pLink		The link.
+**				dwInterval	The interval in milliseconds.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDEServer::SetAdviseInterval(DWORD dwInterval)
+{
+	m_oScheduler.SetInterval(dwInterval);
+}
+
+void CDDEServer::SetAdviseInterval(const tchar* pszTopic, DWORD dwInterval)
+{
+	ASSERT(pszTopic != nullptr);
+
+	m_oScheduler.SetInterval(pszTopic, dwInterval);
+}
+
+void CDDEServer::SetAdviseInterval(const CDDELink* pLink, DWORD dwInterval)
+{
+	ASSERT(pLink != nullptr);
+
+	m_oScheduler.SetInterval(pLink, dwInterval);
+}
+
+/******************************************************************************
+** Method:		ScheduleLinkUpdate()
+**
+** Description:	Schedules an update for a link. If the links interval has
+**				elapsed since the last update was posted it is posted now,
+**				otherwise it is posted by a later call to PostPendingUpdates().
+**				Updates made in the meantime are merged, so that the client
+**				only receives the latest value.
+**
+** Parameters:	pLink	The updated link.
+**
+** Returns:		false if the update was posted and failed, true otherwise.
+**
+*******************************************************************************
+*/
+
+bool CDDEServer::ScheduleLinkUpdate(const CDDELink* pLink)
+{
+	ASSERT(pLink != nullptr);
+
+	if (m_oScheduler.Schedule(pLink, ::GetTickCount()))
+		return PostScheduledUpdate(pLink);
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		PostPendingUpdates()
+**
+** Description:	Posts the updates for the links whose interval has elapsed.
+**				This should be called periodically, e.g. from a timer, when
+**				advise intervals are being used.
+**
+** Parameters:	None.
+**
+** Returns:		The number of updates posted.
+**
+*******************************************************************************
+*/
+
+size_t CDDEServer::PostPendingUpdates()
+{
+	m_aoDueLinks.clear();
+	m_oScheduler.GetDue(::GetTickCount(), m_aoDueLinks);
+
+	if (m_aoDueLinks.empty())
+		return 0;
+
+	size_t nPosted = PostLinkUpdates(m_aoDueLinks);
+
+	m_oScheduler.RecordPosts(nPosted, m_aoDueLinks.size() - nPosted);
+
+	return nPosted;
+}
+
+/******************************************************************************
+** Method:		PostScheduledUpdate()
+**
+** Description:	Posts an update for a link and records the outcome.
+**
+** Parameters:	pLink	The updated link.
+**
+** Returns:		true or false.
+**
+*******************************************************************************
+*/
+
+bool CDDEServer::PostScheduledUpdate(const CDDELink* pLink)
+{
+	CDDESvrConv* pConv = static_cast<CDDESvrConv*>(pLink->Conversation());
+
+	bool bPosted = pConv->PostLinkUpdate(pLink);
+
+	m_oScheduler.RecordPost(bPosted);
+
+	return bPosted;
+}
+
+/******************************************************************************
+** Method:		UnscheduleLinks()
+**
+** Description:	Removes the links for a conversation from the scheduler,
+**				dropping any pending updates.
+**
+** Parameters:	pConv	The conversation.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CDDEServer::UnscheduleLinks(const CDDESvrConv* pConv)
+{
+	for (size_t i = 0, n = pConv->NumLinks(); i != n; ++i)
+		m_oScheduler.Remove(pConv->GetLink(i));
+}
+
 /******************************************************************************
 ** Methods:		OnWildConnect*()
 **
@@ -390,9 +647,10 @@ void CDDEServer::OnConnectConfirm(HCONV hConv, const tchar* pszService, const tc
 	ASSERT(pszTopic   != nullptr);
 
 	// Allocate a new conversation and add to the collection.
-	CDDESvrConv* pConv = new CDDESvrConv(this, hConv, pszService, pszTopic);
+	CDDESvrConv* pConv = new(ConvPool()) CDDESvrConv(this, hConv, pszService, pszTopic);
 
 	m_aoConvs.push_back(pConv);
+	m_oConvIndex.Insert(pConv, m_aoConvs.size()-1);
 
 	// Notify listeners.
 	for (size_t i = 0, n = m_aoListeners.size(); i != n; ++i)
@@ -424,8 +682,11 @@ void CDDEServer::OnDisconnect(HCONV hConv)
 	for (size_t i = 0, n = m_aoListeners.size(); i != n; ++i)
 		m_aoListeners[i]->OnDisconnect(pConv);
 
+	// Drop any pending updates.
+	UnscheduleLinks(pConv);
+
 	// Remove from collection and delete.
-	m_aoConvs.erase(std::find(m_aoConvs.begin(), m_aoConvs.end(), pConv));
+	RemoveConversation(pConv);
 	delete pConv;
 }
 
@@ -506,6 +767,8 @@ bool CDDEServer::OnAdviseStart(HCONV hConv, const tchar* pszItem, uint nFormat)
 		// Create a link and add to conversation collection.
 		CDDELink* pLink = pConv->CreateLink(pszItem, nFormat);
 
+		m_oConvIndex.AddLink(pConv->TopicHandle(), pLink->ItemHandle());
+
 		// Notify listeners.
 		for (size_t i = 0, n = m_aoListeners.size(); i != n; ++i)
 			m_aoListeners[i]->OnAdviseConfirm(pConv, pLink);
@@ -587,7 +850,11 @@ void CDDEServer::OnAdviseStop(HCONV hConv, const tchar* pszItem, uint nFormat)
 	for (size_t i = 0, n = m_aoListeners.size(); i != n; ++i)
 		m_aoListeners[i]->OnAdviseStop(pConv, pLink);
 
+	// Drop any pending update.
+	m_oScheduler.Remove(pLink);
+
 	// Remove from conversation.
+	m_oConvIndex.RemoveLink(pConv->TopicHandle(), pLink->ItemHandle());
 	pConv->DestroyLink(pLink);
 }
 
@@ -672,8 +939,14 @@ bool CDDEServer::OnPoke(HCONV hConv, const tchar* pszItem, uint nFormat, const C
 
 uint CDDEServer::GuessTextFormat(const CBuffer& buffer)
 {
-	const size_t size = buffer.Size();
+	return GuessTextFormat(buffer.Buffer(), buffer.Size());
+}
 
+////////////////////////////////////////////////////////////////////////////////
+//! Attempt to guess the format of the text data by inspecting it in place.
+
+uint CDDEServer::GuessTextFormat(const void* data, size_t size)
+{
 	// Minimum unicode string is 1 character + EOL.
 	// NB: Unicode EOL (\0\0) is equivalent to ANSI EOL (\0)
 	if (size < Core::numBytes<wchar_t>(2))
@@ -683,7 +956,7 @@ uint CDDEServer::GuessTextFormat(const CBuffer& buffer)
 	if ((size % 2) != 0)
 		return CF_TEXT;
 
-	const byte* begin = static_cast<const byte*>(buffer.Buffer());
+	const byte* begin = static_cast<const byte*>(data);
 	const byte* end   = begin + size;
 
 	ASSERT(begin != end);
@@ -938,7 +1211,14 @@ HDDEDATA CDDEServer::DDECallbackProcImpl(UINT uType, UINT uFormat, HCONV hConv,
 		case XTYP_EXECUTE:
 		{
 			CDDEData oData(g_pDDEServer, hData, CF_NONE, true);
-			uint     nFormat = GuessTextFormat(oData.GetBuffer());
+			uint     nFormat = CF_TEXT;
+
+			// Inspect the command without copying it.
+			{
+				CDDEData::CView oView(oData);
+
+				nFormat = GuessTextFormat(oView.Data(), oView.Size());
+			}
 
 			hResult = DDE_FNOTPROCESSED;
 
@@ -19,6 +19,8 @@
 #include "DDEFwd.hpp"
 #include "IDDEServer.hpp"
 #include "DDEInst.hpp"
+#include "DDEAdviseScheduler.hpp"
+#include "DDEConvIndex.hpp"
 #include <vector>
 
 // Forward declarations.
@@ -26,6 +28,7 @@ class CBuffer;
 
 // Template shorthands.
 typedef std::vector<CDDESvrConv*> CDDESvrConvs;
+typedef std::vector<const CDDELink*> CDDELinkUpdates;
 
 /******************************************************************************
 **
@@ -63,16 +66,34 @@ public:
 	size_t       GetNumConversations() const;
 	size_t       GetAllConversations(CDDESvrConvs& aoConvs) const;
 
+	//
+	// Link methods.
+	//
+	size_t PostLinkUpdates(const CDDELinkUpdates& aoLinks);
+
 	//
 	// Event listener methods.
 	//
 	void AddListener(IDDEServerListener* pListener);
 	void RemoveListener(IDDEServerListener* pListener);
 
+	//
+	// Advise scheduling methods.
+	//
+	void                    SetAdviseInterval(DWORD dwInterval);
+	void                    SetAdviseInterval(const tchar* pszTopic, DWORD dwInterval);
+	void                    SetAdviseInterval(const CDDELink* pLink, DWORD dwInterval);
+	bool                    ScheduleLinkUpdate(const CDDELink* pLink);
+	size_t                  PostPendingUpdates();
+	size_t                  GetNumPendingUpdates() const;
+	const DDE::AdviseStats& GetAdviseStats() const;
+	void                    ResetAdviseStats();
+
 	//
 	// Utility methods (initially public for testing)
 	//
 	static uint GuessTextFormat(const CBuffer& buffer);
+	static uint GuessTextFormat(const void* data, size_t size);
 
 protected:
 	// Template shorthands.
@@ -81,8 +102,11 @@ protected:
 	//
 	// Members.
 	//
-	CDDESvrConvs	m_aoConvs;		// The list of conversations.
-	CListeners		m_aoListeners;	// The list of event listeners.
+	CDDESvrConvs			m_aoConvs;		// The list of conversations.
+	DDE::ConvIndex			m_oConvIndex;	// The conversations by handle and name.
+	CListeners				m_aoListeners;	// The list of event listeners.
+	DDE::AdviseScheduler	m_oScheduler;	// The advise update scheduler.
+	CDDELinkUpdates			m_aoDueLinks;	// The links due an update.
 
 	//
 	// Initialisation methods.
@@ -90,6 +114,17 @@ protected:
 	void Initialise(DWORD dwFlags);
 	void Uninitialise();
 
+	//
+	// Internal methods.
+	//
+	void RemoveConversation(CDDESvrConv* pConv);
+
+	//
+	// Advise scheduling methods.
+	//
+	bool PostScheduledUpdate(const CDDELink* pLink);
+	void UnscheduleLinks(const CDDESvrConv* pConv);
+
 	//
 	// DDECallback handlers.
 	//
@@ -141,4 +176,19 @@ inline size_t CDDEServer::GetAllConversations(CDDESvrConvs& aoConvs) const
 	return aoConvs.size();
 }
 
+inline size_t CDDEServer::GetNumPendingUpdates() const
+{
+	return m_oScheduler.PendingCount();
+}
+
+inline const DDE::AdviseStats& CDDEServer::GetAdviseStats() const
+{
+	return m_oScheduler.Stats();
+}
+
+inline void CDDEServer::ResetAdviseStats()
+{
+	m_oScheduler.ResetStats();
+}
+
 #endif // DDESERVER_HPP
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDESimd.hpp
+//! \brief  The SSE2 support shared by the DDE text kernels.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDESIMD_HPP
+#define NCL_DDESIMD_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <wchar.h>
+
+// The block kernels need the SSE2 intrinsics, which VC++ provides for any x86
+// target and GCC only when the target has SSE2 enabled.
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || defined(__SSE2__)
+#define NCL_DDE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// The UTF-16 block kernels also assume a 16-bit wchar_t.
+#if defined(NCL_DDE_SSE2) && (WCHAR_MAX == 0xFFFF)
+#define NCL_DDE_WIDE_SSE2
+#endif
+
+#ifdef NCL_DDE_SSE2
+
+namespace DDE
+{
+
+//! The number of bytes in an SSE2 block.
+const size_t SSE2_BLOCK_SIZE = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the processor supports the SSE2 instructions. The intrinsics can
+//! be compiled for any x86 target but only executed if it does.
+
+inline bool hasSSE2()
+{
+	static const bool supported = (::IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != FALSE);
+
+	return supported;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the position of the lowest bit set in a non-zero block mask.
+
+inline size_t lowestBitSet(int mask)
+{
+	ASSERT(mask != 0);
+
+#if defined(_MSC_VER)
+	unsigned long position = 0;
+
+	_BitScanForward(&position, static_cast<unsigned long>(mask));
+
+	return position;
+#elif defined(__GNUC__)
+	return __builtin_ctz(static_cast<unsigned int>(mask));
+#else
+	size_t position = 0;
+
+	while ((mask & 1) == 0)
+	{
+		mask >>= 1;
+		++position;
+	}
+
+	return position;
+#endif
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDE_SSE2
+
+#endif // NCL_DDESIMD_HPP
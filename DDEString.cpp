@@ -16,44 +16,54 @@
 CDDEString::CDDEString(CDDEInst* pInst, const tchar* pszString, bool bOwn)
 	: m_pInst(pInst)
 	, m_hsz()
-	, m_bOwn(bOwn)
+	, m_psz()
 {
 	ASSERT(pInst     != nullptr);
 	ASSERT(pszString != nullptr);
 
-	// Create the string handle.
-	m_hsz = ::DdeCreateStringHandle(m_pInst->Handle(), pszString, CP_WIN_TCHAR);
+	// Share the instance's handle and value.
+	const DDE::StringTable::String& oString = m_pInst->Strings().Acquire(m_pInst->Handle(), pszString);
 
-	if (m_hsz == NULL)
-		throw CDDEException(CDDEException::E_STRING_FAILED, m_pInst->LastError());
+	m_hsz = oString.m_hsz;
+	m_psz = oString.m_text.c_str();
 
-	// Save original string.
-	tstrncpy(m_sz, pszString, MAX_LENGTH);
+	// Add a reference for the caller to give away?
+	if (!bOwn)
+	{
+		if (!DDE::ddeApi().KeepStringHandle(m_pInst->Handle(), m_hsz))
+		{
+			uint nError = m_pInst->LastError();
+
+			m_pInst->Strings().Release(m_pInst->Handle(), m_hsz);
 
-	m_sz[MAX_LENGTH] = '\0';
+			throw CDDEException(CDDEException::E_STRING_FAILED, nError);
+		}
+	}
 }
 
 CDDEString::CDDEString(CDDEInst* pInst, HSZ hsz, bool bOwn)
 	: m_pInst(pInst)
-	, m_hsz(hsz)
-	, m_bOwn(bOwn)
+	, m_hsz()
+	, m_psz()
 {
 	ASSERT(pInst != nullptr);
 
-	// Extract original string.
-	DWORD result = ::DdeQueryString(m_pInst->Handle(), m_hsz, m_sz, MAX_LENGTH+1, CP_WIN_TCHAR);
+	const DDE::StringTable::String& oString = m_pInst->Strings().Acquire(m_pInst->Handle(), hsz);
 
-	if (result == 0)
-		throw CDDEException(CDDEException::E_STRCOPY_FAILED, m_pInst->LastError());
-}
+	m_hsz = oString.m_hsz;
+	m_psz = oString.m_text.c_str();
 
-CDDEString::~CDDEString()
-{
-	// Free the string, if owned.
-	if (m_bOwn)
+	// The table holds its own reference.
+	if (bOwn)
 	{
-		BOOL okay = ::DdeFreeStringHandle(m_pInst->Handle(), m_hsz);
+		BOOL okay = DDE::ddeApi().FreeStringHandle(m_pInst->Handle(), hsz);
 
 		ASSERT_RESULT(okay, okay != FALSE);
 	}
 }
+
+CDDEString::~CDDEString()
+{
+	// Release the shared handle.
+	m_pInst->Strings().Release(m_pInst->Handle(), m_hsz);
+}
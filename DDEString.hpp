@@ -30,7 +30,10 @@
 
 /******************************************************************************
 **
-** This is a helper class for dealing with DDE string handles.
+** This is a helper class for dealing with DDE string handles. Handles are
+** interned in the instance's string table so that the same name reuses the
+** same handle for as long as it is referenced. A string that is not owned
+** adds a usage count to the handle for the caller to give away to DDEML.
 **
 *******************************************************************************
 */
@@ -52,16 +55,12 @@ public:
 	operator const tchar*() const;
 
 protected:
-	// Max length of string (as per DDE documentation).
-	enum { MAX_LENGTH = 255 };
-
 	//
 	// Members.
 	//
-	CDDEInst*	m_pInst;				// The instance handle.
-	HSZ			m_hsz;					// The string handle.
-	bool		m_bOwn;					// Ownership flag.
-	tchar		m_sz[MAX_LENGTH+1];		// Original string.
+	CDDEInst*		m_pInst;		// The instance handle.
+	HSZ				m_hsz;			// The string handle.
+	const tchar*	m_psz;			// The string value.
 
 	// Disallow copies.
 	CDDEString(const CDDEString&);
@@ -82,7 +81,7 @@ inline CDDEString::operator HSZ() const
 
 inline CDDEString::operator const tchar*() const
 {
-	return m_sz;
+	return m_psz;
 }
 
 #endif // DDESTRING_HPP
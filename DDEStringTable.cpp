@@ -0,0 +1,213 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEStringTable.cpp
+//! \brief  The StringTable class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEStringTable.hpp"
+#include "DDEApi.hpp"
+#include "DDEString.hpp"
+#include "DDEException.hpp"
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare two names without regard to case.
+
+bool StringTable::NoCaseLess::operator()(const tstring& lhs, const tstring& rhs) const
+{
+	return (tstricmp(lhs.c_str(), rhs.c_str()) < 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+StringTable::StringTable()
+	: m_names()
+	, m_handles()
+	, m_idle(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. The handles are freed by DDEML when the instance is
+//! uninitialised.
+
+StringTable::~StringTable()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Acquire a reference to the string for a name, creating the handle if the
+//! name has not been interned.
+
+const StringTable::String& StringTable::Acquire(DWORD inst, const tchar* text)
+{
+	ASSERT(text != nullptr);
+
+	const tstring   name(text);
+	Names::iterator it = m_names.find(name);
+
+	if (it != m_names.end())
+		return AddRef(it->second);
+
+	HSZ hsz = ddeApi().CreateStringHandle(inst, text, CP_WIN_TCHAR);
+
+	if (hsz == NULL)
+		throw CDDEException(CDDEException::E_STRING_FAILED, ddeApi().GetLastError(inst));
+
+	return Insert(hsz, name);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Acquire a reference to the string for a handle, such as one passed to the
+//! DDE callback. If the handle has not been interned its value is queried and
+//! the handle kept, so that it outlives the callback.
+
+const StringTable::String& StringTable::Acquire(DWORD inst, HSZ hsz)
+{
+	ASSERT(hsz != NULL);
+
+	Handles::iterator it = m_handles.find(hsz);
+
+	if (it != m_handles.end())
+		return AddRef(it->second->second);
+
+	// Extract the value.
+	const DWORD length = ddeApi().QueryString(inst, hsz, nullptr, 0, CP_WIN_TCHAR);
+
+	if (length == 0)
+		throw CDDEException(CDDEException::E_STRCOPY_FAILED, ddeApi().GetLastError(inst));
+
+	std::vector<tchar> buffer(length+1);
+
+	if (ddeApi().QueryString(inst, hsz, &buffer[0], length+1, CP_WIN_TCHAR) == 0)
+		throw CDDEException(CDDEException::E_STRCOPY_FAILED, ddeApi().GetLastError(inst));
+
+	const tstring   name(&buffer[0], length);
+	Names::iterator existing = m_names.find(name);
+
+	// Already interned under another handle?
+	if (existing != m_names.end())
+		return AddRef(existing->second);
+
+	if (!ddeApi().KeepStringHandle(inst, hsz))
+		throw CDDEException(CDDEException::E_STRING_FAILED, ddeApi().GetLastError(inst));
+
+	return Insert(hsz, name);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the handle for a name without acquiring a reference to it. Returns
+//! NULL if the name has not been interned.
+
+HSZ StringTable::Find(const tchar* text) const
+{
+	ASSERT(text != nullptr);
+
+	Names::const_iterator it = m_names.find(text);
+
+	if (it == m_names.end())
+		return NULL;
+
+	return it->second.m_hsz;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release a reference to an interned string. Unknown handles are ignored as
+//! the table may have been reset. The unreferenced strings are purged once
+//! they outnumber both the idle limit and the referenced strings, so that the
+//! cost of scanning the table is spread across the releases.
+
+void StringTable::Release(DWORD inst, HSZ hsz)
+{
+	Handles::iterator it = m_handles.find(hsz);
+
+	if (it == m_handles.end())
+		return;
+
+	String& string = it->second->second;
+
+	ASSERT(string.m_refs != 0);
+
+	if (--string.m_refs == 0)
+	{
+		const size_t inUse = m_names.size() - ++m_idle;
+		const size_t limit = (inUse > MAX_IDLE) ? inUse : MAX_IDLE;
+
+		if (m_idle > limit)
+			Purge(inst);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free the strings that are no longer referenced.
+
+void StringTable::Purge(DWORD inst)
+{
+	Names::iterator it = m_names.begin();
+
+	while (it != m_names.end())
+	{
+		Names::iterator next = it;
+		++next;
+
+		if (it->second.m_refs == 0)
+		{
+			BOOL okay = ddeApi().FreeStringHandle(inst, it->second.m_hsz);
+
+			ASSERT_RESULT(okay, okay != FALSE);
+
+			m_handles.erase(it->second.m_hsz);
+			m_names.erase(it);
+		}
+
+		it = next;
+	}
+
+	m_idle = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Forget all strings without freeing the handles. This is used once the
+//! instance has been uninitialised, as DDEML will have freed them.
+
+void StringTable::Reset()
+{
+	m_names.clear();
+	m_handles.clear();
+	m_idle = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a reference to an interned string.
+
+const StringTable::String& StringTable::AddRef(String& string)
+{
+	if (string.m_refs++ == 0)
+	{
+		ASSERT(m_idle != 0);
+		--m_idle;
+	}
+
+	return string;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a new string to the table, with a single reference.
+
+const StringTable::String& StringTable::Insert(HSZ hsz, const tstring& text)
+{
+	String string = { hsz, text, 1 };
+
+	Names::iterator it = m_names.insert(std::make_pair(text, string)).first;
+
+	m_handles[hsz] = it;
+
+	return it->second;
+}
+
+//namespace DDE
+}
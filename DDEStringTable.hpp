@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEStringTable.hpp
+//! \brief  The StringTable class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDESTRINGTABLE_HPP
+#define NCL_DDESTRINGTABLE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <map>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The interned DDE string handles for a DDE instance. Each name maps to a
+//! single long-lived handle which is reference counted, so that the service,
+//! topic and item names in use are only created once. Names are matched
+//! without regard to case, as with DDEML. Strings no longer referenced are
+//! kept for reuse until the number of them exceeds a limit.
+
+class StringTable
+{
+public:
+	//! An interned string.
+	struct String
+	{
+		HSZ		m_hsz;		//!< The string handle.
+		tstring	m_text;		//!< The string value.
+		size_t	m_refs;		//!< The reference count.
+	};
+
+	//! The minimum number of unreferenced strings kept before purging.
+	static const size_t MAX_IDLE = 64;
+
+public:
+	//! Default constructor.
+	StringTable();
+
+	//! Destructor.
+	~StringTable();
+
+	//
+	// Properties.
+	//
+
+	//! The number of strings interned.
+	size_t Size() const;
+
+	//! The number of strings interned but no longer referenced.
+	size_t IdleCount() const;
+
+	//
+	// Methods.
+	//
+
+	//! Acquire a reference to the string for a name.
+	const String& Acquire(DWORD inst, const tchar* text);
+
+	//! Acquire a reference to the string for a handle.
+	const String& Acquire(DWORD inst, HSZ hsz);
+
+	//! Find the handle for a name, if it has been interned.
+	HSZ Find(const tchar* text) const;
+
+	//! Release a reference to an interned string.
+	void Release(DWORD inst, HSZ hsz);
+
+	//! Free the strings that are no longer referenced.
+	void Purge(DWORD inst);
+
+	//! Forget all strings, as the instance has been uninitialised.
+	void Reset();
+
+private:
+	//! Case-insensitive ordering for the names.
+	struct NoCaseLess
+	{
+		bool operator()(const tstring& lhs, const tstring& rhs) const;
+	};
+
+	//! The strings keyed by name.
+	typedef std::map<tstring, String, NoCaseLess> Names;
+	//! The strings keyed by handle.
+	typedef std::map<HSZ, Names::iterator> Handles;
+
+	//
+	// Members.
+	//
+	Names	m_names;	//!< The strings by name.
+	Handles	m_handles;	//!< The strings by handle.
+	size_t	m_idle;		//!< The number of unreferenced strings.
+
+	//
+	// Internal methods.
+	//
+
+	//! Add a reference to an interned string.
+	const String& AddRef(String& string);
+
+	//! Add a new string to the table.
+	const String& Insert(HSZ hsz, const tstring& text);
+
+	// NotCopyable.
+	StringTable(const StringTable&);
+	StringTable& operator=(const StringTable&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of strings interned.
+
+inline size_t StringTable::Size() const
+{
+	return m_names.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of strings interned but no longer referenced.
+
+inline size_t StringTable::IdleCount() const
+{
+	return m_idle;
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDESTRINGTABLE_HPP
@@ -13,7 +13,6 @@
 #include "DDEString.hpp"
 #include "DDELink.hpp"
 #include "DDEInst.hpp"
-#include <algorithm>
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -30,6 +29,7 @@
 CDDESvrConv::CDDESvrConv(CDDEInst* pInst, HCONV hConv, const tchar* pszService, const tchar* pszTopic)
 	: CDDEConv(pInst, hConv, pszService, pszTopic)
 	, m_aoLinks()
+	, m_oLinkIndex()
 {
 }
 
@@ -65,9 +65,10 @@ CDDESvrConv::~CDDESvrConv()
 
 CDDELink* CDDESvrConv::CreateLink(const tchar* pszItem, uint nFormat)
 {
-	CDDELink* pLink = new CDDELink(this, pszItem, nFormat);
+	CDDELink* pLink = new(m_pInst->LinkPool()) CDDELink(m_pInst, this, pszItem, nFormat);
 
-	m_aoLinks.push_back(pLink);
+	m_aoLinks.Add(pLink);
+	m_oLinkIndex.Insert(pszItem, nFormat, pLink);
 
 	return pLink;
 }
@@ -86,9 +87,8 @@ CDDELink* CDDESvrConv::CreateLink(const tchar* pszItem, uint nFormat)
 
 void CDDESvrConv::DestroyLink(CDDELink* pLink)
 {
-	ASSERT(std::find(m_aoLinks.begin(), m_aoLinks.end(), pLink) != m_aoLinks.end());
-
-	m_aoLinks.erase(std::find(m_aoLinks.begin(), m_aoLinks.end(), pLink));
+	m_oLinkIndex.Erase(pLink->Item(), pLink->Format());
+	m_aoLinks.Remove(pLink);
 	delete pLink;
 }
 
@@ -106,16 +106,22 @@ void CDDESvrConv::DestroyLink(CDDELink* pLink)
 
 void CDDESvrConv::DestroyAllLinks()
 {
-	for (size_t i = 0, n = m_aoLinks.size(); i != n; ++i)
-		delete m_aoLinks[i];
+	m_oLinkIndex.Clear();
+
+	// Remove from the back, so no links are moved.
+	while (m_aoLinks.Size() != 0)
+	{
+		CDDELink* pLink = m_aoLinks[m_aoLinks.Size()-1];
 
-	m_aoLinks.clear();
+		m_aoLinks.Remove(pLink);
+		delete pLink;
+	}
 }
 
 /******************************************************************************
 ** Method:		FindLink()
 **
-** Description:	Finds an existing link.
+** Description:	Finds an existing link. The item name is not case-sensitive.
 **
 ** Parameters:	pszItem		The item to link to.
 **				nFormat		The item data format.
@@ -129,16 +135,7 @@ CDDELink* CDDESvrConv::FindLink(const tchar* pszItem, uint nFormat) const
 {
 	ASSERT(pszItem != nullptr);
 
-	// Search the links list.
-	for (size_t i = 0, n = m_aoLinks.size(); i != n; ++i)
-	{
-		CDDELink* pLink = m_aoLinks[i];
-
-		if ( (pLink->Item() == pszItem) && (pLink->Format() == nFormat) )
-			return pLink;
-	}
-
-	return nullptr;
+	return m_oLinkIndex.Find(pszItem, nFormat);
 }
 
 /******************************************************************************
@@ -156,8 +153,5 @@ CDDELink* CDDESvrConv::FindLink(const tchar* pszItem, uint nFormat) const
 
 bool CDDESvrConv::PostLinkUpdate(const CDDELink* pLink)
 {
-	CDDEString strTopic(m_pInst, m_strTopic);
-	CDDEString strItem(m_pInst, pLink->Item());
-
-	return (::DdePostAdvise(m_pInst->Handle(), strTopic, strItem) != 0);
+	return (DDE::ddeApi().PostAdvise(m_pInst->Handle(), m_oTopic, pLink->ItemHandle()) != 0);
 }
@@ -18,6 +18,8 @@
 
 #include "DDEFwd.hpp"
 #include "DDEConv.hpp"
+#include "DDELinkIndex.hpp"
+#include "DDELinkList.hpp"
 #include <vector>
 
 // Template shorthands.
@@ -46,7 +48,8 @@ protected:
 	//
 	// Members.
 	//
-	CDDESvrLinks	m_aoLinks;		// The list of links.
+	DDE::LinkList	m_aoLinks;		// The list of links.
+	DDE::LinkIndex	m_oLinkIndex;	//!< The links by item and format.
 
 	//
 	// Constructors/Destructor.
@@ -76,7 +79,7 @@ protected:
 
 inline size_t CDDESvrConv::NumLinks() const
 {
-	return m_aoLinks.size();
+	return m_aoLinks.Size();
 }
 
 inline CDDELink* CDDESvrConv::GetLink(size_t nIndex) const
@@ -86,7 +89,7 @@ inline CDDELink* CDDESvrConv::GetLink(size_t nIndex) const
 
 inline size_t CDDESvrConv::GetAllLinks(CDDESvrLinks& aoLinks) const
 {
-	aoLinks = m_aoLinks;
+	aoLinks = m_aoLinks.Items();
 
 	return aoLinks.size();
 }
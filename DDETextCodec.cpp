@@ -0,0 +1,353 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETextCodec.cpp
+//! \brief  The DDE text transcoding functions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDETextCodec.hpp"
+#include "DDESimd.hpp"
+#include <Core/AnsiWide.hpp>
+
+namespace DDE
+{
+
+namespace
+{
+
+//! The code point used for an invalid sequence.
+const uint REPLACEMENT_CHAR = 0xFFFD;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy the leading run of ASCII characters from an 8-bit string to a UTF-16
+//! buffer, returning the length of the run.
+
+size_t widenAscii(const char* text, size_t length, wchar_t* buffer)
+{
+	size_t i = 0;
+
+#ifdef NCL_DDE_WIDE_SSE2
+	if (hasSSE2())
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; (length - i) >= SSE2_BLOCK_SIZE; i += SSE2_BLOCK_SIZE)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+
+			// Any character with the top bit set?
+			if (_mm_movemask_epi8(block) != 0)
+				break;
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i),     _mm_unpacklo_epi8(block, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i + 8), _mm_unpackhi_epi8(block, zero));
+		}
+	}
+#endif
+
+	for (; (i != length) && (static_cast<byte>(text[i]) < 0x80); ++i)
+		buffer[i] = static_cast<wchar_t>(text[i]);
+
+	return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy the leading run of ASCII characters from a UTF-16 string to an 8-bit
+//! buffer, returning the length of the run.
+
+size_t narrowAscii(const wchar_t* text, size_t length, char* buffer)
+{
+	size_t i = 0;
+
+#ifdef NCL_DDE_WIDE_SSE2
+	if (hasSSE2())
+	{
+		const __m128i zero     = _mm_setzero_si128();
+		const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+
+		for (; (length - i) >= SSE2_BLOCK_SIZE; i += SSE2_BLOCK_SIZE)
+		{
+			const __m128i first  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 8));
+			const __m128i high   = _mm_and_si128(_mm_or_si128(first, second), nonAscii);
+
+			// Any character above 0x7F?
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF)
+				break;
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), _mm_packus_epi16(first, second));
+		}
+	}
+#endif
+
+	for (; (i != length) && (static_cast<uint>(text[i]) < 0x80); ++i)
+		buffer[i] = static_cast<char>(text[i]);
+
+	return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode a single non-ASCII UTF-8 sequence into UTF-16. An invalid sequence
+//! is replaced by U+FFFD and consumes only the bytes that were valid so far.
+
+void decodeUtf8(const char* text, size_t length, size_t& in, wchar_t* buffer, size_t& out)
+{
+	const uint lead = static_cast<byte>(text[in++]);
+
+	size_t trailing = 0;
+	uint   code     = 0;
+	uint   lower    = 0x80;
+	uint   upper    = 0xBF;
+
+	// Decode the lead byte, restricting the first trailing byte to exclude
+	// overlong forms, surrogates and code points above U+10FFFF.
+	if ((lead >= 0xC2) && (lead <= 0xDF))
+	{
+		trailing = 1;
+		code     = lead & 0x1F;
+	}
+	else if ((lead >= 0xE0) && (lead <= 0xEF))
+	{
+		trailing = 2;
+		code     = lead & 0x0F;
+
+		if (lead == 0xE0)
+			lower = 0xA0;
+		else if (lead == 0xED)
+			upper = 0x9F;
+	}
+	else if ((lead >= 0xF0) && (lead <= 0xF4))
+	{
+		trailing = 3;
+		code     = lead & 0x07;
+
+		if (lead == 0xF0)
+			lower = 0x90;
+		else if (lead == 0xF4)
+			upper = 0x8F;
+	}
+	else
+	{
+		buffer[out++] = static_cast<wchar_t>(REPLACEMENT_CHAR);
+		return;
+	}
+
+	for (; (trailing != 0) && (in != length); --trailing, ++in)
+	{
+		const uint value = static_cast<byte>(text[in]);
+
+		if ((value < lower) || (value > upper))
+			break;
+
+		code  = (code << 6) | (value & 0x3F);
+		lower = 0x80;
+		upper = 0xBF;
+	}
+
+	if (trailing != 0)
+	{
+		buffer[out++] = static_cast<wchar_t>(REPLACEMENT_CHAR);
+	}
+	else if (code >= 0x10000)
+	{
+		code -= 0x10000;
+
+		buffer[out++] = static_cast<wchar_t>(0xD800 + (code >> 10));
+		buffer[out++] = static_cast<wchar_t>(0xDC00 + (code & 0x3FF));
+	}
+	else
+	{
+		buffer[out++] = static_cast<wchar_t>(code);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode a single non-ASCII UTF-16 character as UTF-8. An unpaired surrogate
+//! is replaced by U+FFFD.
+
+void encodeUtf8(const wchar_t* text, size_t length, size_t& in, char* buffer, size_t& out)
+{
+	uint code = static_cast<uint>(text[in++]);
+
+	if ((code >= 0xD800) && (code <= 0xDBFF) && (in != length)
+	 && (static_cast<uint>(text[in]) >= 0xDC00) && (static_cast<uint>(text[in]) <= 0xDFFF))
+	{
+		code = 0x10000 + ((code - 0xD800) << 10) + (static_cast<uint>(text[in++]) - 0xDC00);
+	}
+	else if ( ((code >= 0xD800) && (code <= 0xDFFF)) || (code > 0xFFFF) )
+	{
+		code = REPLACEMENT_CHAR;
+	}
+
+	if (code < 0x800)
+	{
+		buffer[out++] = static_cast<char>(0xC0 | (code >> 6));
+	}
+	else if (code < 0x10000)
+	{
+		buffer[out++] = static_cast<char>(0xE0 | (code >> 12));
+		buffer[out++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+	}
+	else
+	{
+		buffer[out++] = static_cast<char>(0xF0 | (code >> 18));
+		buffer[out++] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+		buffer[out++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+	}
+
+	buffer[out++] = static_cast<char>(0x80 | (code & 0x3F));
+}
+
+//namespace
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count the leading ASCII characters in an ANSI or UTF-8 string.
+
+size_t asciiLength(const char* text, size_t length)
+{
+	ASSERT((text != nullptr) || (length == 0));
+
+	size_t i = 0;
+
+#ifdef NCL_DDE_SSE2
+	if (hasSSE2())
+	{
+		for (; (length - i) >= SSE2_BLOCK_SIZE; i += SSE2_BLOCK_SIZE)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			const int     mask  = _mm_movemask_epi8(block);
+
+			if (mask != 0)
+				return i + lowestBitSet(mask);
+		}
+	}
+#endif
+
+	while ((i != length) && (static_cast<byte>(text[i]) < 0x80))
+		++i;
+
+	return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count the leading ASCII characters in a UTF-16 string.
+
+size_t asciiLength(const wchar_t* text, size_t length)
+{
+	ASSERT((text != nullptr) || (length == 0));
+
+	size_t i = 0;
+
+#ifdef NCL_DDE_WIDE_SSE2
+	if (hasSSE2())
+	{
+		const __m128i zero     = _mm_setzero_si128();
+		const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+
+		for (; (length - i) >= (SSE2_BLOCK_SIZE / 2); i += (SSE2_BLOCK_SIZE / 2))
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			const int     mask  = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(block, nonAscii), zero));
+
+			// Two mask bits per character.
+			if (mask != 0xFFFF)
+				return i + (lowestBitSet(~mask & 0xFFFF) / 2);
+		}
+	}
+#endif
+
+	while ((i != length) && (static_cast<uint>(text[i]) < 0x80))
+		++i;
+
+	return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert an ANSI string to UTF-16. The ASCII prefix is widened directly and
+//! the remainder, which may contain multi-byte characters, is converted by the
+//! Core library as before.
+
+void ansiToUtf16(const char* text, size_t length, wchar_t* buffer)
+{
+	ASSERT((text != nullptr) || (length == 0));
+	ASSERT((buffer != nullptr) || (length == 0));
+
+	const size_t ascii = widenAscii(text, length, buffer);
+
+	if (ascii != length)
+		Core::ansiToWide(text + ascii, text + length, buffer + ascii);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a UTF-16 string to ANSI. The ASCII prefix is narrowed directly and
+//! the remainder is converted by the Core library as before.
+
+void utf16ToAnsi(const wchar_t* text, size_t length, char* buffer)
+{
+	ASSERT((text != nullptr) || (length == 0));
+	ASSERT((buffer != nullptr) || (length == 0));
+
+	const size_t ascii = narrowAscii(text, length, buffer);
+
+	if (ascii != length)
+		Core::wideToAnsi(text + ascii, text + length, buffer + ascii);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a UTF-8 string to UTF-16, returning the number of code units
+//! written. As UTF-8 is self-synchronising the block kernel resumes after
+//! each non-ASCII character.
+
+size_t utf8ToUtf16(const char* text, size_t length, wchar_t* buffer)
+{
+	ASSERT((text != nullptr) || (length == 0));
+	ASSERT((buffer != nullptr) || (length == 0));
+
+	size_t in  = 0;
+	size_t out = 0;
+
+	for (;;)
+	{
+		const size_t ascii = widenAscii(text + in, length - in, buffer + out);
+
+		in  += ascii;
+		out += ascii;
+
+		if (in == length)
+			break;
+
+		decodeUtf8(text, length, in, buffer, out);
+	}
+
+	return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a UTF-16 string to UTF-8, returning the number of bytes written.
+
+size_t utf16ToUtf8(const wchar_t* text, size_t length, char* buffer)
+{
+	ASSERT((text != nullptr) || (length == 0));
+	ASSERT((buffer != nullptr) || (length == 0));
+
+	size_t in  = 0;
+	size_t out = 0;
+
+	for (;;)
+	{
+		const size_t ascii = narrowAscii(text + in, length - in, buffer + out);
+
+		in  += ascii;
+		out += ascii;
+
+		if (in == length)
+			break;
+
+		encodeUtf8(text, length, in, buffer, out);
+	}
+
+	return out;
+}
+
+//namespace DDE
+}
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETextCodec.hpp
+//! \brief  The DDE text transcoding functions.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDETEXTCODEC_HPP
+#define NCL_DDETEXTCODEC_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+namespace DDE
+{
+
+//! The most UTF-8 bytes written for a single UTF-16 code unit.
+const size_t MAX_UTF8_PER_UTF16 = 3;
+
+////////////////////////////////////////////////////////////////////////////////
+// Conversions between the CF_TEXT, CF_UNICODETEXT and UTF-8 representations
+// of a DDE text payload. They convert a counted string, which may include the
+// null terminator, and write straight into a caller supplied buffer. Runs of
+// ASCII characters, the common case for DDE values, are converted a block at
+// a time with SSE2 where the processor supports it.
+
+//! Count the leading ASCII characters in an ANSI or UTF-8 string.
+size_t asciiLength(const char* text, size_t length);
+
+//! Count the leading ASCII characters in a UTF-16 string.
+size_t asciiLength(const wchar_t* text, size_t length);
+
+//! Convert an ANSI string to UTF-16. The buffer must hold length characters.
+void ansiToUtf16(const char* text, size_t length, wchar_t* buffer);
+
+//! Convert a UTF-16 string to ANSI. The buffer must hold length characters.
+void utf16ToAnsi(const wchar_t* text, size_t length, char* buffer);
+
+//! Convert a UTF-8 string to UTF-16, returning the number of code units
+//! written. The buffer must hold length code units.
+size_t utf8ToUtf16(const char* text, size_t length, wchar_t* buffer);
+
+//! Convert a UTF-16 string to UTF-8, returning the number of bytes written.
+//! The buffer must hold length * MAX_UTF8_PER_UTF16 bytes.
+size_t utf16ToUtf8(const wchar_t* text, size_t length, char* buffer);
+
+//namespace DDE
+}
+
+#endif // NCL_DDETEXTCODEC_HPP
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETextTable.cpp
+//! \brief  The TextTable class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDETextTable.hpp"
+#include "DDETextCodec.hpp"
+#include "DDESimd.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor. The table is empty.
+
+TextTable::TextTable()
+	: m_text(nullptr)
+	, m_ends()
+	, m_rows(1, 0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct from the text in a DDE data view. The view must outlive the
+//! table.
+
+TextTable::TextTable(const CDDEData::CView& view)
+	: m_text(nullptr)
+	, m_ends()
+	, m_rows(1, 0)
+{
+	Parse(reinterpret_cast<const char*>(view.Data()), view.Size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct from a block of text. The text must outlive the table.
+
+TextTable::TextTable(const char* text, size_t length)
+	: m_text(nullptr)
+	, m_ends()
+	, m_rows(1, 0)
+{
+	Parse(text, length);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+TextTable::~TextTable()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The text of a cell.
+
+tstring TextTable::Cell(size_t row, size_t column) const
+{
+	const char*  text   = CellData(row, column);
+	const size_t length = CellLength(row, column);
+
+#ifdef ANSI_BUILD
+	return tstring(text, length);
+#else
+	tstring str(length, TXT('\0'));
+
+	if (length != 0)
+		DDE::ansiToUtf16(text, length, &str[0]);
+
+	return str;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Ensure there is room to record a number of row ends after the completed
+//! rows. The row starts are trimmed to size when parsing finishes.
+
+inline void TextTable::ReserveRows(size_t rows, size_t count)
+{
+	const size_t required = rows + 1 + count;
+
+	if (m_rows.size() < required)
+		m_rows.resize(std::max(required, m_rows.size() * 2));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record the delimiter after a cell, which also ends the row if it is a line
+//! end. The row end is always written but only kept for a line end, so that
+//! there is no branch on the type of delimiter.
+
+inline void TextTable::AddDelimiter(size_t position, size_t lineEnd, size_t& rows)
+{
+	ASSERT(m_rows.size() > (rows + 1));
+
+	m_ends.push_back(static_cast<uint>(position));
+
+	m_rows[rows+1] = m_ends.size();
+	rows += lineEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode a block of text, replacing the current table. Cells are separated by
+//! tabs and rows by LF or CR/LF. The text ends at the first null character or
+//! the end of the block, and a final empty row is ignored.
+
+void TextTable::Parse(const char* text, size_t length)
+{
+	ASSERT((text != nullptr) || (length == 0));
+	ASSERT(length <= UINT_MAX);
+
+	const size_t end  = (length != 0) ? strnlen(text, length) : 0;
+	size_t       rows = 0;
+	size_t       i    = 0;
+
+	m_text = text;
+	m_ends.clear();
+	m_rows.assign(1, 0);
+
+#ifdef NCL_DDE_SSE2
+	if (hasSSE2())
+	{
+		const __m128i tabs     = _mm_set1_epi8('\t');
+		const __m128i newlines = _mm_set1_epi8('\n');
+
+		for (; (end - i) >= SSE2_BLOCK_SIZE; i += SSE2_BLOCK_SIZE)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			const int     lines = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines));
+			const int     found = _mm_movemask_epi8(_mm_cmpeq_epi8(block, tabs)) | lines;
+
+			ReserveRows(rows, SSE2_BLOCK_SIZE);
+
+			// Visit each delimiter in the block.
+			for (int mask = found; mask != 0; mask &= (mask - 1))
+			{
+				const size_t bit = lowestBitSet(mask);
+
+				AddDelimiter(i + bit, (lines >> bit) & 1, rows);
+			}
+		}
+	}
+#endif
+
+	for (; i != end; ++i)
+	{
+		const char c = text[i];
+
+		if ((c == '\t') || (c == '\n'))
+		{
+			ReserveRows(rows, 1);
+			AddDelimiter(i, (c == '\n') ? 1 : 0, rows);
+		}
+	}
+
+	m_rows.resize(rows + 1);
+
+	const size_t next = (!m_ends.empty()) ? (m_ends.back() + 1) : 0;
+
+	// Finish any unterminated row.
+	if ( (next != end) || (m_ends.size() != m_rows.back()) )
+	{
+		m_ends.push_back(static_cast<uint>(end));
+		m_rows.push_back(m_ends.size());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a cell as a number. The whole cell must be a number, apart from any
+//! leading whitespace.
+
+bool TextTable::ParseNumber(size_t row, size_t column, double& value) const
+{
+	const size_t length = CellLength(row, column);
+
+	if (length == 0)
+		return false;
+
+	const std::string text(CellData(row, column), length);
+	char*             last = nullptr;
+
+	const double number = strtod(text.c_str(), &last);
+
+	if (last != (text.c_str() + length))
+		return false;
+
+	value = number;
+	return true;
+}
+
+//namespace DDE
+}
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETextTable.hpp
+//! \brief  The TextTable class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDETEXTTABLE_HPP
+#define NCL_DDETEXTTABLE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEData.hpp"
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A table of cells decoded from a tab and CR/LF delimited CF_TEXT value, as
+//! returned by Excel and other spreadsheet style servers. The table is an
+//! index of the cell offsets within the original text, which must outlive
+//! it, and cells are only converted when asked for.
+
+class TextTable
+{
+public:
+	//! Default constructor.
+	TextTable();
+
+	//! Construct from the text in a DDE data view.
+	explicit TextTable(const CDDEData::CView& view);
+
+	//! Construct from a block of text.
+	TextTable(const char* text, size_t length);
+
+	//! Destructor.
+	~TextTable();
+
+	//
+	// Properties.
+	//
+
+	//! The number of rows.
+	size_t Rows() const;
+
+	//! The number of cells in a row.
+	size_t Columns(size_t row) const;
+
+	//! The start of a cell's text.
+	const char* CellData(size_t row, size_t column) const;
+
+	//! The length of a cell's text.
+	size_t CellLength(size_t row, size_t column) const;
+
+	//! The text of a cell.
+	tstring Cell(size_t row, size_t column) const;
+
+	//
+	// Methods.
+	//
+
+	//! Decode a block of text, replacing the current table.
+	void Parse(const char* text, size_t length);
+
+	//! Parse a cell as a number.
+	bool ParseNumber(size_t row, size_t column, double& value) const;
+
+private:
+	//! The bounds of a cell as offsets into the text.
+	struct Span
+	{
+		size_t	m_begin;	//!< The offset of the first character.
+		size_t	m_end;		//!< The offset one past the last character.
+	};
+
+	//! The offset of the delimiter after each cell, in row order.
+	typedef std::vector<uint> Delimiters;
+	//! The index of each row's first cell.
+	typedef std::vector<size_t> RowStarts;
+
+	//
+	// Members.
+	//
+	const char*	m_text;		//!< The original text.
+	Delimiters	m_ends;		//!< The end of each cell.
+	RowStarts	m_rows;		//!< The row starts, with a final end marker.
+
+	//
+	// Internal methods.
+	//
+
+	//! Ensure there is room to record a number of row ends.
+	void ReserveRows(size_t rows, size_t count);
+
+	//! Record the delimiter after a cell, which may also end the row.
+	void AddDelimiter(size_t position, size_t lineEnd, size_t& rows);
+
+	//! Get the span of a cell.
+	Span GetSpan(size_t row, size_t column) const;
+
+	// NotCopyable.
+	TextTable(const TextTable&);
+	TextTable& operator=(const TextTable&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of rows.
+
+inline size_t TextTable::Rows() const
+{
+	return m_rows.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of cells in a row. Rows are not required to be the same length.
+
+inline size_t TextTable::Columns(size_t row) const
+{
+	ASSERT(row < Rows());
+
+	return m_rows[row+1] - m_rows[row];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the span of a cell. A cell starts after the previous cell's delimiter
+//! and the CR of a CR/LF is removed from the last cell in a row.
+
+inline TextTable::Span TextTable::GetSpan(size_t row, size_t column) const
+{
+	ASSERT(column < Columns(row));
+
+	const size_t cell = m_rows[row] + column;
+
+	Span span = { (cell != 0) ? (m_ends[cell-1] + 1) : 0, m_ends[cell] };
+
+	if ( ((cell+1) == m_rows[row+1]) && (span.m_end != span.m_begin) && (m_text[span.m_end-1] == '\r') )
+		--span.m_end;
+
+	return span;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The start of a cell's text, which is not null terminated.
+
+inline const char* TextTable::CellData(size_t row, size_t column) const
+{
+	return m_text + GetSpan(row, column).m_begin;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The length of a cell's text.
+
+inline size_t TextTable::CellLength(size_t row, size_t column) const
+{
+	const Span span = GetSpan(row, column);
+
+	return span.m_end - span.m_begin;
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDETEXTTABLE_HPP
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETransaction.hpp
+//! \brief  The types used to report the outcome of batched and asynchronous
+//!         DDE transactions.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDETRANSACTION_HPP
+#define NCL_DDETRANSACTION_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEData.hpp"
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The outcome of requesting one item in a batch.
+
+struct RequestResult
+{
+	//! Constructor.
+	RequestResult(const tchar* item, const CDDEData& data);
+
+	//
+	// Members.
+	//
+	tstring		m_item;		//!< The item requested.
+	CDDEData	m_data;		//!< The value, which is empty if the request failed.
+	uint		m_error;	//!< The DMLERR_ error code, or DMLERR_NO_ERROR.
+
+	//! Query if the request succeeded.
+	bool Succeeded() const;
+};
+
+//! The outcomes of a batch of requests.
+typedef std::vector<RequestResult> RequestResults;
+
+////////////////////////////////////////////////////////////////////////////////
+//! An asynchronous transaction started by a client conversation. The ID is the
+//! handle returned when the transaction is started, and the elapsed time and
+//! error are set when it completes.
+
+struct AsyncTransaction
+{
+	//! Constructor.
+	AsyncTransaction(DWORD id, uint type, const tchar* item, uint format);
+
+	//
+	// Members.
+	//
+	DWORD	m_id;		//!< The transaction ID.
+	uint	m_type;		//!< The XTYP_ transaction type.
+	tstring	m_item;		//!< The item, which is empty for an execute.
+	uint	m_format;	//!< The data format.
+	DWORD	m_started;	//!< The tick count when the transaction was started.
+	DWORD	m_elapsed;	//!< The time taken to complete (ms).
+	uint	m_error;	//!< The DMLERR_ error code, or DMLERR_NO_ERROR.
+
+	//! Query if the transaction succeeded.
+	bool Succeeded() const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline RequestResult::RequestResult(const tchar* item, const CDDEData& data)
+	: m_item(item)
+	, m_data(data)
+	, m_error(DMLERR_NO_ERROR)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the request succeeded.
+
+inline bool RequestResult::Succeeded() const
+{
+	return (m_error == DMLERR_NO_ERROR);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The transaction is timed from construction.
+
+inline AsyncTransaction::AsyncTransaction(DWORD id, uint type, const tchar* item, uint format)
+	: m_id(id)
+	, m_type(type)
+	, m_item(item)
+	, m_format(format)
+	, m_started(::GetTickCount())
+	, m_elapsed(0)
+	, m_error(DMLERR_NO_ERROR)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the transaction succeeded.
+
+inline bool AsyncTransaction::Succeeded() const
+{
+	return (m_error == DMLERR_NO_ERROR);
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDETRANSACTION_HPP
@@ -0,0 +1,528 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEXlTable.cpp
+//! \brief  The XlTable format encoder and decoder definitions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DDEXlTable.hpp"
+#include "DDEException.hpp"
+#include "DDETextCodec.hpp"
+#include <string.h>
+#include <algorithm>
+
+namespace DDE
+{
+
+//! The size of a record's type and size fields.
+static const size_t RECORD_HEADER_SIZE = 4;
+
+//! The largest record body.
+static const size_t MAX_RECORD_SIZE = 0xFFFF;
+
+//! The largest count of blank or skipped cells in a single record.
+static const size_t MAX_RUN_LENGTH = 0xFFFF;
+
+//! The amount of data buffered before it is written to the data handle.
+static const size_t FLUSH_SIZE = 64 * 1024;
+
+//! The record type used when no record is open.
+static const uint NO_RECORD = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a 16-bit value in little-endian byte order.
+
+static void writeWord(byte* buffer, WORD value)
+{
+	buffer[0] = static_cast<byte>(value);
+	buffer[1] = static_cast<byte>(value >> 8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a 16-bit value in little-endian byte order.
+
+static WORD readWord(const byte* buffer)
+{
+	return static_cast<WORD>(buffer[0] | (buffer[1] << 8));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Report malformed XlTable data.
+
+static void throwBadFormat()
+{
+	throw CDDEException(CDDEException::E_BAD_FORMAT, DMLERR_NO_ERROR);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the registered clipboard format for XlTable data.
+
+uint xlTableFormat()
+{
+	static const uint format = ::RegisterClipboardFormat(TXT("XlTable"));
+
+	ASSERT(format != 0);
+
+	return format;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The table record is written straight away.
+
+XlTableWriter::XlTableWriter(CDDEData& data, size_t rows, size_t columns)
+	: m_data(data)
+	, m_cells(rows * columns)
+	, m_written(0)
+	, m_buffer()
+	, m_offset(0)
+	, m_record(0)
+	, m_type(NO_RECORD)
+{
+	ASSERT(rows <= 0xFFFF);
+	ASSERT(columns <= 0xFFFF);
+	ASSERT(data.Format() == xlTableFormat());
+
+	byte dimensions[4];
+
+	writeWord(dimensions,   static_cast<WORD>(rows));
+	writeWord(dimensions+2, static_cast<WORD>(columns));
+
+	OpenRecord(TDT_TABLE, sizeof(dimensions));
+	Append(dimensions, sizeof(dimensions));
+
+	m_type = NO_RECORD;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any records not flushed by End() are discarded.
+
+XlTableWriter::~XlTableWriter()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a number cell.
+
+void XlTableWriter::WriteNumber(double value)
+{
+	ASSERT(m_written < m_cells);
+
+	OpenRecord(TDT_FLOAT, sizeof(value));
+	Append(&value, sizeof(value));
+
+	++m_written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write an integer cell.
+
+void XlTableWriter::WriteInteger(short value)
+{
+	ASSERT(m_written < m_cells);
+
+	byte encoded[2];
+
+	writeWord(encoded, static_cast<WORD>(value));
+
+	OpenRecord(TDT_INT, sizeof(encoded));
+	Append(encoded, sizeof(encoded));
+
+	++m_written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a boolean cell.
+
+void XlTableWriter::WriteBool(bool value)
+{
+	ASSERT(m_written < m_cells);
+
+	byte encoded[2];
+
+	writeWord(encoded, static_cast<WORD>(value ? 1 : 0));
+
+	OpenRecord(TDT_BOOL, sizeof(encoded));
+	Append(encoded, sizeof(encoded));
+
+	++m_written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write an error cell.
+
+void XlTableWriter::WriteError(WORD code)
+{
+	ASSERT(m_written < m_cells);
+
+	byte encoded[2];
+
+	writeWord(encoded, code);
+
+	OpenRecord(TDT_ERROR, sizeof(encoded));
+	Append(encoded, sizeof(encoded));
+
+	++m_written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a string cell. Text beyond MAX_XLTABLE_STRING characters is dropped.
+
+void XlTableWriter::WriteString(const tchar* value)
+{
+	ASSERT(value != nullptr);
+
+	const size_t length = std::min(tstrlen(value), MAX_XLTABLE_STRING);
+
+#ifdef ANSI_BUILD
+	WriteString(value, length);
+#else
+	char ansi[MAX_XLTABLE_STRING];
+
+	DDE::utf16ToAnsi(value, length, ansi);
+
+	WriteString(ansi, length);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a string cell from ANSI text. Text beyond MAX_XLTABLE_STRING
+//! characters is dropped.
+
+void XlTableWriter::WriteString(const char* value, size_t length)
+{
+	ASSERT((value != nullptr) || (length == 0));
+	ASSERT(m_written < m_cells);
+
+	const byte size = static_cast<byte>(std::min(length, MAX_XLTABLE_STRING));
+
+	OpenRecord(TDT_STRING, 1 + size);
+	Append(&size, sizeof(size));
+	Append(value, size);
+
+	++m_written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a number of blank cells.
+
+void XlTableWriter::WriteBlanks(size_t count)
+{
+	WriteRun(TDT_BLANK, count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a number of cells to leave unchanged.
+
+void XlTableWriter::WriteSkips(size_t count)
+{
+	WriteRun(TDT_SKIP, count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Flush the remaining records to the data handle. Every cell must have been
+//! written.
+
+void XlTableWriter::End()
+{
+	ASSERT(m_written == m_cells);
+
+	Flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Ensure there is an open record of a type with room for some bytes. A new
+//! record is started when the type changes or the open record is full, and
+//! the buffer is flushed first if it has filled up.
+
+void XlTableWriter::OpenRecord(uint type, size_t size)
+{
+	if (m_type == type)
+	{
+		const size_t used = m_buffer.size() - m_record - RECORD_HEADER_SIZE;
+
+		if ((used + size) <= MAX_RECORD_SIZE)
+			return;
+	}
+
+	if (m_buffer.size() >= FLUSH_SIZE)
+		Flush();
+
+	byte header[RECORD_HEADER_SIZE];
+
+	writeWord(header,   static_cast<WORD>(type));
+	writeWord(header+2, 0);
+
+	m_record = m_buffer.size();
+	m_type   = type;
+
+	m_buffer.insert(m_buffer.end(), header, header+RECORD_HEADER_SIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append bytes to the open record.
+
+void XlTableWriter::Append(const void* data, size_t size)
+{
+	ASSERT(m_type != NO_RECORD);
+
+	const byte* bytes = static_cast<const byte*>(data);
+
+	m_buffer.insert(m_buffer.end(), bytes, bytes+size);
+
+	const size_t used = m_buffer.size() - m_record - RECORD_HEADER_SIZE;
+
+	ASSERT(used <= MAX_RECORD_SIZE);
+
+	writeWord(&m_buffer[m_record+2], static_cast<WORD>(used));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a run of blank or skipped cells, extending the open record's count
+//! where possible.
+
+void XlTableWriter::WriteRun(uint type, size_t count)
+{
+	ASSERT((type == TDT_BLANK) || (type == TDT_SKIP));
+	ASSERT((m_written + count) <= m_cells);
+
+	while (count != 0)
+	{
+		if ( (m_type != type) || (readWord(&m_buffer[m_record+RECORD_HEADER_SIZE]) == MAX_RUN_LENGTH) )
+		{
+			byte empty[2] = { 0, 0 };
+
+			m_type = NO_RECORD;
+
+			OpenRecord(type, sizeof(empty));
+			Append(empty, sizeof(empty));
+		}
+
+		byte*        run    = &m_buffer[m_record+RECORD_HEADER_SIZE];
+		const size_t length = readWord(run);
+		const size_t added  = std::min(count, MAX_RUN_LENGTH - length);
+
+		writeWord(run, static_cast<WORD>(length + added));
+
+		m_written += added;
+		count     -= added;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the buffered records to the data handle. The open record is closed.
+
+void XlTableWriter::Flush()
+{
+	if (!m_buffer.empty())
+	{
+		m_data.SetData(&m_buffer[0], m_buffer.size(), m_offset);
+
+		m_offset += m_buffer.size();
+		m_buffer.clear();
+	}
+
+	m_type = NO_RECORD;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The text of a string cell.
+
+tstring XlTableReader::Cell::String() const
+{
+	ASSERT(m_type == TDT_STRING);
+
+#ifdef ANSI_BUILD
+	return tstring(m_text, m_length);
+#else
+	tstring str(m_length, TXT('\0'));
+
+	if (m_length != 0)
+		DDE::ansiToUtf16(m_text, m_length, &str[0]);
+
+	return str;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct from the contents of a DDE data view. The view must outlive the
+//! reader.
+
+XlTableReader::XlTableReader(const CDDEData::CView& view)
+	: m_next(nullptr)
+	, m_end(nullptr)
+	, m_recordEnd(nullptr)
+	, m_type(NO_RECORD)
+	, m_run(0)
+	, m_rows(0)
+	, m_columns(0)
+	, m_cell(0)
+{
+	Open(view.Data(), view.Size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct from a block of data. The data must outlive the reader.
+
+XlTableReader::XlTableReader(const void* data, size_t size)
+	: m_next(nullptr)
+	, m_end(nullptr)
+	, m_recordEnd(nullptr)
+	, m_type(NO_RECORD)
+	, m_run(0)
+	, m_rows(0)
+	, m_columns(0)
+	, m_cell(0)
+{
+	Open(static_cast<const byte*>(data), size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+XlTableReader::~XlTableReader()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the next cell, returning false after the last one. Any data after the
+//! last cell is ignored.
+
+bool XlTableReader::Next(Cell& cell)
+{
+	if (m_cell == (m_rows * m_columns))
+		return false;
+
+	// Skip to a record with a cell left.
+	while ((m_run == 0) && (m_next == m_recordEnd))
+		NextRecord();
+
+	cell.m_type    = static_cast<XlTableType>(m_type);
+	cell.m_row     = m_cell / m_columns;
+	cell.m_column  = m_cell % m_columns;
+	cell.m_number  = 0.0;
+	cell.m_integer = 0;
+	cell.m_text    = nullptr;
+	cell.m_length  = 0;
+
+	const size_t available = m_recordEnd - m_next;
+
+	switch (m_type)
+	{
+		case TDT_BLANK:
+		case TDT_SKIP:
+		{
+			--m_run;
+		}
+		break;
+
+		case TDT_FLOAT:
+		{
+			if (available < sizeof(cell.m_number))
+				throwBadFormat();
+
+			memcpy(&cell.m_number, m_next, sizeof(cell.m_number));
+			m_next += sizeof(cell.m_number);
+		}
+		break;
+
+		case TDT_STRING:
+		{
+			if ((available < 1) || ((available - 1) < m_next[0]))
+				throwBadFormat();
+
+			cell.m_length = m_next[0];
+			cell.m_text   = reinterpret_cast<const char*>(m_next + 1);
+			m_next += 1 + cell.m_length;
+		}
+		break;
+
+		case TDT_BOOL:
+		case TDT_ERROR:
+		case TDT_INT:
+		{
+			if (available < 2)
+				throwBadFormat();
+
+			const WORD value = readWord(m_next);
+
+			cell.m_integer = (m_type == TDT_INT) ? static_cast<short>(value) : value;
+			m_next += 2;
+		}
+		break;
+
+		// Validated by NextRecord().
+		default:
+			ASSERT_FALSE();
+			break;
+	}
+
+	++m_cell;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate the table record.
+
+void XlTableReader::Open(const byte* data, size_t size)
+{
+	ASSERT((data != nullptr) || (size == 0));
+
+	if ( (size < (RECORD_HEADER_SIZE + 4)) || (readWord(data) != TDT_TABLE) || (readWord(data+2) != 4) )
+		throwBadFormat();
+
+	m_rows      = readWord(data+4);
+	m_columns   = readWord(data+6);
+	m_next      = data + RECORD_HEADER_SIZE + 4;
+	m_end       = data + size;
+	m_recordEnd = m_next;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move to the next record, which must lie within the data.
+
+void XlTableReader::NextRecord()
+{
+	ASSERT(m_next == m_recordEnd);
+
+	if (static_cast<size_t>(m_end - m_next) < RECORD_HEADER_SIZE)
+		throwBadFormat();
+
+	const uint   type = readWord(m_next);
+	const size_t size = readWord(m_next+2);
+
+	m_next += RECORD_HEADER_SIZE;
+
+	if (static_cast<size_t>(m_end - m_next) < size)
+		throwBadFormat();
+
+	m_recordEnd = m_next + size;
+	m_type      = type;
+
+	switch (type)
+	{
+		case TDT_BLANK:
+		case TDT_SKIP:
+		{
+			if (size != 2)
+				throwBadFormat();
+
+			m_run  = readWord(m_next);
+			m_next = m_recordEnd;
+		}
+		break;
+
+		case TDT_FLOAT:
+		case TDT_STRING:
+		case TDT_BOOL:
+		case TDT_ERROR:
+		case TDT_INT:
+		break;
+
+		default:
+			throwBadFormat();
+			break;
+	}
+}
+
+//namespace DDE
+}
@@ -0,0 +1,233 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEXlTable.hpp
+//! \brief  The XlTable format encoder and decoder declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_DDEXLTABLE_HPP
+#define NCL_DDEXLTABLE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "DDEData.hpp"
+#include <vector>
+
+namespace DDE
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The XlTable record types. The cells of a table follow the table record in
+//! row order, with consecutive cells of the same type sharing a record.
+
+enum XlTableType
+{
+	TDT_FLOAT	= 0x0001,	//!< IEEE doubles.
+	TDT_STRING	= 0x0002,	//!< Length prefixed ANSI strings.
+	TDT_BOOL	= 0x0003,	//!< 16-bit booleans.
+	TDT_ERROR	= 0x0004,	//!< 16-bit Excel error codes.
+	TDT_BLANK	= 0x0005,	//!< A count of blank cells.
+	TDT_INT		= 0x0006,	//!< 16-bit integers.
+	TDT_SKIP	= 0x0007,	//!< A count of cells to leave unchanged.
+	TDT_TABLE	= 0x0010,	//!< The table dimensions.
+};
+
+//! The longest string a tdtString cell can hold.
+const size_t MAX_XLTABLE_STRING = 255;
+
+//! Get the registered clipboard format for XlTable data.
+uint xlTableFormat();
+
+////////////////////////////////////////////////////////////////////////////////
+//! A streaming encoder for the XlTable format, which writes the cells of a
+//! table into a DDE data handle, such as the one passed to a server listener's
+//! OnRequest() or OnAdviseRequest() handler. Records are flushed to the data
+//! handle as the internal buffer fills, and End() must be called once every
+//! cell has been written.
+
+class XlTableWriter
+{
+public:
+	//! Constructor.
+	XlTableWriter(CDDEData& data, size_t rows, size_t columns);
+
+	//! Destructor.
+	~XlTableWriter();
+
+	//
+	// Properties.
+	//
+
+	//! The number of cells written so far.
+	size_t CellsWritten() const;
+
+	//
+	// Methods.
+	//
+
+	//! Write a number cell.
+	void WriteNumber(double value);
+
+	//! Write an integer cell.
+	void WriteInteger(short value);
+
+	//! Write a boolean cell.
+	void WriteBool(bool value);
+
+	//! Write an error cell.
+	void WriteError(WORD code);
+
+	//! Write a string cell.
+	void WriteString(const tchar* value);
+
+	//! Write a string cell from ANSI text.
+	void WriteString(const char* value, size_t length);
+
+	//! Write a number of blank cells.
+	void WriteBlanks(size_t count = 1);
+
+	//! Write a number of cells to leave unchanged.
+	void WriteSkips(size_t count = 1);
+
+	//! Flush the remaining records to the data handle.
+	void End();
+
+private:
+	//
+	// Members.
+	//
+	CDDEData&			m_data;		//!< The data handle written to.
+	size_t				m_cells;	//!< The number of cells in the table.
+	size_t				m_written;	//!< The number of cells written.
+	std::vector<byte>	m_buffer;	//!< The records not yet flushed.
+	size_t				m_offset;	//!< The offset of the buffer in the data.
+	size_t				m_record;	//!< The offset of the open record.
+	uint				m_type;		//!< The type of the open record.
+
+	//
+	// Internal methods.
+	//
+
+	//! Ensure there is an open record of a type with room for some bytes.
+	void OpenRecord(uint type, size_t size);
+
+	//! Append bytes to the open record.
+	void Append(const void* data, size_t size);
+
+	//! Write a run of blank or skipped cells.
+	void WriteRun(uint type, size_t count);
+
+	//! Write the buffered records to the data handle.
+	void Flush();
+
+	// NotCopyable.
+	XlTableWriter(const XlTableWriter&);
+	XlTableWriter& operator=(const XlTableWriter&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A decoder for the XlTable format, which returns each cell of a table in row
+//! order. String cells refer directly to the text within the data, which must
+//! outlive the reader. Malformed data throws a CDDEException.
+
+class XlTableReader
+{
+public:
+	//! A cell of the table.
+	struct Cell
+	{
+		XlTableType	m_type;		//!< The type of value.
+		size_t		m_row;		//!< The row of the cell.
+		size_t		m_column;	//!< The column of the cell.
+		double		m_number;	//!< The value of a number cell.
+		int			m_integer;	//!< The value of an integer, boolean or error cell.
+		const char*	m_text;		//!< The text of a string cell, which is not null terminated.
+		size_t		m_length;	//!< The length of a string cell.
+
+		//! The text of a string cell.
+		tstring String() const;
+	};
+
+	//! Construct from the contents of a DDE data view.
+	explicit XlTableReader(const CDDEData::CView& view);
+
+	//! Construct from a block of data.
+	XlTableReader(const void* data, size_t size);
+
+	//! Destructor.
+	~XlTableReader();
+
+	//
+	// Properties.
+	//
+
+	//! The number of rows.
+	size_t Rows() const;
+
+	//! The number of columns.
+	size_t Columns() const;
+
+	//
+	// Methods.
+	//
+
+	//! Read the next cell, returning false after the last one.
+	bool Next(Cell& cell);
+
+private:
+	//
+	// Members.
+	//
+	const byte*	m_next;			//!< The next unread byte.
+	const byte*	m_end;			//!< The end of the data.
+	const byte*	m_recordEnd;	//!< The end of the current record.
+	uint		m_type;			//!< The type of the current record.
+	size_t		m_run;			//!< The cells left in a blank or skip record.
+	size_t		m_rows;			//!< The number of rows.
+	size_t		m_columns;		//!< The number of columns.
+	size_t		m_cell;			//!< The index of the next cell.
+
+	//
+	// Internal methods.
+	//
+
+	//! Validate the table record.
+	void Open(const byte* data, size_t size);
+
+	//! Move to the next record.
+	void NextRecord();
+
+	// NotCopyable.
+	XlTableReader(const XlTableReader&);
+	XlTableReader& operator=(const XlTableReader&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of cells written so far.
+
+inline size_t XlTableWriter::CellsWritten() const
+{
+	return m_written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of rows.
+
+inline size_t XlTableReader::Rows() const
+{
+	return m_rows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of columns.
+
+inline size_t XlTableReader::Columns() const
+{
+	return m_columns;
+}
+
+//namespace DDE
+}
+
+#endif // NCL_DDEXLTABLE_HPP
@@ -35,6 +35,7 @@ public:
 	virtual void OnUnregister(const tchar* pszBaseName, const tchar* pszInstName);
 	virtual void OnDisconnect(DDE::IDDECltConv* pConv);
 	virtual void OnAdvise(CDDELink* pLink, const CDDEData* pData);
+	virtual void OnTransactionComplete(DDE::IDDECltConv* pConv, const DDE::AsyncTransaction& oTransaction, const CDDEData* pData);
 };
 
 /******************************************************************************
@@ -60,4 +61,8 @@ inline void CDefDDEClientListener::OnAdvise(CDDELink* /*pLink*/, const CDDEData*
 {
 }
 
+inline void CDefDDEClientListener::OnTransactionComplete(DDE::IDDECltConv* /*pConv*/, const DDE::AsyncTransaction& /*oTransaction*/, const CDDEData* /*pData*/)
+{
+}
+
 #endif // DEFDDECLIENTLISTENER_HPP
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IDDEBridgeService.hpp
+//! \brief  The IService interface declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_IDDEBRIDGESERVICE_HPP
+#define NCL_IDDEBRIDGESERVICE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+class CSocket;
+class CNetBuffer;
+
+namespace DDEBridge
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A DDE conversation forwarded by a relay.
+
+struct Conversation
+{
+	DWORD		m_id;			//!< The ID shared with the relay.
+	CSocket*	m_client;		//!< The relay connection.
+	tstring		m_service;		//!< The service name.
+	tstring		m_topic;		//!< The topic name.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A DDE advise loop forwarded by a relay.
+
+struct Link
+{
+	DWORD		m_id;			//!< The ID shared with the relay.
+	DWORD		m_conv;			//!< The conversation ID.
+	tstring		m_item;			//!< The item name.
+	uint		m_format;		//!< The clipboard format.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The callback interface used by the bridge host to service the DDE server
+//! events forwarded by a relay. It mirrors IDDEServerListener.
+
+class IService
+{
+public:
+	//! Handle a connection request.
+	virtual bool OnConnect(const tstring& service, const tstring& topic) = 0;
+
+	//! Handle a conversation being terminated.
+	virtual void OnDisconnect(const Conversation& conv) = 0;
+
+	//! Handle a request for an item by appending its value to the buffer.
+	virtual bool OnRequest(const Conversation& conv, const tstring& item, uint format, CNetBuffer& data) = 0;
+
+	//! Handle an item being poked.
+	virtual bool OnPoke(const Conversation& conv, const tstring& item, uint format, const byte* data, size_t size) = 0;
+
+	//! Handle a command.
+	virtual bool OnExecute(const Conversation& conv, const tstring& command) = 0;
+
+	//! Handle the start of an advise loop.
+	virtual bool OnAdviseStart(const Conversation& conv, const Link& link) = 0;
+
+	//! Handle the end of an advise loop.
+	virtual void OnAdviseStop(const Conversation& conv, const Link& link) = 0;
+
+protected:
+	//! Make interface.
+	virtual ~IService() {};
+};
+
+//namespace DDEBridge
+}
+
+#endif // NCL_IDDEBRIDGESERVICE_HPP
@@ -17,6 +17,7 @@
 #endif
 
 #include "DDEFwd.hpp"
+#include "DDETransaction.hpp"
 
 /******************************************************************************
 **
@@ -35,6 +36,7 @@ public:
 	virtual void OnUnregister(const tchar* pszBaseName, const tchar* pszInstName) = 0;
 	virtual void OnDisconnect(DDE::IDDECltConv* pConv) = 0;
 	virtual void OnAdvise(CDDELink* pLink, const CDDEData* pData) = 0;
+	virtual void OnTransactionComplete(DDE::IDDECltConv* pConv, const DDE::AsyncTransaction& oTransaction, const CDDEData* pData) = 0;
 
 protected:
 	// Make interface.
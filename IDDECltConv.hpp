@@ -12,6 +12,7 @@
 #endif
 
 #include "IDDEConv.hpp"
+#include "DDETransaction.hpp"
 
 namespace DDE
 {
@@ -45,6 +46,9 @@ public:
 	//! Request a value in a custom format.
 	virtual CDDEData Request(const tchar* pszItem, uint nFormat) const = 0;
 
+	//! Request many values in one batch.
+	virtual DWORD RequestMany(const CStrArray& astrItems, uint nFormat, RequestResults& aoResults) = 0;
+
 	//! Execute a string based command on the server.
 	virtual void ExecuteString(const tchar* pszCommand) const = 0;
 
@@ -59,6 +63,26 @@ public:
 
 	//! Start an advise loop on the server for an item.
 	virtual CDDELink* CreateLink(const tchar* pszItem, uint nFormat = CF_TEXT) = 0;
+
+	//
+	// Asynchronous methods.
+	//
+
+	//! Start a request for a value.
+	virtual DWORD RequestAsync(const tchar* pszItem, uint nFormat) = 0;
+
+	//! Start executing a command on the server.
+	virtual DWORD ExecuteAsync(const void* pValue, size_t nSize) = 0;
+
+	//! Start poking a value.
+	virtual DWORD PokeAsync(const tchar* pszItem, uint nFormat, const void* pValue, size_t nSize) = 0;
+
+	//! Start an advise loop on the server for an item, or add a reference to
+	//! an existing link, in which case 0 is returned.
+	virtual DWORD CreateLinkAsync(const tchar* pszItem, uint nFormat = CF_TEXT) = 0;
+
+	//! Cancel an outstanding asynchronous transaction.
+	virtual bool CancelTransaction(DWORD dwTransID) = 0;
 };
 
 //namespace DDE
@@ -0,0 +1,50 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		IPIPEWRITELISTENER.HPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	The IPipeWriteListener interface declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef IPIPEWRITELISTENER_HPP
+#define IPIPEWRITELISTENER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+class CNamedPipe;
+
+/******************************************************************************
+**
+** The callback interface for queued Named Pipe writes completing. Writes are
+** reported in the order they were queued.
+**
+*******************************************************************************
+*/
+
+class IPipeWriteListener
+{
+public:
+	//
+	// Methods.
+	//
+	virtual void OnWriteComplete(CNamedPipe* pPipe, size_t nBytes) = 0;
+
+protected:
+	// Make interface.
+	virtual ~IPipeWriteListener() {};
+};
+
+/******************************************************************************
+**
+** Implementation of inline functions.
+**
+*******************************************************************************
+*/
+
+#endif // IPIPEWRITELISTENER_HPP
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IRPCNotifyHandler.hpp
+//! \brief  The INotifyHandler interface declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_IRPCNOTIFYHANDLER_HPP
+#define NCL_IRPCNOTIFYHANDLER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+namespace RPC
+{
+
+// Forward declarations.
+class CltSession;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The callback interface used to deliver the one-way notifications sent by the
+//! server to a client session.
+
+class INotifyHandler
+{
+public:
+	//! Invoked when a notification arrives.
+	virtual void OnNotify(CltSession& session, WORD code, const byte* payload, size_t size) = 0;
+
+protected:
+	//! Make interface.
+	virtual ~INotifyHandler() {};
+};
+
+//namespace RPC
+}
+
+#endif // NCL_IRPCNOTIFYHANDLER_HPP
@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IRPCRequestHandler.hpp
+//! \brief  The IRequestHandler interface declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_IRPCREQUESTHANDLER_HPP
+#define NCL_IRPCREQUESTHANDLER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+class CSocket;
+class CNetBuffer;
+
+namespace RPC
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The callback interface used by the server dispatcher to service requests.
+
+class IRequestHandler
+{
+public:
+	//! Service a request by appending the payload to the response buffer and
+	//! returning the response status.
+	virtual WORD OnRequest(CSocket& client, WORD method, const byte* payload, size_t size, CNetBuffer& response) = 0;
+
+	//! Invoked when a client connection has been closed, so that any state
+	//! held for it can be released.
+	virtual void OnClientClosed(CSocket& client) = 0;
+
+protected:
+	//! Make interface.
+	virtual ~IRequestHandler() {};
+};
+
+//namespace RPC
+}
+
+#endif // NCL_IRPCREQUESTHANDLER_HPP
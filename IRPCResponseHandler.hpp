@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IRPCResponseHandler.hpp
+//! \brief  The IResponseHandler interface declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_IRPCRESPONSEHANDLER_HPP
+#define NCL_IRPCRESPONSEHANDLER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+namespace RPC
+{
+
+// Forward declarations.
+class CltSession;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The callback interface used to complete a request made by a client session.
+//! Exactly one of the methods is invoked for each request that is not
+//! cancelled.
+
+class IResponseHandler
+{
+public:
+	//! Invoked when the response to a request arrives.
+	virtual void OnResponse(CltSession& session, DWORD id, WORD status, const byte* payload, size_t size) = 0;
+
+	//! Invoked when a request cannot be completed.
+	virtual void OnFailed(CltSession& session, DWORD id, int reason) = 0;
+
+protected:
+	//! Make interface.
+	virtual ~IResponseHandler() {};
+};
+
+//namespace RPC
+}
+
+#endif // NCL_IRPCRESPONSEHANDLER_HPP
@@ -0,0 +1,46 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		ISOCKETTIMERLISTENER.HPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	The ISocketTimerListener interface declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef ISOCKETTIMERLISTENER_HPP
+#define ISOCKETTIMERLISTENER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+/******************************************************************************
+**
+** The callback interface for timers serviced by the socket message window.
+**
+*******************************************************************************
+*/
+
+class ISocketTimerListener
+{
+public:
+	//
+	// Methods.
+	//
+	virtual void OnTimer(uint nTimerID) = 0;
+
+protected:
+	// Make interface.
+	virtual ~ISocketTimerListener() {};
+};
+
+/******************************************************************************
+**
+** Implementation of inline functions.
+**
+*******************************************************************************
+*/
+
+#endif // ISOCKETTIMERLISTENER_HPP
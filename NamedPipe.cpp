@@ -11,6 +11,8 @@
 #include "Common.hpp"
 #include "NamedPipe.hpp"
 #include "PipeException.hpp"
+#include "IPipeWriteListener.hpp"
+#include <algorithm>
 
 /******************************************************************************
 **
@@ -19,7 +21,50 @@
 *******************************************************************************
 */
 
-const DWORD CNamedPipe::DEF_TIMEOUT = 30000;
+const DWORD  CNamedPipe::DEF_TIMEOUT     = 30000;
+const size_t CNamedPipe::DEF_WRITE_DEPTH = 1;
+const size_t CNamedPipe::DEF_READ_AHEAD  = 4096;
+
+// The message tags used when passing handles.
+static const DWORD HANDLE_MSG_TAG = 0x484C434E;	// "NCLH"
+static const DWORD SOCKET_MSG_TAG = 0x534C434E;	// "NCLS"
+
+// The message sent by WriteHandle().
+struct HandleMsg
+{
+	DWORD		m_dwTag;		// HANDLE_MSG_TAG.
+	DWORD		m_dwPadding;	// Unused.
+	ULONGLONG	m_qwHandle;		// The handle value in the peer process.
+};
+
+// The message sent by WriteSocket().
+struct SocketMsg
+{
+	DWORD				m_dwTag;	// SOCKET_MSG_TAG.
+	WSAPROTOCOL_INFO	m_oInfo;	// The duplicated socket.
+};
+
+// The Vista and later functions, which are looked up at runtime.
+typedef BOOL (WINAPI* CancelIoExFn)(HANDLE, LPOVERLAPPED);
+typedef BOOL (WINAPI* GetPipeProcessIdFn)(HANDLE, PULONG);
+
+// Find a kernel32 function that older versions of Windows may not have.
+static FARPROC kernelFunction(const char* pszName)
+{
+	return ::GetProcAddress(::GetModuleHandle(TXT("kernel32.dll")), pszName);
+}
+
+// Cancel an overlapped operation. Before Vista there is no CancelIoEx(), and
+// CancelIo() only cancels the I/O started by the calling thread.
+static void cancelIo(HANDLE hPipe, OVERLAPPED* pIO)
+{
+	static CancelIoExFn pfnCancelIoEx = reinterpret_cast<CancelIoExFn>(kernelFunction("CancelIoEx"));
+
+	if (pfnCancelIoEx != nullptr)
+		pfnCancelIoEx(hPipe, pIO);
+	else
+		::CancelIo(hPipe);
+}
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -38,19 +83,47 @@ CNamedPipe::CNamedPipe()
 	, m_strName()
 	, m_oReadEvent(true, true)
 	, m_oReadIO()
-	, m_oWriteEvent(true, true)
-	, m_oWriteIO()
-	, m_bPrevWrite(false)
-	, m_nPrevBytes(0)
+	, m_vReadAhead(DEF_READ_AHEAD)
+	, m_nReadPos(0)
+	, m_nReadEnd(0)
+	, m_bReadPosted(false)
+	, m_aoWrites()
+	, m_nNextWrite(0)
+	, m_nPending(0)
+	, m_nWriteDepth(0)
+	, m_pWriteListener(nullptr)
 	, m_dwTimeOut(DEF_TIMEOUT)
 {
 	// Clear Overlapped I/O structs.
-	memset(&m_oReadIO,  0, sizeof(m_oReadIO));
-	memset(&m_oWriteIO, 0, sizeof(m_oWriteIO));
+	memset(&m_oReadIO, 0, sizeof(m_oReadIO));
+
+	// Attach event handle to Overlapped I/O struct.
+	m_oReadIO.hEvent = m_oReadEvent.Handle();
 
-	// Attach event handles to Overlapped I/O structs.
-	m_oReadIO.hEvent  = m_oReadEvent.Handle();
-	m_oWriteIO.hEvent = m_oWriteEvent.Handle();
+	SetWriteDepth(DEF_WRITE_DEPTH);
+}
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	Create an idle write queue slot.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CNamedPipe::WriteOp::WriteOp()
+	: m_oEvent(true, true)
+	, m_oIO()
+	, m_vData()
+	, m_bPending(false)
+{
+	memset(&m_oIO, 0, sizeof(m_oIO));
+
+	m_oIO.hEvent = m_oEvent.Handle();
 }
 
 /******************************************************************************
@@ -74,6 +147,8 @@ CNamedPipe::~CNamedPipe()
 ** Method:		Available()
 **
 ** Description:	Query the number of bytes available in the pipe for reading.
+**				This is the unread part of the next message, which is served
+**				from the read-ahead buffer where possible.
 **
 ** Parameters:	None.
 **
@@ -86,13 +161,11 @@ CNamedPipe::~CNamedPipe()
 
 size_t CNamedPipe::Available()
 {
-	DWORD dwAvail, dwMsgAvail;
+	// Nothing received yet?
+	if (!FillReadAhead(false, CPipeException::E_PEEK_FAILED))
+		return 0;
 
-	// Query the bytes available.
-	if (!::PeekNamedPipe(m_hPipe, nullptr, 0, nullptr, &dwAvail, &dwMsgAvail))
-		throw CPipeException(CPipeException::E_PEEK_FAILED, ::GetLastError());
-
-	return dwAvail;
+	return m_nReadEnd - m_nReadPos;
 }
 
 /******************************************************************************
@@ -112,19 +185,23 @@ size_t CNamedPipe::Available()
 
 size_t CNamedPipe::Peek(void* pBuffer, size_t nBufSize)
 {
-	DWORD dwRead, dwAvail, dwMsgAvail;
+	// Nothing received yet?
+	if (!FillReadAhead(false, CPipeException::E_PEEK_FAILED))
+		return 0;
+
+	size_t nPeeked = std::min(nBufSize, m_nReadEnd - m_nReadPos);
 
-	// Query the bytes available.
-	if (!::PeekNamedPipe(m_hPipe, pBuffer, static_cast<DWORD>(nBufSize), &dwRead, &dwAvail, &dwMsgAvail))
-		throw CPipeException(CPipeException::E_PEEK_FAILED, ::GetLastError());
+	memcpy(pBuffer, &m_vReadAhead[m_nReadPos], nPeeked);
 
-	return dwRead;
+	return nPeeked;
 }
 
 /******************************************************************************
 ** Method:		Read()
 **
-** Description:	Read data from the pipe.
+** Description:	Read data from the pipe. Data already in the read-ahead buffer
+**				is used first, a read larger than the buffer is otherwise made
+**				directly into the callers' buffer.
 **
 ** Parameters:	pBuffer		The buffer to store the data.
 **				nBufSize	The number of bytes to read.
@@ -141,41 +218,222 @@ void CNamedPipe::Read(void* pBuffer, size_t nBufSize)
 	ASSERT(pBuffer  != nullptr);
 	ASSERT(nBufSize != 0 );
 
-	DWORD dwRead;
+	byte* pData = static_cast<byte*>(pBuffer);
 
-	// Start the read.
-	BOOL bResult = ::ReadFile(m_hPipe, pBuffer, static_cast<DWORD>(nBufSize), &dwRead, &m_oReadIO);
+	// Large read with nothing buffered?
+	if ( (m_nReadPos == m_nReadEnd) && (!m_bReadPosted) && (nBufSize >= m_vReadAhead.size()) )
+	{
+		DWORD dwRead;
 
-	// Read failed?
-	if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) )
-		throw CPipeException(CPipeException::E_READ_FAILED, ::GetLastError());
+		// Start the read.
+		BOOL bResult = ::ReadFile(m_hPipe, pData, static_cast<DWORD>(nBufSize), &dwRead, &m_oReadIO);
 
-	// Wait for I/O to finish OR time out.
-	m_oReadEvent.Wait(m_dwTimeOut);
+		// Read failed?
+		if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) )
+			throw CPipeException(CPipeException::E_READ_FAILED, ::GetLastError());
+
+		// Wait for I/O to finish OR time out.
+		m_oReadEvent.Wait(m_dwTimeOut);
+
+		bResult = ::GetOverlappedResult(m_hPipe, &m_oReadIO, &dwRead, FALSE);
+
+		// Read failed?
+		if (bResult == FALSE)
+		{
+			DWORD dwResult = ::GetLastError();
+
+			// Timed out? NB: The callers' buffer must be released first.
+			if (dwResult == ERROR_IO_INCOMPLETE)
+			{
+				cancelIo(m_hPipe, &m_oReadIO);
+				::GetOverlappedResult(m_hPipe, &m_oReadIO, &dwRead, TRUE);
+
+				dwResult = WAIT_TIMEOUT;
+			}
+
+			throw CPipeException(CPipeException::E_READ_FAILED, dwResult);
+		}
+
+		ASSERT(dwRead == nBufSize);
+		return;
+	}
+
+	// Copy from the read-ahead, refilling as required.
+	while (nBufSize != 0)
+	{
+		FillReadAhead(true, CPipeException::E_READ_FAILED);
+
+		size_t nCopy = std::min(nBufSize, m_nReadEnd - m_nReadPos);
+
+		memcpy(pData, &m_vReadAhead[m_nReadPos], nCopy);
+
+		m_nReadPos += nCopy;
+		pData      += nCopy;
+		nBufSize   -= nCopy;
+	}
+}
 
-	bResult = ::GetOverlappedResult(m_hPipe, &m_oReadIO, &dwRead, FALSE);
+/******************************************************************************
+** Method:		FillReadAhead()
+**
+** Description:	Ensure the read-ahead buffer contains some data. If it is empty
+**				a read is posted, a completed read is detected without a call
+**				into the kernel. A message larger than the buffer causes the
+**				buffer to grow.
+**
+** Parameters:	bWait		Wait for the read to complete?
+**				eErrCode	The exception code to use for errors.
+**
+** Returns:		true if there is data buffered or false if not.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+bool CNamedPipe::FillReadAhead(bool bWait, int eErrCode)
+{
+	// Data already buffered?
+	if (m_nReadPos != m_nReadEnd)
+		return true;
+
+	DWORD dwRead = 0;
+
+	// Start the read-ahead.
+	if (!m_bReadPosted)
+	{
+		m_nReadPos = m_nReadEnd = 0;
+
+		BOOL bResult = ::ReadFile(m_hPipe, &m_vReadAhead[0], static_cast<DWORD>(m_vReadAhead.size()), &dwRead, &m_oReadIO);
+
+		// Read failed?
+		if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) && (::GetLastError() != ERROR_MORE_DATA) )
+			throw CPipeException(eErrCode, ::GetLastError());
+
+		m_bReadPosted = true;
+	}
+
+	// Still waiting for a message?
+	if (!HasOverlappedIoCompleted(&m_oReadIO))
+	{
+		if (!bWait)
+			return false;
+
+		// Wait for I/O to finish OR time out.
+		m_oReadEvent.Wait(m_dwTimeOut);
+	}
+
+	BOOL  bResult  = ::GetOverlappedResult(m_hPipe, &m_oReadIO, &dwRead, FALSE);
+	DWORD dwResult = ::GetLastError();
+
+	// Timed out? NB: The read is left posted.
+	if ( (bResult == FALSE) && (dwResult == ERROR_IO_INCOMPLETE) )
+		throw CPipeException(eErrCode, WAIT_TIMEOUT);
+
+	// The read has finished, even if it was cancelled by Close() on another
+	// thread with ERROR_OPERATION_ABORTED.
+	m_bReadPosted = false;
 
 	// Read failed?
+	if ( (bResult == FALSE) && (dwResult != ERROR_MORE_DATA) )
+		throw CPipeException(eErrCode, dwResult);
+
+	m_nReadEnd = dwRead;
+
+	// Message larger than the buffer?
 	if (bResult == FALSE)
 	{
-		DWORD dwResult = ::GetLastError();
+		DWORD dwLeft = 0;
 
-		::CancelIo(m_hPipe);
+		// Query the remainder of the message.
+		if (!::PeekNamedPipe(m_hPipe, nullptr, 0, nullptr, nullptr, &dwLeft))
+			throw CPipeException(eErrCode, ::GetLastError());
 
-		// Remap error code if it timed-out.
-		if (dwResult == ERROR_IO_INCOMPLETE)
-			dwResult = WAIT_TIMEOUT;
+		m_vReadAhead.resize(m_nReadEnd + dwLeft);
+
+		// Read the remainder, it's already in the pipe.
+		bResult = ::ReadFile(m_hPipe, &m_vReadAhead[m_nReadEnd], dwLeft, &dwRead, &m_oReadIO);
 
-		throw CPipeException(CPipeException::E_READ_FAILED, dwResult);
+		if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) )
+			throw CPipeException(eErrCode, ::GetLastError());
+
+		if (::GetOverlappedResult(m_hPipe, &m_oReadIO, &dwRead, TRUE) == FALSE)
+			throw CPipeException(eErrCode, ::GetLastError());
+
+		m_nReadEnd += dwRead;
 	}
 
-	ASSERT(dwRead == nBufSize);
+	return (m_nReadPos != m_nReadEnd);
+}
+
+/******************************************************************************
+** Method:		CancelReadAhead()
+**
+** Description:	Cancel any outstanding read-ahead and discard the buffered data.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::CancelReadAhead()
+{
+	if (m_bReadPosted)
+	{
+		DWORD dwRead;
+
+		// NB: The read may have been posted by another thread.
+		cancelIo(m_hPipe, &m_oReadIO);
+
+		// Wait for the buffer to be released.
+		::GetOverlappedResult(m_hPipe, &m_oReadIO, &dwRead, TRUE);
+	}
+
+	m_nReadPos    = 0;
+	m_nReadEnd    = 0;
+	m_bReadPosted = false;
+}
+
+/******************************************************************************
+** Method:		SetWriteDepth()
+**
+** Description:	Set the maximum number of writes that can be outstanding. Any
+**				writes currently outstanding are completed first.
+**
+** Parameters:	nDepth		The write queue depth, at least 1.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::SetWriteDepth(size_t nDepth)
+{
+	// Write() always needs a slot.
+	if (nDepth == 0)
+		nDepth = 1;
+
+	Flush();
+
+	m_aoWrites.clear();
+
+	for (size_t i = 0; i != nDepth; ++i)
+		m_aoWrites.push_back(WriteOpPtr(new WriteOp));
+
+	m_nNextWrite  = 0;
+	m_nWriteDepth = nDepth;
 }
 
 /******************************************************************************
 ** Method:		Write()
 **
-** Description:	Write data to the pipe.
+** Description:	Write data to the pipe. The data is copied and the write is
+**				queued, the caller only waits if the queue is full, in which
+**				case the oldest write must complete first.
 **
 ** Parameters:	pBuffer		The buffer to store the data.
 **				nBufSize	The number of bytes to write.
@@ -192,47 +450,386 @@ void CNamedPipe::Write(const void* pBuffer, size_t nBufSize)
 	ASSERT(pBuffer  != nullptr);
 	ASSERT(nBufSize != 0 );
 
+	WriteOp& oWrite = *m_aoWrites[m_nNextWrite];
+
+	// Queue full?
+	if (oWrite.m_bPending)
+		CompleteWrite(oWrite, true);
+
+	const byte* pBegin = static_cast<const byte*>(pBuffer);
+
+	oWrite.m_vData.assign(pBegin, pBegin+nBufSize);
+
 	DWORD dwWritten;
 
-	if (m_bPrevWrite)
-	{
-		// Wait for I/O to finish OR time out.
-		m_oWriteEvent.Wait(m_dwTimeOut);
+	// Start the write.
+	BOOL bResult = ::WriteFile(m_hPipe, &oWrite.m_vData[0], static_cast<DWORD>(nBufSize), &dwWritten, &oWrite.m_oIO);
 
-		BOOL bResult = ::GetOverlappedResult(m_hPipe, &m_oWriteIO, &dwWritten, FALSE);
+	// Write failed?
+	if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) )
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ::GetLastError());
 
-		// Write failed?
-		if (bResult == FALSE)
-		{
-			DWORD dwResult = ::GetLastError();
+	oWrite.m_bPending = true;
+	m_nNextWrite = (m_nNextWrite + 1) % m_nWriteDepth;
+	++m_nPending;
 
-			::CancelIo(m_hPipe);
+	// Report any which have finished.
+	ReapWrites();
+}
 
-			// Remap error code if it timed-out.
-			if (dwResult == ERROR_IO_INCOMPLETE)
-				dwResult = WAIT_TIMEOUT;
+/******************************************************************************
+** Method:		PendingWrites()
+**
+** Description:	Query the number of writes still outstanding.
+**
+** Parameters:	None.
+**
+** Returns:		The number of writes.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
 
-			throw CPipeException(CPipeException::E_WRITE_FAILED, dwResult);
-		}
+size_t CNamedPipe::PendingWrites()
+{
+	ReapWrites();
+
+	return m_nPending;
+}
 
-		ASSERT(dwWritten == m_nPrevBytes);
+/******************************************************************************
+** Method:		Flush()
+**
+** Description:	Wait for all outstanding writes to complete.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::Flush()
+{
+	while (m_nPending != 0)
+	{
+		size_t nOldest = (m_nNextWrite + m_nWriteDepth - m_nPending) % m_nWriteDepth;
+
+		CompleteWrite(*m_aoWrites[nOldest], true);
 	}
+}
 
-	// Start the write.
-	BOOL bResult = ::WriteFile(m_hPipe, pBuffer, static_cast<DWORD>(nBufSize), &dwWritten, &m_oWriteIO);
+/******************************************************************************
+** Method:		CompleteWrite()
+**
+** Description:	Complete an outstanding write and notify the listener.
+**
+** Parameters:	oWrite		The write.
+**				bWait		Wait for the write OR time out?
+**
+** Returns:		true if complete or false if still outstanding.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+bool CNamedPipe::CompleteWrite(WriteOp& oWrite, bool bWait)
+{
+	ASSERT(oWrite.m_bPending);
+
+	// Wait for I/O to finish OR time out.
+	if (bWait)
+		oWrite.m_oEvent.Wait(m_dwTimeOut);
+
+	DWORD dwWritten;
+
+	BOOL bResult = ::GetOverlappedResult(m_hPipe, &oWrite.m_oIO, &dwWritten, FALSE);
 
 	// Write failed?
-	if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) )
+	if (bResult == FALSE)
+	{
+		DWORD dwResult = ::GetLastError();
+
+		// Still in progress?
+		if ( (dwResult == ERROR_IO_INCOMPLETE) && (!bWait) )
+			return false;
+
+		CancelWrites();
+
+		// Remap error code if it timed-out.
+		if (dwResult == ERROR_IO_INCOMPLETE)
+			dwResult = WAIT_TIMEOUT;
+
+		throw CPipeException(CPipeException::E_WRITE_FAILED, dwResult);
+	}
+
+	ASSERT(dwWritten == oWrite.m_vData.size());
+
+	oWrite.m_bPending = false;
+	--m_nPending;
+
+	if (m_pWriteListener != nullptr)
+		m_pWriteListener->OnWriteComplete(this, dwWritten);
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		ReapWrites()
+**
+** Description:	Complete, in order, the outstanding writes that have finished.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::ReapWrites()
+{
+	while (m_nPending != 0)
+	{
+		size_t nOldest = (m_nNextWrite + m_nWriteDepth - m_nPending) % m_nWriteDepth;
+
+		if (!CompleteWrite(*m_aoWrites[nOldest], false))
+			break;
+	}
+}
+
+/******************************************************************************
+** Method:		CancelWrites()
+**
+** Description:	Abandon all outstanding writes. The buffers cannot be reused
+**				until the cancelled writes have finished.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::CancelWrites()
+{
+	if (m_nPending == 0)
+		return;
+
+	for (WriteOps::iterator it = m_aoWrites.begin(); it != m_aoWrites.end(); ++it)
+	{
+		WriteOp& oWrite = **it;
+
+		if (oWrite.m_bPending)
+		{
+			DWORD dwWritten;
+
+			// NB: The write may have been queued by another thread.
+			cancelIo(m_hPipe, &oWrite.m_oIO);
+			::GetOverlappedResult(m_hPipe, &oWrite.m_oIO, &dwWritten, TRUE);
+
+			oWrite.m_bPending = false;
+		}
+	}
+
+	m_nPending = 0;
+}
+
+/******************************************************************************
+** Method:		PeerProcessId()
+**
+** Description:	Get the ID of the process at the other end of the pipe.
+**
+** Parameters:	None.
+**
+** Returns:		The process ID.
+**
+** Exceptions:	CPipeException, with ERROR_CALL_NOT_IMPLEMENTED before Vista.
+**
+*******************************************************************************
+*/
+
+DWORD CNamedPipe::PeerProcessId()
+{
+	static GetPipeProcessIdFn pfnClientProcessId = reinterpret_cast<GetPipeProcessIdFn>(kernelFunction("GetNamedPipeClientProcessId"));
+	static GetPipeProcessIdFn pfnServerProcessId = reinterpret_cast<GetPipeProcessIdFn>(kernelFunction("GetNamedPipeServerProcessId"));
+
+	if ( (pfnClientProcessId == nullptr) || (pfnServerProcessId == nullptr) )
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ERROR_CALL_NOT_IMPLEMENTED);
+
+	DWORD dwFlags = 0;
+	ULONG ulProcessID = 0;
+
+	if (::GetNamedPipeInfo(m_hPipe, &dwFlags, nullptr, nullptr, nullptr) == 0)
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ::GetLastError());
+
+	BOOL bResult = (dwFlags & PIPE_SERVER_END) ? pfnClientProcessId(m_hPipe, &ulProcessID)
+											   : pfnServerProcessId(m_hPipe, &ulProcessID);
+
+	if (bResult == 0)
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ::GetLastError());
+
+	return ulProcessID;
+}
+
+/******************************************************************************
+** Method:		WriteHandle()
+**
+** Description:	Pass an open handle to the process at the other end of the pipe.
+**				The handle is duplicated into the peer process, the caller still
+**				owns, and must close, the original.
+**				This waits for any queued writes to be sent.
+**
+** Parameters:	hHandle		The handle to pass.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::WriteHandle(HANDLE hHandle)
+{
+	ASSERT(hHandle != INVALID_HANDLE_VALUE);
+
+	HANDLE hProcess = ::OpenProcess(PROCESS_DUP_HANDLE, FALSE, PeerProcessId());
+
+	if (hProcess == NULL)
 		throw CPipeException(CPipeException::E_WRITE_FAILED, ::GetLastError());
 
-	m_bPrevWrite = true;
-	m_nPrevBytes = nBufSize;
+	HANDLE hDuplicate = NULL;
+
+	BOOL bResult = ::DuplicateHandle(::GetCurrentProcess(), hHandle, hProcess, &hDuplicate,
+										0, FALSE, DUPLICATE_SAME_ACCESS);
+
+	if (bResult == 0)
+	{
+		DWORD dwError = ::GetLastError();
+
+		::CloseHandle(hProcess);
+		throw CPipeException(CPipeException::E_WRITE_FAILED, dwError);
+	}
+
+	HandleMsg oMessage = { HANDLE_MSG_TAG, 0, reinterpret_cast<ULONG_PTR>(hDuplicate) };
+
+	// Wait for it to be sent, so that a failed write can't be missed.
+	try
+	{
+		Write(&oMessage, sizeof(oMessage));
+		Flush();
+	}
+	catch (const CPipeException&)
+	{
+		// The peer will never see it, so close it in the peer process.
+		::DuplicateHandle(hProcess, hDuplicate, NULL, nullptr, 0, FALSE, DUPLICATE_CLOSE_SOURCE);
+		::CloseHandle(hProcess);
+		throw;
+	}
+
+	::CloseHandle(hProcess);
+}
+
+/******************************************************************************
+** Method:		ReadHandle()
+**
+** Description:	Read a handle passed by the process at the other end of the pipe
+**				with WriteHandle(). The caller owns the handle.
+**
+** Parameters:	None.
+**
+** Returns:		The handle.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+HANDLE CNamedPipe::ReadHandle()
+{
+	HandleMsg oMessage;
+
+	Read(&oMessage, sizeof(oMessage));
+
+	if (oMessage.m_dwTag != HANDLE_MSG_TAG)
+		throw CPipeException(CPipeException::E_BAD_PROTOCOL, 0);
+
+	return reinterpret_cast<HANDLE>(static_cast<ULONG_PTR>(oMessage.m_qwHandle));
+}
+
+/******************************************************************************
+** Method:		WriteSocket()
+**
+** Description:	Pass an open socket to the process at the other end of the pipe.
+**				The caller still owns, and must close, the original socket.
+**
+** Parameters:	hSocket		The SOCKET to pass.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CNamedPipe::WriteSocket(UINT_PTR hSocket)
+{
+	ASSERT(hSocket != INVALID_SOCKET);
+
+	SocketMsg oMessage;
+
+	oMessage.m_dwTag = SOCKET_MSG_TAG;
+
+	if (::WSADuplicateSocket(hSocket, PeerProcessId(), &oMessage.m_oInfo) != 0)
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ::WSAGetLastError());
+
+	Write(&oMessage, sizeof(oMessage));
+}
+
+/******************************************************************************
+** Method:		ReadSocket()
+**
+** Description:	Read a socket passed by the process at the other end of the pipe
+**				with WriteSocket(). The caller owns the socket, it can be handed
+**				to a socket object with Attach().
+**
+** Parameters:	None.
+**
+** Returns:		The SOCKET.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+UINT_PTR CNamedPipe::ReadSocket()
+{
+	SocketMsg oMessage;
+
+	Read(&oMessage, sizeof(oMessage));
+
+	if (oMessage.m_dwTag != SOCKET_MSG_TAG)
+		throw CPipeException(CPipeException::E_BAD_PROTOCOL, 0);
+
+	SOCKET hSocket = ::WSASocket(FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO,
+									&oMessage.m_oInfo, 0, 0);
+
+	if (hSocket == INVALID_SOCKET)
+		throw CPipeException(CPipeException::E_READ_FAILED, ::WSAGetLastError());
+
+	return hSocket;
 }
 
 /******************************************************************************
 ** Method:		Close()
 **
-** Description:	Close the named pipe.
+** Description:	Close the named pipe. Any outstanding writes are given up to
+**				the time-out to complete, after which they are cancelled.
 **
 ** Parameters:	None.
 **
@@ -245,14 +842,32 @@ void CNamedPipe::Close()
 {
 	// Not already closed?.
 	if (m_hPipe != INVALID_HANDLE_VALUE)
+	{
+		CancelReadAhead();
+
+		// Drain the write queue, if we can.
+		try
+		{
+			Flush();
+		}
+		catch (const CPipeException& e)
+		{
+			TRACE1(TXT("Pipe writes abandoned on close: %s\n"), e.twhat());
+		}
+
+		CancelWrites();
+
 		::CloseHandle(m_hPipe);
+	}
 
 	// Reset members.
 	m_hPipe      = INVALID_HANDLE_VALUE;
-	m_bPrevWrite = false;
-	m_nPrevBytes = 0;
+	m_nNextWrite = 0;
+	m_nPending   = 0;
 
 	// Reset events to signalled.
 	m_oReadEvent.Signal();
-	m_oWriteEvent.Signal();
+
+	for (WriteOps::iterator it = m_aoWrites.begin(); it != m_aoWrites.end(); ++it)
+		(*it)->m_oEvent.Signal();
 }
@@ -18,11 +18,24 @@
 
 #include <WCL/Buffer.hpp>
 #include <WCL/Event.hpp>
+#include <Core/SharedPtr.hpp>
+#include <vector>
+
+// Forward declarations.
+class IPipeWriteListener;
 
 /******************************************************************************
 **
 ** The base class for Named Pipes.
 **
+** A read is kept posted into a read-ahead buffer once the pipe is in use, so
+** that Available(), Peek() and small Read()s are mostly served from memory
+** instead of costing a kernel call each.
+**
+** Open handles, e.g. accepted sockets, can be passed to the process at the
+** other end. The handle is duplicated into the peer process and the new value
+** is sent instead.
+**
 *******************************************************************************
 */
 
@@ -38,6 +51,11 @@ public:
 	DWORD  TimeOut() const;
 	void   SetTimeOut(DWORD dwTimeOut);
 
+	size_t WriteDepth() const;
+	void   SetWriteDepth(size_t nDepth);
+
+	void   SetWriteListener(IPipeWriteListener* pListener);
+
 	//
 	// Methods.
 	//
@@ -48,10 +66,32 @@ public:
 	void Read(CBuffer& oBuffer);
 	void Write(const void* pBuffer, size_t nBufSize);
 	void Write(const CBuffer& oBuffer);
+	size_t PendingWrites();
+	void Flush();
+
+	void   WriteHandle(HANDLE hHandle);
+	HANDLE ReadHandle();
+	void     WriteSocket(UINT_PTR hSocket);	// hSocket is a SOCKET.
+	UINT_PTR ReadSocket();					// Returns a SOCKET.
 
 	virtual void Close();
 
 protected:
+	// An outstanding overlapped write.
+	struct WriteOp
+	{
+		WriteOp();
+
+		CEvent				m_oEvent;	// Overlapped I/O event.
+		OVERLAPPED			m_oIO;		// Overlapped I/O data.
+		std::vector<byte>	m_vData;	// Copy of the data being written.
+		bool				m_bPending;	// Write outstanding?
+	};
+
+	// The write queue.
+	typedef Core::SharedPtr<WriteOp> WriteOpPtr;
+	typedef std::vector<WriteOpPtr> WriteOps;
+
 	//
 	// Members.
 	//
@@ -59,16 +99,23 @@ protected:
 	CString		m_strName;		// The pipe name.
 	CEvent		m_oReadEvent;	// Read Overlapped I/O event.
 	OVERLAPPED	m_oReadIO;		// Read Overlapped I/O data.
-	CEvent		m_oWriteEvent;	// Write Overlapped I/O event.
-	OVERLAPPED	m_oWriteIO;		// Write Overlapped I/O data.
-	bool		m_bPrevWrite;	// Write outstanding?
-	size_t		m_nPrevBytes;	// Previous write size.
+	std::vector<byte> m_vReadAhead;	// Read-ahead buffer.
+	size_t		m_nReadPos;		// Next unread byte in the read-ahead.
+	size_t		m_nReadEnd;		// End of the data in the read-ahead.
+	bool		m_bReadPosted;	// Read-ahead outstanding?
+	WriteOps	m_aoWrites;		// Write queue, used round-robin.
+	size_t		m_nNextWrite;	// Next write queue slot.
+	size_t		m_nPending;		// Writes outstanding.
+	size_t		m_nWriteDepth;	// Max writes outstanding.
+	IPipeWriteListener* m_pWriteListener;	// Write completion listener.
 	DWORD		m_dwTimeOut;	// Connect/Read/Write time-out.
 
 	//
 	// Constants.
 	//
-	static const DWORD DEF_TIMEOUT;
+	static const DWORD  DEF_TIMEOUT;
+	static const size_t DEF_WRITE_DEPTH;
+	static const size_t DEF_READ_AHEAD;
 
 	//
 	// Constructors/Destructor.
@@ -78,6 +125,16 @@ protected:
 	CNamedPipe(const CNamedPipe&);
 	CNamedPipe& operator=(const CNamedPipe&);
 	virtual ~CNamedPipe();
+
+	//
+	// Internal methods.
+	//
+	bool  CompleteWrite(WriteOp& oWrite, bool bWait);
+	void  ReapWrites();
+	void  CancelWrites();
+	DWORD PeerProcessId();
+	bool  FillReadAhead(bool bWait, int eErrCode);
+	void  CancelReadAhead();
 };
 
 /******************************************************************************
@@ -107,6 +164,16 @@ inline void CNamedPipe::SetTimeOut(DWORD dwTimeOut)
 	m_dwTimeOut = dwTimeOut;
 }
 
+inline size_t CNamedPipe::WriteDepth() const
+{
+	return m_nWriteDepth;
+}
+
+inline void CNamedPipe::SetWriteListener(IPipeWriteListener* pListener)
+{
+	m_pWriteListener = pListener;
+}
+
 inline size_t CNamedPipe::Peek(CBuffer& oBuffer, size_t nBufSize)
 {
 	return Peek(oBuffer.Buffer(), nBufSize);
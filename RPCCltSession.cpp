@@ -0,0 +1,333 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCCltSession.cpp
+//! \brief  The CltSession class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "RPCCltSession.hpp"
+#include "IRPCResponseHandler.hpp"
+#include "IRPCNotifyHandler.hpp"
+#include "Socket.hpp"
+#include "SocketException.hpp"
+#include "WinSock.hpp"
+
+namespace RPC
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CltSession::CltSession(CSocket& socket)
+	: m_socket(socket)
+	, m_nextID(1)
+	, m_requests()
+	, m_timerID(0)
+	, m_batchDepth(0)
+	, m_outbound()
+	, m_inbound()
+	, m_dispatching(false)
+	, m_lastError(0)
+	, m_notifyHandler(nullptr)
+{
+	ASSERT(m_socket.IsOpen());
+
+	// Disable Nagle so that single requests are not held back.
+	if (m_socket.Protocol() == IPPROTO_TCP)
+	{
+		BOOL noDelay = TRUE;
+
+		::setsockopt(m_socket.Handle(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+	}
+
+	m_socket.AddClientListener(this);
+	m_timerID = CWinSock::StartTimer(this, TIMER_INTERVAL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any outstanding requests are abandoned without notification.
+
+CltSession::~CltSession()
+{
+	CWinSock::StopTimer(m_timerID);
+	m_socket.RemoveClientListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send a request. The handler is invoked when the response arrives, or if the
+//! timeout elapses or connection fails first. The request ID is returned.
+
+DWORD CltSession::Call(WORD method, const void* payload, size_t size, IResponseHandler* handler, DWORD timeout)
+{
+	ASSERT(handler != nullptr);
+
+	DWORD id = m_nextID++;
+
+	// Skip the reserved ID on wrap-around.
+	if (m_nextID == 0)
+		m_nextID = 1;
+
+	Request request = { handler, ::GetTickCount(), timeout };
+
+	appendMessage(m_outbound, REQUEST, id, method, payload, size);
+
+	m_requests.insert(std::make_pair(id, request));
+
+	// Not batching?
+	if (m_batchDepth == 0)
+	{
+		try
+		{
+			m_socket.Send(m_outbound.Ptr(), m_outbound.Size());
+			m_outbound.Clear();
+		}
+		catch (const CSocketException&)
+		{
+			m_outbound.Clear();
+			m_requests.erase(id);
+			throw;
+		}
+	}
+
+	return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Cancel an outstanding request. Any response that arrives later is discarded.
+//! Returns false if the request has already completed.
+
+bool CltSession::Cancel(DWORD id)
+{
+	return (m_requests.erase(id) != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start queueing requests so that they are sent together. Batches can be
+//! nested, the requests are sent when the outermost batch is ended.
+
+void CltSession::BeginBatch()
+{
+	++m_batchDepth;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send any requests queued since BeginBatch().
+
+void CltSession::EndBatch()
+{
+	ASSERT(m_batchDepth != 0);
+
+	if ( (--m_batchDepth == 0) && (!m_outbound.Empty()) )
+	{
+		try
+		{
+			m_socket.Send(m_outbound.Ptr(), m_outbound.Size());
+			m_outbound.Clear();
+		}
+		catch (const CSocketException& e)
+		{
+			m_outbound.Clear();
+			m_lastError = e.m_nWSACode;
+			FailAll(SOCKET_FAILED);
+			throw;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fail any outstanding requests whose timeout has elapsed. This is invoked
+//! periodically by the session timer.
+
+void CltSession::CheckTimeouts()
+{
+	typedef Requests::iterator iter;
+
+	DWORD              now = ::GetTickCount();
+	std::vector<DWORD> expired;
+
+	// Find expired requests, the tick count may wrap.
+	for (iter it = m_requests.begin(); it != m_requests.end(); ++it)
+	{
+		const Request& request = it->second;
+
+		if ((now - request.m_sent) >= request.m_timeout)
+			expired.push_back(it->first);
+	}
+
+	// Remove each one before notifying, as the handler may make another call.
+	for (size_t i = 0; i != expired.size(); ++i)
+	{
+		iter it = m_requests.find(expired[i]);
+
+		if (it == m_requests.end())
+			continue;
+
+		IResponseHandler* handler = it->second.m_handler;
+
+		m_requests.erase(it);
+
+		handler->OnFailed(*this, expired[i], TIMED_OUT);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Complete the request with the response.
+
+void CltSession::OnResponse(const Header& header, const byte* payload)
+{
+	Requests::iterator it = m_requests.find(header.m_id);
+
+	// Cancelled or already timed out?
+	if (it == m_requests.end())
+		return;
+
+	IResponseHandler* handler = it->second.m_handler;
+
+	m_requests.erase(it);
+
+	handler->OnResponse(*this, header.m_id, header.m_code, payload, header.m_length);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fail all outstanding requests.
+
+void CltSession::FailAll(int reason)
+{
+	Requests requests;
+
+	// Detach first, as the handlers may make another call.
+	requests.swap(m_requests);
+
+	for (Requests::const_iterator it = requests.begin(); it != requests.end(); ++it)
+		it->second.m_handler->OnFailed(*this, it->first, reason);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dispatch the complete messages in the receive buffer and discard them.
+//! Returns false if a malformed or unexpected message is found.
+
+bool CltSession::DispatchMessages()
+{
+	size_t consumed = 0;
+	Header header;
+	size_t messageSize;
+
+	for (;;)
+	{
+		const byte* buffer = &m_inbound[0] + consumed;
+		size_t      size   = m_inbound.size() - consumed;
+
+		try
+		{
+			if (!parseMessage(buffer, size, header, messageSize))
+				break;
+		}
+		catch (const CSocketException&)
+		{
+			return false;
+		}
+
+		if (header.m_type == RESPONSE)
+			OnResponse(header, buffer+HEADER_SIZE);
+		else if ( (header.m_type == NOTIFY) && (m_notifyHandler != nullptr) )
+			m_notifyHandler->OnNotify(*this, header.m_code, buffer+HEADER_SIZE, header.m_length);
+		else
+			return false;
+
+		consumed += messageSize;
+	}
+
+	m_inbound.erase(m_inbound.begin(), m_inbound.begin()+consumed);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Close the connection and fail all outstanding requests.
+
+void CltSession::Abort(int reason, int error)
+{
+	m_inbound.clear();
+	m_lastError = error;
+
+	if (m_socket.IsOpen())
+		m_socket.Close();
+
+	FailAll(reason);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle incoming data on the socket. All complete responses are dispatched
+//! from a single copy of the receive buffer. A malformed message fails the
+//! outstanding requests with BAD_MESSAGE, and a socket error with
+//! SOCKET_FAILED.
+
+void CltSession::OnReadReady(CSocket* /*pSocket*/)
+{
+	// Re-entered from a handler? The outer call picks up the data.
+	if (m_dispatching)
+		return;
+
+	m_dispatching = true;
+
+	try
+	{
+		size_t available;
+
+		while ( (m_socket.IsOpen()) && ((available = m_socket.Available()) != 0) )
+		{
+			size_t offset = m_inbound.size();
+
+			m_inbound.resize(offset + available);
+			m_socket.Recv(&m_inbound[offset], available);
+
+			if (!DispatchMessages())
+			{
+				m_dispatching = false;
+				Abort(BAD_MESSAGE, WSAEMSGSIZE);
+				return;
+			}
+		}
+	}
+	catch (const CSocketException& e)
+	{
+		m_dispatching = false;
+		Abort(SOCKET_FAILED, e.m_nWSACode);
+		return;
+	}
+	catch (...)
+	{
+		m_dispatching = false;
+		throw;
+	}
+
+	m_dispatching = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the socket being closed.
+
+void CltSession::OnClosed(CSocket* /*pSocket*/, int /*nReason*/)
+{
+	m_inbound.clear();
+	FailAll(DISCONNECTED);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a socket error.
+
+void CltSession::OnError(CSocket* /*pSocket*/, int /*nEvent*/, int nError)
+{
+	Abort(SOCKET_FAILED, nError);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the timer used to check for expired requests.
+
+void CltSession::OnTimer(uint /*nTimerID*/)
+{
+	if (!m_requests.empty())
+		CheckTimeouts();
+}
+
+//namespace RPC
+}
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCCltSession.hpp
+//! \brief  The CltSession class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_RPCCLTSESSION_HPP
+#define NCL_RPCCLTSESSION_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "IClientSocketListener.hpp"
+#include "ISocketTimerListener.hpp"
+#include "NetBuffer.hpp"
+#include "RPCProtocol.hpp"
+#include <map>
+#include <vector>
+
+namespace RPC
+{
+
+// Forward declarations.
+class IResponseHandler;
+class INotifyHandler;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The client side of an RPC connection. Requests are tagged with an ID so that
+//! any number can be outstanding at once and the responses are matched back to
+//! the caller's handler as they arrive. The socket must be connected and in
+//! ASYNC mode as the session is driven by the socket and timer events. Any
+//! notifications from the server are passed to the notify handler, if one has
+//! not been set a notification is treated as a malformed message.
+
+class CltSession : public IClientSocketListener, public ISocketTimerListener
+{
+public:
+	//! The default request timeout in milliseconds.
+	static const DWORD DEFAULT_TIMEOUT = 30000;
+
+public:
+	//! Constructor.
+	CltSession(CSocket& socket);
+
+	//! Destructor.
+	virtual ~CltSession();
+
+	//
+	// Properties.
+	//
+
+	//! The underlying socket.
+	CSocket& Socket() const;
+
+	//! The number of requests awaiting a response.
+	size_t Outstanding() const;
+
+	//! The WinSock error code that last failed the session.
+	int LastError() const;
+
+	//! Set the handler for server notifications.
+	void SetNotifyHandler(INotifyHandler* handler);
+
+	//
+	// Methods.
+	//
+
+	//! Send a request. The handler is invoked when the response arrives.
+	DWORD Call(WORD method, const void* payload, size_t size, IResponseHandler* handler, DWORD timeout = DEFAULT_TIMEOUT);
+
+	//! Cancel an outstanding request. Any response is discarded.
+	bool Cancel(DWORD id);
+
+	//! Start queueing requests so that they are sent together.
+	void BeginBatch();
+
+	//! Send any requests queued since BeginBatch().
+	void EndBatch();
+
+	//! Fail any outstanding requests whose timeout has elapsed.
+	void CheckTimeouts();
+
+private:
+	//! The state of an outstanding request.
+	struct Request
+	{
+		IResponseHandler*	m_handler;		//!< The completion handler.
+		DWORD				m_sent;			//!< The tick count when sent.
+		DWORD				m_timeout;		//!< The timeout in milliseconds.
+	};
+
+	//! The outstanding requests keyed by ID.
+	typedef std::map<DWORD, Request> Requests;
+
+	//
+	// Members.
+	//
+	CSocket&			m_socket;		//!< The connection.
+	DWORD				m_nextID;		//!< The ID of the next request.
+	Requests			m_requests;		//!< The outstanding requests.
+	uint				m_timerID;		//!< The timeout timer.
+	size_t				m_batchDepth;	//!< The BeginBatch() nesting level.
+	CNetBuffer			m_outbound;		//!< The requests not yet sent.
+	std::vector<byte>	m_inbound;		//!< The responses not yet processed.
+	bool				m_dispatching;	//!< Set whilst invoking handlers.
+	int					m_lastError;	//!< The last socket error.
+	INotifyHandler*		m_notifyHandler;	//!< The notification handler.
+
+	//! The period at which timeouts are checked.
+	static const uint TIMER_INTERVAL = 100;
+
+	//
+	// Internal methods.
+	//
+
+	//! Complete the request with the response.
+	void OnResponse(const Header& header, const byte* payload);
+
+	//! Dispatch the complete messages in the receive buffer.
+	bool DispatchMessages();
+
+	//! Close the connection and fail all outstanding requests.
+	void Abort(int reason, int error);
+
+	//! Fail all outstanding requests.
+	void FailAll(int reason);
+
+	//
+	// IClientSocketListener methods.
+	//
+	virtual void OnReadReady(CSocket* pSocket);
+	virtual void OnClosed(CSocket* pSocket, int nReason);
+	virtual void OnError(CSocket* pSocket, int nEvent, int nError);
+
+	//
+	// ISocketTimerListener methods.
+	//
+	virtual void OnTimer(uint nTimerID);
+
+	// NotCopyable.
+	CltSession(const CltSession&);
+	CltSession& operator=(const CltSession&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The underlying socket.
+
+inline CSocket& CltSession::Socket() const
+{
+	return m_socket;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of requests awaiting a response.
+
+inline size_t CltSession::Outstanding() const
+{
+	return m_requests.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The WinSock error code that last failed the session, or 0 if none has.
+
+inline int CltSession::LastError() const
+{
+	return m_lastError;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the handler for server notifications.
+
+inline void CltSession::SetNotifyHandler(INotifyHandler* handler)
+{
+	m_notifyHandler = handler;
+}
+
+//namespace RPC
+}
+
+#endif // NCL_RPCCLTSESSION_HPP
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCProtocol.cpp
+//! \brief  The RPC message framing definitions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "RPCProtocol.hpp"
+#include "NetBuffer.hpp"
+#include "SocketException.hpp"
+
+namespace RPC
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a 32-bit value in network byte order.
+
+static void writeDWord(byte* buffer, DWORD value)
+{
+	buffer[0] = static_cast<byte>(value >> 24);
+	buffer[1] = static_cast<byte>(value >> 16);
+	buffer[2] = static_cast<byte>(value >>  8);
+	buffer[3] = static_cast<byte>(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a 16-bit value in network byte order.
+
+static void writeWord(byte* buffer, WORD value)
+{
+	buffer[0] = static_cast<byte>(value >> 8);
+	buffer[1] = static_cast<byte>(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a 32-bit value in network byte order.
+
+static DWORD readDWord(const byte* buffer)
+{
+	return (static_cast<DWORD>(buffer[0]) << 24) | (static_cast<DWORD>(buffer[1]) << 16)
+		 | (static_cast<DWORD>(buffer[2]) <<  8) |  static_cast<DWORD>(buffer[3]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a 16-bit value in network byte order.
+
+static WORD readWord(const byte* buffer)
+{
+	return static_cast<WORD>((buffer[0] << 8) | buffer[1]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the header to a buffer of HEADER_SIZE bytes.
+
+void encodeHeader(const Header& header, byte* buffer)
+{
+	ASSERT(buffer != nullptr);
+
+	writeDWord(buffer,   header.m_length);
+	writeDWord(buffer+4, header.m_id);
+	writeWord (buffer+8, header.m_type);
+	writeWord (buffer+10, header.m_code);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the header from a buffer of HEADER_SIZE bytes.
+
+Header decodeHeader(const byte* buffer)
+{
+	ASSERT(buffer != nullptr);
+
+	Header header;
+
+	header.m_length = readDWord(buffer);
+	header.m_id     = readDWord(buffer+4);
+	header.m_type   = readWord (buffer+8);
+	header.m_code   = readWord (buffer+10);
+
+	return header;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a complete message to the buffer. Multiple messages can be appended
+//! to the same buffer so that they are written to the socket together.
+
+void appendMessage(CNetBuffer& buffer, MessageType type, DWORD id, WORD code, const void* payload, size_t size)
+{
+	ASSERT((payload != nullptr) || (size == 0));
+	ASSERT(size <= MAX_PAYLOAD_SIZE);
+
+	Header header = { static_cast<DWORD>(size), id, static_cast<WORD>(type), code };
+	byte   encoded[HEADER_SIZE];
+
+	encodeHeader(header, encoded);
+
+	buffer.Append(encoded, HEADER_SIZE);
+
+	if (size != 0)
+		buffer.Append(payload, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Try and find the next complete message at the start of the buffer. If one
+//! is found the header is decoded and the size of the entire message, header
+//! included, is returned. A header which could never be valid is treated as
+//! a protocol error.
+
+bool parseMessage(const byte* buffer, size_t size, Header& header, size_t& messageSize)
+{
+	ASSERT((buffer != nullptr) || (size == 0));
+
+	// Not enough for the header yet?
+	if (size < HEADER_SIZE)
+		return false;
+
+	Header decoded = decodeHeader(buffer);
+
+	if ( (decoded.m_length > MAX_PAYLOAD_SIZE)
+	  || ((decoded.m_type != REQUEST) && (decoded.m_type != RESPONSE) && (decoded.m_type != NOTIFY)) )
+	{
+		throw CSocketException(CSocketException::E_BAD_PROTOCOL, WSAEMSGSIZE);
+	}
+
+	// Not enough for the payload yet?
+	if ((size - HEADER_SIZE) < decoded.m_length)
+		return false;
+
+	header      = decoded;
+	messageSize = HEADER_SIZE + decoded.m_length;
+
+	return true;
+}
+
+//namespace RPC
+}
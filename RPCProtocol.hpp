@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCProtocol.hpp
+//! \brief  The RPC message framing declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_RPCPROTOCOL_HPP
+#define NCL_RPCPROTOCOL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+class CNetBuffer;
+
+namespace RPC
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The types of message carried by the protocol.
+
+enum MessageType
+{
+	REQUEST		= 1,		//!< A request from the client.
+	RESPONSE	= 2,		//!< The server's response to a request.
+	NOTIFY		= 3,		//!< A one-way message from the server.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The response status codes reserved by the protocol. Handlers may use any
+//! other value for their own application level status codes.
+
+enum Status
+{
+	OK				= 0x0000,	//!< The request succeeded.
+	UNKNOWN_METHOD	= 0xFFFE,	//!< The method is not supported.
+	HANDLER_FAILED	= 0xFFFF,	//!< The handler threw an exception.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The reasons passed to a response handler when a call fails.
+
+enum FailureReason
+{
+	TIMED_OUT		= 1,		//!< No response arrived within the timeout.
+	DISCONNECTED	= 2,		//!< The connection was closed or failed.
+	BAD_MESSAGE		= 3,		//!< A malformed message was received.
+	SOCKET_FAILED	= 4,		//!< The socket failed, see CltSession::LastError().
+};
+
+//! The size of the message header on the wire.
+const size_t HEADER_SIZE = 12;
+
+//! The largest payload accepted in a single message.
+const size_t MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The fixed size header which prefixes every message. All fields are sent in
+//! network byte order. The code is the method for a request, the status for a
+//! response and the notification type for a notification, which has no ID.
+
+struct Header
+{
+	DWORD	m_length;		//!< The size of the payload that follows.
+	DWORD	m_id;			//!< The request ID used to match the response.
+	WORD	m_type;			//!< The MessageType.
+	WORD	m_code;			//!< The method or status code.
+};
+
+//! Write the header to a buffer of HEADER_SIZE bytes.
+void encodeHeader(const Header& header, byte* buffer);
+
+//! Read the header from a buffer of HEADER_SIZE bytes.
+Header decodeHeader(const byte* buffer);
+
+//! Append a complete message to the buffer.
+void appendMessage(CNetBuffer& buffer, MessageType type, DWORD id, WORD code, const void* payload, size_t size);
+
+//! Try and find the next complete message at the start of the buffer.
+bool parseMessage(const byte* buffer, size_t size, Header& header, size_t& messageSize);
+
+//namespace RPC
+}
+
+#endif // NCL_RPCPROTOCOL_HPP
@@ -0,0 +1,271 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCSvrDispatcher.cpp
+//! \brief  The SvrDispatcher class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "RPCSvrDispatcher.hpp"
+#include "IRPCRequestHandler.hpp"
+#include "RPCProtocol.hpp"
+#include "TCPSvrSocket.hpp"
+#include "TCPCltSocket.hpp"
+#include "SocketException.hpp"
+
+namespace RPC
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+SvrDispatcher::SvrDispatcher(CTCPSvrSocket& socket, IRequestHandler& handler)
+	: m_socket(socket)
+	, m_handler(handler)
+	, m_clients()
+	, m_closed()
+	, m_response()
+	, m_outbound()
+	, m_notify()
+{
+	m_socket.AddServerListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+SvrDispatcher::~SvrDispatcher()
+{
+	m_socket.RemoveServerListener(this);
+
+	CloseClients();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Close all client connections.
+
+void SvrDispatcher::CloseClients()
+{
+	Clients clients;
+
+	// A handler may close a client whilst being notified.
+	clients.swap(m_clients);
+
+	for (Clients::const_iterator it = clients.begin(); it != clients.end(); ++it)
+	{
+		CTCPCltSocket* socket = it->second->m_socket.get();
+
+		socket->RemoveClientListener(this);
+		socket->Close();
+
+		m_handler.OnClientClosed(*socket);
+	}
+
+	m_closed.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Close a client connection. The handler is notified as if the client had
+//! closed it.
+
+void SvrDispatcher::CloseClient(CSocket& client)
+{
+	RemoveClient(&client);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send a one-way notification to a client. It is written immediately, so if
+//! sent from inside a request handler it will arrive before the response.
+
+void SvrDispatcher::Notify(CSocket& client, WORD code, const void* payload, size_t size)
+{
+	ASSERT(m_clients.find(&client) != m_clients.end());
+
+	m_notify.Clear();
+
+	appendMessage(m_notify, NOTIFY, 0, code, payload, size);
+
+	client.Send(m_notify.Ptr(), m_notify.Size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Process all complete requests from the client. The responses are appended
+//! to a single buffer so that a pipelined batch is answered with one write.
+//! A handler may close the client socket, in which case the requests that
+//! remain and the responses are discarded.
+
+void SvrDispatcher::ProcessRequests(Client& client)
+{
+	CSocket&           socket  = *client.m_socket;
+	std::vector<byte>& inbound = client.m_inbound;
+	size_t             available;
+
+	while ( (socket.IsOpen()) && ((available = socket.Available()) != 0) )
+	{
+		size_t offset = inbound.size();
+
+		inbound.resize(offset + available);
+		socket.Recv(&inbound[offset], available);
+
+		const byte* buffer   = &inbound[0];
+		size_t      size     = inbound.size();
+		size_t      consumed = 0;
+		Header      header;
+		size_t      messageSize;
+
+		while ( (socket.IsOpen()) && (parseMessage(buffer+consumed, size-consumed, header, messageSize)) )
+		{
+			if (header.m_type == REQUEST)
+			{
+				WORD status = HANDLER_FAILED;
+
+				m_response.Clear();
+
+				try
+				{
+					status = m_handler.OnRequest(socket, header.m_code, buffer+consumed+HEADER_SIZE, header.m_length, m_response);
+				}
+				catch (const Core::Exception& e)
+				{
+					TRACE1(TXT("RPC request handler threw: %s\n"), e.twhat());
+					DEBUG_USE_ONLY(e);
+					m_response.Clear();
+				}
+				catch (const std::exception& e)
+				{
+					TRACE1(TXT("RPC request handler threw: %hs\n"), e.what());
+					DEBUG_USE_ONLY(e);
+					m_response.Clear();
+				}
+
+				appendMessage(m_outbound, RESPONSE, header.m_id, status, m_response.Ptr(), m_response.Size());
+			}
+
+			consumed += messageSize;
+		}
+
+		inbound.erase(inbound.begin(), inbound.begin()+consumed);
+	}
+
+	// Closed by a handler?
+	if (!socket.IsOpen())
+	{
+		m_outbound.Clear();
+		return;
+	}
+
+	if (!m_outbound.Empty())
+	{
+		socket.Send(m_outbound.Ptr(), m_outbound.Size());
+		m_outbound.Clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the client. The socket object is not destroyed here as we are likely
+//! to be inside one of its callbacks.
+
+void SvrDispatcher::RemoveClient(CSocket* socket)
+{
+	Clients::iterator it = m_clients.find(socket);
+
+	if (it == m_clients.end())
+		return;
+
+	socket->RemoveClientListener(this);
+
+	if (socket->IsOpen())
+		socket->Close();
+
+	m_handler.OnClientClosed(*socket);
+
+	m_closed.push_back(it->second);
+	m_clients.erase(it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destroy clients that have been closed.
+
+void SvrDispatcher::PurgeClosed()
+{
+	m_closed.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a client connection request.
+
+void SvrDispatcher::OnAcceptReady(CTCPSvrSocket* pSocket)
+{
+	PurgeClosed();
+
+	ClientPtr client(new Client);
+
+	client->m_socket = SocketPtr(pSocket->Accept());
+
+	CTCPCltSocket* socket = client->m_socket.get();
+
+	// Disable Nagle so that responses are not held back.
+	if (socket->Protocol() == IPPROTO_TCP)
+	{
+		BOOL noDelay = TRUE;
+
+		::setsockopt(socket->Handle(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+	}
+
+	m_clients.insert(std::make_pair(socket, client));
+	socket->AddClientListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle incoming data from a client.
+
+void SvrDispatcher::OnReadReady(CSocket* pSocket)
+{
+	PurgeClosed();
+
+	Clients::iterator it = m_clients.find(pSocket);
+
+	if (it == m_clients.end())
+		return;
+
+	// Keep the client alive whilst processing.
+	ClientPtr client = it->second;
+
+	try
+	{
+		ProcessRequests(*client);
+	}
+	catch (const CSocketException& e)
+	{
+		TRACE1(TXT("RPC client dropped: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+		m_outbound.Clear();
+		RemoveClient(pSocket);
+		return;
+	}
+
+	// Closed by a handler?
+	if (!client->m_socket->IsOpen())
+		RemoveClient(pSocket);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a socket being closed.
+
+void SvrDispatcher::OnClosed(CSocket* pSocket, int /*nReason*/)
+{
+	if (pSocket == &m_socket)
+		CloseClients();
+	else
+		RemoveClient(pSocket);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a socket error.
+
+void SvrDispatcher::OnError(CSocket* pSocket, int /*nEvent*/, int /*nError*/)
+{
+	if (pSocket != &m_socket)
+		RemoveClient(pSocket);
+}
+
+//namespace RPC
+}
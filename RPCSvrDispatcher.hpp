@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCSvrDispatcher.hpp
+//! \brief  The SvrDispatcher class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_RPCSVRDISPATCHER_HPP
+#define NCL_RPCSVRDISPATCHER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "IServerSocketListener.hpp"
+#include "IClientSocketListener.hpp"
+#include "NetBuffer.hpp"
+#include <Core/SharedPtr.hpp>
+#include <map>
+#include <vector>
+
+// Forward declarations.
+class CTCPCltSocket;
+
+namespace RPC
+{
+
+// Forward declarations.
+class IRequestHandler;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The server side of an RPC connection. Client connections are accepted from
+//! the listening socket and their requests passed to the handler. All of the
+//! responses to the requests read in one go are written back together. The
+//! listening socket must be in ASYNC mode.
+
+class SvrDispatcher : public IServerSocketListener, public IClientSocketListener
+{
+public:
+	//! Constructor.
+	SvrDispatcher(CTCPSvrSocket& socket, IRequestHandler& handler);
+
+	//! Destructor.
+	virtual ~SvrDispatcher();
+
+	//
+	// Properties.
+	//
+
+	//! The number of connected clients.
+	size_t ClientCount() const;
+
+	//
+	// Methods.
+	//
+
+	//! Close all client connections.
+	void CloseClients();
+
+	//! Close a client connection.
+	void CloseClient(CSocket& client);
+
+	//! Send a one-way notification to a client.
+	void Notify(CSocket& client, WORD code, const void* payload, size_t size);
+
+private:
+	//! The client socket smart-pointer type.
+	typedef Core::SharedPtr<CTCPCltSocket> SocketPtr;
+
+	//! The state of a client connection.
+	struct Client
+	{
+		SocketPtr			m_socket;		//!< The connection.
+		std::vector<byte>	m_inbound;		//!< The requests not yet processed.
+	};
+
+	//! The client smart-pointer type.
+	typedef Core::SharedPtr<Client> ClientPtr;
+	//! The connected clients keyed by socket.
+	typedef std::map<CSocket*, ClientPtr> Clients;
+	//! The collection of closed clients.
+	typedef std::vector<ClientPtr> ClosedClients;
+
+	//
+	// Members.
+	//
+	CTCPSvrSocket&		m_socket;		//!< The listening socket.
+	IRequestHandler&	m_handler;		//!< The request handler.
+	Clients				m_clients;		//!< The connected clients.
+	ClosedClients		m_closed;		//!< Clients awaiting destruction.
+	CNetBuffer			m_response;		//!< The current response payload.
+	CNetBuffer			m_outbound;		//!< The responses not yet sent.
+	CNetBuffer			m_notify;		//!< The notification being sent.
+
+	//
+	// Internal methods.
+	//
+
+	//! Process all complete requests from the client.
+	void ProcessRequests(Client& client);
+
+	//! Remove the client, its destruction is deferred.
+	void RemoveClient(CSocket* socket);
+
+	//! Destroy clients that have been closed.
+	void PurgeClosed();
+
+	//
+	// IServerSocketListener methods.
+	//
+	virtual void OnAcceptReady(CTCPSvrSocket* pSocket);
+
+	//
+	// IClientSocketListener & IServerSocketListener methods.
+	//
+	virtual void OnReadReady(CSocket* pSocket);
+	virtual void OnClosed(CSocket* pSocket, int nReason);
+	virtual void OnError(CSocket* pSocket, int nEvent, int nError);
+
+	// NotCopyable.
+	SvrDispatcher(const SvrDispatcher&);
+	SvrDispatcher& operator=(const SvrDispatcher&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The number of connected clients.
+
+inline size_t SvrDispatcher::ClientCount() const
+{
+	return m_clients.size();
+}
+
+//namespace RPC
+}
+
+#endif // NCL_RPCSVRDISPATCHER_HPP
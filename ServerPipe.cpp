@@ -42,6 +42,7 @@ const DWORD CServerPipe::DEF_BUF_SIZE  = 4096;
 */
 
 CServerPipe::CServerPipe()
+	: m_bConnected(false)
 {
 }
 
@@ -67,7 +68,8 @@ CServerPipe::~CServerPipe()
 **
 ** Description:	Create an instance of the named pipe.
 **
-** Parameters:	pszName		The pipes' name.
+** Parameters:	pszName			The pipes' name.
+**				bFirstInstance	Fail if the pipe already exists?
 **
 ** Returns:		Nothing.
 **
@@ -76,7 +78,7 @@ CServerPipe::~CServerPipe()
 *******************************************************************************
 */
 
-void CServerPipe::Create(const tchar* pszName)
+void CServerPipe::Create(const tchar* pszName, bool bFirstInstance)
 {
 	SECURITY_DESCRIPTOR* pSecDescriptor = (SECURITY_DESCRIPTOR*) alloca(SECURITY_DESCRIPTOR_MIN_LENGTH);
 
@@ -107,7 +109,7 @@ void CServerPipe::Create(const tchar* pszName)
 		throw CPipeException(CPipeException::E_CREATE_FAILED, ::GetLastError());
 
 	// Already exists?
-	if (::GetLastError() == ERROR_ALREADY_EXISTS)
+	if ( (bFirstInstance) && (::GetLastError() == ERROR_ALREADY_EXISTS) )
 	{
 		Close();
 		throw CPipeException(CPipeException::E_CREATE_FAILED, ERROR_ALREADY_EXISTS);
@@ -117,8 +119,13 @@ void CServerPipe::Create(const tchar* pszName)
 	BOOL bResult = ::ConnectNamedPipe(m_hPipe, &m_oReadIO);
 
 	// Connection already established?
+	// NB: No overlapped operation was started so the event must be set by hand.
 	if ( (bResult == FALSE) && (::GetLastError() == ERROR_PIPE_CONNECTED) )
-		bResult = TRUE;
+	{
+		m_bConnected = true;
+		m_oReadEvent.Signal();
+		return;
+	}
 
 	// Error occurred?
 	if ( (bResult == FALSE) && (::GetLastError() != ERROR_IO_PENDING) )
@@ -143,6 +150,10 @@ bool CServerPipe::Accept()
 {
 	ASSERT(m_hPipe != INVALID_HANDLE_VALUE);
 
+	// Connected before the overlapped connect was posted?
+	if (m_bConnected)
+		return true;
+
 	DWORD dwRead;
 
 	// Connection accepted?
@@ -172,5 +183,7 @@ void CServerPipe::Close()
 	if (m_hPipe != INVALID_HANDLE_VALUE)
 		::DisconnectNamedPipe(m_hPipe);
 
+	m_bConnected = false;
+
 	CNamedPipe::Close();
 }
@@ -37,8 +37,9 @@ public:
 	//
 	// Methods.
 	//
-	void Create(const tchar* pszName);
+	void Create(const tchar* pszName, bool bFirstInstance = true);
 	bool Accept();
+	HANDLE AcceptEvent() const;	// Signalled when a client connects.
 
 	virtual void Close();
 
@@ -46,6 +47,7 @@ protected:
 	//
 	// Members.
 	//
+	bool		m_bConnected;	// Client connected before Accept()?
 
 	//
 	// Constants.
@@ -62,4 +64,9 @@ protected:
 *******************************************************************************
 */
 
+inline HANDLE CServerPipe::AcceptEvent() const
+{
+	return m_oReadEvent.Handle();
+}
+
 #endif // SERVERPIPE_HPP
@@ -0,0 +1,186 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		SERVERPIPEPOOL.CPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	CServerPipePool class definition.
+**
+*******************************************************************************
+*/
+
+#include "Common.hpp"
+#include "ServerPipePool.hpp"
+#include "PipeException.hpp"
+#include <algorithm>
+
+/******************************************************************************
+**
+** Constants.
+**
+*******************************************************************************
+*/
+
+const size_t CServerPipePool::DEF_INSTANCES;
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	.
+**
+** Parameters:	nInstances	The number of instances to keep waiting. This is
+**							clamped to 1..MAXIMUM_WAIT_OBJECTS as Accept()
+**							waits on all of them at once.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CServerPipePool::CServerPipePool(size_t nInstances)
+	: m_strName()
+	, m_nInstances(std::min<size_t>(std::max<size_t>(nInstances, 1), MAXIMUM_WAIT_OBJECTS))
+	, m_aoPipes()
+{
+}
+
+/******************************************************************************
+** Method:		Destructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CServerPipePool::~CServerPipePool()
+{
+	Close();
+}
+
+/******************************************************************************
+** Method:		Create()
+**
+** Description:	Create the pipe instances and post a connection on each.
+**
+** Parameters:	pszName		The pipes' name.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CServerPipePool::Create(const tchar* pszName)
+{
+	ASSERT(m_aoPipes.empty());
+
+	m_strName = pszName;
+
+	try
+	{
+		for (size_t i = 0; i != m_nInstances; ++i)
+			m_aoPipes.push_back(CreateInstance(i == 0));
+	}
+	catch (const CPipeException&)
+	{
+		Close();
+		throw;
+	}
+}
+
+/******************************************************************************
+** Method:		Accept()
+**
+** Description:	Wait for a client to connect to any of the instances. The
+**				connected instance is replaced before it is returned so that
+**				the pool is never short of waiting instances.
+**
+** Parameters:	dwTimeOut	The time to wait, in ms.
+**
+** Returns:		The connected pipe or an empty pointer if timed-out.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+CServerPipePool::ServerPipePtr CServerPipePool::Accept(DWORD dwTimeOut)
+{
+	ASSERT(!m_aoPipes.empty());
+
+	HANDLE ahEvents[MAXIMUM_WAIT_OBJECTS];
+	DWORD  dwCount = static_cast<DWORD>(m_aoPipes.size());
+
+	for (DWORD i = 0; i != dwCount; ++i)
+		ahEvents[i] = m_aoPipes[i]->AcceptEvent();
+
+	DWORD dwResult = ::WaitForMultipleObjects(dwCount, ahEvents, FALSE, dwTimeOut);
+
+	// Timed out?
+	if (dwResult == WAIT_TIMEOUT)
+		return ServerPipePtr();
+
+	if (dwResult >= (WAIT_OBJECT_0 + dwCount))
+		throw CPipeException(CPipeException::E_ACCEPT_FAILED, ::GetLastError());
+
+	size_t        nIndex = dwResult - WAIT_OBJECT_0;
+	ServerPipePtr pPipe  = m_aoPipes[nIndex];
+
+	// Create the replacement first, so that the pipe name never lapses and a
+	// failure leaves the pool intact. It goes to the back so that the instances
+	// earlier in the wait list can't starve the later ones.
+	ServerPipePtr pReplacement = CreateInstance(false);
+
+	m_aoPipes.push_back(pReplacement);
+	m_aoPipes.erase(m_aoPipes.begin() + nIndex);
+
+	// Connection failed?
+	if (!pPipe->Accept())
+		return ServerPipePtr();
+
+	return pPipe;
+}
+
+/******************************************************************************
+** Method:		Close()
+**
+** Description:	Close all the waiting instances.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CServerPipePool::Close()
+{
+	m_aoPipes.clear();
+}
+
+/******************************************************************************
+** Method:		CreateInstance()
+**
+** Description:	Create a single pipe instance with a connection posted.
+**
+** Parameters:	bFirstInstance	Fail if the pipe already exists?
+**
+** Returns:		The pipe instance.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+CServerPipePool::ServerPipePtr CServerPipePool::CreateInstance(bool bFirstInstance)
+{
+	ServerPipePtr pPipe(new CServerPipe);
+
+	pPipe->Create(m_strName.c_str(), bFirstInstance);
+
+	return pPipe;
+}
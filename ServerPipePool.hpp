@@ -0,0 +1,109 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		SERVERPIPEPOOL.HPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	The CServerPipePool class declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef SERVERPIPEPOOL_HPP
+#define SERVERPIPEPOOL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "ServerPipe.hpp"
+#include <Core/SharedPtr.hpp>
+#include <vector>
+
+/******************************************************************************
+**
+** A pool of server Named Pipe instances waiting for clients. Each instance
+** has a connection posted so that a burst of clients can connect at the same
+** time. When a client connects the instance is handed to the caller and a
+** replacement is created in its place.
+**
+*******************************************************************************
+*/
+
+class CServerPipePool /*: private NotCopyable*/
+{
+public:
+	//! The server pipe smart-pointer type.
+	typedef Core::SharedPtr<CServerPipe> ServerPipePtr;
+
+	//
+	// Constructors/Destructor.
+	//
+	CServerPipePool(size_t nInstances = DEF_INSTANCES);
+	~CServerPipePool();
+
+	//
+	// Properties.
+	//
+	const CString& Name() const;
+	size_t         Instances() const;
+	bool           IsOpen() const;
+
+	//
+	// Methods.
+	//
+	void Create(const tchar* pszName);
+	ServerPipePtr Accept(DWORD dwTimeOut);
+
+	void Close();
+
+	//
+	// Constants.
+	//
+	static const size_t DEF_INSTANCES = 4;
+
+protected:
+	//! The collection of pipe instances.
+	typedef std::vector<ServerPipePtr> ServerPipes;
+
+	//
+	// Members.
+	//
+	CString		m_strName;		// The pipe name.
+	size_t		m_nInstances;	// The number of instances waiting.
+	ServerPipes	m_aoPipes;		// The pipe instances.
+
+	//
+	// Internal methods.
+	//
+	ServerPipePtr CreateInstance(bool bFirstInstance);
+
+private:
+	// NotCopyable.
+	CServerPipePool(const CServerPipePool&);
+	CServerPipePool& operator=(const CServerPipePool&);
+};
+
+/******************************************************************************
+**
+** Implementation of inline functions.
+**
+*******************************************************************************
+*/
+
+inline const CString& CServerPipePool::Name() const
+{
+	return m_strName;
+}
+
+inline size_t CServerPipePool::Instances() const
+{
+	return m_nInstances;
+}
+
+inline bool CServerPipePool::IsOpen() const
+{
+	return !m_aoPipes.empty();
+}
+
+#endif // SERVERPIPEPOOL_HPP
@@ -0,0 +1,818 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		SHAREDMEMPIPE.CPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	CSharedMemPipe class definition.
+**
+*******************************************************************************
+*/
+
+#include "Common.hpp"
+#include "SharedMemPipe.hpp"
+#include "PipeException.hpp"
+#include <Core/StringUtils.hpp>
+#include <string.h>
+#include <algorithm>
+
+/******************************************************************************
+**
+** Constants.
+**
+*******************************************************************************
+*/
+
+const size_t CSharedMemPipe::DEF_CAPACITY;
+const DWORD  CSharedMemPipe::DEF_TIMEOUT  = 30000;
+const DWORD  CSharedMemPipe::DEF_INTERVAL = 10;
+
+// The size of a cache line, to avoid false sharing.
+static const size_t CACHE_LINE = 64;
+
+// Identifies the shared memory layout.
+static const DWORD LAYOUT_MAGIC = 0x4E434C31;	// "NCL1"
+
+// The size of the length prefix on each message.
+static const DWORD PREFIX_SIZE = sizeof(DWORD);
+
+// The time-out value which means wait forever.
+static const DWORD INFINITE_TIMEOUT = 0xFFFFFFFF;
+
+// The error codes.
+static const HRESULT ERR_TIMED_OUT = WAIT_TIMEOUT;
+static const HRESULT ERR_BROKEN    = ERROR_BROKEN_PIPE;
+static const HRESULT ERR_TOO_BIG   = ERROR_MORE_DATA;
+
+/******************************************************************************
+**
+** The shared memory layout. The header is followed by the ring positions for
+** each direction and then each ring buffer. Ring 0 is written by the creator
+** and ring 1 by the other end. The positions are free running counters which
+** are masked to index the buffer.
+**
+*******************************************************************************
+*/
+
+struct CSharedMemPipe::SharedHeader
+{
+	DWORD			m_dwMagic;			// LAYOUT_MAGIC.
+	DWORD			m_dwCapacity;		// Ring buffer size, a power of 2.
+	volatile DWORD	m_dwClosed;			// Either end closed?
+	byte			m_abPad[CACHE_LINE - 3*sizeof(DWORD)];
+};
+
+struct CSharedMemPipe::RingHeader
+{
+	volatile DWORD	m_dwHead;			// Write position, owned by the producer.
+	byte			m_abPad1[CACHE_LINE - sizeof(DWORD)];
+	volatile DWORD	m_dwTail;			// Read position, owned by the consumer.
+	byte			m_abPad2[CACHE_LINE - sizeof(DWORD)];
+	volatile DWORD	m_dwReaderParked;	// Consumer waiting for data?
+	byte			m_abPad3[CACHE_LINE - sizeof(DWORD)];
+	volatile DWORD	m_dwWriterParked;	// Producer waiting for space?
+	byte			m_abPad4[CACHE_LINE - sizeof(DWORD)];
+};
+
+/******************************************************************************
+**
+** Local functions.
+**
+*******************************************************************************
+*/
+
+// Read a value written by the other end.
+static inline DWORD LoadAcquire(const volatile DWORD* pValue)
+{
+#ifdef __GNUC__
+	return __atomic_load_n(pValue, __ATOMIC_ACQUIRE);
+#else
+	DWORD dwValue = *pValue;
+	_ReadWriteBarrier();
+	return dwValue;
+#endif
+}
+
+// Publish a value to the other end.
+static inline void StoreRelease(volatile DWORD* pValue, DWORD dwValue)
+{
+#ifdef __GNUC__
+	__atomic_store_n(pValue, dwValue, __ATOMIC_RELEASE);
+#else
+	_ReadWriteBarrier();
+	*pValue = dwValue;
+#endif
+}
+
+// Publish a value, which is ordered before any later loads.
+static inline void StoreFence(volatile DWORD* pValue, DWORD dwValue)
+{
+#ifdef __GNUC__
+	__atomic_store_n(pValue, dwValue, __ATOMIC_SEQ_CST);
+#else
+	::InterlockedExchange(reinterpret_cast<volatile LONG*>(pValue), dwValue);
+#endif
+}
+
+// Order the previous stores before any later loads.
+static inline void FullFence()
+{
+#ifdef __GNUC__
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+	::MemoryBarrier();
+#endif
+}
+
+// Get the time in ms, for measuring time-outs.
+static DWORD TickCount()
+{
+	return ::GetTickCount();
+}
+
+// Calculate the time left before a time-out.
+static DWORD TimeLeft(DWORD dwStart, DWORD dwTimeOut)
+{
+	if (dwTimeOut == INFINITE_TIMEOUT)
+		return INFINITE_TIMEOUT;
+
+	DWORD dwElapsed = TickCount() - dwStart;
+
+	return (dwElapsed < dwTimeOut) ? (dwTimeOut - dwElapsed) : 0;
+}
+
+// Calculate the ring space used by a message.
+static inline DWORD RecordSize(size_t nSize)
+{
+	// Keep the length prefix aligned so that it never wraps.
+	return static_cast<DWORD>((PREFIX_SIZE + nSize + (PREFIX_SIZE-1)) & ~(PREFIX_SIZE-1));
+}
+
+// Copy data into the ring, wrapping at the end.
+static void CopyIn(byte* pRing, DWORD dwMask, DWORD dwPos, const void* pData, size_t nSize)
+{
+	size_t nOffset = dwPos & dwMask;
+	size_t nFirst  = std::min<size_t>(nSize, (dwMask + 1) - nOffset);
+
+	memcpy(pRing + nOffset, pData, nFirst);
+	memcpy(pRing, static_cast<const byte*>(pData) + nFirst, nSize - nFirst);
+}
+
+// Copy data out of the ring, wrapping at the end.
+static void CopyOut(const byte* pRing, DWORD dwMask, DWORD dwPos, void* pData, size_t nSize)
+{
+	size_t nOffset = dwPos & dwMask;
+	size_t nFirst  = std::min<size_t>(nSize, (dwMask + 1) - nOffset);
+
+	memcpy(pData, pRing + nOffset, nFirst);
+	memcpy(static_cast<byte*>(pData) + nFirst, pRing, nSize - nFirst);
+}
+
+// Create, or open, one of the named wake-up events.
+static HANDLE CreateWakeEvent(const CString& strName, size_t nRing, const tchar* pszType)
+{
+	CString strEvent = Core::fmt(TXT("%s.%u.%s"), strName.c_str(), static_cast<uint>(nRing), pszType);
+
+	HANDLE hEvent = ::CreateEvent(nullptr, FALSE, FALSE, strEvent.c_str());
+
+	if (hEvent == NULL)
+		throw CPipeException(CPipeException::E_CREATE_FAILED, ::GetLastError());
+
+	return hEvent;
+}
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CSharedMemPipe::CSharedMemPipe()
+	: m_strName()
+	, m_bCreator(false)
+	, m_hMapping(NULL)
+	, m_pView(nullptr)
+	, m_nViewSize(0)
+	, m_pHeader(nullptr)
+	, m_dwMask(0)
+	, m_oInbound()
+	, m_oOutbound()
+	, m_dwTimeOut(DEF_TIMEOUT)
+{
+}
+
+/******************************************************************************
+** Method:		Destructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CSharedMemPipe::~CSharedMemPipe()
+{
+	Close();
+}
+
+/******************************************************************************
+** Method:		Create()
+**
+** Description:	Create the shared memory for the pipe.
+**
+** Parameters:	pszName		The pipes' name.
+**				nCapacity	The size of the buffer for each direction. This is
+**							rounded up to a power of 2.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Create(const tchar* pszName, size_t nCapacity)
+{
+	ASSERT(m_pView == nullptr);
+	ASSERT(nCapacity != 0);
+
+	size_t nRingSize = CACHE_LINE;
+
+	while (nRingSize < nCapacity)
+		nRingSize *= 2;
+
+	m_strName   = pszName;
+	m_bCreator  = true;
+	m_nViewSize = sizeof(SharedHeader) + (2 * sizeof(RingHeader)) + (2 * nRingSize);
+
+	// Reset error flag, to detect ERROR_ALREADY_EXISTS.
+	::SetLastError(NO_ERROR);
+
+	m_hMapping = ::CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+										0, static_cast<DWORD>(m_nViewSize), pszName);
+
+	if (m_hMapping == NULL)
+		throw CPipeException(CPipeException::E_CREATE_FAILED, ::GetLastError());
+
+	// Already exists?
+	if (::GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		Close();
+		throw CPipeException(CPipeException::E_CREATE_FAILED, ERROR_ALREADY_EXISTS);
+	}
+
+	m_pView = ::MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+	if (m_pView == nullptr)
+	{
+		HRESULT hResult = ::GetLastError();
+
+		Close();
+		throw CPipeException(CPipeException::E_CREATE_FAILED, hResult);
+	}
+
+	try
+	{
+		Map(nRingSize, true);
+	}
+	catch (const CPipeException&)
+	{
+		Close();
+		throw;
+	}
+}
+
+/******************************************************************************
+** Method:		Open()
+**
+** Description:	Open the other end of an existing pipe. The open is retried,
+**				every DEF_INTERVAL ms, until the pipe has been created.
+**
+** Parameters:	pszName		The pipes' name.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Open(const tchar* pszName)
+{
+	ASSERT(m_pView == nullptr);
+
+	DWORD dwStart = TickCount();
+
+	m_strName  = pszName;
+	m_bCreator = false;
+
+	// Wait for the other end to create it.
+	while (!OpenMapping())
+	{
+		if (TimeLeft(dwStart, m_dwTimeOut) == 0)
+			throw CPipeException(CPipeException::E_OPEN_FAILED, ERR_TIMED_OUT);
+
+		::Sleep(DEF_INTERVAL);
+	}
+
+	try
+	{
+		Map(m_pHeader->m_dwCapacity, false);
+	}
+	catch (const CPipeException&)
+	{
+		Close();
+		throw;
+	}
+}
+
+/******************************************************************************
+** Method:		OpenMapping()
+**
+** Description:	Try and map the shared memory created by the other end.
+**
+** Parameters:	None.
+**
+** Returns:		true if mapped or false if not yet created.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+bool CSharedMemPipe::OpenMapping()
+{
+	m_hMapping = ::OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, m_strName.c_str());
+
+	if (m_hMapping == NULL)
+	{
+		if (::GetLastError() == ERROR_FILE_NOT_FOUND)
+			return false;
+
+		throw CPipeException(CPipeException::E_OPEN_FAILED, ::GetLastError());
+	}
+
+	MEMORY_BASIC_INFORMATION oInfo;
+
+	m_pView = ::MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+	if ( (m_pView == nullptr) || (::VirtualQuery(m_pView, &oInfo, sizeof(oInfo)) == 0) )
+	{
+		HRESULT hResult = ::GetLastError();
+
+		Close();
+		throw CPipeException(CPipeException::E_OPEN_FAILED, hResult);
+	}
+
+	m_nViewSize = oInfo.RegionSize;
+
+	SharedHeader* pHeader = static_cast<SharedHeader*>(m_pView);
+	DWORD         dwMagic = (m_nViewSize >= sizeof(SharedHeader)) ? LoadAcquire(&pHeader->m_dwMagic) : 0;
+
+	// Not initialised yet?
+	if ( (dwMagic == 0) && (m_nViewSize >= sizeof(SharedHeader)) )
+	{
+		Close();
+		return false;
+	}
+
+	// Not one of ours?
+	if (dwMagic != LAYOUT_MAGIC)
+	{
+		Close();
+		throw CPipeException(CPipeException::E_BAD_PROTOCOL, 0);
+	}
+
+	m_pHeader = pHeader;
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		Map()
+**
+** Description:	Locate the pipe structures in the shared memory.
+**
+** Parameters:	nCapacity	The ring buffer size.
+**				bInitialise	Initialise the shared memory?
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Map(size_t nCapacity, bool bInitialise)
+{
+	byte*        pView  = static_cast<byte*>(m_pView);
+	const size_t nFixed = sizeof(SharedHeader) + (2 * sizeof(RingHeader));
+
+	// Header too small for the rings?
+	if (m_nViewSize < nFixed)
+		throw CPipeException(CPipeException::E_BAD_PROTOCOL, 0);
+
+	// Capacity not a power of 2, or the rings don't fit in the mapping? When
+	// opening, this comes from the other process, so it can't be trusted.
+	if ( (nCapacity == 0) || ((nCapacity & (nCapacity - 1)) != 0)
+	  || (nCapacity > ((m_nViewSize - nFixed) / 2)) )
+		throw CPipeException(CPipeException::E_BAD_PROTOCOL, 0);
+
+	m_pHeader = reinterpret_cast<SharedHeader*>(pView);
+	m_dwMask  = static_cast<DWORD>(nCapacity - 1);
+
+	RingHeader* pRings = reinterpret_cast<RingHeader*>(pView + sizeof(SharedHeader));
+	byte*       pData  = pView + nFixed;
+	size_t      nIn    = (m_bCreator) ? 1 : 0;
+	size_t      nOut   = (m_bCreator) ? 0 : 1;
+
+	m_oInbound.m_pHeader  = pRings + nIn;
+	m_oInbound.m_pData    = pData + (nIn * nCapacity);
+	m_oOutbound.m_pHeader = pRings + nOut;
+	m_oOutbound.m_pData   = pData + (nOut * nCapacity);
+
+	OpenRing(m_oInbound, nIn);
+	OpenRing(m_oOutbound, nOut);
+
+	if (bInitialise)
+	{
+		memset(pView, 0, nFixed);
+
+		m_pHeader->m_dwCapacity = static_cast<DWORD>(nCapacity);
+
+		// Publish last.
+		StoreFence(&m_pHeader->m_dwMagic, LAYOUT_MAGIC);
+	}
+}
+
+/******************************************************************************
+** Method:		OpenRing()
+**
+** Description:	Open the wake-up events for a ring.
+**
+** Parameters:	oRing		The ring.
+**				nRing		The ring number.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::OpenRing(Ring& oRing, size_t nRing)
+{
+	oRing.m_hDataEvent  = CreateWakeEvent(m_strName, nRing, TXT("Data"));
+	oRing.m_hSpaceEvent = CreateWakeEvent(m_strName, nRing, TXT("Space"));
+}
+
+/******************************************************************************
+** Method:		CloseRing()
+**
+** Description:	Close the wake-up events for a ring.
+**
+** Parameters:	oRing		The ring.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::CloseRing(Ring& oRing)
+{
+	if (oRing.m_hDataEvent != NULL)
+		::CloseHandle(oRing.m_hDataEvent);
+
+	if (oRing.m_hSpaceEvent != NULL)
+		::CloseHandle(oRing.m_hSpaceEvent);
+
+	memset(&oRing, 0, sizeof(oRing));
+}
+
+/******************************************************************************
+** Method:		Park()
+**
+** Description:	Wait for the other end to wake us.
+**
+** Parameters:	oRing		The ring.
+**				bForData	Waiting for data or space?
+**				dwTimeOut	The time to wait, in ms.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Park(Ring& oRing, bool bForData, DWORD dwTimeOut)
+{
+	HANDLE hEvent = (bForData) ? oRing.m_hDataEvent : oRing.m_hSpaceEvent;
+
+	::WaitForSingleObject(hEvent, dwTimeOut);
+}
+
+/******************************************************************************
+** Method:		Wake()
+**
+** Description:	Wake the other end if it is parked.
+**
+** Parameters:	oRing		The ring.
+**				bForData	Waiting for data or space?
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Wake(Ring& oRing, bool bForData)
+{
+	volatile DWORD* pParked = (bForData) ? &oRing.m_pHeader->m_dwReaderParked : &oRing.m_pHeader->m_dwWriterParked;
+
+	// Order our writes before checking if the other end is parked.
+	FullFence();
+
+	if (LoadAcquire(pParked) == 0)
+		return;
+
+	StoreRelease(pParked, 0);
+
+	::SetEvent((bForData) ? oRing.m_hDataEvent : oRing.m_hSpaceEvent);
+}
+
+/******************************************************************************
+** Method:		NextMessage()
+**
+** Description:	Query the size of the next message to read.
+**
+** Parameters:	None.
+**
+** Returns:		The message size or 0 if there isn't one.
+**
+*******************************************************************************
+*/
+
+size_t CSharedMemPipe::NextMessage()
+{
+	RingHeader* pHeader = m_oInbound.m_pHeader;
+	DWORD       dwTail  = pHeader->m_dwTail;
+
+	if (LoadAcquire(&pHeader->m_dwHead) == dwTail)
+		return 0;
+
+	DWORD dwSize;
+
+	CopyOut(m_oInbound.m_pData, m_dwMask, dwTail, &dwSize, sizeof(dwSize));
+
+	return dwSize;
+}
+
+/******************************************************************************
+** Method:		WaitForMessage()
+**
+** Description:	Wait for a message to read.
+**
+** Parameters:	eErrCode	The exception code to use.
+**
+** Returns:		The message size.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+size_t CSharedMemPipe::WaitForMessage(int eErrCode)
+{
+	RingHeader* pHeader = m_oInbound.m_pHeader;
+	DWORD       dwStart = TickCount();
+
+	for (;;)
+	{
+		size_t nSize = NextMessage();
+
+		if (nSize != 0)
+			return nSize;
+
+		if (LoadAcquire(&m_pHeader->m_dwClosed))
+			throw CPipeException(eErrCode, ERR_BROKEN);
+
+		DWORD dwTimeLeft = TimeLeft(dwStart, m_dwTimeOut);
+
+		if (dwTimeLeft == 0)
+			throw CPipeException(eErrCode, ERR_TIMED_OUT);
+
+		// Park, then re-check in case the write raced with us.
+		StoreFence(&pHeader->m_dwReaderParked, 1);
+
+		if ( (NextMessage() == 0) && (!LoadAcquire(&m_pHeader->m_dwClosed)) )
+			Park(m_oInbound, true, dwTimeLeft);
+
+		StoreRelease(&pHeader->m_dwReaderParked, 0);
+	}
+}
+
+/******************************************************************************
+** Method:		Available()
+**
+** Description:	Query the size of the next message available for reading.
+**
+** Parameters:	None.
+**
+** Returns:		The number of bytes available.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+size_t CSharedMemPipe::Available()
+{
+	ASSERT(m_pView != nullptr);
+
+	size_t nSize = NextMessage();
+
+	// Other end gone?
+	if ( (nSize == 0) && (LoadAcquire(&m_pHeader->m_dwClosed)) )
+		throw CPipeException(CPipeException::E_PEEK_FAILED, ERR_BROKEN);
+
+	return nSize;
+}
+
+/******************************************************************************
+** Method:		Peek()
+**
+** Description:	Peek at the next message without removing it.
+**
+** Parameters:	pBuffer		The buffer to store the data.
+**				nBufSize	The number of bytes to peek at.
+**
+** Returns:		The number of bytes peeked.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+size_t CSharedMemPipe::Peek(void* pBuffer, size_t nBufSize)
+{
+	ASSERT(m_pView != nullptr);
+
+	size_t nSize = std::min(NextMessage(), nBufSize);
+
+	if (nSize != 0)
+		CopyOut(m_oInbound.m_pData, m_dwMask, m_oInbound.m_pHeader->m_dwTail + PREFIX_SIZE, pBuffer, nSize);
+
+	return nSize;
+}
+
+/******************************************************************************
+** Method:		Read()
+**
+** Description:	Read the next message from the pipe.
+**
+** Parameters:	pBuffer		The buffer to store the data.
+**				nBufSize	The number of bytes to read.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Read(void* pBuffer, size_t nBufSize)
+{
+	ASSERT(m_pView  != nullptr);
+	ASSERT(pBuffer  != nullptr);
+	ASSERT(nBufSize != 0 );
+
+	size_t nSize = WaitForMessage(CPipeException::E_READ_FAILED);
+
+	// Message larger than the buffer?
+	if (nSize > nBufSize)
+		throw CPipeException(CPipeException::E_READ_FAILED, ERR_TOO_BIG);
+
+	RingHeader* pHeader = m_oInbound.m_pHeader;
+	DWORD       dwTail  = pHeader->m_dwTail;
+
+	CopyOut(m_oInbound.m_pData, m_dwMask, dwTail + PREFIX_SIZE, pBuffer, nSize);
+
+	// Release the space.
+	StoreRelease(&pHeader->m_dwTail, dwTail + RecordSize(nSize));
+
+	Wake(m_oInbound, false);
+
+	ASSERT(nSize == nBufSize);
+}
+
+/******************************************************************************
+** Method:		Write()
+**
+** Description:	Write a message to the pipe.
+**
+** Parameters:	pBuffer		The buffer to store the data.
+**				nBufSize	The number of bytes to write.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CPipeException.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Write(const void* pBuffer, size_t nBufSize)
+{
+	ASSERT(m_pView  != nullptr);
+	ASSERT(pBuffer  != nullptr);
+	ASSERT(nBufSize != 0 );
+
+	RingHeader* pHeader  = m_oOutbound.m_pHeader;
+	DWORD       dwHead   = pHeader->m_dwHead;
+	DWORD       dwRecord = RecordSize(nBufSize);
+	DWORD       dwStart  = TickCount();
+
+	// Larger than the ring?
+	if ( (nBufSize > m_dwMask) || (dwRecord > (m_dwMask + 1)) )
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ERR_TOO_BIG);
+
+	// Wait for space.
+	while ((dwHead - LoadAcquire(&pHeader->m_dwTail)) > ((m_dwMask + 1) - dwRecord))
+	{
+		if (LoadAcquire(&m_pHeader->m_dwClosed))
+			throw CPipeException(CPipeException::E_WRITE_FAILED, ERR_BROKEN);
+
+		DWORD dwTimeLeft = TimeLeft(dwStart, m_dwTimeOut);
+
+		if (dwTimeLeft == 0)
+			throw CPipeException(CPipeException::E_WRITE_FAILED, ERR_TIMED_OUT);
+
+		// Park, then re-check in case the read raced with us.
+		StoreFence(&pHeader->m_dwWriterParked, 1);
+
+		if ( ((dwHead - LoadAcquire(&pHeader->m_dwTail)) > ((m_dwMask + 1) - dwRecord))
+		  && (!LoadAcquire(&m_pHeader->m_dwClosed)) )
+			Park(m_oOutbound, false, dwTimeLeft);
+
+		StoreRelease(&pHeader->m_dwWriterParked, 0);
+	}
+
+	if (LoadAcquire(&m_pHeader->m_dwClosed))
+		throw CPipeException(CPipeException::E_WRITE_FAILED, ERR_BROKEN);
+
+	DWORD dwSize = static_cast<DWORD>(nBufSize);
+
+	CopyIn(m_oOutbound.m_pData, m_dwMask, dwHead, &dwSize, sizeof(dwSize));
+	CopyIn(m_oOutbound.m_pData, m_dwMask, dwHead + PREFIX_SIZE, pBuffer, nBufSize);
+
+	// Publish the message.
+	StoreRelease(&pHeader->m_dwHead, dwHead + dwRecord);
+
+	Wake(m_oOutbound, true);
+}
+
+/******************************************************************************
+** Method:		Close()
+**
+** Description:	Close the pipe. The other end is woken so that it sees the
+**				pipe is broken.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CSharedMemPipe::Close()
+{
+	if (m_oInbound.m_pHeader != nullptr)
+	{
+		StoreFence(&m_pHeader->m_dwClosed, 1);
+
+		Wake(m_oInbound, false);
+		Wake(m_oOutbound, true);
+	}
+
+	CloseRing(m_oInbound);
+	CloseRing(m_oOutbound);
+
+	if (m_pView != nullptr)
+		::UnmapViewOfFile(m_pView);
+
+	if (m_hMapping != NULL)
+		::CloseHandle(m_hMapping);
+
+	m_hMapping = NULL;
+
+	// Reset members.
+	m_pView     = nullptr;
+	m_nViewSize = 0;
+	m_pHeader   = nullptr;
+	m_dwMask    = 0;
+}
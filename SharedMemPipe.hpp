@@ -0,0 +1,168 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		SHAREDMEMPIPE.HPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	The CSharedMemPipe class declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef SHAREDMEMPIPE_HPP
+#define SHAREDMEMPIPE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/Buffer.hpp>
+
+/******************************************************************************
+**
+** A same-host, message based pipe built on a pair of single-producer/single-
+** consumer ring buffers in shared memory, one for each direction. Messages are
+** copied straight into the peer's address space, and the peer is only woken,
+** via an event, if it is parked waiting for data or space.
+**
+** One end creates the pipe and the other opens it by name. It supports the
+** same Read/Write/Peek/Available methods as CNamedPipe. It is only safe to use
+** each end from a single thread at a time.
+**
+*******************************************************************************
+*/
+
+class CSharedMemPipe /*: private NotCopyable*/
+{
+public:
+	//
+	// Constructors/Destructor.
+	//
+	CSharedMemPipe();
+	~CSharedMemPipe();
+
+	//
+	// Properties.
+	//
+	bool   IsOpen() const;
+	size_t Capacity() const;
+
+	DWORD  TimeOut() const;
+	void   SetTimeOut(DWORD dwTimeOut);
+
+	//
+	// Methods.
+	//
+	void Create(const tchar* pszName, size_t nCapacity = DEF_CAPACITY);
+	void Open(const tchar* pszName);
+
+	size_t Available();
+	size_t Peek(void* pBuffer, size_t nBufSize);
+	size_t Peek(CBuffer& oBuffer, size_t nBufSize);
+	void Read(void* pBuffer, size_t nBufSize);
+	void Read(CBuffer& oBuffer);
+	void Write(const void* pBuffer, size_t nBufSize);
+	void Write(const CBuffer& oBuffer);
+
+	void Close();
+
+	//
+	// Constants.
+	//
+	static const size_t DEF_CAPACITY = 64 * 1024;
+
+protected:
+	// The shared memory layout.
+	struct SharedHeader;
+	struct RingHeader;
+
+	// One direction of the pipe.
+	struct Ring
+	{
+		RingHeader*	m_pHeader;		// The shared positions.
+		byte*		m_pData;		// The shared buffer.
+		HANDLE		m_hDataEvent;	// Signalled when data is written.
+		HANDLE		m_hSpaceEvent;	// Signalled when data is read.
+	};
+
+	//
+	// Members.
+	//
+	CString			m_strName;		// The pipe name.
+	bool			m_bCreator;		// Created or opened?
+	HANDLE			m_hMapping;		// The file mapping.
+	void*			m_pView;		// The mapped memory.
+	size_t			m_nViewSize;	// The mapped memory size.
+	SharedHeader*	m_pHeader;		// The shared pipe state.
+	DWORD			m_dwMask;		// Ring capacity - 1.
+	Ring			m_oInbound;		// The ring read from.
+	Ring			m_oOutbound;	// The ring written to.
+	DWORD			m_dwTimeOut;	// Open/Read/Write time-out.
+
+	//
+	// Constants.
+	//
+	static const DWORD DEF_TIMEOUT;
+	static const DWORD DEF_INTERVAL;
+
+	//
+	// Internal methods.
+	//
+	bool   OpenMapping();
+	void   Map(size_t nCapacity, bool bInitialise);
+	void   OpenRing(Ring& oRing, size_t nRing);
+	void   CloseRing(Ring& oRing);
+	size_t NextMessage();
+	size_t WaitForMessage(int eErrCode);
+	void   Park(Ring& oRing, bool bForData, DWORD dwTimeOut);
+	void   Wake(Ring& oRing, bool bForData);
+
+private:
+	// NotCopyable.
+	CSharedMemPipe(const CSharedMemPipe&);
+	CSharedMemPipe& operator=(const CSharedMemPipe&);
+};
+
+/******************************************************************************
+**
+** Implementation of inline functions.
+**
+*******************************************************************************
+*/
+
+inline bool CSharedMemPipe::IsOpen() const
+{
+	return (m_pView != nullptr);
+}
+
+inline size_t CSharedMemPipe::Capacity() const
+{
+	return (m_pView != nullptr) ? (m_dwMask + 1) : 0;
+}
+
+inline DWORD CSharedMemPipe::TimeOut() const
+{
+	return m_dwTimeOut;
+}
+
+inline void CSharedMemPipe::SetTimeOut(DWORD dwTimeOut)
+{
+	m_dwTimeOut = dwTimeOut;
+}
+
+inline size_t CSharedMemPipe::Peek(CBuffer& oBuffer, size_t nBufSize)
+{
+	return Peek(oBuffer.Buffer(), nBufSize);
+}
+
+inline void CSharedMemPipe::Read(CBuffer& oBuffer)
+{
+	Read(oBuffer.Buffer(), oBuffer.Size());
+}
+
+inline void CSharedMemPipe::Write(const CBuffer& oBuffer)
+{
+	Write(oBuffer.Buffer(), oBuffer.Size());
+}
+
+#endif // SHAREDMEMPIPE_HPP
@@ -104,6 +104,39 @@ void CSocket::Close()
 		m_pRecvBuffer->Clear();
 }
 
+/******************************************************************************
+** Method:		Detach()
+**
+** Description:	Release ownership of the socket handle without closing it, e.g.
+**				to pass it to another process with CNamedPipe::WriteSocket().
+**
+** Parameters:	None.
+**
+** Returns:		The socket handle.
+**
+*******************************************************************************
+*/
+
+SOCKET CSocket::Detach()
+{
+	SOCKET hSocket = m_hSocket;
+
+	// If async mode, end select.
+	if ( (m_hSocket != INVALID_SOCKET) && (m_eMode == ASYNC) )
+		CWinSock::EndAsyncSelect(this);
+
+	// Reset members.
+	m_hSocket = INVALID_SOCKET;
+
+	if (m_pSendBuffer.get() != nullptr)
+		m_pSendBuffer->Clear();
+
+	if (m_pRecvBuffer.get() != nullptr)
+		m_pRecvBuffer->Clear();
+
+	return hSocket;
+}
+
 /******************************************************************************
 ** Method:		Create()
 **
@@ -48,6 +48,7 @@ public:
 	// Methods.
 	//
 	virtual void Close();
+	SOCKET Detach();
 
 	size_t Send(const void* pBuffer, size_t nBufSize);
 	size_t Send(const CBuffer& oBuffer);
@@ -45,14 +45,14 @@ public:
 	//
 	void Connect(const tchar* pszHost, uint nPort);
 
+	// For use by CTCPSvrSocket or with CNamedPipe::ReadSocket().
+	virtual void Attach(SOCKET hSocket, Mode eMode);
+
 protected:
 	//
 	// Members.
 	//
 
-	// For use by CTCPSvrSocket.
-	void Attach(SOCKET hSocket, Mode eMode);
-
 	// Friends.
 	friend class CTCPSvrSocket;
 };
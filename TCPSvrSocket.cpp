@@ -177,12 +177,11 @@ void CTCPSvrSocket::Accept(CTCPCltSocket* pCltSocket)
 {
 	ASSERT(pCltSocket != nullptr);
 
-	SOCKET       hSocket;
-	sockaddr_in  addr      = { 0 };;
-	int          nAddrSize = sizeof(addr);
+	SOCKET hSocket;
 
 	// Accept the next client connection.
-	if ((hSocket = accept(m_hSocket, reinterpret_cast<sockaddr*>(&addr), &nAddrSize)) == INVALID_SOCKET)
+	// NB: The peer address is queried by Attach() as it depends on the family.
+	if ((hSocket = accept(m_hSocket, nullptr, nullptr)) == INVALID_SOCKET)
 		throw CSocketException(CSocketException::E_ACCEPT_FAILED, CWinSock::LastError());
 
 	pCltSocket->Attach(hSocket, m_eMode);
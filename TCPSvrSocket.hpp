@@ -79,7 +79,7 @@ protected:
 	//
 	// Template methods.
 	//
-	CTCPCltSocket* AllocCltSocket();
+	virtual CTCPCltSocket* AllocCltSocket();
 };
 
 /******************************************************************************
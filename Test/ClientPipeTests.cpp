@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ClientPipeTests.cpp
+//! \brief  The unit tests for the CClientPipe class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/ClientPipe.hpp>
+#include <NCL/ServerPipe.hpp>
+#include <NCL/PipeException.hpp>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Drive a background open until it completes, fails, or a number of attempts
+//! have been made.
+
+bool driveOpen(CClientPipe& pipe, size_t attempts)
+{
+	for (size_t i = 0; i != attempts; ++i)
+	{
+		::WaitForSingleObject(pipe.OpenCompleteEvent(), INFINITE);
+
+		if (pipe.EndOpen())
+			return true;
+	}
+
+	return false;
+}
+
+//namespace
+}
+
+TEST_SET(ClientPipe)
+{
+	const tchar* PIPE_NAME = TXT("\\\\.\\pipe\\ncl-test-client-pipe");
+
+TEST_CASE("opening a pipe that does not exist times out")
+{
+	CClientPipe client;
+
+	client.SetTimeOut(50);
+
+	TEST_THROWS(client.Open(PIPE_NAME));
+	TEST_FALSE(client.IsOpen());
+}
+TEST_CASE_END
+
+TEST_CASE("opening a pipe connects to a waiting server instance")
+{
+	CServerPipe server;
+	CClientPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(client.IsOpen());
+	TEST_TRUE(server.Accept());
+}
+TEST_CASE_END
+
+TEST_CASE("a background open completes once the server pipe is created")
+{
+	CServerPipe server;
+	CClientPipe client;
+
+	client.BeginOpen(PIPE_NAME);
+
+	TEST_TRUE(client.IsOpening());
+	TEST_FALSE(driveOpen(client, 2));
+	TEST_TRUE(client.IsOpening());
+
+	server.Create(PIPE_NAME);
+
+	TEST_TRUE(driveOpen(client, 100));
+	TEST_FALSE(client.IsOpening());
+	TEST_TRUE(client.IsOpen());
+	TEST_TRUE(server.Accept());
+}
+TEST_CASE_END
+
+TEST_CASE("a background open fails once it times out")
+{
+	CClientPipe client;
+
+	client.SetTimeOut(50);
+	client.BeginOpen(PIPE_NAME);
+
+	TEST_THROWS(driveOpen(client, 100));
+	TEST_FALSE(client.IsOpening());
+	TEST_FALSE(client.IsOpen());
+}
+TEST_CASE_END
+
+TEST_CASE("closing a pipe abandons a background open")
+{
+	CClientPipe client;
+
+	client.BeginOpen(PIPE_NAME);
+	client.Close();
+
+	TEST_FALSE(client.IsOpening());
+	TEST_FALSE(client.IsOpen());
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
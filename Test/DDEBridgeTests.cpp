@@ -0,0 +1,641 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBridgeTests.cpp
+//! \brief  The unit tests for the DDE-over-TCP bridge.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDEBridgeProtocol.hpp>
+#include <NCL/DDEBridgeHost.hpp>
+#include <NCL/DDEBridgeRelay.hpp>
+#include <NCL/DDEServer.hpp>
+#include <NCL/DDEData.hpp>
+#include <NCL/NetBuffer.hpp>
+#include <NCL/AutoWinSock.hpp>
+#include <NCL/WinSock.hpp>
+#include <NCL/TCPSvrSocket.hpp>
+#include <NCL/TCPCltSocket.hpp>
+#include <NCL/SocketException.hpp>
+#include <NCL/RPCProtocol.hpp>
+#include <WCL/Module.hpp>
+#include <WCL/Event.hpp>
+#include <WCL/Buffer.hpp>
+
+//! The port used by the scripted host.
+static const uint RELAY_PORT = 50236;
+//! The port used by the real host.
+static const uint HOST_PORT = 50237;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The fake service used to drive the host.
+
+class TestService : public DDEBridge::IService
+{
+public:
+	TestService()
+		: m_disconnects(0)
+		, m_adviseStops(0)
+		, m_lastPoke()
+		, m_lastCommand()
+	{
+	}
+
+	virtual bool OnConnect(const tstring& /*service*/, const tstring& topic)
+	{
+		return (topic == TXT("Topic"));
+	}
+
+	virtual void OnDisconnect(const DDEBridge::Conversation& /*conv*/)
+	{
+		++m_disconnects;
+	}
+
+	virtual bool OnRequest(const DDEBridge::Conversation& /*conv*/, const tstring& item, uint /*format*/, CNetBuffer& data)
+	{
+		if (item != TXT("Item"))
+			return false;
+
+		data.Append("value", 5);
+		return true;
+	}
+
+	virtual bool OnPoke(const DDEBridge::Conversation& /*conv*/, const tstring& /*item*/, uint /*format*/, const byte* data, size_t size)
+	{
+		m_lastPoke.assign(reinterpret_cast<const char*>(data), size);
+		return true;
+	}
+
+	virtual bool OnExecute(const DDEBridge::Conversation& /*conv*/, const tstring& command)
+	{
+		m_lastCommand = command;
+		return true;
+	}
+
+	virtual bool OnAdviseStart(const DDEBridge::Conversation& /*conv*/, const DDEBridge::Link& link)
+	{
+		return (link.m_item == TXT("Item"));
+	}
+
+	virtual void OnAdviseStop(const DDEBridge::Conversation& /*conv*/, const DDEBridge::Link& /*link*/)
+	{
+		++m_adviseStops;
+	}
+
+	size_t		m_disconnects;
+	size_t		m_adviseStops;
+	std::string	m_lastPoke;
+	tstring		m_lastCommand;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open a conversation via the host and return its ID.
+
+static DWORD connect(DDEBridge::Host& host, CSocket& client, const tchar* topic)
+{
+	CNetBuffer request, response;
+
+	DDEBridge::Writer writer(request);
+
+	writer.writeString(TXT("Service"));
+	writer.writeString(topic);
+
+	if (host.OnRequest(client, DDEBridge::CONNECT, static_cast<const byte*>(request.Ptr()), request.Size(), response) != RPC::OK)
+		return 0;
+
+	return DDEBridge::Reader(static_cast<const byte*>(response.Ptr()), response.Size()).readDWord();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start an advise loop via the host and return its ID.
+
+static DWORD adviseStart(DDEBridge::Host& host, CSocket& client, DWORD conv, const tchar* item)
+{
+	CNetBuffer request, response;
+
+	DDEBridge::Writer writer(request);
+
+	writer.writeDWord(conv);
+	writer.writeString(item);
+	writer.writeFormat(CF_TEXT);
+
+	if (host.OnRequest(client, DDEBridge::ADVISE_START, static_cast<const byte*>(request.Ptr()), request.Size(), response) != RPC::OK)
+		return 0;
+
+	return DDEBridge::Reader(static_cast<const byte*>(response.Ptr()), response.Size()).readDWord();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send a message to the relay as if from the host.
+
+static void sendMessage(CSocket& socket, RPC::MessageType type, DWORD id, WORD code, const CNetBuffer& payload)
+{
+	CNetBuffer message;
+
+	RPC::appendMessage(message, type, id, code, payload.Ptr(), payload.Size());
+
+	socket.Send(message.Ptr(), message.Size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Send the response to a request which returns an ID.
+
+static void sendID(CSocket& socket, DWORD requestID, DWORD id)
+{
+	CNetBuffer payload;
+
+	DDEBridge::Writer(payload).writeDWord(id);
+
+	sendMessage(socket, RPC::RESPONSE, requestID, RPC::OK, payload);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the next message sent by the relay.
+
+static RPC::Header receiveMessage(CSocket& socket, std::vector<byte>& payload)
+{
+	std::vector<byte> inbound;
+	RPC::Header       header;
+	size_t            messageSize;
+	byte              buffer[256];
+
+	while ( (inbound.empty()) || (!RPC::parseMessage(&inbound[0], inbound.size(), header, messageSize)) )
+	{
+		const size_t read = socket.Recv(buffer, sizeof(buffer));
+
+		if (read == 0)
+			throw CSocketException(CSocketException::E_DISCONNECTED, WSAECONNRESET);
+
+		inbound.insert(inbound.end(), buffer, buffer+read);
+	}
+
+	payload.assign(inbound.begin()+RPC::HEADER_SIZE, inbound.begin()+messageSize);
+
+	return header;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The state shared with the thread running a relay against a real host.
+
+struct RelayTest
+{
+	HANDLE		m_flushed;		//!< Signalled once the host has flushed.
+	bool		m_requested;	//!< Did the request succeed?
+	size_t		m_pending;		//!< The updates pending after the request.
+	std::string	m_value;		//!< The latest value for the link.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open an advise loop through a relay, then once the host has flushed its
+//! updates make a request so that they are read before the response.
+
+static DWORD WINAPI relayThread(LPVOID param)
+{
+	RelayTest& test = *static_cast<RelayTest*>(param);
+
+	try
+	{
+		CTCPCltSocket socket;
+
+		socket.Connect(TXT("localhost"), HOST_PORT);
+
+		CDDEServer       server;
+		DDEBridge::Relay relay(server, socket);
+
+		// Only used as keys by the relay.
+		CDDESvrConv* conv = reinterpret_cast<CDDESvrConv*>(&test);
+		CDDELink*    link = reinterpret_cast<CDDELink*>(&test.m_value);
+
+		if (!relay.OnConnect(TXT("Service"), TXT("Topic")))
+			return 0;
+
+		relay.OnConnectConfirm(conv);
+
+		if (!relay.OnAdviseStart(conv, TXT("Item"), CF_TEXT))
+			return 0;
+
+		relay.OnAdviseConfirm(conv, link);
+
+		::WaitForSingleObject(test.m_flushed, 5000);
+
+		CDDEData data(&server, static_cast<HSZ>(NULL), CF_TEXT, true);
+		CDDEData value(&server, static_cast<HSZ>(NULL), CF_TEXT, true);
+
+		test.m_requested = relay.OnRequest(conv, TXT("Item"), CF_TEXT, data);
+		test.m_pending   = relay.PendingUpdates();
+
+		if (relay.OnAdviseRequest(conv, link, value))
+		{
+			CBuffer buffer = value.GetBuffer();
+
+			test.m_value.assign(static_cast<const char*>(buffer.Buffer()), buffer.Size());
+		}
+	}
+	catch (const Core::Exception& e)
+	{
+		TRACE1(TXT("Relay thread failed: %s\n"), e.twhat());
+		DEBUG_USE_ONLY(e);
+	}
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Process socket events until the thread exits or a timeout expires.
+
+static bool pumpUntilExit(HANDLE thread)
+{
+	const DWORD start = ::GetTickCount();
+
+	while (::WaitForSingleObject(thread, 0) != WAIT_OBJECT_0)
+	{
+		if ((::GetTickCount() - start) > 5000)
+			return false;
+
+		::MsgWaitForMultipleObjects(1, &thread, FALSE, 10, QS_ALLINPUT);
+
+		CWinSock::ProcessSocketMsgs();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Process socket events until the host has a number of links or a timeout
+//! expires.
+
+static bool pumpUntilLinked(const DDEBridge::Host& host, size_t count)
+{
+	const DWORD start = ::GetTickCount();
+
+	while (host.LinkCount() != count)
+	{
+		if ((::GetTickCount() - start) > 5000)
+			return false;
+
+		::MsgWaitForMultipleObjects(0, nullptr, FALSE, 10, QS_ALLINPUT);
+
+		CWinSock::ProcessSocketMsgs();
+	}
+
+	return true;
+}
+
+TEST_SET(DDEBridge)
+{
+	CModule     module;
+	AutoWinSock autoWinSock;
+
+	CTCPSvrSocket listener;
+
+	listener.Listen(RELAY_PORT);
+
+TEST_CASE("values written can be read back in the same order")
+{
+	CNetBuffer buffer;
+	DDEBridge::Writer writer(buffer);
+
+	writer.writeWord(0x0102);
+	writer.writeDWord(0x03040506);
+	writer.writeString(TXT("string"));
+	writer.writeData("data", 4);
+
+	DDEBridge::Reader reader(static_cast<const byte*>(buffer.Ptr()), buffer.Size());
+	size_t            size;
+
+	TEST_TRUE(reader.readWord() == 0x0102);
+	TEST_TRUE(reader.readDWord() == 0x03040506);
+	TEST_TRUE(reader.readString() == TXT("string"));
+
+	const byte* data = reader.readData(size);
+
+	TEST_TRUE((size == 4) && (memcmp(data, "data", 4) == 0));
+	TEST_TRUE(reader.remaining() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a registered clipboard format is sent with its name")
+{
+	const uint xlTable = ::RegisterClipboardFormat(TXT("XlTable"));
+
+	CNetBuffer buffer;
+	DDEBridge::Writer writer(buffer);
+
+	writer.writeFormat(CF_TEXT);
+	writer.writeFormat(xlTable);
+
+	TEST_TRUE(buffer.Size() == (2 + 2 + 4 + 7));
+
+	DDEBridge::Reader reader(static_cast<const byte*>(buffer.Ptr()), buffer.Size());
+
+	TEST_TRUE(reader.readFormat() == CF_TEXT);
+	TEST_TRUE(reader.readFormat() == xlTable);
+	TEST_TRUE(reader.remaining() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("reading past the end of the payload throws")
+{
+	CNetBuffer buffer;
+
+	DDEBridge::Writer(buffer).writeData("data", 4);
+
+	DDEBridge::Reader reader(static_cast<const byte*>(buffer.Ptr()), buffer.Size()-1);
+	size_t            size;
+
+	TEST_THROWS(reader.readData(size));
+}
+TEST_CASE_END
+
+TEST_CASE("a conversation is opened when the service accepts the topic")
+{
+	CTCPSvrSocket     socket(CSocket::ASYNC);
+	CTCPCltSocket     client;
+	TestService       service;
+	DDEBridge::Host   host(socket, service);
+
+	TEST_TRUE(connect(host, client, TXT("Topic")) != 0);
+	TEST_TRUE(connect(host, client, TXT("Unknown")) == 0);
+	TEST_TRUE(host.ConversationCount() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("a request returns the data from the service")
+{
+	CTCPSvrSocket     socket(CSocket::ASYNC);
+	CTCPCltSocket     client;
+	TestService       service;
+	DDEBridge::Host   host(socket, service);
+	CNetBuffer        request, response;
+
+	const DWORD conv = connect(host, client, TXT("Topic"));
+
+	DDEBridge::Writer writer(request);
+
+	writer.writeDWord(conv);
+	writer.writeString(TXT("Item"));
+	writer.writeFormat(CF_TEXT);
+
+	TEST_TRUE(host.OnRequest(client, DDEBridge::REQUEST, static_cast<const byte*>(request.Ptr()), request.Size(), response) == RPC::OK);
+	TEST_TRUE((response.Size() == 5) && (memcmp(response.Ptr(), "value", 5) == 0));
+}
+TEST_CASE_END
+
+TEST_CASE("a poke and execute are passed to the service")
+{
+	CTCPSvrSocket     socket(CSocket::ASYNC);
+	CTCPCltSocket     client;
+	TestService       service;
+	DDEBridge::Host   host(socket, service);
+	CNetBuffer        poke, execute, response;
+
+	const DWORD conv = connect(host, client, TXT("Topic"));
+
+	DDEBridge::Writer pokeWriter(poke);
+
+	pokeWriter.writeDWord(conv);
+	pokeWriter.writeString(TXT("Item"));
+	pokeWriter.writeFormat(CF_TEXT);
+	pokeWriter.writeData("poked", 5);
+
+	DDEBridge::Writer executeWriter(execute);
+
+	executeWriter.writeDWord(conv);
+	executeWriter.writeString(TXT("[Command]"));
+
+	TEST_TRUE(host.OnRequest(client, DDEBridge::POKE, static_cast<const byte*>(poke.Ptr()), poke.Size(), response) == RPC::OK);
+	TEST_TRUE(service.m_lastPoke == "poked");
+
+	TEST_TRUE(host.OnRequest(client, DDEBridge::EXECUTE, static_cast<const byte*>(execute.Ptr()), execute.Size(), response) == RPC::OK);
+	TEST_TRUE(service.m_lastCommand == TXT("[Command]"));
+}
+TEST_CASE_END
+
+TEST_CASE("a conversation opened by another relay is rejected")
+{
+	CTCPSvrSocket     socket(CSocket::ASYNC);
+	CTCPCltSocket     client, other;
+	TestService       service;
+	DDEBridge::Host   host(socket, service);
+	CNetBuffer        request, response;
+
+	const DWORD conv = connect(host, client, TXT("Topic"));
+
+	DDEBridge::Writer(request).writeDWord(conv);
+
+	TEST_TRUE(host.OnRequest(other, DDEBridge::DISCONNECT, static_cast<const byte*>(request.Ptr()), request.Size(), response) == DDEBridge::UNKNOWN_ID);
+	TEST_TRUE(host.OnRequest(client, DDEBridge::DISCONNECT, static_cast<const byte*>(request.Ptr()), request.Size(), response) == RPC::OK);
+	TEST_TRUE(host.ConversationCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("updates are only queued for active advise loops")
+{
+	CTCPSvrSocket     socket(CSocket::ASYNC);
+	CTCPCltSocket     client;
+	TestService       service;
+	DDEBridge::Host   host(socket, service);
+
+	const DWORD conv = connect(host, client, TXT("Topic"));
+	const DWORD link = adviseStart(host, client, conv, TXT("Item"));
+
+	TEST_TRUE(link != 0);
+	TEST_TRUE(adviseStart(host, client, conv, TXT("Unknown")) == 0);
+
+	std::vector<DWORD> links;
+
+	host.FindLinks(TXT("TOPIC"), TXT("item"), links);
+
+	TEST_TRUE((links.size() == 1) && (links[0] == link));
+
+	TEST_TRUE(host.PostUpdate(link, "1", 1));
+	TEST_TRUE(host.PostUpdate(link, "2", 1));
+	TEST_FALSE(host.PostUpdate(link+1, "3", 1));
+	TEST_TRUE(host.PendingUpdates() == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("closing a relay releases its conversations and links")
+{
+	CTCPSvrSocket     socket(CSocket::ASYNC);
+	CTCPCltSocket     client;
+	TestService       service;
+	DDEBridge::Host   host(socket, service);
+
+	const DWORD conv = connect(host, client, TXT("Topic"));
+	const DWORD link = adviseStart(host, client, conv, TXT("Item"));
+
+	host.PostUpdate(link, "1", 1);
+
+	host.OnClientClosed(client);
+
+	TEST_TRUE(host.ConversationCount() == 0);
+	TEST_TRUE(host.LinkCount() == 0);
+	TEST_TRUE(host.PendingUpdates() == 0);
+	TEST_TRUE(service.m_adviseStops == 1);
+	TEST_TRUE(service.m_disconnects == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("a relay forwards a connection request and returns the host's answer")
+{
+	CTCPCltSocket socket;
+
+	socket.Connect(TXT("localhost"), RELAY_PORT);
+
+	Core::SharedPtr<CTCPCltSocket> host(listener.Accept());
+	CDDEServer                     server;
+	DDEBridge::Relay               relay(server, socket);
+	std::vector<byte>              payload;
+
+	sendID(*host, 1, 7);
+
+	TEST_TRUE(relay.OnConnect(TXT("Service"), TXT("Topic")));
+
+	const RPC::Header header = receiveMessage(*host, payload);
+
+	TEST_TRUE((header.m_type == RPC::REQUEST) && (header.m_id == 1) && (header.m_code == DDEBridge::CONNECT));
+
+	DDEBridge::Reader reader(&payload[0], payload.size());
+
+	TEST_TRUE(reader.readString() == TXT("Service"));
+	TEST_TRUE(reader.readString() == TXT("Topic"));
+}
+TEST_CASE_END
+
+TEST_CASE("a relay call fails if the host does not answer in time")
+{
+	CTCPCltSocket socket;
+
+	socket.Connect(TXT("localhost"), RELAY_PORT);
+
+	Core::SharedPtr<CTCPCltSocket> host(listener.Accept());
+	CDDEServer                     server;
+	DDEBridge::Relay               relay(server, socket);
+
+	relay.SetTimeOut(50);
+
+	const DWORD start = ::GetTickCount();
+
+	TEST_FALSE(relay.OnConnect(TXT("Service"), TXT("Topic")));
+	TEST_TRUE((::GetTickCount() - start) < 5000);
+	TEST_TRUE(relay.IsConnected());
+
+	// The late answer is discarded.
+	sendID(*host, 1, 7);
+	sendID(*host, 2, 9);
+
+	TEST_TRUE(relay.OnConnect(TXT("Service"), TXT("Topic")));
+}
+TEST_CASE_END
+
+TEST_CASE("a relay whose connection fails stops forwarding")
+{
+	CTCPCltSocket socket;
+
+	socket.Connect(TXT("localhost"), RELAY_PORT);
+
+	Core::SharedPtr<CTCPCltSocket> host(listener.Accept());
+	CDDEServer                     server;
+	DDEBridge::Relay               relay(server, socket);
+
+	host->Close();
+
+	TEST_FALSE(relay.OnConnect(TXT("Service"), TXT("Topic")));
+	TEST_FALSE(relay.IsConnected());
+
+	relay.ProcessUpdates();
+
+	TEST_TRUE(relay.LinkCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("updates received during a call are stored until posted")
+{
+	CTCPCltSocket socket;
+
+	socket.Connect(TXT("localhost"), RELAY_PORT);
+
+	Core::SharedPtr<CTCPCltSocket> host(listener.Accept());
+	CDDEServer                     server;
+	DDEBridge::Relay               relay(server, socket);
+
+	// Only used as keys by the relay.
+	CDDESvrConv* conv = reinterpret_cast<CDDESvrConv*>(&relay);
+	CDDELink*    link = reinterpret_cast<CDDELink*>(&server);
+
+	sendID(*host, 1, 7);
+
+	TEST_TRUE(relay.OnConnect(TXT("Service"), TXT("Topic")));
+
+	relay.OnConnectConfirm(conv);
+
+	sendID(*host, 2, 11);
+
+	TEST_TRUE(relay.OnAdviseStart(conv, TXT("Item"), CF_TEXT));
+
+	relay.OnAdviseConfirm(conv, link);
+
+	CNetBuffer updates;
+	DDEBridge::Writer writer(updates);
+
+	writer.writeDWord(3);
+	writer.writeDWord(11);
+	writer.writeData("1", 1);
+	writer.writeDWord(12);
+	writer.writeData("x", 1);
+	writer.writeDWord(11);
+	writer.writeData("2", 1);
+
+	sendMessage(*host, RPC::NOTIFY, 0, DDEBridge::ADVISE_DATA, updates);
+	sendMessage(*host, RPC::RESPONSE, 3, RPC::OK, CNetBuffer());
+
+	TEST_TRUE(relay.OnExecute(conv, TXT("[Command]")));
+	TEST_TRUE(relay.PendingUpdates() == 1);
+
+	CDDEData value(&server, static_cast<HSZ>(NULL), CF_TEXT, true);
+
+	TEST_TRUE(relay.OnAdviseRequest(conv, link, value));
+
+	CBuffer buffer = value.GetBuffer();
+
+	TEST_TRUE((buffer.Size() == 1) && (memcmp(buffer.Buffer(), "2", 1) == 0));
+}
+TEST_CASE_END
+
+TEST_CASE("updates flushed by the host are delivered to the relay in one notification")
+{
+	CTCPSvrSocket   socket(CSocket::ASYNC);
+	TestService     service;
+	DDEBridge::Host host(socket, service);
+	CEvent          flushed(true, false);
+	RelayTest       test = { flushed.Handle(), false, 0, std::string() };
+
+	socket.Listen(HOST_PORT);
+
+	HANDLE thread = ::CreateThread(nullptr, 0, relayThread, &test, 0, nullptr);
+
+	TEST_TRUE(pumpUntilLinked(host, 1));
+
+	std::vector<DWORD> links;
+
+	host.FindLinks(TXT("Topic"), TXT("Item"), links);
+
+	TEST_TRUE(links.size() == 1);
+	TEST_TRUE(host.PostUpdate(links[0], "1", 1));
+	TEST_TRUE(host.PostUpdate(links[0], "2", 1));
+
+	host.Flush();
+	flushed.Signal();
+
+	TEST_TRUE(host.PendingUpdates() == 0);
+	TEST_TRUE(pumpUntilExit(thread));
+
+	::CloseHandle(thread);
+
+	TEST_TRUE(test.m_requested);
+	TEST_TRUE(test.m_pending == 1);
+	TEST_TRUE(test.m_value == "2");
+}
+TEST_CASE_END
+}
+TEST_SET_END
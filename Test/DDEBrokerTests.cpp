@@ -0,0 +1,821 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEBrokerTests.cpp
+//! \brief  The integration tests for the DDEBroker class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDEBroker.hpp>
+#include <NCL/DDEClient.hpp>
+#include <NCL/DDECltConvPtr.hpp>
+#include <NCL/DDEData.hpp>
+#include <NCL/DDEException.hpp>
+#include <NCL/DDELink.hpp>
+#include <NCL/DDEServer.hpp>
+#include <NCL/DDESvrConv.hpp>
+#include <NCL/DefDDEClientListener.hpp>
+#include <NCL/DefDDEServerListener.hpp>
+#include <WCL/StrArray.hpp>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A DDE server that records the transactions sent through the broker.
+
+class BrokerServer : public CDefDDEServerListener
+{
+public:
+	//! Default constructor.
+	BrokerServer()
+		: m_server()
+		, m_conv(nullptr)
+		, m_link(nullptr)
+	{
+		m_server.AddListener(this);
+		m_server.Register(SERVICE);
+	}
+
+	//! Destructor.
+	~BrokerServer()
+	{
+		m_server.Unregister(SERVICE);
+	}
+
+	//! Post an update for the last link started.
+	bool PostUpdate()
+	{
+		return m_conv->PostLinkUpdate(m_link);
+	}
+
+	//! Schedule an update for the last link started.
+	bool ScheduleUpdate()
+	{
+		return m_server.ScheduleLinkUpdate(m_link);
+	}
+
+	//
+	// Constants.
+	//
+
+	//! The service name.
+	static const tchar* SERVICE;
+	//! The topic name.
+	static const tchar* TOPIC;
+	//! An item name.
+	static const tchar* ITEM;
+	//! The value for the item.
+	static const tchar* VALUE;
+
+	//
+	// Members.
+	//
+	CDDEServer		m_server;		//!< The DDE server.
+	CDDESvrConv*	m_conv;			//!< The conversation for the last link.
+	CDDELink*		m_link;			//!< The last link started.
+	CString			m_lastPoke;		//!< The last value poked.
+	CString			m_lastCommand;	//!< The last command executed.
+
+private:
+	//
+	// IDDEServerListener methods.
+	//
+
+	//! Handle a request for the supported services and topics.
+	virtual bool OnWildConnect(CStrArray& services, CStrArray& topics)
+	{
+		services.Add(SERVICE);
+		topics.Add(TOPIC);
+
+		return true;
+	}
+
+	//! Handle a request for the topics supported by a given service.
+	virtual bool OnWildConnectService(const tchar* service, CStrArray& topics)
+	{
+		if (tstricmp(service, SERVICE) != 0)
+			return false;
+
+		topics.Add(TOPIC);
+
+		return true;
+	}
+
+	//! Handle a connection request.
+	virtual bool OnConnect(const tchar* service, const tchar* topic)
+	{
+		return (tstricmp(service, SERVICE) == 0) && (tstricmp(topic, TOPIC) == 0);
+	}
+
+	//! Handle a request for an item.
+	virtual bool OnRequest(CDDESvrConv* /*conversation*/, const tchar* item, uint format, CDDEData& data)
+	{
+		if ( (tstricmp(item, ITEM) != 0) || (format != CF_TEXT) )
+			return false;
+
+		data.SetString(VALUE, ANSI_TEXT);
+
+		return true;
+	}
+
+	//! Handle the start of an advise loop.
+	virtual bool OnAdviseStart(CDDESvrConv* /*conversation*/, const tchar* /*item*/, uint format)
+	{
+		return (format == CF_TEXT) || (format == CF_OEMTEXT);
+	}
+
+	//! Handle the confirmation of an advise loop.
+	virtual void OnAdviseConfirm(CDDESvrConv* conversation, CDDELink* link)
+	{
+		m_conv = conversation;
+		m_link = link;
+	}
+
+	//! Handle the end of an advise loop.
+	virtual void OnAdviseStop(CDDESvrConv* /*conversation*/, CDDELink* link)
+	{
+		if (link == m_link)
+			m_link = nullptr;
+	}
+
+	//! Handle a request for the data for an advise loop.
+	virtual bool OnAdviseRequest(CDDESvrConv* /*conversation*/, CDDELink* link, CDDEData& data)
+	{
+		if (link->Format() == CF_OEMTEXT)
+		{
+			const char value[] = "OEM_VALUE";
+
+			data.SetData(value, sizeof(value));
+		}
+		else
+		{
+			data.SetString(VALUE, ANSI_TEXT);
+		}
+
+		return true;
+	}
+
+	//! Handle a command.
+	virtual bool OnExecute(CDDESvrConv* /*conversation*/, const CString& command)
+	{
+		m_lastCommand = command;
+
+		return true;
+	}
+
+	//! Handle an item being poked.
+	virtual bool OnPoke(CDDESvrConv* /*conversation*/, const tchar* /*item*/, uint /*format*/, const CDDEData& data)
+	{
+		m_lastPoke = data.GetString(ANSI_TEXT);
+
+		return true;
+	}
+};
+
+//! The service name.
+const tchar* BrokerServer::SERVICE = TXT("BROKER_SERVER");
+//! The topic name.
+const tchar* BrokerServer::TOPIC = TXT("BROKER_TOPIC");
+//! An item name.
+const tchar* BrokerServer::ITEM = TXT("BROKER_ITEM");
+//! The value for the item.
+const tchar* BrokerServer::VALUE = TXT("BROKER_VALUE");
+
+////////////////////////////////////////////////////////////////////////////////
+//! A DDE client listener that records advise loop updates.
+
+class BrokerClientListener : public CDefDDEClientListener
+{
+public:
+	//! Default constructor.
+	BrokerClientListener()
+		: m_updates(0)
+	{
+	}
+
+	//! Handle an advise loop update.
+	virtual void OnAdvise(CDDELink* /*link*/, const CDDEData* data)
+	{
+		++m_updates;
+		m_lastValue = data->GetString(ANSI_TEXT);
+	}
+
+	//! Handle the completion of an asynchronous transaction.
+	virtual void OnTransactionComplete(DDE::IDDECltConv* /*conversation*/, const DDE::AsyncTransaction& transaction, const CDDEData* data)
+	{
+		m_transactions.push_back(transaction);
+
+		if (data != nullptr)
+			m_lastResult = data->GetString(ANSI_TEXT);
+	}
+
+	//
+	// Members.
+	//
+	size_t								m_updates;		//!< The number of updates received.
+	CString								m_lastValue;	//!< The last value received.
+	std::vector<DDE::AsyncTransaction>	m_transactions;	//!< The transactions completed.
+	CString								m_lastResult;	//!< The last value requested asynchronously.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A DDE client listener that destroys the conversation and tries to start
+//! another batch when a transaction completes during a batch.
+
+class BatchReentrantListener : public CDefDDEClientListener
+{
+public:
+	//! Constructor.
+	BatchReentrantListener(CDDEClient& client)
+		: m_client(client)
+		, m_nestedThrew(false)
+	{
+	}
+
+	//! Handle the completion of an asynchronous transaction.
+	virtual void OnTransactionComplete(DDE::IDDECltConv* conversation, const DDE::AsyncTransaction& transaction, const CDDEData* /*data*/)
+	{
+		CStrArray           items;
+		DDE::RequestResults results;
+
+		items.Add(transaction.m_item);
+
+		m_client.DestroyConversation(conversation);
+
+		try
+		{
+			conversation->RequestMany(items, CF_TEXT, results);
+		}
+		catch (const CDDEException&)
+		{
+			m_nestedThrew = true;
+		}
+	}
+
+	//
+	// Members.
+	//
+	CDDEClient&	m_client;		//!< The client.
+	bool		m_nestedThrew;	//!< Was the nested batch rejected?
+};
+
+TEST_SET(DDEBroker)
+{
+	DDE::DDEBroker::install();
+
+	{
+		// The same order of construction as with the real DDEML.
+		CDDEClient           client;
+		BrokerServer         server;
+		BrokerClientListener listener;
+
+		client.AddListener(&listener);
+
+		const tchar* SERVICE = BrokerServer::SERVICE;
+		const tchar* TOPIC = BrokerServer::TOPIC;
+		const tchar* ITEM = BrokerServer::ITEM;
+		const tchar* VALUE = BrokerServer::VALUE;
+
+TEST_CASE("The broker replaces the DDEML functions when installed")
+{
+	TEST_TRUE(DDE::DDEBroker::isInstalled());
+	TEST_TRUE(&DDE::ddeApi() == &DDE::DDEBroker::api());
+}
+TEST_CASE_END
+
+TEST_CASE("querying for all servers returns the service names registered with the broker")
+{
+	CStrArray servers;
+
+	client.QueryServers(servers);
+
+	TEST_TRUE(servers.Find(SERVICE) != Core::npos);
+}
+TEST_CASE_END
+
+TEST_CASE("querying a server not registered with the broker throws an exception")
+{
+	CStrArray topics;
+
+	TEST_THROWS(client.QueryServerTopics(TXT("InvalidServerName"), topics));
+}
+TEST_CASE_END
+
+TEST_CASE("A conversation can be established through the broker")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	TEST_TRUE(conv->Service() == SERVICE);
+	TEST_TRUE(conv->Topic() == TOPIC);
+	TEST_TRUE(server.m_server.GetNumConversations() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("A conversation is found by its handle and by its service and topic regardless of case")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	TEST_TRUE(client.FindConversation(TXT("broker_server"), TXT("Broker_Topic")) == conv.get());
+	TEST_TRUE(client.FindConversation(SERVICE, TXT("InvalidTopicName")) == nullptr);
+	TEST_TRUE(client.FindConversation(conv->Handle()) == conv.get());
+
+	CDDESvrConv* svrConv = server.m_server.FindConversation(TXT("Broker_Server"), TXT("broker_topic"));
+
+	TEST_TRUE(svrConv != nullptr);
+	TEST_TRUE(server.m_server.FindConversation(svrConv->Handle()) == svrConv);
+
+	conv.Release();
+
+	TEST_TRUE(client.FindConversation(SERVICE, TOPIC) == nullptr);
+	TEST_TRUE(server.m_server.FindConversation(SERVICE, TOPIC) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("A conversation the server disconnects is no longer found by its handle")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+	const HCONV     handle = conv->Handle();
+	CDDESvrConvs    convs;
+
+	server.m_server.GetAllConversations(convs);
+
+	TEST_TRUE(convs.size() == 1);
+
+	server.m_server.DestroyConversation(convs[0]);
+
+	TEST_TRUE(client.FindConversation(handle) == nullptr);
+	TEST_TRUE(client.FindConversation(SERVICE, TOPIC) == conv.get());
+}
+TEST_CASE_END
+
+TEST_CASE("Trying to converse on a topic the server rejects throws an exception")
+{
+	TEST_THROWS(client.CreateConversation(SERVICE, TXT("InvalidTopicName")));
+}
+TEST_CASE_END
+
+TEST_CASE("The value for an item can be requested through the broker")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	TEST_TRUE(conv->RequestString(ITEM, CF_TEXT) == VALUE);
+	TEST_THROWS(conv->RequestString(TXT("InvalidItemName"), CF_TEXT));
+}
+TEST_CASE_END
+
+TEST_CASE("A batch of requests returns a result for every item in the same order")
+{
+	DDE::CltConvPtr     conv(client.CreateConversation(SERVICE, TOPIC));
+	CStrArray           items;
+	DDE::RequestResults results;
+
+	items.Add(ITEM);
+	items.Add(TXT("InvalidItemName"));
+	items.Add(ITEM);
+
+	conv->RequestMany(items, CF_TEXT, results);
+
+	TEST_TRUE(results.size() == 3);
+	TEST_TRUE(results[0].Succeeded() && (results[0].m_item == ITEM));
+	TEST_TRUE(results[0].m_data.GetString(ANSI_TEXT) == VALUE);
+	TEST_FALSE(results[1].Succeeded());
+	TEST_TRUE(results[2].Succeeded() && (results[2].m_data.GetString(ANSI_TEXT) == VALUE));
+
+	const CStrArray none;
+
+	conv->RequestMany(none, CF_TEXT, results);
+
+	TEST_TRUE(results.empty());
+}
+TEST_CASE_END
+
+TEST_CASE("A conversation destroyed by a listener during a batch outlives the batch")
+{
+	DDE::IDDECltConv*      conv = client.CreateConversation(SERVICE, TOPIC);
+	BatchReentrantListener reentrant(client);
+	CStrArray              items;
+	DDE::RequestResults    results;
+
+	items.Add(ITEM);
+
+	client.AddListener(&reentrant);
+
+	conv->RequestAsync(ITEM, CF_TEXT);
+	conv->RequestMany(items, CF_TEXT, results);
+
+	client.RemoveListener(&reentrant);
+
+	TEST_TRUE(reentrant.m_nestedThrew);
+	TEST_TRUE((results.size() == 1) && results[0].Succeeded());
+	TEST_TRUE(client.FindConversation(SERVICE, TOPIC) == nullptr);
+	TEST_TRUE(server.m_server.GetNumConversations() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("An asynchronous request completes through the listener when messages are processed")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	listener.m_transactions.clear();
+
+	const DWORD id = conv->RequestAsync(ITEM, CF_TEXT);
+
+	TEST_TRUE(listener.m_transactions.empty());
+	TEST_TRUE(client.ProcessMessages());
+	TEST_TRUE(listener.m_transactions.size() == 1);
+
+	const DDE::AsyncTransaction& transaction = listener.m_transactions.front();
+
+	TEST_TRUE((transaction.m_id == id) && (transaction.m_type == XTYP_REQUEST));
+	TEST_TRUE((transaction.m_item == ITEM) && (transaction.m_format == CF_TEXT));
+	TEST_TRUE(transaction.Succeeded());
+	TEST_TRUE(listener.m_lastResult == VALUE);
+	TEST_FALSE(client.ProcessMessages());
+}
+TEST_CASE_END
+
+TEST_CASE("Asynchronous transactions complete in the order they were started")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	const char   value[] = "ASYNC_VALUE";
+	const tchar* command = TXT("[Async()]");
+
+	listener.m_transactions.clear();
+
+	const DWORD pokeId = conv->PokeAsync(ITEM, CF_TEXT, value, sizeof(value));
+	const DWORD executeId = conv->ExecuteAsync(command, Core::numBytes<tchar>(tstrlen(command)+1));
+	const DWORD linkId = conv->CreateLinkAsync(ITEM, CF_TEXT);
+	const DWORD failedId = conv->RequestAsync(TXT("InvalidItemName"), CF_TEXT);
+
+	TEST_TRUE(conv->FindLink(ITEM, CF_TEXT) == nullptr);
+
+	client.ProcessMessages();
+
+	TEST_TRUE(listener.m_transactions.size() == 4);
+	TEST_TRUE(listener.m_transactions[0].m_id == pokeId && listener.m_transactions[0].Succeeded());
+	TEST_TRUE(listener.m_transactions[1].m_id == executeId && listener.m_transactions[1].Succeeded());
+	TEST_TRUE(listener.m_transactions[2].m_id == linkId && listener.m_transactions[2].Succeeded());
+	TEST_TRUE(listener.m_transactions[3].m_id == failedId && !listener.m_transactions[3].Succeeded());
+	TEST_TRUE(server.m_lastPoke == TXT("ASYNC_VALUE"));
+	TEST_TRUE(server.m_lastCommand == command);
+
+	CDDELink* link = conv->FindLink(ITEM, CF_TEXT);
+
+	TEST_TRUE((link != nullptr) && (link->RefCount() == 1));
+
+	conv->DestroyLink(link);
+}
+TEST_CASE_END
+
+TEST_CASE("A cancelled asynchronous transaction is never completed")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	listener.m_transactions.clear();
+
+	const DWORD id = conv->RequestAsync(ITEM, CF_TEXT);
+
+	TEST_TRUE(conv->CancelTransaction(id));
+	TEST_FALSE(conv->CancelTransaction(id));
+	TEST_FALSE(client.ProcessMessages());
+	TEST_TRUE(listener.m_transactions.empty());
+}
+TEST_CASE_END
+
+TEST_CASE("Asynchronously linking to an item already linked adds a reference")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	CDDELink* link = conv->CreateLink(ITEM, CF_TEXT);
+
+	listener.m_transactions.clear();
+
+	TEST_TRUE(conv->CreateLinkAsync(ITEM, CF_TEXT) == 0);
+	TEST_TRUE(conv->NumPendingTransactions() == 0);
+	TEST_TRUE(link->RefCount() == 2);
+	TEST_FALSE(client.ProcessMessages());
+	TEST_TRUE(listener.m_transactions.empty());
+
+	conv->DestroyLink(link);
+
+	TEST_TRUE(conv->FindLink(ITEM, CF_TEXT) == link);
+
+	conv->DestroyLink(link);
+
+	TEST_TRUE(conv->FindLink(ITEM, CF_TEXT) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("Outstanding asynchronous transactions fail when the server disconnects")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	listener.m_transactions.clear();
+
+	const DWORD requestId = conv->RequestAsync(ITEM, CF_TEXT);
+	const DWORD linkId = conv->CreateLinkAsync(ITEM, CF_TEXT);
+
+	TEST_TRUE(conv->NumPendingTransactions() == 2);
+
+	CDDESvrConvs convs;
+
+	server.m_server.GetAllConversations(convs);
+
+	TEST_TRUE(convs.size() == 1);
+
+	server.m_server.DestroyConversation(convs[0]);
+
+	TEST_TRUE(conv->NumPendingTransactions() == 0);
+	TEST_TRUE(listener.m_transactions.size() == 2);
+	TEST_TRUE(listener.m_transactions[0].m_id == requestId);
+	TEST_TRUE(listener.m_transactions[0].m_error == DMLERR_NO_CONV_ESTABLISHED);
+	TEST_TRUE(listener.m_transactions[1].m_id == linkId);
+	TEST_TRUE(listener.m_transactions[1].m_error == DMLERR_NO_CONV_ESTABLISHED);
+	TEST_TRUE(conv->FindLink(ITEM, CF_TEXT) == nullptr);
+	TEST_FALSE(client.ProcessMessages());
+}
+TEST_CASE_END
+
+TEST_CASE("A value can be poked and a command executed through the broker")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	conv->PokeString(ITEM, TXT("POKED_VALUE"), CF_TEXT);
+	conv->ExecuteString(TXT("[Command()]"));
+
+	TEST_TRUE(server.m_lastPoke == TXT("POKED_VALUE"));
+	TEST_TRUE(server.m_lastCommand == TXT("[Command()]"));
+}
+TEST_CASE_END
+
+TEST_CASE("An advise loop delivers updates until the link is destroyed")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	CDDELink* link = conv->CreateLink(ITEM, CF_TEXT);
+
+	listener.m_updates = 0;
+
+	TEST_TRUE(server.PostUpdate());
+	TEST_TRUE(server.PostUpdate());
+
+	TEST_TRUE(listener.m_updates == 2);
+	TEST_TRUE(listener.m_lastValue == VALUE);
+
+	conv->DestroyLink(link);
+
+	TEST_TRUE(server.m_link == nullptr);
+	TEST_TRUE(server.m_conv->FindLink(ITEM, CF_TEXT) == nullptr);
+	TEST_TRUE(listener.m_updates == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("A link is found by its item regardless of case and by its format")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	CDDELink* link = conv->CreateLink(ITEM, CF_TEXT);
+
+	TEST_TRUE(conv->FindLink(TXT("broker_item"), CF_TEXT) == link);
+	TEST_TRUE(conv->FindLink(ITEM, CF_UNICODETEXT) == nullptr);
+	TEST_TRUE(conv->FindLink(TXT("OTHER_ITEM"), CF_TEXT) == nullptr);
+	TEST_TRUE(server.m_conv->FindLink(TXT("Broker_Item"), CF_TEXT) == server.m_link);
+
+	conv->DestroyLink(link);
+
+	TEST_TRUE(conv->FindLink(ITEM, CF_TEXT) == nullptr);
+	TEST_TRUE(server.m_conv->FindLink(ITEM, CF_TEXT) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("Links for many items are created and destroyed in one batch")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+	CStrArray       items;
+	CDDECltLinks    links;
+
+	items.Add(ITEM);
+	items.Add(TXT("OTHER_ITEM"));
+	items.Add(TXT("broker_item"));
+
+	TEST_TRUE(conv->CreateLinks(items, CF_TEXT, links) == 3);
+	TEST_TRUE((links.size() == 3) && (links[0] == links[2]));
+	TEST_TRUE(links[0]->RefCount() == 2);
+	TEST_TRUE(conv->NumLinks() == 2);
+	TEST_TRUE(conv->FindLink(TXT("OTHER_ITEM"), CF_TEXT) == links[1]);
+	TEST_TRUE(server.m_conv->FindLink(TXT("OTHER_ITEM"), CF_TEXT) != nullptr);
+
+	conv->DestroyLinks(links);
+
+	TEST_TRUE(conv->NumLinks() == 0);
+	TEST_TRUE(conv->FindLink(ITEM, CF_TEXT) == nullptr);
+	TEST_TRUE(server.m_conv->FindLink(ITEM, CF_TEXT) == nullptr);
+	TEST_TRUE(server.m_conv->FindLink(TXT("OTHER_ITEM"), CF_TEXT) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("Items the server refuses to link to are returned without a link")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+	CStrArray       items;
+	CDDECltLinks    links;
+
+	items.Add(ITEM);
+	items.Add(TXT("OTHER_ITEM"));
+
+	TEST_TRUE(conv->CreateLinks(items, CF_UNICODETEXT, links) == 0);
+	TEST_TRUE((links.size() == 2) && (links[0] == nullptr) && (links[1] == nullptr));
+	TEST_TRUE(conv->NumLinks() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("Destroying all links ends every advise loop regardless of its references")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	conv->CreateLink(ITEM, CF_TEXT);
+	conv->CreateLink(ITEM, CF_TEXT);
+	conv->CreateLink(TXT("OTHER_ITEM"), CF_TEXT);
+
+	conv->DestroyAllLinks();
+
+	TEST_TRUE(conv->NumLinks() == 0);
+	TEST_TRUE(server.m_conv->FindLink(ITEM, CF_TEXT) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("Links and conversations are allocated from the instance's pools")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	CDDELink* first = conv->CreateLink(ITEM, CF_TEXT);
+	CDDELink* other = conv->CreateLink(TXT("OTHER_ITEM"), CF_TEXT);
+	CDDELink* last = conv->CreateLink(TXT("THIRD_ITEM"), CF_TEXT);
+
+	DDE::MemoryStats stats = client.GetMemoryStats();
+
+	TEST_TRUE(stats.m_links.m_inUse == 3);
+	TEST_TRUE(stats.m_convs.m_inUse == 1);
+	TEST_TRUE(stats.m_links.m_reserved != 0);
+	TEST_TRUE(server.m_server.GetMemoryStats().m_links.m_inUse == 3);
+
+	conv->DestroyLink(other);
+
+	TEST_TRUE(conv->NumLinks() == 2);
+	TEST_TRUE((conv->GetLink(0) == first) && (conv->GetLink(1) == last));
+	TEST_TRUE(client.GetMemoryStats().m_links.m_inUse == 2);
+
+	conv->DestroyAllLinks();
+	conv.Release();
+
+	stats = client.GetMemoryStats();
+
+	TEST_TRUE(stats.m_links.m_inUse == 0);
+	TEST_TRUE(stats.m_links.m_peak >= 3);
+	TEST_TRUE(stats.m_convs.m_inUse == 0);
+	TEST_TRUE(server.m_server.GetMemoryStats().m_links.m_inUse == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("Advise updates within the interval are merged and posted later")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	CDDELink* link = conv->CreateLink(ITEM, CF_TEXT);
+
+	listener.m_updates = 0;
+	server.m_server.ResetAdviseStats();
+	server.m_server.SetAdviseInterval(TOPIC, 60000);
+
+	TEST_TRUE(server.ScheduleUpdate());
+	TEST_TRUE(server.ScheduleUpdate());
+	TEST_TRUE(server.ScheduleUpdate());
+
+	TEST_TRUE(listener.m_updates == 1);
+	TEST_TRUE(server.m_server.GetNumPendingUpdates() == 1);
+	TEST_TRUE(server.m_server.PostPendingUpdates() == 0);
+
+	server.m_server.SetAdviseInterval(TOPIC, 0);
+
+	TEST_TRUE(server.m_server.PostPendingUpdates() == 1);
+	TEST_TRUE(listener.m_updates == 2);
+
+	const DDE::AdviseStats& stats = server.m_server.GetAdviseStats();
+
+	TEST_TRUE(stats.m_updates == 3);
+	TEST_TRUE(stats.m_posted == 2);
+	TEST_TRUE(stats.m_coalesced == 1);
+	TEST_TRUE(stats.m_dropped == 0);
+
+	server.m_server.SetAdviseInterval(TOPIC, 60000);
+
+	TEST_TRUE(server.ScheduleUpdate());
+	TEST_TRUE(server.m_server.GetNumPendingUpdates() == 1);
+
+	conv->DestroyLink(link);
+
+	TEST_TRUE(server.m_server.GetNumPendingUpdates() == 0);
+	TEST_TRUE(stats.m_dropped == 1);
+
+	server.m_server.SetAdviseInterval(TOPIC, 0);
+}
+TEST_CASE_END
+
+TEST_CASE("An advise update posted for one link to an item is not posted again for another")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	conv->CreateLink(ITEM, CF_TEXT);
+
+	const CDDELink* firstLink = server.m_link;
+
+	conv->CreateLink(ITEM, CF_OEMTEXT);
+
+	const CDDELink* secondLink = server.m_link;
+
+	listener.m_updates = 0;
+	server.m_server.ResetAdviseStats();
+	server.m_server.SetAdviseInterval(TOPIC, 60000);
+
+	TEST_TRUE(server.m_server.ScheduleLinkUpdate(firstLink));
+	TEST_TRUE(listener.m_updates == 2);
+
+	TEST_TRUE(server.m_server.ScheduleLinkUpdate(secondLink));
+	TEST_TRUE(server.m_server.ScheduleLinkUpdate(firstLink));
+
+	TEST_TRUE(listener.m_updates == 2);
+	TEST_TRUE(server.m_server.GetNumPendingUpdates() == 2);
+
+	server.m_server.SetAdviseInterval(TOPIC, 0);
+
+	TEST_TRUE(server.m_server.PostPendingUpdates() == 1);
+	TEST_TRUE(listener.m_updates == 4);
+	TEST_TRUE(server.m_server.GetNumPendingUpdates() == 0);
+
+	const DDE::AdviseStats& stats = server.m_server.GetAdviseStats();
+
+	TEST_TRUE(stats.m_updates == 3);
+	TEST_TRUE(stats.m_posted == 2);
+	TEST_TRUE(stats.m_coalesced == 1);
+	TEST_TRUE(stats.m_dropped == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("Updates for a set of links are posted in one batch")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	conv->CreateLink(ITEM, CF_TEXT);
+	conv->CreateLink(TXT("OTHER_ITEM"), CF_TEXT);
+	conv->CreateLink(TXT("THIRD_ITEM"), CF_TEXT);
+
+	CDDESvrConvs    convs;
+	CDDELinkUpdates links;
+	CDDELinkUpdates itemLinks;
+
+	server.m_server.GetAllConversations(convs);
+
+	for (size_t i = 0; i != convs.size(); ++i)
+	{
+		for (size_t j = 0; j != convs[i]->NumLinks(); ++j)
+		{
+			const CDDELink* link = convs[i]->GetLink(j);
+
+			links.push_back(link);
+
+			if (link->Item() == ITEM)
+				itemLinks.push_back(link);
+		}
+	}
+
+	TEST_TRUE(links.size() == 3);
+
+	listener.m_updates = 0;
+
+	TEST_TRUE(server.m_server.PostLinkUpdates(itemLinks) == 1);
+	TEST_TRUE(listener.m_updates == 1);
+
+	listener.m_updates = 0;
+
+	TEST_TRUE(server.m_server.PostLinkUpdates(links) == 3);
+	TEST_TRUE(listener.m_updates == 3);
+}
+TEST_CASE_END
+
+TEST_CASE("Destroying a conversation disconnects the server end")
+{
+	DDE::CltConvPtr conv(client.CreateConversation(SERVICE, TOPIC));
+
+	TEST_TRUE(server.m_server.GetNumConversations() == 1);
+
+	conv.Release();
+
+	TEST_TRUE(server.m_server.GetNumConversations() == 0);
+}
+TEST_CASE_END
+
+		client.RemoveListener(&listener);
+	}
+
+	DDE::DDEBroker::uninstall();
+}
+TEST_SET_END
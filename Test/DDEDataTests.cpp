@@ -96,6 +96,65 @@ TEST_CASE("extracting CF_UNICODETEXT value with no string terminator should equa
 }
 TEST_CASE_END
 
+TEST_CASE("a view exposes the data contents in place")
+{
+	const char value[] = "unit test";
+
+	CDDEData data(&instance, value, sizeof(value), 0, CF_TEXT, true);
+
+	CDDEData::CView view(data);
+
+	TEST_FALSE(view.Empty());
+	TEST_TRUE(view.Size() == sizeof(value));
+	TEST_TRUE(memcmp(view.Data(), value, sizeof(value)) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a view of a null data handle is empty")
+{
+	const HDDEDATA noData = NULL;
+
+	CDDEData data(&instance, noData, CF_TEXT, false);
+
+	CDDEData::CView view(data);
+
+	TEST_TRUE(view.Empty());
+	TEST_TRUE(view.Size() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("the buffer for a null data handle is empty")
+{
+	const HDDEDATA noData = NULL;
+
+	CDDEData data(&instance, noData, CF_TEXT, false);
+
+	TEST_TRUE(data.GetBuffer().Size() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("the size and format are known without querying the data handle")
+{
+	CDDEData data(&instance, empty, CF_TEXT, false);
+
+	TEST_TRUE(data.Format() == CF_TEXT);
+	TEST_TRUE(data.Size() == 0);
+
+	data.SetData("unit", 4);
+
+	TEST_TRUE(data.Size() == 4);
+
+	data.SetData(" test", 5, 4);
+
+	TEST_TRUE(data.Size() == 9);
+	TEST_TRUE(data.GetBuffer().Size() == 9);
+
+	data.Free();
+
+	TEST_TRUE(data.Size() == 0);
+}
+TEST_CASE_END
+
 TEST_CASE("Ansi data buffer can be set from an Ansi string")
 {
 	const std::string value = "unit test";
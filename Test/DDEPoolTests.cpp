@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEPoolTests.cpp
+//! \brief  The unit tests for the DDE Pool class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDEPool.hpp>
+#include <vector>
+
+TEST_SET(DDEPool)
+{
+
+TEST_CASE("a freed block is reused by the next allocation")
+{
+	DDE::Pool pool(24);
+
+	void* first = pool.Allocate(24);
+	void* second = pool.Allocate(16);
+
+	TEST_TRUE(first != second);
+	TEST_TRUE(pool.InUse() == 2);
+
+	DDE::Pool::Free(first);
+
+	TEST_TRUE(pool.InUse() == 1);
+	TEST_TRUE(pool.Allocate(24) == first);
+
+	DDE::Pool::Free(first);
+	DDE::Pool::Free(second);
+
+	const DDE::PoolStats stats = pool.Stats();
+
+	TEST_TRUE(stats.m_inUse == 0);
+	TEST_TRUE(stats.m_peak == 2);
+	TEST_TRUE(stats.m_slabs == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("blocks are aligned and do not overlap")
+{
+	DDE::Pool pool(10);
+
+	char* first = static_cast<char*>(pool.Allocate(10));
+	char* second = static_cast<char*>(pool.Allocate(10));
+
+	TEST_TRUE((reinterpret_cast<size_t>(first) % sizeof(double)) == 0);
+	TEST_TRUE((reinterpret_cast<size_t>(second) % sizeof(double)) == 0);
+	TEST_TRUE(second >= first + 10);
+
+	DDE::Pool::Free(first);
+	DDE::Pool::Free(second);
+}
+TEST_CASE_END
+
+TEST_CASE("the pool grows by adding slabs when the free list is empty")
+{
+	DDE::Pool          pool(sizeof(int));
+	std::vector<void*> blocks;
+
+	for (size_t i = 0; i != DDE::Pool::FIRST_SLAB_SIZE+1; ++i)
+		blocks.push_back(pool.Allocate(sizeof(int)));
+
+	const DDE::PoolStats stats = pool.Stats();
+
+	TEST_TRUE(stats.m_slabs == 2);
+	TEST_TRUE(stats.m_inUse == DDE::Pool::FIRST_SLAB_SIZE+1);
+	TEST_TRUE(stats.m_reserved > (3 * DDE::Pool::FIRST_SLAB_SIZE * sizeof(int)));
+
+	for (size_t i = 0; i != blocks.size(); ++i)
+		DDE::Pool::Free(blocks[i]);
+
+	TEST_TRUE(pool.InUse() == 0);
+	TEST_TRUE(pool.Stats().m_slabs == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("a block is returned to the pool it was allocated from")
+{
+	DDE::Pool first(8);
+	DDE::Pool second(8);
+
+	void* block = second.Allocate(8);
+
+	TEST_TRUE(first.InUse() == 0);
+	TEST_TRUE(second.InUse() == 1);
+
+	DDE::Pool::Free(block);
+
+	TEST_TRUE(second.InUse() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("an allocation bigger than the block size is taken from the heap")
+{
+	DDE::Pool pool(8);
+
+	void* block = pool.Allocate(100);
+
+	TEST_TRUE(pool.InUse() == 0);
+	TEST_TRUE(pool.Stats().m_oversized == 1);
+	TEST_TRUE(pool.Stats().m_slabs == 0);
+
+	DDE::Pool::Free(block);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEStringTableTests.cpp
+//! \brief  The unit tests for the DDE StringTable class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDEBroker.hpp>
+#include <NCL/DDEClient.hpp>
+#include <NCL/DDEString.hpp>
+#include <NCL/DDEStringTable.hpp>
+#include <vector>
+
+TEST_SET(DDEStringTable)
+{
+	DDE::DDEBroker::install();
+
+	{
+		CDDEClient  client;
+		const DWORD inst = client.Handle();
+
+TEST_CASE("interning the same name returns the same handle regardless of case")
+{
+	DDE::StringTable table;
+
+	const DDE::StringTable::String& first = table.Acquire(inst, TXT("ITEM"));
+	const DDE::StringTable::String& second = table.Acquire(inst, TXT("item"));
+
+	TEST_TRUE(first.m_hsz == second.m_hsz);
+	TEST_TRUE(first.m_text == TXT("ITEM"));
+	TEST_TRUE(first.m_refs == 2);
+	TEST_TRUE(table.Size() == 1);
+
+	table.Release(inst, first.m_hsz);
+	table.Release(inst, first.m_hsz);
+	table.Purge(inst);
+}
+TEST_CASE_END
+
+TEST_CASE("interning a handle returns its value and the same handle as its name")
+{
+	DDE::StringTable table;
+
+	HSZ hsz = DDE::ddeApi().CreateStringHandle(inst, TXT("TOPIC"), CP_WIN_TCHAR);
+
+	const DDE::StringTable::String& string = table.Acquire(inst, hsz);
+
+	DDE::ddeApi().FreeStringHandle(inst, hsz);
+
+	TEST_TRUE(string.m_text == TXT("TOPIC"));
+	TEST_TRUE(table.Acquire(inst, TXT("Topic")).m_hsz == string.m_hsz);
+
+	table.Release(inst, string.m_hsz);
+	table.Release(inst, string.m_hsz);
+	table.Purge(inst);
+}
+TEST_CASE_END
+
+TEST_CASE("unreferenced strings are kept until purged")
+{
+	DDE::StringTable table;
+
+	HSZ hsz = table.Acquire(inst, TXT("ITEM")).m_hsz;
+
+	table.Release(inst, hsz);
+
+	TEST_TRUE(table.Size() == 1);
+	TEST_TRUE(table.IdleCount() == 1);
+	TEST_TRUE(table.Acquire(inst, TXT("ITEM")).m_hsz == hsz);
+	TEST_TRUE(table.IdleCount() == 0);
+
+	table.Release(inst, hsz);
+	table.Purge(inst);
+
+	TEST_TRUE(table.Size() == 0);
+	TEST_TRUE(table.IdleCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("unreferenced strings are freed once the idle limit is exceeded")
+{
+	DDE::StringTable table;
+
+	for (size_t i = 0; i != DDE::StringTable::MAX_IDLE+1; ++i)
+	{
+		HSZ hsz = table.Acquire(inst, Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)).c_str()).m_hsz;
+
+		table.Release(inst, hsz);
+	}
+
+	TEST_TRUE(table.Size() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("unreferenced strings are kept whilst the referenced ones outnumber them")
+{
+	DDE::StringTable  table;
+	std::vector<HSZ>  held;
+
+	for (size_t i = 0; i != 2*DDE::StringTable::MAX_IDLE; ++i)
+		held.push_back(table.Acquire(inst, Core::fmt(TXT("HELD%u"), static_cast<uint>(i)).c_str()).m_hsz);
+
+	for (size_t i = 0; i != DDE::StringTable::MAX_IDLE+1; ++i)
+	{
+		HSZ hsz = table.Acquire(inst, Core::fmt(TXT("ITEM%u"), static_cast<uint>(i)).c_str()).m_hsz;
+
+		table.Release(inst, hsz);
+	}
+
+	TEST_TRUE(table.IdleCount() == DDE::StringTable::MAX_IDLE+1);
+
+	for (size_t i = 0; i != held.size(); ++i)
+		table.Release(inst, held[i]);
+
+	TEST_TRUE(table.Size() == table.IdleCount());
+	TEST_TRUE(table.IdleCount() <= DDE::StringTable::MAX_IDLE);
+
+	table.Purge(inst);
+}
+TEST_CASE_END
+
+TEST_CASE("a DDE string shares the instance's interned handle")
+{
+	CDDEString first(&client, TXT("ITEM"));
+	CDDEString second(&client, TXT("Item"));
+
+	TEST_TRUE(static_cast<HSZ>(first) == static_cast<HSZ>(second));
+	TEST_TRUE(tstring(static_cast<const tchar*>(second)) == TXT("ITEM"));
+	TEST_TRUE(client.Strings().Acquire(inst, TXT("item")).m_refs == 3);
+
+	client.Strings().Release(inst, first);
+}
+TEST_CASE_END
+
+TEST_CASE("a DDE string given away refers to the interned value")
+{
+	tchar buffer[] = TXT("GIVEN");
+
+	CDDEString string(&client, buffer, false);
+
+	buffer[0] = TXT('X');
+
+	TEST_TRUE(tstring(static_cast<const tchar*>(string)) == TXT("GIVEN"));
+	TEST_TRUE(client.Strings().Acquire(inst, TXT("given")).m_hsz == static_cast<HSZ>(string));
+
+	client.Strings().Release(inst, string);
+
+	// Free the reference given away.
+	TEST_TRUE(DDE::ddeApi().FreeStringHandle(inst, string) != FALSE);
+}
+TEST_CASE_END
+	}
+
+	DDE::DDEBroker::uninstall();
+}
+TEST_SET_END
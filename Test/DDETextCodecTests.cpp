@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETextCodecTests.cpp
+//! \brief  The unit tests for the DDE text transcoding functions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDETextCodec.hpp>
+#include <string>
+#include <algorithm>
+#include <vector>
+
+TEST_SET(DDETextCodec)
+{
+
+TEST_CASE("ASCII text is converted in both directions whatever its length")
+{
+	bool allEqual = true;
+
+	// Cover the partial blocks either side of the block kernels.
+	for (size_t length = 0; length != 70; ++length)
+	{
+		std::string ansi;
+
+		for (size_t i = 0; i != length; ++i)
+			ansi += static_cast<char>('!' + (i % 90));
+
+		std::vector<wchar_t> wide(length+1);
+		std::vector<char>    back(length+1);
+
+		DDE::ansiToUtf16(ansi.data(), length, &wide[0]);
+		DDE::utf16ToAnsi(&wide[0], length, &back[0]);
+
+		for (size_t i = 0; i != length; ++i)
+		{
+			if ( (wide[i] != static_cast<wchar_t>(ansi[i])) || (back[i] != ansi[i]) )
+				allEqual = false;
+		}
+	}
+
+	TEST_TRUE(allEqual);
+}
+TEST_CASE_END
+
+TEST_CASE("the ASCII length stops at the first non-ASCII character")
+{
+	const std::vector<char>    ansi(40, 'a');
+	const std::vector<wchar_t> wide(40, L'a');
+	bool                       allFound = true;
+
+	for (size_t pos = 0; pos != ansi.size(); ++pos)
+	{
+		std::vector<char>    ansiText(ansi);
+		std::vector<wchar_t> wideText(wide);
+
+		ansiText[pos] = '\xE9';
+		wideText[pos] = static_cast<wchar_t>(0x20AC);
+
+		if ( (DDE::asciiLength(&ansiText[0], ansiText.size()) != pos)
+		  || (DDE::asciiLength(&wideText[0], wideText.size()) != pos) )
+			allFound = false;
+	}
+
+	TEST_TRUE(allFound);
+	TEST_TRUE(DDE::asciiLength(&ansi[0], ansi.size()) == ansi.size());
+	TEST_TRUE(DDE::asciiLength(&wide[0], wide.size()) == wide.size());
+}
+TEST_CASE_END
+
+TEST_CASE("UTF-8 text is converted to UTF-16 and back including surrogate pairs")
+{
+	// "A" U+00E9 U+20AC U+1F600 "z"
+	const char    utf8[] = "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z";
+	const wchar_t utf16[] = { L'A', 0x00E9, 0x20AC, 0xD83D, 0xDE00, L'z' };
+
+	const size_t length = ARRAY_SIZE(utf8)-1;
+
+	std::vector<wchar_t> wide(length);
+
+	const size_t units = DDE::utf8ToUtf16(utf8, length, &wide[0]);
+
+	TEST_TRUE(units == ARRAY_SIZE(utf16));
+	TEST_TRUE(std::equal(utf16, utf16+ARRAY_SIZE(utf16), wide.begin()));
+
+	std::vector<char> back(units * DDE::MAX_UTF8_PER_UTF16);
+
+	const size_t bytes = DDE::utf16ToUtf8(&wide[0], units, &back[0]);
+
+	TEST_TRUE(bytes == length);
+	TEST_TRUE(std::equal(utf8, utf8+length, back.begin()));
+}
+TEST_CASE_END
+
+TEST_CASE("an invalid UTF-8 sequence is replaced by U+FFFD")
+{
+	// A stray trailing byte, an overlong '/' and a truncated U+20AC.
+	const char   utf8[] = "a\x80" "b\xC0\xAF" "c\xE2\x82";
+	const size_t length = ARRAY_SIZE(utf8)-1;
+
+	const wchar_t expected[] = { L'a', 0xFFFD, L'b', 0xFFFD, 0xFFFD, L'c', 0xFFFD };
+
+	std::vector<wchar_t> wide(length);
+
+	const size_t units = DDE::utf8ToUtf16(utf8, length, &wide[0]);
+
+	TEST_TRUE(units == ARRAY_SIZE(expected));
+	TEST_TRUE(std::equal(expected, expected+ARRAY_SIZE(expected), wide.begin()));
+}
+TEST_CASE_END
+
+TEST_CASE("an unpaired UTF-16 surrogate is encoded as U+FFFD")
+{
+	const wchar_t utf16[] = { L'a', 0xD800, L'b', 0xDC00 };
+	const char    expected[] = "a\xEF\xBF\xBD" "b\xEF\xBF\xBD";
+
+	std::vector<char> utf8(ARRAY_SIZE(utf16) * DDE::MAX_UTF8_PER_UTF16);
+
+	const size_t bytes = DDE::utf16ToUtf8(utf16, ARRAY_SIZE(utf16), &utf8[0]);
+
+	TEST_TRUE(bytes == ARRAY_SIZE(expected)-1);
+	TEST_TRUE(std::equal(expected, expected+bytes, utf8.begin()));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
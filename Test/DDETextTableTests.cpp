@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDETextTableTests.cpp
+//! \brief  The unit tests for the DDE TextTable class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDETextTable.hpp>
+#include <NCL/DDEData.hpp>
+#include <NCL/DDEClient.hpp>
+#include <string>
+
+TEST_SET(DDETextTable)
+{
+	CDDEClient instance;
+
+TEST_CASE("tab and CR/LF delimited text is split into rows and cells")
+{
+	const char text[] = "A1\tB1\tC1\r\nA2\t\tC2\r\n";
+
+	DDE::TextTable table(text, ARRAY_SIZE(text)-1);
+
+	TEST_TRUE(table.Rows() == 2);
+	TEST_TRUE(table.Columns(0) == 3);
+	TEST_TRUE(table.Columns(1) == 3);
+	TEST_TRUE(table.Cell(0, 0) == TXT("A1"));
+	TEST_TRUE(table.Cell(0, 2) == TXT("C1"));
+	TEST_TRUE(table.Cell(1, 1) == TXT(""));
+	TEST_TRUE(table.Cell(1, 2) == TXT("C2"));
+	TEST_TRUE(table.CellData(1, 0) == text+10);
+	TEST_TRUE(table.CellLength(1, 0) == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("the table ends at the first null and rows may have different lengths")
+{
+	const char text[] = "A1\nA2\tB2\tC2\nA3\0garbage\tgarbage";
+
+	DDE::TextTable table(text, ARRAY_SIZE(text)-1);
+
+	TEST_TRUE(table.Rows() == 3);
+	TEST_TRUE(table.Columns(0) == 1);
+	TEST_TRUE(table.Columns(1) == 3);
+	TEST_TRUE(table.Columns(2) == 1);
+	TEST_TRUE(table.Cell(2, 0) == TXT("A3"));
+}
+TEST_CASE_END
+
+TEST_CASE("empty text has no rows")
+{
+	DDE::TextTable table;
+
+	TEST_TRUE(table.Rows() == 0);
+
+	table.Parse("", 0);
+
+	TEST_TRUE(table.Rows() == 0);
+
+	table.Parse("\0", 1);
+
+	TEST_TRUE(table.Rows() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a cell is only parsed as a number when the whole cell is numeric")
+{
+	const char text[] = "1234.5678\t-1e3\t12abc\t\r\n";
+
+	DDE::TextTable table(text, ARRAY_SIZE(text)-1);
+	double         value = 0.0;
+
+	TEST_TRUE(table.ParseNumber(0, 0, value) && (value == 1234.5678));
+	TEST_TRUE(table.ParseNumber(0, 1, value) && (value == -1000.0));
+	TEST_FALSE(table.ParseNumber(0, 2, value));
+	TEST_FALSE(table.ParseNumber(0, 3, value));
+}
+TEST_CASE_END
+
+TEST_CASE("cells that span many blocks are indexed correctly")
+{
+	const std::string cell(37, 'x');
+	std::string       text;
+
+	for (size_t row = 0; row != 10; ++row)
+	{
+		for (size_t column = 0; column != 20; ++column)
+		{
+			if (column != 0)
+				text += '\t';
+
+			text += cell.substr(0, (row + column) % cell.length());
+		}
+
+		text += "\r\n";
+	}
+
+	DDE::TextTable table(text.data(), text.length());
+	bool           allMatch = (table.Rows() == 10);
+
+	for (size_t row = 0; allMatch && (row != table.Rows()); ++row)
+	{
+		allMatch = (table.Columns(row) == 20);
+
+		for (size_t column = 0; allMatch && (column != table.Columns(row)); ++column)
+			allMatch = (table.CellLength(row, column) == ((row + column) % cell.length()));
+	}
+
+	TEST_TRUE(allMatch);
+}
+TEST_CASE_END
+
+TEST_CASE("a table is decoded in place from the contents of DDE data")
+{
+	const char     text[] = "1\t2\r\n3\t4\r\n";
+	const CDDEData data(&instance, text, sizeof(text), 0, CF_TEXT, true);
+
+	CDDEData::CView view(data);
+	DDE::TextTable  table(view);
+	double          value = 0.0;
+
+	TEST_TRUE(table.Rows() == 2);
+	TEST_TRUE(table.CellData(1, 1) == reinterpret_cast<const char*>(view.Data()) + 7);
+	TEST_TRUE(table.ParseNumber(1, 1, value) && (value == 4.0));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DDEXlTableTests.cpp
+//! \brief  The unit tests for the DDE XlTable encoder and decoder.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/DDEXlTable.hpp>
+#include <NCL/DDEData.hpp>
+#include <NCL/DDEClient.hpp>
+#include <string.h>
+#include <string>
+
+TEST_SET(DDEXlTable)
+{
+	CDDEClient instance;
+
+TEST_CASE("a table of mixed cells survives a round trip through DDE data")
+{
+	CDDEData data(&instance, nullptr, 0, 0, DDE::xlTableFormat(), true);
+
+	DDE::XlTableWriter writer(data, 2, 3);
+
+	writer.WriteNumber(1.5);
+	writer.WriteString(TXT("Text"));
+	writer.WriteBool(true);
+	writer.WriteInteger(-42);
+	writer.WriteBlanks();
+	writer.WriteError(7);
+	writer.End();
+
+	TEST_TRUE(writer.CellsWritten() == 6);
+
+	CDDEData::CView           view(data);
+	DDE::XlTableReader        reader(view);
+	DDE::XlTableReader::Cell  cell;
+
+	TEST_TRUE(reader.Rows() == 2);
+	TEST_TRUE(reader.Columns() == 3);
+
+	TEST_TRUE(reader.Next(cell) && (cell.m_type == DDE::TDT_FLOAT) && (cell.m_number == 1.5));
+	TEST_TRUE(reader.Next(cell) && (cell.m_type == DDE::TDT_STRING) && (cell.String() == TXT("Text")));
+	TEST_TRUE(reader.Next(cell) && (cell.m_type == DDE::TDT_BOOL) && (cell.m_integer == 1));
+	TEST_TRUE(reader.Next(cell) && (cell.m_type == DDE::TDT_INT) && (cell.m_integer == -42));
+	TEST_TRUE(cell.m_row == 1 && cell.m_column == 0);
+	TEST_TRUE(reader.Next(cell) && (cell.m_type == DDE::TDT_BLANK));
+	TEST_TRUE(reader.Next(cell) && (cell.m_type == DDE::TDT_ERROR) && (cell.m_integer == 7));
+	TEST_FALSE(reader.Next(cell));
+}
+TEST_CASE_END
+
+TEST_CASE("consecutive cells of the same type share a record")
+{
+	CDDEData data(&instance, nullptr, 0, 0, DDE::xlTableFormat(), true);
+
+	DDE::XlTableWriter writer(data, 1, 6);
+
+	writer.WriteNumber(1.0);
+	writer.WriteNumber(2.0);
+	writer.WriteBlanks(2);
+	writer.WriteSkips();
+	writer.WriteSkips();
+	writer.End();
+
+	const byte expected[] =
+	{
+		0x10, 0x00, 0x04, 0x00, 0x01, 0x00, 0x06, 0x00,
+		0x01, 0x00, 0x10, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x3F,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,
+		0x05, 0x00, 0x02, 0x00, 0x02, 0x00,
+		0x07, 0x00, 0x02, 0x00, 0x02, 0x00,
+	};
+
+	CDDEData::CView view(data);
+
+	TEST_TRUE(view.Size() == sizeof(expected));
+	TEST_TRUE(memcmp(view.Data(), expected, sizeof(expected)) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("string cells refer to the text within the data")
+{
+	const byte table[] =
+	{
+		0x10, 0x00, 0x04, 0x00, 0x01, 0x00, 0x02, 0x00,
+		0x02, 0x00, 0x05, 0x00, 0x02, 'A', 'B', 0x01, 'C',
+	};
+
+	DDE::XlTableReader       reader(table, sizeof(table));
+	DDE::XlTableReader::Cell cell;
+
+	TEST_TRUE(reader.Next(cell) && (cell.m_text == reinterpret_cast<const char*>(table+13)) && (cell.m_length == 2));
+	TEST_TRUE(reader.Next(cell) && (cell.m_text == reinterpret_cast<const char*>(table+16)) && (cell.m_length == 1));
+	TEST_TRUE(cell.m_row == 0 && cell.m_column == 1);
+	TEST_FALSE(reader.Next(cell));
+}
+TEST_CASE_END
+
+TEST_CASE("strings longer than the format allows are truncated")
+{
+	const std::string text(300, 'x');
+
+	CDDEData data(&instance, nullptr, 0, 0, DDE::xlTableFormat(), true);
+
+	DDE::XlTableWriter writer(data, 1, 1);
+
+	writer.WriteString(text.data(), text.length());
+	writer.End();
+
+	CDDEData::CView          view(data);
+	DDE::XlTableReader       reader(view);
+	DDE::XlTableReader::Cell cell;
+
+	TEST_TRUE(reader.Next(cell) && (cell.m_length == DDE::MAX_XLTABLE_STRING));
+}
+TEST_CASE_END
+
+TEST_CASE("malformed tables throw an exception")
+{
+	const byte badTable[]  = { 0x01, 0x00, 0x04, 0x00, 0x01, 0x00, 0x01, 0x00 };
+	const byte truncated[] = { 0x10, 0x00, 0x04, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x08, 0x00, 0x00 };
+	const byte badType[]   = { 0x10, 0x00, 0x04, 0x00, 0x01, 0x00, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00 };
+	const byte badString[] = { 0x10, 0x00, 0x04, 0x00, 0x01, 0x00, 0x01, 0x00, 0x02, 0x00, 0x02, 0x00, 0x05, 'A' };
+	const byte missing[]   = { 0x10, 0x00, 0x04, 0x00, 0x01, 0x00, 0x02, 0x00, 0x06, 0x00, 0x02, 0x00, 0x01, 0x00 };
+
+	DDE::XlTableReader::Cell cell;
+
+	TEST_THROWS(DDE::XlTableReader(badTable, sizeof(badTable)));
+	TEST_THROWS(DDE::XlTableReader(truncated, sizeof(truncated)).Next(cell));
+	TEST_THROWS(DDE::XlTableReader(badType, sizeof(badType)).Next(cell));
+	TEST_THROWS(DDE::XlTableReader(badString, sizeof(badString)).Next(cell));
+
+	DDE::XlTableReader reader(missing, sizeof(missing));
+
+	TEST_TRUE(reader.Next(cell) && (cell.m_integer == 1));
+	TEST_THROWS(reader.Next(cell));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
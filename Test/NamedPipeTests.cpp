@@ -0,0 +1,351 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NamedPipeTests.cpp
+//! \brief  The unit tests for the CNamedPipe class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/ServerPipe.hpp>
+#include <NCL/ClientPipe.hpp>
+#include <NCL/PipeException.hpp>
+#include <NCL/IPipeWriteListener.hpp>
+#include <WCL/Event.hpp>
+#include <vector>
+
+namespace
+{
+
+//! The size of a message too big to fit in the pipe buffer.
+const size_t LARGE_MESSAGE = 8192;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The write listener which records each completed write.
+
+class WriteRecorder : public IPipeWriteListener
+{
+public:
+	virtual void OnWriteComplete(CNamedPipe* /*pPipe*/, size_t nBytes)
+	{
+		m_sizes.push_back(nBytes);
+	}
+
+	std::vector<size_t>	m_sizes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The thread which closes a pipe after a short delay.
+
+DWORD WINAPI closePipeThread(LPVOID param)
+{
+	::Sleep(50);
+
+	static_cast<CNamedPipe*>(param)->Close();
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The thread which reads two large messages from a pipe after a short delay.
+
+DWORD WINAPI readPipeThread(LPVOID param)
+{
+	::Sleep(50);
+
+	CNamedPipe*       pipe = static_cast<CNamedPipe*>(param);
+	std::vector<byte> buffer(LARGE_MESSAGE);
+
+	pipe->Read(&buffer[0], buffer.size());
+	pipe->Read(&buffer[0], buffer.size());
+
+	return 0;
+}
+
+//namespace
+}
+
+TEST_SET(NamedPipe)
+{
+	const tchar* PIPE_NAME = TXT("\\\\.\\pipe\\ncl-test-pipe");
+
+TEST_CASE("a write depth of zero is treated as one")
+{
+	CServerPipe server;
+
+	server.SetWriteDepth(0);
+
+	TEST_TRUE(server.WriteDepth() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("queued writes are reported to the listener in the order written")
+{
+	CServerPipe   server;
+	CClientPipe   client;
+	WriteRecorder recorder;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	server.SetWriteDepth(4);
+	server.SetWriteListener(&recorder);
+
+	server.Write("1", 1);
+	server.Write("22", 2);
+	server.Write("333", 3);
+	server.Flush();
+
+	TEST_TRUE(server.PendingWrites() == 0);
+	TEST_TRUE(recorder.m_sizes.size() == 3);
+	TEST_TRUE((recorder.m_sizes[0] == 1) && (recorder.m_sizes[1] == 2) && (recorder.m_sizes[2] == 3));
+
+	char buffer[3];
+
+	client.Read(buffer, 1);
+	TEST_TRUE(memcmp(buffer, "1", 1) == 0);
+	client.Read(buffer, 2);
+	TEST_TRUE(memcmp(buffer, "22", 2) == 0);
+	client.Read(buffer, 3);
+	TEST_TRUE(memcmp(buffer, "333", 3) == 0);
+
+	server.Close();
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("a write to a full queue waits for the oldest write to complete")
+{
+	CServerPipe   server;
+	CClientPipe   client;
+	WriteRecorder recorder;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	server.SetWriteDepth(2);
+	server.SetWriteListener(&recorder);
+
+	std::vector<byte> message(LARGE_MESSAGE, 0xAA);
+	std::vector<byte> buffer(LARGE_MESSAGE);
+
+	server.Write(&message[0], message.size());
+	server.Write(&message[0], message.size());
+
+	TEST_TRUE(server.PendingWrites() == 2);
+
+	client.Read(&buffer[0], buffer.size());
+
+	server.Write(&message[0], message.size());
+
+	TEST_TRUE(recorder.m_sizes.size() >= 1);
+	TEST_TRUE(recorder.m_sizes[0] == LARGE_MESSAGE);
+
+	client.Read(&buffer[0], buffer.size());
+	client.Read(&buffer[0], buffer.size());
+	server.Flush();
+
+	TEST_TRUE(server.PendingWrites() == 0);
+	TEST_TRUE(recorder.m_sizes.size() == 3);
+
+	server.Close();
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("a write to a full queue times out if the reader never drains it")
+{
+	CServerPipe   server;
+	CClientPipe   client;
+	WriteRecorder recorder;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	server.SetTimeOut(100);
+	server.SetWriteDepth(2);
+	server.SetWriteListener(&recorder);
+
+	std::vector<byte> message(LARGE_MESSAGE);
+
+	server.Write(&message[0], message.size());
+	server.Write(&message[0], message.size());
+
+	bool timedOut = false;
+
+	try
+	{
+		server.Write(&message[0], message.size());
+	}
+	catch (const CPipeException& e)
+	{
+		timedOut = (e.m_hResult == WAIT_TIMEOUT);
+	}
+
+	TEST_TRUE(timedOut);
+	TEST_TRUE(server.PendingWrites() == 0);
+	TEST_TRUE(recorder.m_sizes.empty());
+
+	server.Close();
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("closing a pipe waits for the outstanding writes to be read")
+{
+	CServerPipe   server;
+	CClientPipe   client;
+	WriteRecorder recorder;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	server.SetWriteDepth(2);
+	server.SetWriteListener(&recorder);
+
+	std::vector<byte> message(LARGE_MESSAGE);
+
+	server.Write(&message[0], message.size());
+	server.Write(&message[0], message.size());
+
+	TEST_TRUE(server.PendingWrites() == 2);
+
+	HANDLE thread = ::CreateThread(nullptr, 0, readPipeThread, &client, 0, nullptr);
+
+	server.Close();
+
+	::WaitForSingleObject(thread, INFINITE);
+	::CloseHandle(thread);
+
+	TEST_FALSE(server.IsOpen());
+	TEST_TRUE(recorder.m_sizes.size() == 2);
+
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("closing a pipe cancels the writes that are never read without reporting them")
+{
+	CServerPipe   server;
+	CClientPipe   client;
+	WriteRecorder recorder;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	server.SetWriteDepth(2);
+	server.SetWriteListener(&recorder);
+
+	std::vector<byte> message(LARGE_MESSAGE);
+
+	server.Write(&message[0], message.size());
+	server.Write(&message[0], message.size());
+
+	TEST_TRUE(server.PendingWrites() == 2);
+
+	server.SetTimeOut(10);
+	server.Close();
+
+	TEST_FALSE(server.IsOpen());
+	TEST_TRUE(server.PendingWrites() == 0);
+	TEST_TRUE(recorder.m_sizes.empty());
+
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("a handle written to the pipe can be read by the peer")
+{
+	CServerPipe server;
+	CClientPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	CEvent event(true, false);
+
+	server.WriteHandle(event.Handle());
+
+	HANDLE handle = client.ReadHandle();
+
+	TEST_TRUE(handle != event.Handle());
+
+	::SetEvent(handle);
+
+	TEST_TRUE(::WaitForSingleObject(event.Handle(), 0) == WAIT_OBJECT_0);
+
+	::CloseHandle(handle);
+
+	server.Close();
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("a handle that could not be written is not leaked in the peer")
+{
+	CServerPipe server;
+	CClientPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	client.Close();
+
+	CEvent event(true, false);
+	DWORD  before = 0;
+	DWORD  after = 0;
+
+	::GetProcessHandleCount(::GetCurrentProcess(), &before);
+
+	TEST_THROWS(server.WriteHandle(event.Handle()));
+
+	::GetProcessHandleCount(::GetCurrentProcess(), &after);
+
+	TEST_TRUE(after == before);
+
+	server.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("closing a pipe on another thread aborts a blocked read")
+{
+	CServerPipe server;
+	CClientPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	TEST_TRUE(server.Accept());
+
+	client.SetTimeOut(5000);
+
+	HANDLE thread = ::CreateThread(nullptr, 0, closePipeThread, &client, 0, nullptr);
+	DWORD  start = ::GetTickCount();
+	char   buffer[1];
+
+	TEST_THROWS(client.Read(buffer, sizeof(buffer)));
+	TEST_TRUE((::GetTickCount() - start) < 5000);
+
+	::WaitForSingleObject(thread, INFINITE);
+	::CloseHandle(thread);
+
+	TEST_FALSE(client.IsOpen());
+
+	server.Close();
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCProtocolTests.cpp
+//! \brief  The unit tests for the RPC message framing functions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/RPCProtocol.hpp>
+#include <NCL/NetBuffer.hpp>
+
+TEST_SET(RPCProtocol)
+{
+TEST_CASE("a header is encoded in network byte order")
+{
+	const RPC::Header header = { 0x01020304, 0x05060708, RPC::REQUEST, 0x0A0B };
+	byte buffer[RPC::HEADER_SIZE];
+
+	RPC::encodeHeader(header, buffer);
+
+	const byte expected[RPC::HEADER_SIZE] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x00, 0x01, 0x0A, 0x0B };
+
+	TEST_TRUE(memcmp(buffer, expected, RPC::HEADER_SIZE) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a decoded header matches the one encoded")
+{
+	const RPC::Header header = { 42, 0xFFFFFFFE, RPC::RESPONSE, RPC::UNKNOWN_METHOD };
+	byte buffer[RPC::HEADER_SIZE];
+
+	RPC::encodeHeader(header, buffer);
+
+	const RPC::Header decoded = RPC::decodeHeader(buffer);
+
+	TEST_TRUE(decoded.m_length == header.m_length);
+	TEST_TRUE(decoded.m_id == header.m_id);
+	TEST_TRUE(decoded.m_type == header.m_type);
+	TEST_TRUE(decoded.m_code == header.m_code);
+}
+TEST_CASE_END
+
+TEST_CASE("an appended message can be parsed back out of the buffer")
+{
+	const char payload[] = "payload";
+	CNetBuffer buffer;
+
+	RPC::appendMessage(buffer, RPC::REQUEST, 7, 3, payload, sizeof(payload));
+
+	RPC::Header header;
+	size_t      messageSize = 0;
+
+	TEST_TRUE(RPC::parseMessage(static_cast<const byte*>(buffer.Ptr()), buffer.Size(), header, messageSize));
+	TEST_TRUE(messageSize == buffer.Size());
+	TEST_TRUE(header.m_id == 7);
+	TEST_TRUE(header.m_code == 3);
+	TEST_TRUE(header.m_length == sizeof(payload));
+	TEST_TRUE(memcmp(static_cast<const byte*>(buffer.Ptr()) + RPC::HEADER_SIZE, payload, sizeof(payload)) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a notification message can be parsed")
+{
+	CNetBuffer buffer;
+
+	RPC::appendMessage(buffer, RPC::NOTIFY, 0, 5, nullptr, 0);
+
+	RPC::Header header;
+	size_t      messageSize = 0;
+
+	TEST_TRUE(RPC::parseMessage(static_cast<const byte*>(buffer.Ptr()), buffer.Size(), header, messageSize));
+	TEST_TRUE(header.m_type == RPC::NOTIFY);
+	TEST_TRUE(header.m_code == 5);
+}
+TEST_CASE_END
+
+TEST_CASE("an incomplete message is not parsed")
+{
+	const char payload[] = "payload";
+	CNetBuffer buffer;
+
+	RPC::appendMessage(buffer, RPC::REQUEST, 1, 1, payload, sizeof(payload));
+
+	RPC::Header header;
+	size_t      messageSize = 0;
+	const byte* data = static_cast<const byte*>(buffer.Ptr());
+
+	TEST_FALSE(RPC::parseMessage(data, RPC::HEADER_SIZE-1, header, messageSize));
+	TEST_FALSE(RPC::parseMessage(data, buffer.Size()-1, header, messageSize));
+}
+TEST_CASE_END
+
+TEST_CASE("pipelined messages are parsed in the order they were appended")
+{
+	CNetBuffer buffer;
+
+	RPC::appendMessage(buffer, RPC::RESPONSE, 1, RPC::OK, nullptr, 0);
+	RPC::appendMessage(buffer, RPC::RESPONSE, 2, RPC::OK, "x", 1);
+	RPC::appendMessage(buffer, RPC::RESPONSE, 3, RPC::OK, nullptr, 0);
+
+	const byte* data = static_cast<const byte*>(buffer.Ptr());
+	size_t      size = buffer.Size();
+	size_t      consumed = 0;
+	DWORD       expectedID = 1;
+	RPC::Header header;
+	size_t      messageSize = 0;
+
+	while (RPC::parseMessage(data+consumed, size-consumed, header, messageSize))
+	{
+		TEST_TRUE(header.m_id == expectedID);
+
+		consumed += messageSize;
+		++expectedID;
+	}
+
+	TEST_TRUE(expectedID == 4);
+	TEST_TRUE(consumed == size);
+}
+TEST_CASE_END
+
+TEST_CASE("parsing a header with an oversized payload throws")
+{
+	const RPC::Header header = { RPC::MAX_PAYLOAD_SIZE+1, 1, RPC::REQUEST, 0 };
+	byte buffer[RPC::HEADER_SIZE];
+
+	RPC::encodeHeader(header, buffer);
+
+	RPC::Header decoded;
+	size_t      messageSize = 0;
+
+	TEST_THROWS(RPC::parseMessage(buffer, RPC::HEADER_SIZE, decoded, messageSize));
+}
+TEST_CASE_END
+
+TEST_CASE("parsing a header with an unknown message type throws")
+{
+	const RPC::Header header = { 0, 1, 99, 0 };
+	byte buffer[RPC::HEADER_SIZE];
+
+	RPC::encodeHeader(header, buffer);
+
+	RPC::Header decoded;
+	size_t      messageSize = 0;
+
+	TEST_THROWS(RPC::parseMessage(buffer, RPC::HEADER_SIZE, decoded, messageSize));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
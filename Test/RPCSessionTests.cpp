@@ -0,0 +1,436 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RPCSessionTests.cpp
+//! \brief  The round-trip tests for the RPC client session and dispatcher.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/AutoWinSock.hpp>
+#include <NCL/WinSock.hpp>
+#include <NCL/TCPSvrSocket.hpp>
+#include <NCL/TCPCltSocket.hpp>
+#include <NCL/RPCCltSession.hpp>
+#include <NCL/RPCSvrDispatcher.hpp>
+#include <NCL/IRPCRequestHandler.hpp>
+#include <NCL/IRPCResponseHandler.hpp>
+#include <NCL/IRPCNotifyHandler.hpp>
+#include <WCL/Module.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//! The port used for the loopback connection.
+const uint TEST_PORT = 50226;
+//! The port used for the dispatcher that is closed by its handler.
+const uint CLOSE_ALL_PORT = 50227;
+
+//! The methods supported by the test handler.
+enum Method
+{
+	ECHO		= 1,	//!< Return the payload.
+	THROW_STD	= 2,	//!< Throw a std::exception.
+	CLOSE		= 3,	//!< Close the client connection.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The server handler used by the tests.
+
+class TestHandler : public RPC::IRequestHandler
+{
+public:
+	TestHandler()
+		: m_client(nullptr)
+	{ }
+
+	virtual WORD OnRequest(CSocket& client, WORD method, const byte* payload, size_t size, CNetBuffer& response)
+	{
+		m_client = &client;
+
+		switch (method)
+		{
+			case ECHO:
+				if (size != 0)
+					response.Append(payload, size);
+				return RPC::OK;
+
+			case THROW_STD:
+				throw std::runtime_error("handler failed");
+
+			case CLOSE:
+				client.Close();
+				return RPC::OK;
+		}
+
+		return RPC::UNKNOWN_METHOD;
+	}
+
+	virtual void OnClientClosed(CSocket& client)
+	{
+		if (m_client == &client)
+			m_client = nullptr;
+	}
+
+	CSocket*	m_client;	//!< The client of the last request.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The server handler which closes every client when told one has closed.
+
+class CloseAllHandler : public RPC::IRequestHandler
+{
+public:
+	CloseAllHandler()
+		: m_dispatcher(nullptr)
+	{ }
+
+	virtual WORD OnRequest(CSocket& /*client*/, WORD /*method*/, const byte* /*payload*/, size_t /*size*/, CNetBuffer& /*response*/)
+	{
+		return RPC::OK;
+	}
+
+	virtual void OnClientClosed(CSocket& client)
+	{
+		m_closed.push_back(&client);
+
+		m_dispatcher->CloseClients();
+	}
+
+	RPC::SvrDispatcher*		m_dispatcher;	//!< The dispatcher being handled.
+	std::vector<CSocket*>	m_closed;		//!< The clients closed.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The outcome of a call.
+
+struct Result
+{
+	DWORD		m_id;		//!< The request ID.
+	bool		m_failed;	//!< Did the call fail?
+	int			m_code;		//!< The status or failure reason.
+	std::string	m_payload;	//!< The response payload.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The client handler which records the outcome of each call.
+
+class ResultRecorder : public RPC::IResponseHandler
+{
+public:
+	virtual void OnResponse(RPC::CltSession& /*session*/, DWORD id, WORD status, const byte* payload, size_t size)
+	{
+		Result result = { id, false, status, std::string(reinterpret_cast<const char*>(payload), size) };
+
+		m_results.push_back(result);
+	}
+
+	virtual void OnFailed(RPC::CltSession& /*session*/, DWORD id, int reason)
+	{
+		Result result = { id, true, reason, std::string() };
+
+		m_results.push_back(result);
+	}
+
+	std::vector<Result>	m_results;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The client handler which records each notification.
+
+class NotifyRecorder : public RPC::INotifyHandler
+{
+public:
+	virtual void OnNotify(RPC::CltSession& /*session*/, WORD code, const byte* payload, size_t size)
+	{
+		m_codes.push_back(code);
+		m_payloads.push_back(std::string(reinterpret_cast<const char*>(payload), size));
+	}
+
+	std::vector<WORD>			m_codes;
+	std::vector<std::string>	m_payloads;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The condition satisfied when a number of notifications have been recorded.
+
+struct HasNotifications
+{
+	HasNotifications(const NotifyRecorder& recorder, size_t count)
+		: m_recorder(recorder), m_count(count)
+	{ }
+
+	bool operator()() const
+	{
+		return (m_recorder.m_codes.size() >= m_count);
+	}
+
+	const NotifyRecorder&	m_recorder;
+	size_t					m_count;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Process socket events until the condition is met or a timeout expires.
+
+template<typename Condition>
+bool pumpUntil(Condition condition)
+{
+	const DWORD start = ::GetTickCount();
+
+	while (!condition())
+	{
+		if ((::GetTickCount() - start) > 5000)
+			return false;
+
+		::MsgWaitForMultipleObjects(0, nullptr, FALSE, 10, QS_ALLINPUT);
+
+		CWinSock::ProcessSocketMsgs();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The condition satisfied when a number of results have been recorded.
+
+struct HasResults
+{
+	HasResults(const ResultRecorder& recorder, size_t count)
+		: m_recorder(recorder), m_count(count)
+	{ }
+
+	bool operator()() const
+	{
+		return (m_recorder.m_results.size() >= m_count);
+	}
+
+	const ResultRecorder&	m_recorder;
+	size_t					m_count;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The condition satisfied when the dispatcher has a number of clients.
+
+struct HasClients
+{
+	HasClients(const RPC::SvrDispatcher& dispatcher, size_t count)
+		: m_dispatcher(dispatcher), m_count(count)
+	{ }
+
+	bool operator()() const
+	{
+		return (m_dispatcher.ClientCount() == m_count);
+	}
+
+	const RPC::SvrDispatcher&	m_dispatcher;
+	size_t						m_count;
+};
+
+//namespace
+}
+
+TEST_SET(RPCSession)
+{
+	CModule     module;
+	AutoWinSock autoWinSock;
+
+	CTCPSvrSocket server(CSocket::ASYNC);
+	TestHandler   handler;
+
+	server.Listen(TEST_PORT);
+
+	RPC::SvrDispatcher dispatcher(server, handler);
+
+TEST_CASE("a request is answered with the response from the handler")
+{
+	CTCPCltSocket   client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), TEST_PORT);
+
+	RPC::CltSession session(client);
+	ResultRecorder  recorder;
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 1)));
+
+	const DWORD id = session.Call(ECHO, "payload", 7, &recorder);
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 1)));
+	TEST_TRUE(recorder.m_results[0].m_id == id);
+	TEST_FALSE(recorder.m_results[0].m_failed);
+	TEST_TRUE(recorder.m_results[0].m_code == RPC::OK);
+	TEST_TRUE(recorder.m_results[0].m_payload == "payload");
+	TEST_TRUE(session.Outstanding() == 0);
+
+	client.Close();
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 0)));
+}
+TEST_CASE_END
+
+TEST_CASE("a batch of requests is answered in the order sent")
+{
+	CTCPCltSocket   client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), TEST_PORT);
+
+	RPC::CltSession session(client);
+	ResultRecorder  recorder;
+	DWORD           ids[3];
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 1)));
+
+	session.BeginBatch();
+
+	ids[0] = session.Call(ECHO, "1", 1, &recorder);
+	ids[1] = session.Call(99, nullptr, 0, &recorder);
+	ids[2] = session.Call(ECHO, "3", 1, &recorder);
+
+	session.EndBatch();
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 3)));
+	TEST_TRUE((recorder.m_results[0].m_id == ids[0]) && (recorder.m_results[0].m_payload == "1"));
+	TEST_TRUE((recorder.m_results[1].m_id == ids[1]) && (recorder.m_results[1].m_code == RPC::UNKNOWN_METHOD));
+	TEST_TRUE((recorder.m_results[2].m_id == ids[2]) && (recorder.m_results[2].m_payload == "3"));
+
+	client.Close();
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 0)));
+}
+TEST_CASE_END
+
+TEST_CASE("a handler that throws a standard exception fails only that request")
+{
+	CTCPCltSocket   client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), TEST_PORT);
+
+	RPC::CltSession session(client);
+	ResultRecorder  recorder;
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 1)));
+
+	session.BeginBatch();
+	session.Call(THROW_STD, nullptr, 0, &recorder);
+	session.Call(ECHO, "after", 5, &recorder);
+	session.EndBatch();
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 2)));
+	TEST_TRUE(!recorder.m_results[0].m_failed && (recorder.m_results[0].m_code == RPC::HANDLER_FAILED));
+	TEST_TRUE(!recorder.m_results[1].m_failed && (recorder.m_results[1].m_payload == "after"));
+
+	client.Close();
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 0)));
+}
+TEST_CASE_END
+
+TEST_CASE("a handler that closes the connection fails the calls in flight")
+{
+	CTCPCltSocket   client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), TEST_PORT);
+
+	RPC::CltSession session(client);
+	ResultRecorder  recorder;
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 1)));
+
+	session.BeginBatch();
+	session.Call(CLOSE, nullptr, 0, &recorder);
+	session.Call(ECHO, "unanswered", 10, &recorder);
+	session.EndBatch();
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 2)));
+	TEST_TRUE(recorder.m_results[0].m_failed && (recorder.m_results[0].m_code == RPC::DISCONNECTED));
+	TEST_TRUE(recorder.m_results[1].m_failed && (recorder.m_results[1].m_code == RPC::DISCONNECTED));
+	TEST_TRUE(dispatcher.ClientCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a handler that closes the clients whilst being notified is told once about each")
+{
+	CTCPSvrSocket   closeAllServer(CSocket::ASYNC);
+	CloseAllHandler closeAllHandler;
+
+	closeAllServer.Listen(CLOSE_ALL_PORT);
+
+	RPC::SvrDispatcher closeAllDispatcher(closeAllServer, closeAllHandler);
+	CTCPCltSocket      first(CSocket::ASYNC);
+	CTCPCltSocket      second(CSocket::ASYNC);
+
+	closeAllHandler.m_dispatcher = &closeAllDispatcher;
+
+	first.Connect(TXT("localhost"), CLOSE_ALL_PORT);
+	second.Connect(TXT("localhost"), CLOSE_ALL_PORT);
+
+	TEST_TRUE(pumpUntil(HasClients(closeAllDispatcher, 2)));
+
+	closeAllDispatcher.CloseClients();
+
+	TEST_TRUE(closeAllHandler.m_closed.size() == 2);
+	TEST_TRUE(closeAllHandler.m_closed[0] != closeAllHandler.m_closed[1]);
+	TEST_TRUE(closeAllDispatcher.ClientCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a notification is passed to the session's notify handler")
+{
+	CTCPCltSocket   client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), TEST_PORT);
+
+	RPC::CltSession session(client);
+	ResultRecorder  recorder;
+	NotifyRecorder  notifications;
+
+	session.SetNotifyHandler(&notifications);
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 1)));
+
+	session.Call(ECHO, nullptr, 0, &recorder);
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 1)));
+	TEST_TRUE(handler.m_client != nullptr);
+
+	dispatcher.Notify(*handler.m_client, 42, "news", 4);
+
+	TEST_TRUE(pumpUntil(HasNotifications(notifications, 1)));
+	TEST_TRUE(notifications.m_codes[0] == 42);
+	TEST_TRUE(notifications.m_payloads[0] == "news");
+	TEST_TRUE(client.IsOpen());
+
+	client.Close();
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 0)));
+}
+TEST_CASE_END
+
+TEST_CASE("a notification without a notify handler fails the session")
+{
+	CTCPCltSocket   client(CSocket::ASYNC);
+
+	client.Connect(TXT("localhost"), TEST_PORT);
+
+	RPC::CltSession session(client);
+	ResultRecorder  recorder;
+
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 1)));
+
+	session.Call(ECHO, nullptr, 0, &recorder);
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 1)));
+	TEST_TRUE(handler.m_client != nullptr);
+
+	dispatcher.Notify(*handler.m_client, 42, "news", 4);
+	session.Call(ECHO, "unanswered", 10, &recorder);
+
+	TEST_TRUE(pumpUntil(HasResults(recorder, 2)));
+	TEST_TRUE(recorder.m_results[1].m_failed && (recorder.m_results[1].m_code == RPC::BAD_MESSAGE));
+	TEST_FALSE(client.IsOpen());
+	TEST_TRUE(pumpUntil(HasClients(dispatcher, 0)));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
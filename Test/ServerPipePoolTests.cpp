@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ServerPipePoolTests.cpp
+//! \brief  The unit tests for the CServerPipePool class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/ServerPipePool.hpp>
+#include <NCL/ClientPipe.hpp>
+#include <NCL/PipeException.hpp>
+
+TEST_SET(ServerPipePool)
+{
+	const tchar* PIPE_NAME = TXT("\\\\.\\pipe\\ncl-test-pipe-pool");
+
+TEST_CASE("the number of instances is limited to what can be waited on at once")
+{
+	CServerPipePool none(0);
+	CServerPipePool many(MAXIMUM_WAIT_OBJECTS + 1);
+
+	TEST_TRUE(none.Instances() == 1);
+	TEST_TRUE(many.Instances() == MAXIMUM_WAIT_OBJECTS);
+}
+TEST_CASE_END
+
+TEST_CASE("accepting when no client has connected times out")
+{
+	CServerPipePool pool(1);
+
+	pool.Create(PIPE_NAME);
+
+	CServerPipePool::ServerPipePtr pipe = pool.Accept(10);
+
+	TEST_TRUE(pipe.get() == nullptr);
+	TEST_TRUE(pool.IsOpen());
+}
+TEST_CASE_END
+
+TEST_CASE("an accepted instance is connected to the client")
+{
+	CServerPipePool pool(1);
+	CClientPipe     client;
+
+	pool.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	CServerPipePool::ServerPipePtr pipe = pool.Accept(1000);
+
+	TEST_TRUE(pipe.get() != nullptr);
+
+	char buffer[4];
+
+	client.Write("ping", 4);
+	pipe->Read(buffer, 4);
+
+	TEST_TRUE(memcmp(buffer, "ping", 4) == 0);
+
+	pipe->Close();
+	client.Close();
+}
+TEST_CASE_END
+
+TEST_CASE("an accepted instance is replaced so that more clients can connect")
+{
+	CServerPipePool pool(1);
+	CClientPipe     clients[3];
+
+	pool.Create(PIPE_NAME);
+
+	for (size_t i = 0; i != 3; ++i)
+	{
+		clients[i].Open(PIPE_NAME);
+
+		CServerPipePool::ServerPipePtr pipe = pool.Accept(1000);
+
+		TEST_TRUE(pipe.get() != nullptr);
+		TEST_TRUE(pool.IsOpen());
+
+		char buffer[1] = { 0 };
+
+		pipe->Write("x", 1);
+		clients[i].Read(buffer, 1);
+
+		TEST_TRUE(buffer[0] == 'x');
+
+		pipe->Close();
+		clients[i].Close();
+	}
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
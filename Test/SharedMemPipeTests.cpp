@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SharedMemPipeTests.cpp
+//! \brief  The unit tests for the CSharedMemPipe class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/SharedMemPipe.hpp>
+#include <NCL/PipeException.hpp>
+
+TEST_SET(SharedMemPipe)
+{
+	const tchar* PIPE_NAME = TXT("ncl-test-shm");
+
+TEST_CASE("the capacity is rounded up to a power of 2")
+{
+	CSharedMemPipe pipe;
+
+	pipe.Create(PIPE_NAME, 1000);
+
+	TEST_TRUE(pipe.Capacity() == 1024);
+}
+TEST_CASE_END
+
+TEST_CASE("messages written at one end are read in order at the other")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	client.Write("hello", 5);
+	client.Write("world!", 6);
+
+	char buffer[6];
+
+	TEST_TRUE(server.Available() == 5);
+	server.Read(buffer, 5);
+	TEST_TRUE(memcmp(buffer, "hello", 5) == 0);
+
+	TEST_TRUE(server.Available() == 6);
+	server.Read(buffer, 6);
+	TEST_TRUE(memcmp(buffer, "world!", 6) == 0);
+
+	TEST_TRUE(server.Available() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("messages wrap around the end of the ring buffer")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME, 64);
+	client.Open(PIPE_NAME);
+
+	byte message[25];
+	byte buffer[25];
+
+	for (byte i = 0; i != 20; ++i)
+	{
+		memset(message, i, sizeof(message));
+
+		server.Write(message, sizeof(message));
+		client.Read(buffer, sizeof(buffer));
+
+		TEST_TRUE(memcmp(buffer, message, sizeof(message)) == 0);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("peeking at a message does not remove it")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	server.Write("message", 7);
+
+	char buffer[7];
+
+	TEST_TRUE(client.Peek(buffer, 3) == 3);
+	TEST_TRUE(memcmp(buffer, "mes", 3) == 0);
+	TEST_TRUE(client.Available() == 7);
+}
+TEST_CASE_END
+
+TEST_CASE("writing a message larger than the ring buffer throws")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME, 64);
+	client.Open(PIPE_NAME);
+
+	byte message[64] = { 0 };
+
+	TEST_THROWS(server.Write(message, sizeof(message)));
+}
+TEST_CASE_END
+
+TEST_CASE("reading when the other end has closed throws")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	client.Close();
+
+	char buffer[1];
+
+	TEST_THROWS(server.Read(buffer, sizeof(buffer)));
+	TEST_THROWS(server.Available());
+}
+TEST_CASE_END
+
+TEST_CASE("reading times out when no message is written")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME);
+	client.Open(PIPE_NAME);
+
+	server.SetTimeOut(10);
+
+	char buffer[1];
+
+	TEST_THROWS(server.Read(buffer, sizeof(buffer)));
+}
+TEST_CASE_END
+
+TEST_CASE("opening a pipe whose capacity does not fit the mapping throws")
+{
+	CSharedMemPipe server;
+	CSharedMemPipe client;
+
+	server.Create(PIPE_NAME, 64);
+
+	HANDLE hMapping = ::OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, PIPE_NAME);
+	DWORD* pHeader  = static_cast<DWORD*>(::MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+
+	// Corrupt the capacity, which follows the magic number.
+	pHeader[1] = 0x40000000;
+
+	TEST_THROWS(client.Open(PIPE_NAME));
+	TEST_FALSE(client.IsOpen());
+
+	pHeader[1] = 100;
+
+	TEST_THROWS(client.Open(PIPE_NAME));
+	TEST_FALSE(client.IsOpen());
+
+	::UnmapViewOfFile(pHeader);
+	::CloseHandle(hMapping);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -6,6 +6,7 @@
 #include "Common.hpp"
 #include <Core/UnitTest.hpp>
 #include <NCL/Socket.hpp>
+#include <NCL/TCPSvrSocket.hpp>
 #include <WCL/Module.hpp>
 #include <NCL/AutoWinSock.hpp>
 
@@ -96,5 +97,19 @@ TEST_CASE("testing if a valid ip address can be resolved returns true")
 }
 TEST_CASE_END
 
+TEST_CASE("detaching a socket releases ownership of the handle without closing it")
+{
+	CTCPSvrSocket socket;
+
+	socket.Listen(0);
+
+	SOCKET handle = socket.Detach();
+
+	TEST_TRUE(handle != INVALID_SOCKET);
+	TEST_FALSE(socket.IsOpen());
+	TEST_TRUE(::closesocket(handle) == 0);
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   UnixSocketTests.cpp
+//! \brief  The unit tests for the Unix domain socket classes.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <NCL/UnixCltSocket.hpp>
+#include <NCL/UnixSvrSocket.hpp>
+#include <NCL/UnixAddress.hpp>
+#include <WCL/Module.hpp>
+#include <NCL/AutoWinSock.hpp>
+#include <Core/SharedPtr.hpp>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create a socket path in the temporary folder.
+
+tstring tempSocketPath()
+{
+	tchar szFolder[MAX_PATH+1] = { 0 };
+
+	::GetTempPath(MAX_PATH, szFolder);
+
+	return tstring(szFolder) + TXT("NCLUnixSocketTests.sock");
+}
+
+//namespace
+}
+
+TEST_SET(UnixSocket)
+{
+	CModule module;
+	AutoWinSock autoWinSock;
+
+	const tstring path = tempSocketPath();
+
+TEST_CASE("a client socket defaults to a byte stream")
+{
+	CUnixCltSocket socket;
+
+	TEST_TRUE(socket.Type() == SOCK_STREAM);
+	TEST_TRUE(socket.Protocol() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a server socket reports the type it was created with")
+{
+	CUnixSvrSocket socket(CSocket::BLOCK, SOCK_SEQPACKET);
+
+	TEST_TRUE(socket.Type() == SOCK_SEQPACKET);
+	TEST_TRUE(socket.Protocol() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("connecting to a path that is too long throws")
+{
+	const tstring path(UNIX_PATH_MAX, TXT('x'));
+	CUnixCltSocket socket;
+
+	TEST_THROWS(socket.Connect(path.c_str()));
+	TEST_FALSE(socket.IsOpen());
+}
+TEST_CASE_END
+
+TEST_CASE("listening on a path that is too long throws")
+{
+	const tstring path(UNIX_PATH_MAX, TXT('x'));
+	CUnixSvrSocket socket;
+
+	TEST_THROWS(socket.Listen(path.c_str()));
+	TEST_FALSE(socket.IsOpen());
+}
+TEST_CASE_END
+
+TEST_CASE("a client can exchange data with the server it connected to")
+{
+	CUnixSvrSocket server;
+
+	server.Listen(path.c_str());
+
+	CUnixCltSocket client;
+
+	client.Connect(path.c_str());
+
+	Core::SharedPtr<CTCPCltSocket> peer(server.Accept());
+	char                           buffer[5] = { 0 };
+
+	TEST_TRUE(client.Send("ping", 4) == 4);
+	TEST_TRUE(peer->Recv(buffer, 4) == 4);
+	TEST_TRUE(strcmp(buffer, "ping") == 0);
+
+	TEST_TRUE(peer->Send("pong", 4) == 4);
+	TEST_TRUE(client.Recv(buffer, 4) == 4);
+	TEST_TRUE(strcmp(buffer, "pong") == 0);
+
+	client.Close();
+	peer->Close();
+	server.Close();
+
+	TEST_TRUE(::GetFileAttributes(path.c_str()) == INVALID_FILE_ATTRIBUTES);
+}
+TEST_CASE_END
+
+TEST_CASE("listening on a path owned by a running server throws")
+{
+	CUnixSvrSocket running;
+
+	running.Listen(path.c_str());
+
+	CUnixSvrSocket server;
+
+	TEST_THROWS(server.Listen(path.c_str()));
+	TEST_FALSE(server.IsOpen());
+
+	CUnixCltSocket client;
+
+	client.Connect(path.c_str());
+
+	TEST_TRUE(client.IsOpen());
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   UnixAddress.hpp
+//! \brief  The helpers for building AF_UNIX socket addresses.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NCL_UNIXADDRESS_HPP
+#define NCL_UNIXADDRESS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "SocketException.hpp"
+#include <Core/AnsiWide.hpp>
+
+#ifndef AF_UNIX
+#define AF_UNIX 1
+#endif
+
+#ifndef UNIX_PATH_MAX
+//! The maximum length of an AF_UNIX socket path.
+#define UNIX_PATH_MAX 108
+
+////////////////////////////////////////////////////////////////////////////////
+//! The AF_UNIX socket address, as declared by <afunix.h> in newer SDKs.
+
+struct sockaddr_un
+{
+	u_short	sun_family;					//!< AF_UNIX.
+	char	sun_path[UNIX_PATH_MAX];	//!< The socket path.
+};
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the address for a socket path. The size of the address is returned.
+//! The error code is used for the exception if the path is too long.
+
+inline int makeUnixAddress(const tchar* path, sockaddr_un& address, int errorCode)
+{
+	ASSERT(path != nullptr);
+
+	std::string ansiPath = T2A(path);
+
+	if (ansiPath.length() >= UNIX_PATH_MAX)
+		throw CSocketException(errorCode, WSAENAMETOOLONG);
+
+	memset(&address, 0, sizeof(address));
+
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, ansiPath.c_str(), ansiPath.length());
+
+	return static_cast<int>(sizeof(address));
+}
+
+#endif // NCL_UNIXADDRESS_HPP
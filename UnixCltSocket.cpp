@@ -0,0 +1,139 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		UNIXCLTSOCKET.CPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	CUnixCltSocket class definition.
+**
+*******************************************************************************
+*/
+
+#include "Common.hpp"
+#include "UnixCltSocket.hpp"
+#include "UnixAddress.hpp"
+#include "WinSock.hpp"
+#include "SocketException.hpp"
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	.
+**
+** Parameters:	eMode	The 'select' mode.
+**				nType	SOCK_STREAM or SOCK_SEQPACKET.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CUnixCltSocket::CUnixCltSocket(Mode eMode, int nType)
+	: CTCPCltSocket(eMode)
+	, m_nType(nType)
+{
+	ASSERT((nType == SOCK_STREAM) || (nType == SOCK_SEQPACKET));
+}
+
+/******************************************************************************
+** Method:		Destructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CUnixCltSocket::~CUnixCltSocket()
+{
+}
+
+/******************************************************************************
+** Methods:		Type() & Protocol()
+**
+** Description:	Template methods to get the socket type and protocol.
+**
+** Parameters:	None.
+**
+** Returns:		SOCK_* & 0.
+**
+*******************************************************************************
+*/
+
+int CUnixCltSocket::Type() const
+{
+	return m_nType;
+}
+
+int CUnixCltSocket::Protocol() const
+{
+	return 0;
+}
+
+/******************************************************************************
+** Method:		Connect()
+**
+** Description:	Open a connection to the server listening on the path.
+**
+** Parameters:	pszPath		The socket path.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CSocketException.
+**
+*******************************************************************************
+*/
+
+void CUnixCltSocket::Connect(const tchar* pszPath)
+{
+	ASSERT(m_hSocket == INVALID_SOCKET);
+	ASSERT(pszPath   != nullptr);
+
+	sockaddr_un addr;
+	int         nAddrSize = makeUnixAddress(pszPath, addr, CSocketException::E_CONNECT_FAILED);
+
+	// Save parameters.
+	m_strHost = pszPath;
+	m_nPort   = 0;
+
+	// Create the socket.
+	Create(AF_UNIX, Type(), Protocol());
+
+	// Connect to server.
+	if (connect(m_hSocket, reinterpret_cast<sockaddr*>(&addr), nAddrSize) == SOCKET_ERROR)
+		throw CSocketException(CSocketException::E_CONNECT_FAILED, CWinSock::LastError());
+
+	// If async mode, do select.
+	if (m_eMode == ASYNC)
+		CWinSock::BeginAsyncSelect(this, (FD_READ | FD_WRITE | FD_CLOSE));
+}
+
+/******************************************************************************
+** Method:		Attach()
+**
+** Description:	Attach a socket accepted by the server.
+**
+** Parameters:	hSocket		The socket handle.
+**				eMode		The 'select' mode.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CUnixCltSocket::Attach(SOCKET hSocket, Mode eMode)
+{
+	ASSERT(hSocket   != INVALID_SOCKET);
+	ASSERT(m_hSocket == INVALID_SOCKET);
+	ASSERT(m_eMode   == eMode);
+
+	m_hSocket = hSocket;
+	m_eMode   = eMode;
+	m_nPort   = 0;
+
+	// If async mode, do select.
+	if (m_eMode == ASYNC)
+		CWinSock::BeginAsyncSelect(this, (FD_READ | FD_WRITE | FD_CLOSE));
+}
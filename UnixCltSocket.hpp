@@ -0,0 +1,78 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		UNIXCLTSOCKET.HPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	The CUnixCltSocket class declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef UNIXCLTSOCKET_HPP
+#define UNIXCLTSOCKET_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "TCPCltSocket.hpp"
+
+/******************************************************************************
+** 
+** A client side Unix domain socket. This is a drop-in replacement for a TCP
+** client socket between processes on the same machine, the "host" is the
+** socket path and there is no port. The socket can either be a byte stream
+** (SOCK_STREAM) or preserve message boundaries (SOCK_SEQPACKET).
+**
+*******************************************************************************
+*/
+
+class CUnixCltSocket : public CTCPCltSocket
+{
+public:
+	//
+	// Constructors/Destructor.
+	//
+	CUnixCltSocket(Mode eMode = BLOCK, int nType = SOCK_STREAM);
+	virtual ~CUnixCltSocket();
+
+	//
+	// Properties.
+	//
+	virtual int Type()     const;
+	virtual int Protocol() const;
+
+	CString Path() const;
+
+	//
+	// Methods.
+	//
+	void Connect(const tchar* pszPath);
+
+	// For use by CUnixSvrSocket or with CNamedPipe::ReadSocket().
+	virtual void Attach(SOCKET hSocket, Mode eMode);
+
+protected:
+	//
+	// Members.
+	//
+	int		m_nType;		// SOCK_STREAM or SOCK_SEQPACKET.
+
+	// Friends.
+	friend class CUnixSvrSocket;
+};
+
+/******************************************************************************
+**
+** Implementation of inline functions.
+**
+*******************************************************************************
+*/
+
+inline CString CUnixCltSocket::Path() const
+{
+	return m_strHost;
+}
+
+#endif // UNIXCLTSOCKET_HPP
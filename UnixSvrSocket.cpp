@@ -0,0 +1,200 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		UNIXSVRSOCKET.CPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	CUnixSvrSocket class definition.
+**
+*******************************************************************************
+*/
+
+#include "Common.hpp"
+#include "UnixSvrSocket.hpp"
+#include "UnixCltSocket.hpp"
+#include "UnixAddress.hpp"
+#include "WinSock.hpp"
+#include "SocketException.hpp"
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	.
+**
+** Parameters:	eMode	The 'select' mode.
+**				nType	SOCK_STREAM or SOCK_SEQPACKET.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CUnixSvrSocket::CUnixSvrSocket(Mode eMode, int nType)
+	: CTCPSvrSocket(eMode)
+	, m_nType(nType)
+{
+	ASSERT((nType == SOCK_STREAM) || (nType == SOCK_SEQPACKET));
+}
+
+/******************************************************************************
+** Method:		Destructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CUnixSvrSocket::~CUnixSvrSocket()
+{
+	Close();
+}
+
+/******************************************************************************
+** Methods:		Type() & Protocol()
+**
+** Description:	Template methods to get the socket type and protocol.
+**
+** Parameters:	None.
+**
+** Returns:		SOCK_* & 0.
+**
+*******************************************************************************
+*/
+
+int CUnixSvrSocket::Type() const
+{
+	return m_nType;
+}
+
+int CUnixSvrSocket::Protocol() const
+{
+	return 0;
+}
+
+/******************************************************************************
+** Method:		Listen()
+**
+** Description:	Open the socket for listening on the given path. A socket file
+**				left by a previous server is only removed if nothing is
+**				listening on it any more.
+**
+** Parameters:	pszPath		The socket path.
+**				nBackLog	The connection queue size.
+**
+** Returns:		Nothing.
+**
+** Exceptions:	CSocketException.
+**
+*******************************************************************************
+*/
+
+void CUnixSvrSocket::Listen(const tchar* pszPath, uint nBackLog)
+{
+	ASSERT(m_hSocket == INVALID_SOCKET);
+	ASSERT(pszPath   != nullptr);
+
+	sockaddr_un addr;
+	int         nAddrSize = makeUnixAddress(pszPath, addr, CSocketException::E_BIND_FAILED);
+
+	// Remove stale socket file.
+	if (IsStalePath(addr, nAddrSize))
+		::DeleteFile(pszPath);
+
+	// Create the socket.
+	Create(AF_UNIX, Type(), Protocol());
+
+	// Bind socket to path.
+	if (bind(m_hSocket, reinterpret_cast<sockaddr*>(&addr), nAddrSize) == SOCKET_ERROR)
+		throw CSocketException(CSocketException::E_BIND_FAILED, CWinSock::LastError());
+
+	// Save parameters.
+	m_strPath = pszPath;
+	m_nPort   = 0;
+
+	// Start accepting client connections.
+	if (listen(m_hSocket, nBackLog)  == SOCKET_ERROR)
+		throw CSocketException(CSocketException::E_LISTEN_FAILED, CWinSock::LastError());
+
+	// If async mode, do select.
+	if (m_eMode == ASYNC)
+		CWinSock::BeginAsyncSelect(this, (FD_ACCEPT | FD_CLOSE));
+}
+
+/******************************************************************************
+** Method:		IsStalePath()
+**
+** Description:	Queries if the socket path is left over from a server that is
+**				no longer running, by trying to connect to it.
+**
+** Parameters:	addr		The socket address.
+**				nAddrSize	The address size.
+**
+** Returns:		true or false.
+**
+** Exceptions:	CSocketException.
+**
+*******************************************************************************
+*/
+
+bool CUnixSvrSocket::IsStalePath(const sockaddr_un& addr, int nAddrSize) const
+{
+	SOCKET hSocket = socket(AF_UNIX, Type(), Protocol());
+
+	if (hSocket == INVALID_SOCKET)
+		throw CSocketException(CSocketException::E_BIND_FAILED, CWinSock::LastError());
+
+	int nResult = connect(hSocket, reinterpret_cast<const sockaddr*>(&addr), nAddrSize);
+	int nError  = (nResult == SOCKET_ERROR) ? CWinSock::LastError() : 0;
+
+	closesocket(hSocket);
+
+	// Another server still owns the path?
+	if (nResult != SOCKET_ERROR)
+		throw CSocketException(CSocketException::E_BIND_FAILED, WSAEADDRINUSE);
+
+	return (nError == WSAECONNREFUSED);
+}
+
+/******************************************************************************
+** Method:		Close()
+**
+** Description:	Close the socket and remove the socket file.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CUnixSvrSocket::Close()
+{
+	CTCPSvrSocket::Close();
+
+	// Remove socket file.
+	if (!m_strPath.Empty())
+	{
+		::DeleteFile(m_strPath);
+		m_strPath = TXT("");
+	}
+}
+
+/******************************************************************************
+** Method:		AllocCltSocket()
+**
+** Description:	Allocate a client Unix domain socket.
+**
+** Parameters:	None.
+**
+** Returns:		The socket.
+**
+*******************************************************************************
+*/
+
+CTCPCltSocket* CUnixSvrSocket::AllocCltSocket()
+{
+	return new CUnixCltSocket(m_eMode, m_nType);
+}
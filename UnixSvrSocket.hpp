@@ -0,0 +1,87 @@
+/******************************************************************************
+** (C) Chris Oldwood
+**
+** MODULE:		UNIXSVRSOCKET.HPP
+** COMPONENT:	Network & Comms Library
+** DESCRIPTION:	The CUnixSvrSocket class declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef UNIXSVRSOCKET_HPP
+#define UNIXSVRSOCKET_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "TCPSvrSocket.hpp"
+
+// Forward declarations.
+struct sockaddr_un;
+
+/******************************************************************************
+** 
+** A server side Unix domain socket. This is a drop-in replacement for a TCP
+** server socket; it notifies the same server listeners and accepts clients
+** as CUnixCltSocket objects.
+**
+*******************************************************************************
+*/
+
+class CUnixSvrSocket : public CTCPSvrSocket
+{
+public:
+	//
+	// Constructors/Destructor.
+	//
+	CUnixSvrSocket(Mode eMode = BLOCK, int nType = SOCK_STREAM);
+	virtual ~CUnixSvrSocket();
+	
+	//
+	// Properties.
+	//
+	virtual int Type()     const;
+	virtual int Protocol() const;
+
+	const CString& Path() const;
+
+	//
+	// Methods.
+	//
+	void Listen(const tchar* pszPath, uint nBackLog = SOMAXCONN);
+
+	virtual void Close();
+
+protected:
+	//
+	// Members.
+	//
+	int		m_nType;		// SOCK_STREAM or SOCK_SEQPACKET.
+	CString	m_strPath;		// The socket path, if listening.
+
+	//
+	// Template methods.
+	//
+	virtual CTCPCltSocket* AllocCltSocket();
+
+	//
+	// Internal methods.
+	//
+	bool IsStalePath(const sockaddr_un& addr, int nAddrSize) const;
+};
+
+/******************************************************************************
+**
+** Implementation of inline functions.
+**
+*******************************************************************************
+*/
+
+inline const CString& CUnixSvrSocket::Path() const
+{
+	return m_strPath;
+}
+
+#endif // UNIXSVRSOCKET_HPP
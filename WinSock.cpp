@@ -13,6 +13,7 @@
 #include <WCL/Module.hpp>
 #include "Socket.hpp"
 #include "SocketException.hpp"
+#include "ISocketTimerListener.hpp"
 #include <tchar.h>
 #include <limits>
 #include <WCL/Exception.hpp>
@@ -39,6 +40,8 @@ WSADATA CWinSock::g_oWSAData = { 0 };
 uint    CWinSock::g_nSockMsg = 0;
 HWND    CWinSock::g_hSockWnd = NULL;
 CWinSock::SocketMapPtr CWinSock::g_pSockMap;
+CWinSock::TimerMapPtr  CWinSock::g_pTimerMap;
+uint    CWinSock::g_nNextTimerID = 0;
 
 /******************************************************************************
 ** Method:		Startup()
@@ -77,8 +80,9 @@ int CWinSock::Startup(uint nMajorVer, uint nMinorVer)
 
 	ASSERT(g_hSockWnd != NULL);
 
-	// Create the socket handle map.
-	g_pSockMap = SocketMapPtr(new SocketMap);
+	// Create the socket handle and timer maps.
+	g_pSockMap  = SocketMapPtr(new SocketMap);
+	g_pTimerMap = TimerMapPtr(new TimerMap);
 
 	return ::WSAStartup(MAKEWORD(nMajorVer, nMinorVer), &g_oWSAData);
 }
@@ -98,9 +102,11 @@ int CWinSock::Startup(uint nMajorVer, uint nMinorVer)
 int CWinSock::Cleanup()
 {
 	ASSERT((g_pSockMap.get() == nullptr) || (g_pSockMap->empty()));
+	ASSERT((g_pTimerMap.get() == nullptr) || (g_pTimerMap->empty()));
 
-	// Destroy the socket handle map.
+	// Destroy the socket handle and timer maps.
 	g_pSockMap.reset();
+	g_pTimerMap.reset();
 
 	// Destroy the socket window.
 	if (g_hSockWnd != NULL)
@@ -248,6 +254,47 @@ LRESULT CALLBACK CWinSock::WindowProc(HWND hWnd, UINT nMsg, WPARAM wParam, LPARA
 											nEvent, nError);
 		}
 	}
+	// Is a timer message?
+	else if ( (nMsg == WM_TIMER) && (g_pTimerMap.get() != nullptr) )
+	{
+		uint nTimerID = static_cast<uint>(wParam);
+
+		try
+		{
+			TimerMap::const_iterator it = g_pTimerMap->find(nTimerID);
+
+			// Timer still running?
+			if (it != g_pTimerMap->end())
+			{
+				ISocketTimerListener* pListener = it->second;
+
+				ASSERT(pListener != nullptr);
+
+				// Forward event.
+				pListener->OnTimer(nTimerID);
+			}
+
+			return 0;
+		}
+		catch (const Core::Exception& e)
+		{
+			WCL::ReportUnhandledException(	TXT("Unexpected exception caught in CWinSock::WindowProc()\n\n")
+											TXT("Message: Timer=%u\n\n%s"),
+											nTimerID, e.twhat());
+		}
+		catch (const std::exception& e)
+		{
+			WCL::ReportUnhandledException(	TXT("Unexpected exception caught in CWinSock::WindowProc()\n\n")
+											TXT("Message: Timer=%u\n\n%hs"),
+											nTimerID, e.what());
+		}
+		catch (...)
+		{
+			WCL::ReportUnhandledException(	TXT("Unexpected unknown exception caught in CWinSock::WindowProc()\n\n")
+											TXT("Message: Timer=%u"),
+											nTimerID);
+		}
+	}
 
 	// Do default processing.
 	return ::DefWindowProc(hWnd, nMsg, wParam, lParam);
@@ -336,4 +383,73 @@ void CWinSock::ProcessSocketMsgs()
 
 	while (::PeekMessage(&oMsg, g_hSockWnd, g_nSockMsg, g_nSockMsg, PM_REMOVE))
 		::DispatchMessage(&oMsg);
+
+	// Timers only fire when the queue is otherwise empty.
+	while (::PeekMessage(&oMsg, g_hSockWnd, WM_TIMER, WM_TIMER, PM_REMOVE))
+		::DispatchMessage(&oMsg);
+}
+
+/******************************************************************************
+** Method:		StartTimer()
+**
+** Description:	Start a timer which is serviced by the socket window. This
+**				allows listeners to schedule work, such as timeouts, on the
+**				same thread as their socket events.
+**
+** Parameters:	pListener	The listener to notify.
+**				nInterval	The timer period in milliseconds.
+**
+** Returns:		The timer ID.
+**
+*******************************************************************************
+*/
+
+uint CWinSock::StartTimer(ISocketTimerListener* pListener, uint nInterval)
+{
+	ASSERT(pListener != nullptr);
+	ASSERT(g_pTimerMap.get() != nullptr);
+
+	uint nTimerID = ++g_nNextTimerID;
+
+	// Skip the reserved ID on wrap-around.
+	if (nTimerID == 0)
+		nTimerID = ++g_nNextTimerID;
+
+	ASSERT(g_pTimerMap->find(nTimerID) == g_pTimerMap->end());
+
+	// Add ID<->listener mapping.
+	g_pTimerMap->insert(std::make_pair(nTimerID, pListener));
+
+	// Start events...
+	UINT_PTR nResult = ::SetTimer(g_hSockWnd, nTimerID, nInterval, NULL);
+
+	ASSERT_RESULT(nResult, nResult != 0);
+
+	return nTimerID;
+}
+
+/******************************************************************************
+** Method:		StopTimer()
+**
+** Description:	Stop a timer started with StartTimer().
+**
+** Parameters:	nTimerID	The timer ID.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CWinSock::StopTimer(uint nTimerID)
+{
+	ASSERT(g_pTimerMap.get() != nullptr);
+
+	// Stop events.
+	::KillTimer(g_hSockWnd, nTimerID);
+
+	// Remove ID<->listener mapping.
+	TimerMap::iterator it = g_pTimerMap->find(nTimerID);
+
+	if (it != g_pTimerMap->end())
+		g_pTimerMap->erase(it);
 }
@@ -20,6 +20,7 @@
 
 // Forward declarations.
 class CSocket;
+class ISocketTimerListener;
 
 /******************************************************************************
 ** 
@@ -46,11 +47,18 @@ public:
 
 	static void ProcessSocketMsgs();
 
+	static uint StartTimer(ISocketTimerListener* pListener, uint nInterval);
+	static void StopTimer(uint nTimerID);
+
 private:
 	//! The map of socket handle to object.
 	typedef std::map<SOCKET, CSocket*> SocketMap;
 	//! The socket handle map smart-pointer type.
 	typedef Core::SharedPtr<SocketMap> SocketMapPtr;
+	//! The map of timer ID to listener.
+	typedef std::map<uint, ISocketTimerListener*> TimerMap;
+	//! The timer map smart-pointer type.
+	typedef Core::SharedPtr<TimerMap> TimerMapPtr;
 
 	//
 	// Class members.
@@ -60,6 +68,8 @@ private:
 	static uint			g_nSockMsg;
 	static HWND			g_hSockWnd;
 	static SocketMapPtr	g_pSockMap;
+	static TimerMapPtr	g_pTimerMap;
+	static uint			g_nNextTimerID;
 
 	// Socket window procedure.
 	static LRESULT CALLBACK WindowProc(HWND hWnd, UINT nMsg, WPARAM wParam, LPARAM lParam);